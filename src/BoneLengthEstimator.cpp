@@ -0,0 +1,96 @@
+#include "BoneLengthEstimator.h"
+
+
+/******************************************************************************
+ * BoneLengthEstimator class
+ */
+
+BoneLengthEstimator::BoneLengthEstimator(int nBones, int _convergenceFrames, float _adaptationRate) :
+	convergenceFrames(_convergenceFrames),
+	adaptationRate(_adaptationRate),
+	nConverged(0),
+	nExcluded(0),
+	offset(nBones, 0),
+	length(nBones, 0),
+	nMeasurements(nBones, 0),
+	excluded(nBones, false)
+{
+	// nothing else to do
+}
+
+
+void BoneLengthEstimator::reset()
+{
+	offset.assign(offset.size(), 0);
+	length.assign(length.size(), 0);
+	nMeasurements.assign(nMeasurements.size(), 0);
+	nConverged = 0;
+}
+
+
+void BoneLengthEstimator::excludeBone(int boneIdx)
+{
+	if (!excluded[boneIdx])
+	{
+		// forget measurements that were added before
+		if (nMeasurements[boneIdx] >= convergenceFrames)
+		{
+			nConverged--;
+		}
+		offset[boneIdx]        = 0;
+		length[boneIdx]        = 0;
+		nMeasurements[boneIdx] = 0;
+		excluded[boneIdx]      = true;
+		nExcluded++;
+	}
+}
+
+
+void BoneLengthEstimator::addMeasurement(int boneIdx, float _offset, float _length)
+{
+	if (excluded[boneIdx]) return;
+
+	int& count = nMeasurements[boneIdx];
+	if (count < convergenceFrames)
+	{
+		// not converged yet > running mean
+		count++;
+		float weight = 1.0f / count;
+		offset[boneIdx] += (_offset - offset[boneIdx]) * weight;
+		length[boneIdx] += (_length - length[boneIdx]) * weight;
+		if (count == convergenceFrames)
+		{
+			nConverged++;
+		}
+	}
+	else if (adaptationRate > 0)
+	{
+		// converged > follow slow changes only
+		offset[boneIdx] += (_offset - offset[boneIdx]) * adaptationRate;
+		length[boneIdx] += (_length - length[boneIdx]) * adaptationRate;
+	}
+}
+
+
+bool BoneLengthEstimator::hasEstimate(int boneIdx) const
+{
+	return nMeasurements[boneIdx] > 0;
+}
+
+
+bool BoneLengthEstimator::isFrozen() const
+{
+	return (adaptationRate <= 0) && (nConverged + nExcluded == (int)nMeasurements.size());
+}
+
+
+float BoneLengthEstimator::getOffset(int boneIdx) const
+{
+	return offset[boneIdx];
+}
+
+
+float BoneLengthEstimator::getLength(int boneIdx) const
+{
+	return length[boneIdx];
+}
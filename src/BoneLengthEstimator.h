@@ -0,0 +1,94 @@
+/**
+ * Class for estimating stable bone offsets and lengths of a skeleton from noisy measurements.
+ */
+
+#pragma once
+
+#include <vector>
+
+
+class BoneLengthEstimator
+{
+public:
+
+	/**
+	 * Creates a bone length estimator.
+	 *
+	 * @param nBones             the amount of bones
+	 * @param convergenceFrames  the amount of measurements that are averaged before the estimate is converged
+	 * @param adaptationRate     the weight of new measurements after convergence (0: estimate is frozen)
+	 */
+	BoneLengthEstimator(int nBones = 0, int convergenceFrames = 90, float adaptationRate = 0);
+
+	/**
+	 * Discards all measurements, e.g., when the skeleton belongs to a new person.
+	 */
+	void reset();
+
+	/**
+	 * Excludes a bone that cannot be tracked, e.g., the legs in seated mode.
+	 * The bone gets no estimate and does not keep the other estimates from freezing.
+	 * The exclusion is kept when the estimator is reset.
+	 *
+	 * @param boneIdx  the index of the bone
+	 */
+	void excludeBone(int boneIdx);
+
+	/**
+	 * Adds a measurement of a bone.
+	 * Measurements of a converged bone are ignored if the estimate is frozen,
+	 * measurements of an excluded bone are always ignored.
+	 *
+	 * @param boneIdx  the index of the bone
+	 * @param offset   the measured offset of the bone
+	 * @param length   the measured length of the bone
+	 */
+	void addMeasurement(int boneIdx, float offset, float length);
+
+	/**
+	 * Checks if there is an estimate for a bone.
+	 *
+	 * @param boneIdx  the index of the bone
+	 *
+	 * @return <code>true</code> if at least one measurement of the bone has been added
+	 */
+	bool hasEstimate(int boneIdx) const;
+
+	/**
+	 * Checks if the estimates of all bones that are not excluded are converged and frozen,
+	 * i.e., if further measurements are not necessary.
+	 *
+	 * @return <code>true</code> if all estimates are converged and frozen
+	 */
+	bool isFrozen() const;
+
+	/**
+	 * Gets the estimated offset of a bone.
+	 *
+	 * @param boneIdx  the index of the bone
+	 *
+	 * @return the estimated offset of the bone
+	 */
+	float getOffset(int boneIdx) const;
+
+	/**
+	 * Gets the estimated length of a bone.
+	 *
+	 * @param boneIdx  the index of the bone
+	 *
+	 * @return the estimated length of the bone
+	 */
+	float getLength(int boneIdx) const;
+
+private:
+
+	int                convergenceFrames;
+	float              adaptationRate;
+	int                nConverged;
+	int                nExcluded;
+
+	std::vector<float> offset;
+	std::vector<float> length;
+	std::vector<int>   nMeasurements;
+	std::vector<bool>  excluded;
+};
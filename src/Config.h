@@ -5,6 +5,8 @@
 
 #define USE_CORTEX		// build a MotionServer module for connecting to Cortex MoCap systems
 
+// #define USE_CORTEX_EMULATOR // uncomment to replace the Cortex SDK library by an emulator with synthetic data
+
 #define USE_KINECT		// build a MotionServer module that uses the Kinect
 
 #define USE_PIECEMETA	// build a MotionServer module that reads data from the PieceMeta website
@@ -0,0 +1,499 @@
+#include "CortexEmulator.h"
+
+#ifdef USE_CORTEX_EMULATOR
+
+#include "Cortex.h"
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+
+/******************************************************************************
+ * Emulator state
+ */
+
+static CortexEmulatorSettings settings;
+
+// handlers can be replaced while the frame thread is running
+static std::atomic<void (*)(int, char*)>     pMessageHandler(nullptr);
+static std::atomic<void (*)(sFrameOfData*)>  pDataHandler(nullptr);
+
+static std::mutex        mtxScene;        // guards scene and frame against concurrent SDK calls
+static std::thread       frameThread;
+static std::atomic<bool> threadRunning(false);
+static std::atomic<bool> paused(false);
+
+static int               nActiveActors = 0;       // actors in the current scene
+static sFrameOfData*     pFrame        = nullptr; // frame that is generated and passed to the data handler
+
+static float             conversionToMillimeters = 1.0f; // response buffers for Cortex_Request(...)
+static float             contextFrameRate        = 0.0f;
+
+
+static void sendMessage(int iLevel, const std::string& strMessage)
+{
+	void (*pHandler)(int, char*) = pMessageHandler;
+	if (pHandler != nullptr)
+	{
+		pHandler(iLevel, (char*) strMessage.c_str());
+	}
+}
+
+
+static void formatName(char* szBuffer, size_t size, const char* szPrefix, int idx)
+{
+	snprintf(szBuffer, size, "%s%d", szPrefix, idx + 1);
+}
+
+
+static char* duplicateName(const char* szPrefix, int idx)
+{
+	char szBuffer[64];
+	formatName(szBuffer, sizeof(szBuffer), szPrefix, idx);
+	char* szName = new char[strlen(szBuffer) + 1];
+	strcpy(szName, szBuffer);
+	return szName;
+}
+
+
+/**
+ * Allocates the marker and segment arrays of a frame for the current scene.
+ */
+static void allocateFrame(sFrameOfData& refFrame, int nActors)
+{
+	memset(&refFrame, 0, sizeof(refFrame));
+	refFrame.nBodies = nActors;
+	for (int aIdx = 0; aIdx < nActors; aIdx++)
+	{
+		sBodyData& refBody = refFrame.BodyData[aIdx];
+		formatName(refBody.szName, sizeof(refBody.szName), "Actor", aIdx);
+		refBody.nMarkers  = settings.nMarkers;
+		refBody.Markers   = new tMarkerData[settings.nMarkers];
+		refBody.nSegments = settings.nSegments;
+		refBody.Segments  = new tSegmentData[settings.nSegments];
+	}
+	refFrame.nUnidentifiedMarkers = settings.nUnidentifiedMarkers;
+	refFrame.UnidentifiedMarkers  = new tMarkerData[settings.nUnidentifiedMarkers];
+}
+
+
+/**
+ * Frees the marker and segment arrays of a frame.
+ */
+static void releaseFrame(sFrameOfData& refFrame)
+{
+	for (int aIdx = 0; aIdx < refFrame.nBodies; aIdx++)
+	{
+		delete[] refFrame.BodyData[aIdx].Markers;
+		delete[] refFrame.BodyData[aIdx].Segments;
+	}
+	delete[] refFrame.UnidentifiedMarkers;
+	memset(&refFrame, 0, sizeof(refFrame));
+}
+
+
+/**
+ * Fills a frame with synthetic data.
+ * Actors walk on circles, segments form a chain with swinging joints,
+ * and markers and segments drop out periodically to emulate occlusions.
+ */
+static void generateFrame(sFrameOfData& refFrame, int iFrame)
+{
+	const float time = iFrame / settings.frameRate;
+
+	refFrame.iFrame = iFrame;
+	refFrame.fDelay = 1.0f / settings.frameRate;
+
+	for (int aIdx = 0; aIdx < refFrame.nBodies; aIdx++)
+	{
+		sBodyData& refBody = refFrame.BodyData[aIdx];
+		const float angle  = time * 0.5f + aIdx;
+		const float radius = 1000.0f + 250.0f * aIdx;
+		const float rootX  = radius * cosf(angle);
+		const float rootY  = 1000.0f;
+		const float rootZ  = radius * sinf(angle);
+
+		for (int sIdx = 0; sIdx < refBody.nSegments; sIdx++)
+		{
+			double* pSegment = refBody.Segments[sIdx];
+			if ((iFrame + 13 * sIdx + 7 * aIdx) % 211 < 2)
+			{
+				pSegment[0] = pSegment[1] = pSegment[2] = XEMPTY;
+				pSegment[3] = pSegment[4] = pSegment[5] = pSegment[6] = XEMPTY;
+				continue;
+			}
+			pSegment[0] = rootX;
+			pSegment[1] = rootY + 100.0 * sIdx;
+			pSegment[2] = rootZ;
+			pSegment[3] = 20.0 * sin(time * 2.0 + sIdx);          // rotation X in degrees
+			pSegment[4] = fmod(angle * 180.0 / 3.14159265358979, 360.0) - 180.0; // rotation Y
+			pSegment[5] = 10.0 * cos(time * 1.5 + sIdx);          // rotation Z
+			pSegment[6] = 100.0;                                   // segment length
+		}
+
+		for (int mIdx = 0; mIdx < refBody.nMarkers; mIdx++)
+		{
+			float* pMarker = refBody.Markers[mIdx];
+			if ((iFrame + 7 * mIdx + 3 * aIdx) % 97 < 3)
+			{
+				pMarker[0] = pMarker[1] = pMarker[2] = XEMPTY;
+				continue;
+			}
+			const float markerAngle = angle + mIdx * 0.3f;
+			pMarker[0] = rootX + 100.0f * cosf(markerAngle);
+			pMarker[1] = rootY + 40.0f * (mIdx % 25);
+			pMarker[2] = rootZ + 100.0f * sinf(markerAngle);
+		}
+	}
+
+	for (int mIdx = 0; mIdx < refFrame.nUnidentifiedMarkers; mIdx++)
+	{
+		float* pMarker = refFrame.UnidentifiedMarkers[mIdx];
+		const float markerAngle = time * 0.2f + mIdx;
+		pMarker[0] = 3000.0f * cosf(markerAngle);
+		pMarker[1] = 500.0f + 50.0f * mIdx;
+		pMarker[2] = 3000.0f * sinf(markerAngle);
+	}
+}
+
+
+/**
+ * Thread that produces frames at the configured rate and passes them to the data handler.
+ */
+static void runFrameThread()
+{
+	const std::chrono::duration<double> interval(1.0 / settings.frameRate);
+	auto nextFrameTime = std::chrono::steady_clock::now();
+	int  iFrame        = 0;
+
+	while (threadRunning)
+	{
+		nextFrameTime += std::chrono::duration_cast<std::chrono::steady_clock::duration>(interval);
+		std::this_thread::sleep_until(nextFrameTime);
+
+		if (paused)
+		{
+			continue;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(mtxScene);
+
+			// add/remove the last actor periodically to trigger scene changes
+			if ((settings.sceneChangeInterval > 0) && (settings.nActors > 1) &&
+			    (iFrame > 0) && (iFrame % settings.sceneChangeInterval == 0))
+			{
+				int nActors = (nActiveActors == settings.nActors) ? settings.nActors - 1 : settings.nActors;
+				releaseFrame(*pFrame);
+				allocateFrame(*pFrame, nActors);
+				nActiveActors = nActors;
+			}
+
+			generateFrame(*pFrame, iFrame);
+		}
+
+		// the frame is only modified by this thread, so it can be passed on without holding the lock
+		void (*pHandler)(sFrameOfData*) = pDataHandler;
+		if (pHandler != nullptr)
+		{
+			pHandler(pFrame);
+		}
+
+		iFrame++;
+	}
+}
+
+
+
+/******************************************************************************
+ * Emulator configuration
+ */
+
+bool CortexEmulator_ParseSettings(const std::string& strSettings, CortexEmulatorSettings& refSettings)
+{
+	CortexEmulatorSettings newSettings;
+	std::istringstream     strm(strSettings);
+	char                   separator;
+
+	strm >> newSettings.nActors    >> separator
+	     >> newSettings.nSegments  >> separator
+	     >> newSettings.nMarkers   >> separator
+	     >> newSettings.nUnidentifiedMarkers >> separator
+	     >> newSettings.frameRate;
+	if (strm.fail())
+	{
+		return false;
+	}
+
+	newSettings.sceneChangeInterval = 0;
+	if (strm >> separator)
+	{
+		strm >> newSettings.sceneChangeInterval;
+		if (strm.fail()) return false;
+	}
+
+	if ((newSettings.nActors < 0) || (newSettings.nActors > MAX_N_BODIES) ||
+	    (newSettings.nSegments < 0) || (newSettings.nMarkers < 0) ||
+	    (newSettings.nUnidentifiedMarkers < 0) || (newSettings.frameRate <= 0) ||
+	    (newSettings.sceneChangeInterval < 0))
+	{
+		return false;
+	}
+
+	refSettings = newSettings;
+	return true;
+}
+
+
+void CortexEmulator_Configure(const CortexEmulatorSettings& refSettings)
+{
+	std::lock_guard<std::mutex> lock(mtxScene);
+	settings = refSettings;
+}
+
+
+
+/******************************************************************************
+ * Cortex SDK functions
+ */
+
+int Cortex_GetSdkVersion(unsigned char Version[4])
+{
+	Version[0] = 'E'; // emulator
+	Version[1] = 5;
+	Version[2] = 0;
+	Version[3] = 0;
+	return RC_Okay;
+}
+
+
+int Cortex_SetErrorMsgHandlerFunc(void (*MyFunction)(int iLogLevel, char* szLogMessage))
+{
+	pMessageHandler = MyFunction;
+	return RC_Okay;
+}
+
+
+int Cortex_SetDataHandlerFunc(void (*MyFunction)(sFrameOfData* pFrameOfData))
+{
+	pDataHandler = MyFunction;
+	return RC_Okay;
+}
+
+
+int Cortex_Initialize(char* szTalkToHostNicCardAddress, char* szHostNicCardAddress, char* szHostMulticastAddress, char* szTalkToClientsNicCardAddress, char* szClientsMulticastAddress)
+{
+	if (threadRunning)
+	{
+		return RC_GeneralError;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mtxScene);
+		nActiveActors = settings.nActors;
+		pFrame = new sFrameOfData;
+		allocateFrame(*pFrame, nActiveActors);
+		contextFrameRate = settings.frameRate;
+	}
+
+	std::stringstream strm;
+	strm << "Cortex emulator: " << settings.nActors << " actors, "
+	     << settings.nSegments << " segments, " << settings.nMarkers << " markers, "
+	     << settings.nUnidentifiedMarkers << " unidentified markers at " << settings.frameRate << " fps";
+	sendMessage(VL_Info, strm.str());
+
+	paused        = false;
+	threadRunning = true;
+	frameThread   = std::thread(runFrameThread);
+	return RC_Okay;
+}
+
+
+int Cortex_GetPortNumbers(int* TalkToHostPort, int* HostPort, int* HostMulticastPort, int* TalkToClientsRequestPort, int* TalkToClientsMulticastPort, int* ClientsMulticastPort)
+{
+	if (TalkToHostPort             != nullptr) *TalkToHostPort             = 0;
+	if (HostPort                   != nullptr) *HostPort                   = 1510;
+	if (HostMulticastPort          != nullptr) *HostMulticastPort          = 1001;
+	if (TalkToClientsRequestPort   != nullptr) *TalkToClientsRequestPort   = 0;
+	if (TalkToClientsMulticastPort != nullptr) *TalkToClientsMulticastPort = 0;
+	if (ClientsMulticastPort       != nullptr) *ClientsMulticastPort       = 1001;
+	return RC_Okay;
+}
+
+
+int Cortex_GetHostInfo(sHostInfo* pHostInfo)
+{
+	memset(pHostInfo, 0, sizeof(sHostInfo));
+	pHostInfo->bFoundHost = threadRunning ? 1 : 0;
+	strncpy(pHostInfo->szHostMachineName, "localhost", sizeof(pHostInfo->szHostMachineName) - 1);
+	strncpy(pHostInfo->szHostProgramName, "Cortex Emulator", sizeof(pHostInfo->szHostProgramName) - 1);
+	pHostInfo->HostMachineAddress[0] = 127;
+	pHostInfo->HostMachineAddress[3] = 1;
+	pHostInfo->HostProgramVersion[1] = 5;
+	return RC_Okay;
+}
+
+
+int Cortex_Exit()
+{
+	if (threadRunning)
+	{
+		threadRunning = false;
+		frameThread.join();
+	}
+
+	std::lock_guard<std::mutex> lock(mtxScene);
+	if (pFrame != nullptr)
+	{
+		releaseFrame(*pFrame);
+		delete pFrame;
+		pFrame = nullptr;
+	}
+	return RC_Okay;
+}
+
+
+int Cortex_Request(char* szCommand, void** ppResponse, int* pnBytes)
+{
+	int result = RC_Okay;
+	*ppResponse = nullptr;
+	*pnBytes    = 0;
+
+	if (strcmp(szCommand, "GetConversionToMillimeters") == 0)
+	{
+		*ppResponse = &conversionToMillimeters;
+		*pnBytes    = sizeof(conversionToMillimeters);
+	}
+	else if (strcmp(szCommand, "GetContextFrameRate") == 0)
+	{
+		*ppResponse = &contextFrameRate;
+		*pnBytes    = sizeof(contextFrameRate);
+	}
+	else if (strcmp(szCommand, "LiveMode") == 0)
+	{
+		paused = false;
+	}
+	else if (strcmp(szCommand, "Pause") == 0)
+	{
+		paused = true;
+	}
+	else
+	{
+		result = RC_Unrecognized;
+	}
+	return result;
+}
+
+
+sBodyDefs* Cortex_GetBodyDefs()
+{
+	std::lock_guard<std::mutex> lock(mtxScene);
+	if (pFrame == nullptr)
+	{
+		return nullptr;
+	}
+
+	sBodyDefs* pBodyDefs = new sBodyDefs;
+	memset(pBodyDefs, 0, sizeof(sBodyDefs));
+	pBodyDefs->nBodyDefs = nActiveActors;
+
+	for (int aIdx = 0; aIdx < nActiveActors; aIdx++)
+	{
+		sBodyDef& refDef = pBodyDefs->BodyDefs[aIdx];
+		refDef.szName = duplicateName("Actor", aIdx);
+
+		refDef.nMarkers      = settings.nMarkers;
+		refDef.szMarkerNames = new char*[settings.nMarkers];
+		for (int mIdx = 0; mIdx < settings.nMarkers; mIdx++)
+		{
+			refDef.szMarkerNames[mIdx] = duplicateName("Marker", mIdx);
+		}
+
+		// segments form a chain starting at the root segment
+		sHierarchy& refHierarchy = refDef.Hierarchy;
+		refHierarchy.nSegments      = settings.nSegments;
+		refHierarchy.szSegmentNames = new char*[settings.nSegments];
+		refHierarchy.iParents       = new int[settings.nSegments];
+		for (int sIdx = 0; sIdx < settings.nSegments; sIdx++)
+		{
+			refHierarchy.szSegmentNames[sIdx] = duplicateName("Segment", sIdx);
+			refHierarchy.iParents[sIdx]       = sIdx - 1;
+		}
+	}
+	return pBodyDefs;
+}
+
+
+int Cortex_FreeBodyDefs(sBodyDefs* pBodyDefs)
+{
+	if (pBodyDefs == nullptr)
+	{
+		return RC_GeneralError;
+	}
+
+	for (int aIdx = 0; aIdx < pBodyDefs->nBodyDefs; aIdx++)
+	{
+		sBodyDef& refDef = pBodyDefs->BodyDefs[aIdx];
+		delete[] refDef.szName;
+		for (int mIdx = 0; mIdx < refDef.nMarkers; mIdx++)
+		{
+			delete[] refDef.szMarkerNames[mIdx];
+		}
+		delete[] refDef.szMarkerNames;
+		for (int sIdx = 0; sIdx < refDef.Hierarchy.nSegments; sIdx++)
+		{
+			delete[] refDef.Hierarchy.szSegmentNames[sIdx];
+		}
+		delete[] refDef.Hierarchy.szSegmentNames;
+		delete[] refDef.Hierarchy.iParents;
+	}
+	delete pBodyDefs;
+	return RC_Okay;
+}
+
+
+sFrameOfData* Cortex_GetCurrentFrame()
+{
+	std::lock_guard<std::mutex> lock(mtxScene);
+	if (pFrame == nullptr)
+	{
+		return nullptr;
+	}
+
+	// deep copy of the latest frame, released by Cortex_FreeFrame(...)
+	sFrameOfData* pCopy = new sFrameOfData;
+	allocateFrame(*pCopy, pFrame->nBodies);
+	pCopy->iFrame = pFrame->iFrame;
+	pCopy->fDelay = pFrame->fDelay;
+	for (int aIdx = 0; aIdx < pFrame->nBodies; aIdx++)
+	{
+		const sBodyData& refSrc = pFrame->BodyData[aIdx];
+		sBodyData&       refDst = pCopy->BodyData[aIdx];
+		memcpy(refDst.Markers,  refSrc.Markers,  refSrc.nMarkers  * sizeof(tMarkerData));
+		memcpy(refDst.Segments, refSrc.Segments, refSrc.nSegments * sizeof(tSegmentData));
+	}
+	memcpy(pCopy->UnidentifiedMarkers, pFrame->UnidentifiedMarkers, pFrame->nUnidentifiedMarkers * sizeof(tMarkerData));
+	return pCopy;
+}
+
+
+int Cortex_FreeFrame(sFrameOfData* pFrameOfData)
+{
+	if (pFrameOfData == nullptr)
+	{
+		return RC_GeneralError;
+	}
+
+	releaseFrame(*pFrameOfData);
+	delete pFrameOfData;
+	return RC_Okay;
+}
+
+
+#endif // #ifdef USE_CORTEX_EMULATOR
@@ -0,0 +1,63 @@
+/**
+ * Emulator of the Cortex SDK entry points used by MoCapCortex, producing synthetic data.
+ * Replaces Cortex_SDK.lib when USE_CORTEX_EMULATOR is defined in Config.h,
+ * so that the Cortex data path can be profiled and tested without a Cortex host.
+ * Only synthetic scenes are produced, recorded Cortex sessions cannot be replayed.
+ */
+
+#pragma once
+
+#include "Config.h"
+
+#ifdef USE_CORTEX_EMULATOR
+
+#include <string>
+
+
+/**
+ * Parameters of the synthetic scene produced by the Cortex emulator.
+ */
+struct CortexEmulatorSettings
+{
+	int   nActors;              // amount of actors
+	int   nSegments;            // segments per actor (1: actors are rigid bodies)
+	int   nMarkers;             // markers per actor
+	int   nUnidentifiedMarkers; // unidentified markers per frame
+	float frameRate;            // frames per second
+	int   sceneChangeInterval;  // frames between adding/removing the last actor (0: constant scene)
+
+	CortexEmulatorSettings() :
+		nActors(4),
+		nSegments(20),
+		nMarkers(40),
+		nUnidentifiedMarkers(10),
+		frameRate(100),
+		sceneChangeInterval(0)
+	{
+		// nothing else to do
+	}
+};
+
+
+/**
+ * Parses emulator settings in the format
+ * "<actors>,<segments>,<markers>,<unidentified markers>,<frame rate>[,<scene change interval>]".
+ *
+ * @param strSettings  the settings string
+ * @param refSettings  the settings structure to fill in
+ *
+ * @return <code>true</code> if the settings were valid
+ */
+bool CortexEmulator_ParseSettings(const std::string& strSettings, CortexEmulatorSettings& refSettings);
+
+
+/**
+ * Configures the synthetic scene of the emulator.
+ * Has to be called before Cortex_Initialize(...).
+ *
+ * @param refSettings  the scene parameters
+ */
+void CortexEmulator_Configure(const CortexEmulatorSettings& refSettings);
+
+
+#endif // #ifdef USE_CORTEX_EMULATOR
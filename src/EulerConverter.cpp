@@ -0,0 +1,236 @@
+#include "EulerConverter.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define USE_SSE2
+#include <emmintrin.h>
+#endif
+
+
+// constants for the half angle sine/cosine approximation
+static const float DEG_TO_HALF_RAD = 3.14159265358979f / 360.0f;
+static const float TWO_OVER_PI     = 0.636619772367581f;
+static const float PIO2_HI         = 1.5707963705062866f;    // pi/2 split into two parts
+static const float PIO2_LO         = -4.371139000186243e-08f; // for accurate range reduction
+static const float SIN_C1          = -1.6666654611e-1f;       // minimax polynomial coefficients
+static const float SIN_C2          =  8.3321608736e-3f;       // for sin(x) on [-pi/4, pi/4]
+static const float SIN_C3          = -1.9515295891e-4f;
+static const float COS_C1          =  4.166664568298827e-2f;  // minimax polynomial coefficients
+static const float COS_C2          = -1.388731625493765e-3f;  // for cos(x) on [-pi/4, pi/4]
+static const float COS_C3          =  2.443315711809948e-5f;
+
+
+static const char* EULER_ORDER_NAMES[] = { "XYZ", "XZY", "YXZ", "YZX", "ZXY", "ZYX" };
+
+// axis indices (0: X, 1: Y, 2: Z) of the three factors of the quaternion product per order
+static const int EULER_ORDER_AXES[][3] =
+{
+	{ 0, 1, 2 }, { 0, 2, 1 }, { 1, 0, 2 }, { 1, 2, 0 }, { 2, 0, 1 }, { 2, 1, 0 }
+};
+
+
+bool parseEulerOrder(const std::string& strName, EulerOrder& refOrder)
+{
+	std::string strUpperCase;
+	std::transform(strName.begin(), strName.end(), std::back_inserter(strUpperCase), ::toupper);
+
+	for (int idx = 0; idx < 6; idx++)
+	{
+		if (strUpperCase == EULER_ORDER_NAMES[idx])
+		{
+			refOrder = (EulerOrder) idx;
+			return true;
+		}
+	}
+	return false;
+}
+
+
+const char* getEulerOrderName(EulerOrder order)
+{
+	return EULER_ORDER_NAMES[order];
+}
+
+
+/**
+ * Scalar version of the half angle sine/cosine calculation.
+ * Uses the same range reduction and polynomials as the SSE2 version,
+ * so that results do not depend on the position of an angle in the batch.
+ */
+static void calculateHalfAngleSinCosScalar(float degrees, float& refSin, float& refCos)
+{
+	float   x = degrees * DEG_TO_HALF_RAD;
+	int32_t j = (int32_t) (x * TWO_OVER_PI + (x < 0 ? -0.5f : 0.5f)); // round to nearest quadrant
+	float   r = (x - j * PIO2_HI) - j * PIO2_LO;
+	float   r2 = r * r;
+
+	float s = r + r * r2 * (SIN_C1 + r2 * (SIN_C2 + r2 * SIN_C3));
+	float c = 1.0f - 0.5f * r2 + r2 * r2 * (COS_C1 + r2 * (COS_C2 + r2 * COS_C3));
+
+	// select and correct the sign per quadrant
+	switch (j & 3)
+	{
+		case 0: refSin =  s; refCos =  c; break;
+		case 1: refSin =  c; refCos = -s; break;
+		case 2: refSin = -s; refCos = -c; break;
+		case 3: refSin = -c; refCos =  s; break;
+	}
+}
+
+
+void calculateHalfAngleSinCos(const float* pDegrees, float* pSin, float* pCos, size_t count)
+{
+	size_t idx = 0;
+
+#ifdef USE_SSE2
+	const __m128  vDegToHalfRad = _mm_set1_ps(DEG_TO_HALF_RAD);
+	const __m128  vTwoOverPi    = _mm_set1_ps(TWO_OVER_PI);
+	const __m128  vPio2Hi       = _mm_set1_ps(PIO2_HI);
+	const __m128  vPio2Lo       = _mm_set1_ps(PIO2_LO);
+	const __m128  vOne          = _mm_set1_ps(1.0f);
+	const __m128  vHalf         = _mm_set1_ps(0.5f);
+	const __m128i vIntOne       = _mm_set1_epi32(1);
+	const __m128i vIntTwo       = _mm_set1_epi32(2);
+
+	for (; idx + 4 <= count; idx += 4)
+	{
+		__m128  x  = _mm_mul_ps(_mm_loadu_ps(pDegrees + idx), vDegToHalfRad);
+		__m128i j  = _mm_cvtps_epi32(_mm_mul_ps(x, vTwoOverPi)); // round to nearest quadrant
+		__m128  fj = _mm_cvtepi32_ps(j);
+		__m128  r  = _mm_sub_ps(_mm_sub_ps(x, _mm_mul_ps(fj, vPio2Hi)), _mm_mul_ps(fj, vPio2Lo));
+		__m128  r2 = _mm_mul_ps(r, r);
+
+		__m128 s = _mm_add_ps(_mm_set1_ps(SIN_C2), _mm_mul_ps(r2, _mm_set1_ps(SIN_C3)));
+		s = _mm_add_ps(_mm_set1_ps(SIN_C1), _mm_mul_ps(r2, s));
+		s = _mm_add_ps(r, _mm_mul_ps(_mm_mul_ps(r, r2), s));
+
+		__m128 c = _mm_add_ps(_mm_set1_ps(COS_C2), _mm_mul_ps(r2, _mm_set1_ps(COS_C3)));
+		c = _mm_add_ps(_mm_set1_ps(COS_C1), _mm_mul_ps(r2, c));
+		c = _mm_add_ps(_mm_sub_ps(vOne, _mm_mul_ps(vHalf, r2)), _mm_mul_ps(_mm_mul_ps(r2, r2), c));
+
+		// odd quadrants swap sine and cosine
+		__m128 swap = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(j, vIntOne), vIntOne));
+		__m128 sinV = _mm_or_ps(_mm_and_ps(swap, c), _mm_andnot_ps(swap, s));
+		__m128 cosV = _mm_or_ps(_mm_and_ps(swap, s), _mm_andnot_ps(swap, c));
+
+		// sine is negative in quadrants 2 and 3, cosine in quadrants 1 and 2
+		__m128 sinSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(j, vIntTwo), 30));
+		__m128 cosSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(_mm_add_epi32(j, vIntOne), vIntTwo), 30));
+
+		_mm_storeu_ps(pSin + idx, _mm_xor_ps(sinV, sinSign));
+		_mm_storeu_ps(pCos + idx, _mm_xor_ps(cosV, cosSign));
+	}
+#endif
+
+	// remaining angles (or all of them without SSE2)
+	for (; idx < count; idx++)
+	{
+		calculateHalfAngleSinCosScalar(pDegrees[idx], pSin[idx], pCos[idx]);
+	}
+}
+
+
+
+/******************************************************************************
+ * EulerConverter class
+ */
+
+EulerConverter::EulerConverter() :
+	order(ZYX)
+{
+	// nothing else to do
+}
+
+
+EulerOrder EulerConverter::getOrder() const
+{
+	return order;
+}
+
+
+void EulerConverter::setOrder(EulerOrder _order)
+{
+	order = _order;
+}
+
+
+void EulerConverter::clear()
+{
+	for (int axis = 0; axis < 3; axis++)
+	{
+		angles[axis].clear();
+	}
+}
+
+
+size_t EulerConverter::add(float angleX, float angleY, float angleZ)
+{
+	angles[0].push_back(angleX);
+	angles[1].push_back(angleY);
+	angles[2].push_back(angleZ);
+	return angles[0].size() - 1;
+}
+
+
+size_t EulerConverter::size() const
+{
+	return angles[0].size();
+}
+
+
+void EulerConverter::convert()
+{
+	const size_t count = size();
+
+	// resize() only allocates while the amount of angles grows
+	for (int axis = 0; axis < 3; axis++)
+	{
+		sinHalf[axis].resize(count);
+		cosHalf[axis].resize(count);
+		calculateHalfAngleSinCos(angles[axis].data(), sinHalf[axis].data(), cosHalf[axis].data(), count);
+	}
+	for (int comp = 0; comp < 4; comp++)
+	{
+		quat[comp].resize(count);
+	}
+
+	// q = qA * qB * qC with A, B, C being the axes in the order of the product.
+	// Expanding the product results in the same terms for all orders,
+	// only the sign of the sinA*sinB*sinC terms depends on the parity of the order.
+	const int   axisA = EULER_ORDER_AXES[order][0];
+	const int   axisB = EULER_ORDER_AXES[order][1];
+	const int   axisC = EULER_ORDER_AXES[order][2];
+	const float sign  = ((order == XYZ) || (order == YZX) || (order == ZXY)) ? -1.0f : 1.0f;
+
+	const float* pSinA = sinHalf[axisA].data(); const float* pCosA = cosHalf[axisA].data();
+	const float* pSinB = sinHalf[axisB].data(); const float* pCosB = cosHalf[axisB].data();
+	const float* pSinC = sinHalf[axisC].data(); const float* pCosC = cosHalf[axisC].data();
+	float*       pQA   = quat[axisA].data();
+	float*       pQB   = quat[axisB].data();
+	float*       pQC   = quat[axisC].data();
+	float*       pQW   = quat[3].data();
+
+	for (size_t idx = 0; idx < count; idx++)
+	{
+		const float sA = pSinA[idx], cA = pCosA[idx];
+		const float sB = pSinB[idx], cB = pCosB[idx];
+		const float sC = pSinC[idx], cC = pCosC[idx];
+
+		pQW[idx] = cA * cB * cC + sign * sA * sB * sC;
+		pQA[idx] = sA * cB * cC - sign * cA * sB * sC;
+		pQB[idx] = cA * sB * cC + sign * sA * cB * sC;
+		pQC[idx] = cA * cB * sC - sign * sA * sB * cC;
+	}
+}
+
+
+void EulerConverter::getQuaternion(size_t idx, float& qx, float& qy, float& qz, float& qw) const
+{
+	qx = quat[0][idx];
+	qy = quat[1][idx];
+	qz = quat[2][idx];
+	qw = quat[3][idx];
+}
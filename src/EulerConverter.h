@@ -0,0 +1,128 @@
+/**
+ * Batch conversion of Euler angles to quaternions.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+
+/**
+ * Rotation orders for Euler angles.
+ * The name lists the axes in the order of the quaternion product,
+ * e.g., ZYX results in q = qZ * qY * qX (the Cortex default).
+ */
+enum EulerOrder
+{
+	XYZ, XZY, YXZ, YZX, ZXY, ZYX
+};
+
+
+/**
+ * Parses the name of a rotation order, e.g., "ZYX".
+ *
+ * @param strName   the name of the rotation order (not case sensitive)
+ * @param refOrder  the rotation order to fill in
+ *
+ * @return <code>true</code> if the name was valid
+ */
+bool parseEulerOrder(const std::string& strName, EulerOrder& refOrder);
+
+
+/**
+ * Gets the name of a rotation order.
+ *
+ * @param order  the rotation order
+ *
+ * @return the name of the rotation order, e.g., "ZYX"
+ */
+const char* getEulerOrderName(EulerOrder order);
+
+
+/**
+ * Calculates sine and cosine of half the given angles in one vectorised pass.
+ *
+ * @param pDegrees  array of angles in degrees
+ * @param pSin      array to receive sin(angle / 2)
+ * @param pCos      array to receive cos(angle / 2)
+ * @param count     the number of angles
+ */
+void calculateHalfAngleSinCos(const float* pDegrees, float* pSin, float* pCos, size_t count);
+
+
+/**
+ * Class for converting many sets of Euler angles to quaternions at once.
+ * The angles are collected as structure-of-arrays, converted in a single pass,
+ * and the buffers are kept between frames so that conversions do not allocate memory.
+ */
+class EulerConverter
+{
+public:
+
+	/**
+	 * Creates an Euler angle converter with the ZYX rotation order.
+	 */
+	EulerConverter();
+
+	/**
+	 * Gets the rotation order of the converter.
+	 *
+	 * @return the rotation order
+	 */
+	EulerOrder getOrder() const;
+
+	/**
+	 * Sets the rotation order of the converter.
+	 *
+	 * @param order  the new rotation order
+	 */
+	void setOrder(EulerOrder order);
+
+	/**
+	 * Removes all angles from the converter (but keeps the allocated memory).
+	 */
+	void clear();
+
+	/**
+	 * Adds a set of Euler angles to convert.
+	 *
+	 * @param angleX  rotation around the X axis in degrees
+	 * @param angleY  rotation around the Y axis in degrees
+	 * @param angleZ  rotation around the Z axis in degrees
+	 *
+	 * @return the index of the angle set
+	 */
+	size_t add(float angleX, float angleY, float angleZ);
+
+	/**
+	 * Gets the amount of angle sets in the converter.
+	 *
+	 * @return the amount of angle sets
+	 */
+	size_t size() const;
+
+	/**
+	 * Converts all angle sets to quaternions.
+	 */
+	void convert();
+
+	/**
+	 * Gets a converted quaternion.
+	 *
+	 * @param idx  the index of the angle set as returned by add(...)
+	 * @param qx   the X component of the quaternion
+	 * @param qy   the Y component of the quaternion
+	 * @param qz   the Z component of the quaternion
+	 * @param qw   the W component of the quaternion
+	 */
+	void getQuaternion(size_t idx, float& qx, float& qy, float& qz, float& qw) const;
+
+private:
+
+	EulerOrder         order;
+	std::vector<float> angles[3];  // input angles in degrees per axis
+	std::vector<float> sinHalf[3]; // sine of the half angles per axis
+	std::vector<float> cosHalf[3]; // cosine of the half angles per axis
+	std::vector<float> quat[4];    // resulting quaternion components x, y, z, w
+};
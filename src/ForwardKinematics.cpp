@@ -0,0 +1,304 @@
+#include "ForwardKinematics.h"
+
+#include "Logging.h"
+#include "Portability.h"
+#undef   LOG_CLASS
+#define  LOG_CLASS "ForwardKinematics"
+
+#include "VectorMath.h"
+
+#include <algorithm>
+#include <cstring>
+
+
+#define WORLD_SKELETON_SUFFIX    "_World"
+#define WORLD_SKELETON_ID_OFFSET 1000 // world space skeleton ID = source skeleton ID + offset
+
+
+/**
+ * Checks if a skeleton is a world space skeleton already, e.g., when reading a recorded file.
+ */
+static bool isWorldSkeleton(const sSkeletonDescription& refDescr)
+{
+	size_t nameLength   = strlen(refDescr.szName);
+	size_t suffixLength = strlen(WORLD_SKELETON_SUFFIX);
+	return (nameLength >= suffixLength) && (strcmp(refDescr.szName + nameLength - suffixLength, WORLD_SKELETON_SUFFIX) == 0);
+}
+
+
+/******************************************************************************
+ * ForwardKinematics class
+ */
+
+ForwardKinematics::ForwardKinematics() :
+	sceneVersion(-1),
+	nSourceSkeletons(-1),
+	added(false)
+{
+	// nothing else to do
+}
+
+
+bool ForwardKinematics::needsUpdate(const MoCapData& refData) const
+{
+	// the world space skeletons might still be part of the frame
+	int nSkeletons = refData.frame.nSkeletons - (added ? (int)worldSkeletons.size() : 0);
+	if ((refData.sceneVersion != sceneVersion) || (nSkeletons != nSourceSkeletons))
+	{
+		return true;
+	}
+
+	// skeleton data might have been reallocated without a new scene version
+	for (size_t wIdx = 0; wIdx < boneSkeleton.size(); wIdx++)
+	{
+		if (refData.frame.Skeletons[boneSkeleton[wIdx]].nRigidBodies <= boneIndex[wIdx])
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+
+void ForwardKinematics::updateDescriptions(MoCapData& refData)
+{
+	// the world space skeleton data must not be part of the frame while the sources are determined
+	removeWorldSkeletonData(refData);
+	removeDescriptions(refData);
+
+	rebuild(refData);
+
+	// append to the scene description (space has been checked in rebuild)
+	sDataDescriptions& refDescr = refData.description;
+	for (size_t wIdx = 0; wIdx < worldDescriptions.size(); wIdx++)
+	{
+		sDataDescription& refBlock = refDescr.arrDataDescriptions[refDescr.nDataDescriptions++];
+		refBlock.type = Descriptor_Skeleton;
+		refBlock.Data.SkeletonDescription = &worldDescriptions[wIdx];
+	}
+}
+
+
+void ForwardKinematics::addWorldSkeletonData(MoCapData& refData)
+{
+	// without matching descriptions, the bones of the frame cannot be assigned
+	if (added || worldSkeletons.empty() || needsUpdate(refData)) return;
+
+	calculate(refData);
+
+	// append to the frame (space has been checked in rebuild)
+	sFrameOfMocapData& refFrame = refData.frame;
+	for (size_t wIdx = 0; wIdx < worldSkeletons.size(); wIdx++)
+	{
+		refFrame.Skeletons[refFrame.nSkeletons++] = worldSkeletons[wIdx];
+	}
+	added = true;
+}
+
+
+void ForwardKinematics::removeWorldSkeletonData(MoCapData& refData)
+{
+	if (!added) return;
+
+	// the world space skeletons are always the last entries of the frame
+	for (size_t wIdx = 0; wIdx < worldSkeletons.size(); wIdx++)
+	{
+		sSkeletonData& refSkeleton = refData.frame.Skeletons[--refData.frame.nSkeletons];
+		refSkeleton.nRigidBodies  = 0;
+		refSkeleton.RigidBodyData = nullptr;
+	}
+	added = false;
+}
+
+
+void ForwardKinematics::removeWorldSkeletons(MoCapData& refData)
+{
+	removeWorldSkeletonData(refData);
+	removeDescriptions(refData);
+	worldDescriptions.clear();
+	worldSkeletons.clear();
+	worldBones.clear();
+	boneOrder.clear();
+	boneSkeleton.clear();
+	boneIndex.clear();
+	boneParent.clear();
+	sceneVersion     = -1;
+	nSourceSkeletons = -1;
+}
+
+
+void ForwardKinematics::removeDescriptions(MoCapData& refData)
+{
+	if (worldDescriptions.empty()) return;
+
+	// other descriptions might have been appended after the world space skeletons
+	sDataDescriptions&          refDescr = refData.description;
+	const sSkeletonDescription* pFirst   = worldDescriptions.data();
+	const sSkeletonDescription* pLast    = pFirst + worldDescriptions.size();
+	int                         nKept    = 0;
+	for (int dIdx = 0; dIdx < refDescr.nDataDescriptions; dIdx++)
+	{
+		sDataDescription& refBlock = refDescr.arrDataDescriptions[dIdx];
+		if ((refBlock.type == Descriptor_Skeleton) &&
+		    (refBlock.Data.SkeletonDescription >= pFirst) && (refBlock.Data.SkeletonDescription < pLast))
+		{
+			continue;
+		}
+		refDescr.arrDataDescriptions[nKept++] = refBlock;
+	}
+	for (int dIdx = nKept; dIdx < refDescr.nDataDescriptions; dIdx++)
+	{
+		refDescr.arrDataDescriptions[dIdx].Data.SkeletonDescription = nullptr;
+	}
+	refDescr.nDataDescriptions = nKept;
+}
+
+
+void ForwardKinematics::rebuild(const MoCapData& refData)
+{
+	const sFrameOfMocapData& refFrame = refData.frame;
+
+	sceneVersion     = refData.sceneVersion;
+	nSourceSkeletons = refFrame.nSkeletons;
+
+	// find the skeletons that can be converted and the amount of bones
+	int maxWorldSkeletons = std::min(MAX_SKELETONS - refFrame.nSkeletons, MAX_MODELS - refData.description.nDataDescriptions);
+	std::vector<int> sourceSkeletons;
+	int nBones = 0;
+	for (int sIdx = 0; sIdx < refFrame.nSkeletons; sIdx++)
+	{
+		const sSkeletonData&  refSkeleton = refFrame.Skeletons[sIdx];
+		sSkeletonDescription* pDescr      = refData.findSkeletonDescription(refSkeleton);
+		if ((pDescr == nullptr) || (refSkeleton.RigidBodyData == nullptr) ||
+		    (refSkeleton.nRigidBodies != pDescr->nRigidBodies) || isWorldSkeleton(*pDescr))
+		{
+			continue;
+		}
+		if ((int)sourceSkeletons.size() >= maxWorldSkeletons)
+		{
+			LOG_WARNING("Not enough space for world space skeletons");
+			break;
+		}
+		sourceSkeletons.push_back(sIdx);
+		nBones += refSkeleton.nRigidBodies;
+	}
+
+	int nWorldSkeletons = (int)sourceSkeletons.size();
+	worldDescriptions.assign(nWorldSkeletons, sSkeletonDescription());
+	worldSkeletons.assign(nWorldSkeletons, sSkeletonData());
+	worldBones.assign(nBones, sRigidBodyData());
+	boneOrder.clear();
+	boneSkeleton.clear();
+	boneIndex.clear();
+	boneParent.clear();
+
+	int firstBone = 0;
+	for (int wIdx = 0; wIdx < nWorldSkeletons; wIdx++)
+	{
+		int                         sIdx        = sourceSkeletons[wIdx];
+		const sSkeletonData&        refSkeleton = refFrame.Skeletons[sIdx];
+		const sSkeletonDescription& refSource   = *refData.findSkeletonDescription(refSkeleton);
+		int                         nSkelBones  = refSkeleton.nRigidBodies;
+
+		// description: same bones, but without hierarchy
+		sSkeletonDescription& refDescr = worldDescriptions[wIdx];
+		sprintf_s(refDescr.szName, sizeof(refDescr.szName), "%s%s", refSource.szName, WORLD_SKELETON_SUFFIX);
+		refDescr.skeletonID   = refSource.skeletonID + WORLD_SKELETON_ID_OFFSET;
+		refDescr.nRigidBodies = nSkelBones;
+
+		sSkeletonData& refWorldData = worldSkeletons[wIdx];
+		refWorldData.skeletonID    = refDescr.skeletonID;
+		refWorldData.nRigidBodies  = nSkelBones;
+		refWorldData.RigidBodyData = &worldBones[firstBone];
+
+		// parent bone index and depth of each bone
+		std::vector<int> parent(nSkelBones, -1);
+		std::vector<int> depth(nSkelBones, 0);
+		for (int bIdx = 0; bIdx < nSkelBones; bIdx++)
+		{
+			const sRigidBodyDescription& refBone      = refSource.RigidBodies[bIdx];
+			sRigidBodyDescription&       refWorldBone = refDescr.RigidBodies[bIdx];
+			refWorldBone = refBone;
+			refWorldBone.parentID = -1;
+			refWorldBone.offsetx  = 0;
+			refWorldBone.offsety  = 0;
+			refWorldBone.offsetz  = 0;
+
+			refWorldData.RigidBodyData[bIdx].ID = refBone.ID;
+
+			for (int pIdx = 0; pIdx < nSkelBones; pIdx++)
+			{
+				if ((pIdx != bIdx) && (refSource.RigidBodies[pIdx].ID == refBone.parentID))
+				{
+					parent[bIdx] = pIdx;
+					break;
+				}
+			}
+		}
+		for (int bIdx = 0; bIdx < nSkelBones; bIdx++)
+		{
+			// limit the search in case of cyclic parent definitions
+			for (int pIdx = parent[bIdx]; (pIdx >= 0) && (depth[bIdx] < nSkelBones); pIdx = parent[pIdx])
+			{
+				depth[bIdx]++;
+			}
+		}
+
+		// calculation order: parents before children
+		std::vector<int> order(nSkelBones);
+		for (int bIdx = 0; bIdx < nSkelBones; bIdx++) order[bIdx] = bIdx;
+		std::stable_sort(order.begin(), order.end(), [&depth](int a, int b) { return depth[a] < depth[b]; });
+
+		for (int oIdx = 0; oIdx < nSkelBones; oIdx++)
+		{
+			int bIdx = order[oIdx];
+			boneOrder.push_back(firstBone + bIdx);
+			boneSkeleton.push_back(sIdx);
+			boneIndex.push_back(bIdx);
+			boneParent.push_back((parent[bIdx] >= 0 && depth[parent[bIdx]] < depth[bIdx]) ? firstBone + parent[bIdx] : -1);
+		}
+
+		firstBone += nSkelBones;
+	}
+
+	LOG_INFO("Created " << nWorldSkeletons << " world space skeletons with " << nBones << " bones");
+}
+
+
+void ForwardKinematics::calculate(const MoCapData& refData)
+{
+	const sFrameOfMocapData& refFrame = refData.frame;
+
+	for (size_t oIdx = 0; oIdx < boneOrder.size(); oIdx++)
+	{
+		const sRigidBodyData& refLocal = refFrame.Skeletons[boneSkeleton[oIdx]].RigidBodyData[boneIndex[oIdx]];
+		sRigidBodyData&       refWorld = worldBones[boneOrder[oIdx]];
+
+		Quaternion rotation;
+		rotation.x = refLocal.qx; rotation.y = refLocal.qy; rotation.z = refLocal.qz; rotation.w = refLocal.qw;
+		Vector3D position(refLocal.x, refLocal.y, refLocal.z);
+
+		int parentIdx = boneParent[oIdx];
+		if (parentIdx >= 0)
+		{
+			// world = parent * local
+			const sRigidBodyData& refParent = worldBones[parentIdx];
+			Quaternion parentRotation;
+			parentRotation.x = refParent.qx; parentRotation.y = refParent.qy; parentRotation.z = refParent.qz; parentRotation.w = refParent.qw;
+
+			Vector3D offset = parentRotation.rotate(position);
+			position.set(refParent.x + offset.x, refParent.y + offset.y, refParent.z + offset.z);
+			rotation = parentRotation.mult(rotation);
+		}
+
+		refWorld.x  = position.x;
+		refWorld.y  = position.y;
+		refWorld.z  = position.z;
+		refWorld.qx = rotation.x;
+		refWorld.qy = rotation.y;
+		refWorld.qz = rotation.z;
+		refWorld.qw = rotation.w;
+		refWorld.MeanError = refLocal.MeanError; // "abused" for bone length
+		refWorld.params    = refLocal.params;
+	}
+}
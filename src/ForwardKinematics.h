@@ -0,0 +1,89 @@
+/**
+ * Class for calculating world space poses of hierarchical skeletons.
+ * The results are added to the scene as additional skeletons with the suffix "_World",
+ * so that clients do not need to calculate the forward kinematics themselves.
+ */
+
+#pragma once
+
+#include "MoCapData.h"
+
+#include <vector>
+
+
+class ForwardKinematics
+{
+public:
+
+	ForwardKinematics();
+
+	/**
+	 * Checks if the world space skeleton descriptions do not match the scene any more.
+	 *
+	 * @param refData  the MoCap data with the hierarchical skeletons
+	 *
+	 * @return <code>true</code> if updateDescriptions(...) has to be called
+	 */
+	bool needsUpdate(const MoCapData& refData) const;
+
+	/**
+	 * Replaces the world space skeleton descriptions in the scene description
+	 * by ones that match the hierarchical skeletons of the current scene.
+	 * The descriptions stay in the scene until the next update,
+	 * so the server lock for the scene description has to be held while calling this method.
+	 *
+	 * @param refData  the MoCap data to add the world space skeleton descriptions to
+	 */
+	void updateDescriptions(MoCapData& refData);
+
+	/**
+	 * Calculates the world space poses from the hierarchical skeletons of the current frame
+	 * and appends them to the frame data.
+	 *
+	 * @param refData  the MoCap data to add the world space skeleton data to
+	 */
+	void addWorldSkeletonData(MoCapData& refData);
+
+	/**
+	 * Removes the world space skeletons from the frame data
+	 * before the MoCap system updates the frame again.
+	 *
+	 * @param refData  the MoCap data to remove the world space skeleton data from
+	 */
+	void removeWorldSkeletonData(MoCapData& refData);
+
+	/**
+	 * Removes the world space skeletons from the scene description and the frame data,
+	 * e.g., before the MoCap data is released.
+	 *
+	 * @param refData  the MoCap data to remove the world space skeletons from
+	 */
+	void removeWorldSkeletons(MoCapData& refData);
+
+private:
+
+	// removes the world space skeleton descriptions from the scene description
+	void removeDescriptions(MoCapData& refData);
+
+	// creates the world space skeleton descriptions and the bone calculation order
+	void rebuild(const MoCapData& refData);
+
+	// calculates the world space poses of all bones
+	void calculate(const MoCapData& refData);
+
+private:
+
+	int                               sceneVersion;
+	int                               nSourceSkeletons;
+	bool                              added;
+
+	std::vector<sSkeletonDescription> worldDescriptions;
+	std::vector<sSkeletonData>        worldSkeletons;
+	std::vector<sRigidBodyData>       worldBones;
+
+	// per world bone in calculation order (parents before children, batched across all skeletons)
+	std::vector<int>                  boneOrder;       // index into worldBones
+	std::vector<int>                  boneSkeleton;    // index of the source skeleton in the frame
+	std::vector<int>                  boneIndex;       // index of the bone in the source skeleton
+	std::vector<int>                  boneParent;      // index of the parent into worldBones (-1: root)
+};
@@ -1,18 +1,39 @@
 #include "InteractionSystem.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
 #include "Logging.h"
 #undef   LOG_CLASS
 #define  LOG_CLASS "InteractionSystem"
 
 
+static const double CLOCK_RESYNC_THRESHOLD = 0.5;  // clock offset change in seconds that is considered a timestamp jump
+static const double CLOCK_DRIFT_ADAPTATION = 0.01; // rate for following an increasing clock offset
+static const int    TELEMETRY_INTERVAL     = 10;   // seconds between battery and signal strength queries
+
+
 /******************************************************************************
  * InteractionDevice class
  */
 
 InteractionDevice::InteractionDevice(const std::string& name) :
-	m_deviceName(name)
+	m_deviceName(name),
+	m_sequence(0),
+	m_sampleWriteIdx(0),
+	m_sampleReadIdx(0),
+	m_droppedSamples(0),
+	m_handledDrops(0),
+	m_historyCount(0),
+	m_lastFrameTime(0)
 {
-	// nothing else to do
+	for (auto& value : m_arrPublishedValues)
+	{
+		value.store(0.0f, std::memory_order_relaxed);
+	}
+	memset(m_arrFrameValues, 0, sizeof(m_arrFrameValues));
 }
 
 
@@ -34,6 +55,159 @@ const std::vector<Channel>& InteractionDevice::getChannels() const
 }
 
 
+void InteractionDevice::getValues(float* pValues) const
+{
+	size_t   nValues = (m_arrChannels.size() < MAX_ANALOG_CHANNELS) ? m_arrChannels.size() : MAX_ANALOG_CHANNELS;
+	uint32_t seqStart, seqEnd;
+	do
+	{
+		seqStart = m_sequence.load(std::memory_order_acquire);
+		for (size_t idx = 0; idx < nValues; idx++)
+		{
+			pValues[idx] = m_arrPublishedValues[idx].load(std::memory_order_relaxed);
+		}
+		std::atomic_thread_fence(std::memory_order_acquire);
+		seqEnd = m_sequence.load(std::memory_order_relaxed);
+	}
+	while ((seqStart & 1) || (seqStart != seqEnd)); // sample was being published > read again
+}
+
+
+void InteractionDevice::publishValues()
+{
+	size_t   nValues  = (m_arrChannels.size() < MAX_ANALOG_CHANNELS) ? m_arrChannels.size() : MAX_ANALOG_CHANNELS;
+	uint32_t sequence = m_sequence.load(std::memory_order_relaxed);
+
+	m_sequence.store(sequence + 1, std::memory_order_relaxed); // odd: publishing
+	std::atomic_thread_fence(std::memory_order_release);
+	for (size_t idx = 0; idx < nValues; idx++)
+	{
+		m_arrPublishedValues[idx].store(m_arrChannels[idx].value, std::memory_order_relaxed);
+	}
+	m_sequence.store(sequence + 2, std::memory_order_release); // even: published
+
+	// queue sample for the next frame
+	uint32_t writeIdx = m_sampleWriteIdx.load(std::memory_order_relaxed);
+	if (writeIdx - m_sampleReadIdx.load(std::memory_order_acquire) >= SAMPLE_QUEUE_SIZE)
+	{
+		// nobody is collecting the samples > drop (getValues() still has the latest values)
+		m_droppedSamples.fetch_add(1, std::memory_order_relaxed);
+	}
+	else
+	{
+		sSample& refSample = m_arrSamples[writeIdx % SAMPLE_QUEUE_SIZE];
+		refSample.timestamp = getLocalTime();
+		for (size_t idx = 0; idx < nValues; idx++)
+		{
+			refSample.values[idx] = m_arrChannels[idx].value;
+		}
+		m_sampleWriteIdx.store(writeIdx + 1, std::memory_order_release);
+	}
+}
+
+
+void InteractionDevice::getSamples(sForcePlateData& refData, double frameTime)
+{
+	size_t nValues = (m_arrChannels.size() < MAX_ANALOG_CHANNELS) ? m_arrChannels.size() : MAX_ANALOG_CHANNELS;
+
+	// move the queued samples into the history
+	uint32_t readIdx  = m_sampleReadIdx.load(std::memory_order_relaxed);
+	uint32_t writeIdx = m_sampleWriteIdx.load(std::memory_order_acquire);
+	while (readIdx != writeIdx)
+	{
+		if (m_historyCount == HISTORY_SIZE)
+		{
+			// history is full > forget the oldest sample
+			std::copy(m_arrHistory + 1, m_arrHistory + m_historyCount, m_arrHistory);
+			m_historyCount--;
+		}
+		m_arrHistory[m_historyCount] = m_arrSamples[readIdx % SAMPLE_QUEUE_SIZE];
+		m_historyCount++;
+		readIdx++;
+	}
+	m_sampleReadIdx.store(readIdx, std::memory_order_release);
+
+	// when the latest samples were dropped, add the latest values so that the state does not become stale
+	uint32_t droppedSamples = m_droppedSamples.load(std::memory_order_relaxed);
+	if ((droppedSamples != m_handledDrops) && (m_historyCount < HISTORY_SIZE))
+	{
+		sSample& refSample = m_arrHistory[m_historyCount];
+		refSample.timestamp = getLocalTime();
+		getValues(refSample.values);
+		m_historyCount++;
+		m_handledDrops = droppedSamples;
+	}
+
+	// find the samples since the last frame (idxFirst...idxEnd-1)
+	int idxFirst = 0;
+	while ((idxFirst < m_historyCount) && (m_arrHistory[idxFirst].timestamp <= m_lastFrameTime)) { idxFirst++; }
+	int idxEnd = idxFirst;
+	while ((idxEnd < m_historyCount) && (m_arrHistory[idxEnd].timestamp <= frameTime)) { idxEnd++; }
+	if (idxEnd - idxFirst > MAX_ANALOG_SUBFRAMES)
+	{
+		// more samples than sub-frames > skip the oldest ones
+		idxFirst = idxEnd - MAX_ANALOG_SUBFRAMES;
+	}
+
+	// one sub-frame per sample
+	int nSubframes = 0;
+	for (int sIdx = idxFirst; sIdx < idxEnd; sIdx++)
+	{
+		for (size_t idx = 0; idx < nValues; idx++)
+		{
+			refData.ChannelData[idx].Values[nSubframes] = m_arrHistory[sIdx].values[idx];
+		}
+		nSubframes++;
+	}
+
+	// without new samples, the state stays the same as at the last sample or frame
+	if (nSubframes == 0)
+	{
+		const float* pValues = (idxEnd > 0) ? m_arrHistory[idxEnd - 1].values : m_arrFrameValues;
+		for (size_t idx = 0; idx < nValues; idx++)
+		{
+			refData.ChannelData[idx].Values[0] = pValues[idx];
+		}
+		nSubframes = 1;
+	}
+
+	// align the last sub-frame to the frame time by interpolating the axes towards the next sample
+	int lastSubframe = nSubframes - 1;
+	if ((idxEnd > 0) && (idxEnd < m_historyCount))
+	{
+		const sSample& refBefore = m_arrHistory[idxEnd - 1];
+		const sSample& refAfter  = m_arrHistory[idxEnd];
+		float factor = (float) ((frameTime - refBefore.timestamp) / (refAfter.timestamp - refBefore.timestamp));
+		for (size_t idx = 0; idx < nValues; idx++)
+		{
+			if (m_arrChannels[idx].type == Channel::AXIS)
+			{
+				refData.ChannelData[idx].Values[lastSubframe] =
+					refBefore.values[idx] + factor * (refAfter.values[idx] - refBefore.values[idx]);
+			}
+		}
+	}
+
+	for (size_t idx = 0; idx < nValues; idx++)
+	{
+		refData.ChannelData[idx].nFrames = nSubframes;
+		m_arrFrameValues[idx] = refData.ChannelData[idx].Values[lastSubframe];
+	}
+
+	// forget the samples before the frame, apart from the last one as start for the interpolation
+	int idxKeep = (idxEnd > 0) ? (idxEnd - 1) : 0;
+	std::copy(m_arrHistory + idxKeep, m_arrHistory + m_historyCount, m_arrHistory);
+	m_historyCount -= idxKeep;
+	m_lastFrameTime = frameTime;
+}
+
+
+double InteractionDevice::getLocalTime()
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
 
 /******************************************************************************
  * InteractionDevice_Joystick class
@@ -43,14 +217,14 @@ InteractionDevice_Joystick::InteractionDevice_Joystick(const std::string& name,
 	InteractionDevice(name),
 	m_device(refDevice)
 {
-	m_arrChannels.push_back(Channel("button1"));
-	m_arrChannels.push_back(Channel("button2"));
-	m_arrChannels.push_back(Channel("button3"));
-	m_arrChannels.push_back(Channel("button4"));
-	m_arrChannels.push_back(Channel("button5"));
-	m_arrChannels.push_back(Channel("button6"));
-	m_arrChannels.push_back(Channel("axis1"));
-	m_arrChannels.push_back(Channel("axis2"));
+	m_arrChannels.push_back(Channel("button1", Channel::BUTTON));
+	m_arrChannels.push_back(Channel("button2", Channel::BUTTON));
+	m_arrChannels.push_back(Channel("button3", Channel::BUTTON));
+	m_arrChannels.push_back(Channel("button4", Channel::BUTTON));
+	m_arrChannels.push_back(Channel("button5", Channel::BUTTON));
+	m_arrChannels.push_back(Channel("button6", Channel::BUTTON));
+	m_arrChannels.push_back(Channel("axis1",   Channel::AXIS));
+	m_arrChannels.push_back(Channel("axis2",   Channel::AXIS));
 }
 
 
@@ -96,6 +270,7 @@ bool InteractionDevice_Joystick::update(const XBeePacket_Receive& refPacket)
 			}
 			m_arrChannels[6].value = x;
 			m_arrChannels[7].value = y;
+			publishValues();
 
 			/*
 			LOG_INFO("update " << std::hex << (int) pinState << " " << btnPrimary << " " << btnSecondary
@@ -116,9 +291,18 @@ bool InteractionDevice_Joystick::update(const XBeePacket_Receive& refPacket)
  * InteractionSystem class
  */
 
-InteractionSystem::InteractionSystem(std::unique_ptr<SerialPort>& pPort)
+InteractionSystem::InteractionSystem(std::vector<std::unique_ptr<SerialPort>>& arrPorts) :
+	m_stopReceiver(false),
+	m_clockSynchronised(false),
+	m_clockOffset(0),
+	m_deviceCount(0),
+	m_describedDevices(0)
 {
-	m_pSerialPort = std::move(pPort);
+	for (auto& pPort : arrPorts)
+	{
+		m_arrSerialPorts.push_back(std::move(pPort));
+	}
+	arrPorts.clear();
 }
 
 
@@ -133,67 +317,84 @@ InteractionSystem::~InteractionSystem()
 
 bool InteractionSystem::initialise()
 {
-	if (m_pSerialPort && m_pSerialPort->open() && m_pSerialPort->isOpen())
+	for (auto& pPort : m_arrSerialPorts)
 	{
-		m_pCoordinator.reset(new XBeeCoordinator(*m_pSerialPort));
-		if (m_pCoordinator->isValid())
+		if (pPort && pPort->open() && pPort->isOpen())
 		{
-			// detect connected devices
-			LOG_INFO("Scanning for devices...");
-			m_pCoordinator->setNumberOfRetries(20);
-			m_pCoordinator->scanDevices();
-			if (!m_pCoordinator->getConnectedDevices().empty())
+			std::unique_ptr<sCoordinator> pEntry(new sCoordinator());
+			pEntry->pCoordinator.reset(new XBeeCoordinator(*pPort));
+			if (pEntry->pCoordinator->isValid())
 			{
-				std::stringstream output;
-				bool firstLine = true; // avoid unnecessary line after list
-				for each (auto& node in m_pCoordinator->getConnectedDevices())
-				{
-					if (!firstLine) output << std::endl;
-					output << " - '" << node->getName() << "': "
-						<< "Serial# " << std::hex << node->getSerialNumber()
-						<< ", Address " << std::hex << node->getNetworkAddress()
-						<< ", Type " << std::hex << node->getDeviceType()
-						<< ", Parent " << std::hex << node->getParentAddress()
-						<< ", Battery " << std::hex << (roundf(node->getBatteryVoltage() * 10) / 10) << "V";
-					firstLine = false;
-
-					if (node->getName().find("oystick") != std::string::npos)
-					{
-						m_arrDevices.push_back(
-							std::unique_ptr<InteractionDevice>(
-								new InteractionDevice_Joystick(node->getName(), *node)));
-					}
-				}
-				LOG_INFO("Connected devices: " << std::endl << output.str());
-
-				// start receiver thread
-				m_receiverThread = std::thread(&InteractionSystem::receiverThread, this);
-				LOG_INFO("Initialised");
-			}
-			else
-			{
-				LOG_INFO("No devices connected");
+				LOG_INFO("Found Interaction System on " << pPort->getName());
+
+				// detect connected devices in the background
+				LOG_INFO("Scanning for devices...");
+				pEntry->pCoordinator->setNumberOfRetries(20);
+				pEntry->discovering = pEntry->pCoordinator->startDiscovery();
+				pEntry->knownNodes  = 0;
+				pEntry->pSerialPort = std::move(pPort);
+				m_arrCoordinators.push_back(std::move(pEntry));
 			}
+		}
+	}
+	m_arrSerialPorts.clear();
 
+	if (isActive())
+	{
+		// start receiver threads
+		m_stopReceiver = false;
+		for (auto& pEntry : m_arrCoordinators)
+		{
+			pEntry->receiverThread = std::thread(&InteractionSystem::receiverThread, this, pEntry.get());
 		}
+		LOG_INFO("Initialised (" << m_arrCoordinators.size() << " coordinators)");
 	}
 	return isActive();
 }
 
 
-bool InteractionSystem::isActive()
+bool InteractionSystem::isDiscovering() const
+{
+	bool discovering = false;
+	for (auto& pEntry : m_arrCoordinators)
+	{
+		discovering |= pEntry->discovering;
+	}
+	return discovering;
+}
+
+
+void InteractionSystem::waitForDiscovery() const
 {
-	return (m_pCoordinator && m_pCoordinator->isValid());
+	while (isDiscovering())
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+}
+
+
+bool InteractionSystem::hasNewDevices() const
+{
+	return m_deviceCount > m_describedDevices;
+}
+
+
+bool InteractionSystem::isActive() const
+{
+	return !m_arrCoordinators.empty();
 }
 
 
 void InteractionSystem::getSceneDescription(MoCapData& refData)
 {
-	int plateID = 0;
+	int deviceCount = m_deviceCount.load(std::memory_order_acquire);
+	int plateID     = m_describedDevices;
 
-	// fill in each device
-	for each ( auto& device in m_arrDevices )
+	// fill in each device that has been added since the last call
+	for (int devIdx = m_describedDevices; devIdx < deviceCount; devIdx++)
 	{
+		const std::unique_ptr<InteractionDevice>& device = m_arrDevices[devIdx];
+
 		// create and zero new description structure
 		sForcePlateDescription* pForce = new sForcePlateDescription();
 		memset(pForce, 0, sizeof(*pForce));
@@ -201,16 +402,16 @@ void InteractionSystem::getSceneDescription(MoCapData& refData)
 		// plate ID (start counting at 1)
 		plateID++; pForce->ID = plateID; 
 		// plate serial#/name
-		strncpy_s(pForce->strSerialNo, device->getName().c_str(), sizeof(pForce->strSerialNo));
+		snprintf(pForce->strSerialNo, sizeof(pForce->strSerialNo), "%s", device->getName().c_str());
 		
 		// channel information
 		pForce->nChannels = (int) device->getChannelCount(); // channel count
 		for (size_t chnIdx = 0; chnIdx < device->getChannelCount(); chnIdx++)
 		{
-			strncpy_s(
+			snprintf(
 				pForce->szChannelNames[chnIdx], 
-				device->getChannels()[chnIdx].name.c_str(), 
-				sizeof(pForce->szChannelNames[chnIdx]));
+				sizeof(pForce->szChannelNames[chnIdx]),
+				"%s", device->getChannels()[chnIdx].name.c_str());
 		}
 
 		sDataDescription& refDescription = refData.description.arrDataDescriptions[refData.description.nDataDescriptions];
@@ -218,28 +419,46 @@ void InteractionSystem::getSceneDescription(MoCapData& refData)
 		refDescription.Data.ForcePlateDescription = pForce;
 		refData.description.nDataDescriptions++; // that was one desciption more
 	}
+	m_describedDevices = deviceCount;
 }
 
 
 void InteractionSystem::getFrameData(MoCapData& refData)
 {
-	refData.frame.nForcePlates = (int) m_arrDevices.size(); // number of plates/devices
+	refData.frame.nForcePlates = m_describedDevices; // number of plates/devices
 	
+	// map the frame timestamp to the local clock of the samples:
+	// the smallest offset belongs to the frame with the least transport delay,
+	// larger offsets are only followed slowly to compensate for clock drift
+	double frameTime = InteractionDevice::getLocalTime();
+	if (refData.frame.fTimestamp > 0)
+	{
+		double offset = frameTime - refData.frame.fTimestamp;
+		if (!m_clockSynchronised || (offset < m_clockOffset) || (offset - m_clockOffset > CLOCK_RESYNC_THRESHOLD))
+		{
+			// first frame, less delay, or timestamp jump (e.g., looped file)
+			m_clockOffset       = offset;
+			m_clockSynchronised = true;
+		}
+		else
+		{
+			m_clockOffset += CLOCK_DRIFT_ADAPTATION * (offset - m_clockOffset);
+		}
+		frameTime = refData.frame.fTimestamp + m_clockOffset;
+	}
+
 	int plateID = 0;
 	// fill in each device channel values
-	for each (auto& device in m_arrDevices)
+	for (int devIdx = 0; devIdx < m_describedDevices; devIdx++)
 	{
+		const std::unique_ptr<InteractionDevice>& device = m_arrDevices[devIdx];
 		sForcePlateData& refForce = refData.frame.ForcePlates[plateID];
 		// plate ID (start counting at 1)
 		plateID++; refForce.ID = plateID; 
 		// channel count
 		refForce.nChannels = (int) device->getChannelCount();  
-		// values
-		for (size_t chnIdx = 0; chnIdx < device->getChannelCount(); chnIdx++)
-		{
-			refForce.ChannelData[chnIdx].nFrames   = 1; // 1 subframe
-			refForce.ChannelData[chnIdx].Values[0] = device->getChannels()[chnIdx].value;
-		}
+		// values of all samples since the last frame as subframes
+		device->getSamples(refForce, frameTime);
 		// parameters
 		refForce.params = 0; 
 	}
@@ -250,40 +469,106 @@ bool InteractionSystem::deinitialise()
 {
 	if (isActive())
 	{
-		m_pCoordinator.reset();
-		m_pSerialPort.reset();
-
-		if (m_receiverThread.joinable())
+		// stop receiver threads before the coordinators and the ports disappear
+		m_stopReceiver = true;
+		for (auto& pEntry : m_arrCoordinators)
 		{
-			m_receiverThread.join();
+			if (pEntry->receiverThread.joinable())
+			{
+				pEntry->receiverThread.join();
+			}
 		}
 
+		m_arrCoordinators.clear();
+
 		LOG_INFO("Deinitialised");
 	}
 	return true;
 }
 
 
-void InteractionSystem::receiverThread()
+void InteractionSystem::receiverThread(sCoordinator* pCoordinator)
 {
-	LOG_INFO("Receiver Thread started");
-	while (isActive())
+	sCoordinator&    refCoordinator = *pCoordinator;
+	XBeeCoordinator& refXBee        = *refCoordinator.pCoordinator;
+
+	LOG_INFO("Receiver Thread started (" << refCoordinator.pSerialPort->getName() << ")");
+	auto nextTelemetry = std::chrono::steady_clock::now() + std::chrono::seconds(TELEMETRY_INTERVAL);
+	while (!m_stopReceiver)
 	{
 		// start receiving
-		std::unique_ptr<XBeePacket_Receive> packet = m_pCoordinator->receive();
-		if (packet)
+		const XBeePacket_Receive* pPacket = refXBee.receive();
+		if (pPacket != NULL)
 		{
-			for each (auto& device in m_arrDevices)
+			for (auto pDevice : refCoordinator.arrDevices)
 			{
-				if (device->update(*packet))
+				if (pDevice->update(*pPacket))
 				{
 					// packet was parsed > no need to continue
 					break;
 				}
 			}
 		}
+
+		if (refCoordinator.discovering)
+		{
+			addDevices(refCoordinator);
+		}
+		else if (std::chrono::steady_clock::now() >= nextTelemetry)
+		{
+			// query all devices at once, the responses are handled by receive() without holding up the samples
+			for (auto& node : refXBee.getConnectedDevices())
+			{
+				node->requestTelemetry();
+			}
+			nextTelemetry += std::chrono::seconds(TELEMETRY_INTERVAL);
+		}
 	}
-	LOG_INFO("Receiver Thread stopped");
+	LOG_INFO("Receiver Thread stopped (" << refCoordinator.pSerialPort->getName() << ")");
 }
 
 
+void InteractionSystem::addDevices(sCoordinator& refCoordinator)
+{
+	// check discovery state first, so that a device that is found at the same time is not missed
+	bool discovering = refCoordinator.pCoordinator->isDiscovering();
+
+	const std::vector<std::unique_ptr<XBeeRemoteDevice>>& arrNodes = refCoordinator.pCoordinator->getConnectedDevices();
+	for (; refCoordinator.knownNodes < arrNodes.size(); refCoordinator.knownNodes++)
+	{
+		XBeeRemoteDevice& node = *arrNodes[refCoordinator.knownNodes];
+		LOG_INFO("Found device '" << node.getName() << "': "
+			<< "Serial# " << std::hex << node.getSerialNumber()
+			<< ", Address " << std::hex << node.getNetworkAddress()
+			<< ", Type " << std::hex << node.getDeviceType()
+			<< ", Parent " << std::hex << node.getParentAddress()
+			<< ", Port " << refCoordinator.pSerialPort->getName());
+
+		if (node.getName().find("oystick") != std::string::npos)
+		{
+			// several receiver threads can add devices at the same time
+			std::lock_guard<std::mutex> lock(m_mtxAddDevice);
+			int deviceCount = m_deviceCount.load(std::memory_order_relaxed);
+			if (deviceCount < MAX_DEVICES)
+			{
+				// construct the device completely before it is published to other threads
+				m_arrDevices[deviceCount].reset(new InteractionDevice_Joystick(node.getName(), node));
+				refCoordinator.arrDevices.push_back(m_arrDevices[deviceCount].get());
+				m_deviceCount.store(deviceCount + 1, std::memory_order_release);
+			}
+			else
+			{
+				LOG_WARNING("Too many devices, ignoring '" << node.getName() << "'");
+			}
+		}
+	}
+
+	if (!discovering)
+	{
+		if (refCoordinator.arrDevices.empty())
+		{
+			LOG_INFO("No devices connected on " << refCoordinator.pSerialPort->getName());
+		}
+		refCoordinator.discovering = false;
+	}
+}
@@ -3,24 +3,39 @@
 #include "XBeeDevice.h"
 #include "MoCapData.h"
 
+#include <atomic>
+#include <mutex>
 #include <thread>
 
 
 /**
  * Class for a single device data channel with a name and a value.
+ * The value is only used by the receiver thread while parsing a sample,
+ * other threads read the published values with InteractionDevice::getValues().
  */
 class Channel
 {
 public:
+	/**
+	 * Type of the channel data, which determines how the values are aligned to MoCap frames.
+	 */
+	enum eType
+	{
+		BUTTON, // discrete states, every change is kept
+		AXIS    // continuous values that are interpolated
+	};
+
 	/**
 	 * Creates a channel with a given name and a default value of 0.
 	 *
-	 * @param refName  the name of the channel
+	 * @param refName      the name of the channel
+	 * @param channelType  the type of the channel data
 	 */
-	Channel(const std::string& refName) : name(refName), value(0.0f) { };
+	Channel(const std::string& refName, eType channelType) : name(refName), type(channelType), value(0.0f) { };
 
 public:
 	const std::string name;
+	const eType       type;
 	      float       value;
 };
 
@@ -63,6 +78,36 @@ public:
 	 */
 	const std::vector<Channel>& getChannels() const;
 
+	/**
+	 * Gets a consistent copy of the channel values of the last published sample.
+	 * The caller never blocks the receiver thread,
+	 * but retries the copy when a sample was published at the same time.
+	 *
+	 * @param pValues  the array to copy the values into (space for getChannelCount() values)
+	 */
+	void getValues(float* pValues) const;
+
+	/**
+	 * Fills in the samples that were received up to a frame time as sub-frames, oldest first.
+	 * Samples that were received after the frame time are kept for the next frame,
+	 * and when more samples than sub-frames were received, the oldest samples are skipped.
+	 * The last sub-frame is the state at the frame time:
+	 * Buttons keep the state of the last sample before the frame time,
+	 * axes are interpolated between the samples before and after the frame time.
+	 * Only to be called from one thread, e.g., the streaming thread.
+	 *
+	 * @param refData    the force plate data to fill in the channel values of
+	 * @param frameTime  the time of the frame on the clock of the sample timestamps
+	 */
+	void getSamples(sForcePlateData& refData, double frameTime);
+
+	/**
+	 * Gets the time of the monotonic clock that is used for the sample timestamps.
+	 *
+	 * @return the current time in seconds
+	 */
+	static double getLocalTime();
+
 	/**
 	 * Updates the data from a received packet.
 	 *
@@ -74,9 +119,47 @@ public:
 
 protected:
 
+	/**
+	 * Publishes the channel values so that getValues() returns them together
+	 * and queues them with the receive time as a sample for getSamples().
+	 * Called by the receiver thread after parsing a sample.
+	 */
+	void publishValues();
+
+protected:
+
+	/**
+	 * Sample of all channel values with the time it was received.
+	 */
+	struct sSample
+	{
+		double timestamp; // receive time in seconds
+		float  values[MAX_ANALOG_CHANNELS];
+	};
+
+	static const uint32_t SAMPLE_QUEUE_SIZE = 2 * MAX_ANALOG_SUBFRAMES;
+	static const int      HISTORY_SIZE      = SAMPLE_QUEUE_SIZE + MAX_ANALOG_SUBFRAMES;
+
 	std::string          m_deviceName;
 	std::vector<Channel> m_arrChannels;
 
+	// published channel values, guarded by a sequence lock (odd sequence: publishing in progress)
+	std::atomic<uint32_t> m_sequence;
+	std::atomic<float>    m_arrPublishedValues[MAX_ANALOG_CHANNELS];
+
+	// queue of received samples with one producer (receiver thread) and one consumer (streaming thread)
+	sSample               m_arrSamples[SAMPLE_QUEUE_SIZE];
+	std::atomic<uint32_t> m_sampleWriteIdx;   // total amount of queued samples
+	std::atomic<uint32_t> m_sampleReadIdx;    // total amount of consumed samples
+	std::atomic<uint32_t> m_droppedSamples;   // samples that did not fit into the queue
+	uint32_t              m_handledDrops;     // dropped samples that getSamples() has compensated for
+
+	// samples taken from the queue, oldest first (streaming thread only)
+	sSample               m_arrHistory[HISTORY_SIZE];
+	int                   m_historyCount;
+	double                m_lastFrameTime;    // frame time of the last call to getSamples()
+	float                 m_arrFrameValues[MAX_ANALOG_CHANNELS]; // values at the last frame time
+
 };
 
 
@@ -110,17 +193,19 @@ protected:
 
 /**
  * Class for managing interaction devices based on the XBee controllers.
+ * Several coordinators on separate serial ports can be used to cover a larger area,
+ * their devices are combined into one list.
  */
 class InteractionSystem
 {
 public:
 
 	/**
-	 * Creates an interaction system using a specific serial port.
+	 * Creates an interaction system using specific serial ports.
 	 *
-	 * @param pPort  the serial port to use
+	 * @param arrPorts  the serial ports to use, each with a coordinator (the ports are taken over)
 	 */
-	InteractionSystem(std::unique_ptr<SerialPort>& pPort);
+	InteractionSystem(std::vector<std::unique_ptr<SerialPort>>& arrPorts);
 
 	/**
 	 * Deinitialises and destroys the interaction system.
@@ -128,35 +213,59 @@ public:
 	~InteractionSystem();
 
 	/**
-	 * Initialises the system by opening the serial port and polling for connected devices.
+	 * Initialises the system by opening the serial ports and starting the discovery of connected devices.
+	 * Ports without a coordinator are released.
+	 * This does not wait for the devices, they are added in the background as they are discovered.
 	 *
-	 * @return <code>true</code> if initialisation was succesful
+	 * @return <code>true</code> if at least one coordinator was found
 	 */
 	bool initialise();
 
+	/**
+	 * Checks if the discovery of devices is still in progress.
+	 *
+	 * @return <code>true</code> if more devices can be added
+	 */
+	bool isDiscovering() const;
+
+	/**
+	 * Waits until the discovery of devices is complete.
+	 */
+	void waitForDiscovery() const;
+
+	/**
+	 * Checks if devices were discovered that are not part of the scene description yet.
+	 *
+	 * @return <code>true</code> if getSceneDescription() needs to be called again
+	 */
+	bool hasNewDevices() const;
+
 	/**
 	 * Checks if the interaction system has been successfully initialised.
 	 *
 	 * @return <code>true</code> if initialisation was succesful
 	 */
-	bool isActive();
+	bool isActive() const;
 
 	/**
-	 * Fills in the interaction device descriptions into the MoCap description structure.
+	 * Fills in the descriptions of the interaction devices that are not part of the scene yet
+	 * into the MoCap description structure.
 	 *
 	 * @param refData  the MoCap data structure to fill in
 	 */
 	void getSceneDescription(MoCapData& refData);
 
 	/**
-	 * Fills in the interaction device data into the MoCap data structure.
+	 * Fills in the data of the described interaction devices into the MoCap data structure.
+	 * The samples are aligned to the timestamp of the MoCap frame
+	 * (or to the current time if the MoCap system does not provide timestamps).
 	 *
 	 * @param refData  the MoCap data structure to fill in
 	 */
 	void getFrameData(MoCapData& refData);
 	
 	/**
-	 * Deinitialises the system by closing the serial port and releasing it.
+	 * Deinitialises the system by closing the serial ports and releasing them.
 	 *
 	 * @return <code>true</code> if deinitialisation was succesful
 	 */
@@ -165,17 +274,52 @@ public:
 protected:
 
 	/**
-	 * Thread that receives data from the XBee devices in the background.
+	 * XBee coordinator with its serial port, receiver thread, and devices.
+	 */
+	struct sCoordinator
+	{
+		std::unique_ptr<SerialPort>      pSerialPort;
+		std::unique_ptr<XBeeCoordinator> pCoordinator;
+		std::thread                      receiverThread;
+		std::atomic<bool>                discovering; // cleared after the last discovered device has been added
+		size_t                           knownNodes;  // XBee devices that have been checked by addDevices()
+		std::vector<InteractionDevice*>  arrDevices;  // devices of this coordinator, only used by its receiver thread
+	};
+
+	/**
+	 * Thread that receives data from the XBee devices of one coordinator in the background.
+	 * Network addresses are only unique per coordinator,
+	 * so samples are only passed on to the devices of the same coordinator.
+	 *
+	 * @param pCoordinator  the coordinator to receive from
+	 */
+	void receiverThread(sCoordinator* pCoordinator);
+
+	/**
+	 * Creates interaction devices for newly discovered XBee devices of a coordinator.
+	 * Called by the receiver thread of the coordinator.
+	 *
+	 * @param refCoordinator  the coordinator to check the devices of
 	 */
-	void receiverThread();
+	void addDevices(sCoordinator& refCoordinator);
 
 protected:
 
-	std::unique_ptr<SerialPort>      m_pSerialPort;
-	std::unique_ptr<XBeeCoordinator> m_pCoordinator;
-	std::thread                      m_receiverThread;
+	static const int MAX_DEVICES = MAX_FORCEPLATES;
+
+	std::vector<std::unique_ptr<SerialPort>>   m_arrSerialPorts;   // ports to initialise
+	std::vector<std::unique_ptr<sCoordinator>> m_arrCoordinators;  // coordinators that were found
+	std::atomic<bool>                          m_stopReceiver;
+
+	bool                                       m_clockSynchronised; // offset between MoCap and local clock is known
+	double                                     m_clockOffset;       // local time - MoCap frame timestamp
 
-	std::vector<std::unique_ptr<InteractionDevice>> m_arrDevices;
+	// devices of all coordinators, only appended by the receiver threads and published through the counter,
+	// so other threads can use the first m_deviceCount entries without locking
+	std::unique_ptr<InteractionDevice> m_arrDevices[MAX_DEVICES];
+	std::atomic<int>                   m_deviceCount;
+	std::mutex                         m_mtxAddDevice;     // between the receiver threads
+	int                                m_describedDevices; // devices that are part of the scene description
 
 };
 
@@ -193,7 +193,12 @@ void printFrameOfData(std::ostream& refOutput, sFrameOfMocapData& refData)
 		for (int chIdx = 0; chIdx < refForcePlate.nChannels; chIdx++)
 		{
 			sAnalogChannelData& refChannel = refForcePlate.ChannelData[chIdx];
-			refOutput << "\tChn #" << chIdx << ":\t" << refChannel.Values[0] << std::endl;
+			refOutput << "\tChn #" << chIdx << ":";
+			for (int sIdx = 0; sIdx < refChannel.nFrames; sIdx++)
+			{
+				refOutput << "\t" << refChannel.Values[sIdx];
+			}
+			refOutput << std::endl;
 		}
 	}
 }
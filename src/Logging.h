@@ -15,22 +15,8 @@
 #define LOG_INFO_MID(x)   { std::cout << x << std::flush; } 
 #define LOG_INFO_END()    { std::cout << std::endl; } 
 
-#include "NatNetTypes.h"
-
 /**
  * Prints a section of memory.
  */
 void printMemory(std::ostream& refOutput, const void* pBuf, size_t length);
 
-
-/**
- * Prints the model definition into an output stream. 
- */
-void printModelDefinitions(std::ostream& refOutput, sDataDescriptions& refData);
-
-
-/**
-* Prints the current frame information into an output stream.
-*/
-void printFrameOfData(std::ostream& refOutput, sFrameOfMocapData& refData);
-
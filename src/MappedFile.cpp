@@ -0,0 +1,201 @@
+#include "MappedFile.h"
+
+#include "Logging.h"
+#undef   LOG_CLASS
+#define  LOG_CLASS "MappedFile"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <cerrno>
+#include <cstdint>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+
+/******************************************************************************
+ * MappedFile class
+ */
+
+MappedFile::MappedFile() :
+	filename(""),
+#ifdef _WIN32
+	hFile(NULL),
+	hMapping(NULL),
+#else
+	fdFile(-1),
+#endif
+	pData(NULL),
+	size(0)
+{
+	// nothing else to do
+}
+
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+
+#ifdef _WIN32
+
+/******************************************************************************
+ * Windows implementation using a file mapping object
+ */
+
+bool MappedFile::create(const std::string& _filename, size_t _size)
+{
+	close();
+	filename = _filename;
+
+	hFile = CreateFileA(filename.c_str(), GENERIC_READ | GENERIC_WRITE, 0, NULL, CREATE_ALWAYS,
+	                    FILE_ATTRIBUTE_NORMAL | FILE_FLAG_DELETE_ON_CLOSE, NULL);
+	if (hFile == INVALID_HANDLE_VALUE)
+	{
+		hFile = NULL;
+		LOG_ERROR("Could not create file " << filename);
+		return false;
+	}
+
+	// the mapping extends the file to the requested size
+	ULARGE_INTEGER mappingSize;
+	mappingSize.QuadPart = _size;
+	hMapping = CreateFileMappingA(hFile, NULL, PAGE_READWRITE, mappingSize.HighPart, mappingSize.LowPart, NULL);
+	if (hMapping != NULL)
+	{
+		pData = (char*) MapViewOfFile(hMapping, FILE_MAP_ALL_ACCESS, 0, 0, _size);
+	}
+	if (pData == NULL)
+	{
+		LOG_ERROR("Could not map " << (_size >> 20) << "MB of file " << filename << " (Error " << GetLastError() << ")");
+		close();
+		return false;
+	}
+
+	size = _size;
+	return true;
+}
+
+
+void MappedFile::close()
+{
+	if (pData != NULL)
+	{
+		UnmapViewOfFile(pData);
+		pData = NULL;
+	}
+	if (hMapping != NULL)
+	{
+		CloseHandle(hMapping);
+		hMapping = NULL;
+	}
+	if (hFile != NULL)
+	{
+		CloseHandle(hFile); // also deletes the file
+		hFile = NULL;
+	}
+	size = 0;
+}
+
+
+void MappedFile::release(const void* pAddress, size_t _size)
+{
+	if ((pData != NULL) && (_size > 0))
+	{
+		// unlocking pages that are not locked removes them from the working set
+		VirtualUnlock((LPVOID) pAddress, _size);
+	}
+}
+
+#else
+
+/******************************************************************************
+ * POSIX implementation using mmap()
+ */
+
+bool MappedFile::create(const std::string& _filename, size_t _size)
+{
+	close();
+	filename = _filename;
+
+	fdFile = open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+	if (fdFile < 0)
+	{
+		LOG_ERROR("Could not create file " << filename);
+		return false;
+	}
+	// the file is deleted as soon as it is closed (the name is not needed any more)
+	unlink(filename.c_str());
+
+	// extending the file fills it with zeroes
+	if (ftruncate(fdFile, (off_t) _size) == 0)
+	{
+		void* pMapped = mmap(NULL, _size, PROT_READ | PROT_WRITE, MAP_SHARED, fdFile, 0);
+		pData = (pMapped != MAP_FAILED) ? (char*) pMapped : NULL;
+	}
+	if (pData == NULL)
+	{
+		LOG_ERROR("Could not map " << (_size >> 20) << "MB of file " << filename << " (Error " << errno << ")");
+		close();
+		return false;
+	}
+
+	size = _size;
+	return true;
+}
+
+
+void MappedFile::close()
+{
+	if (pData != NULL)
+	{
+		munmap(pData, size);
+		pData = NULL;
+	}
+	if (fdFile >= 0)
+	{
+		::close(fdFile);
+		fdFile = -1;
+	}
+	size = 0;
+}
+
+
+void MappedFile::release(const void* pAddress, size_t _size)
+{
+	if ((pData != NULL) && (_size > 0))
+	{
+		// only whole pages can be released
+		const uintptr_t pageSize = (uintptr_t) sysconf(_SC_PAGESIZE);
+		uintptr_t start = ((uintptr_t) pAddress + pageSize - 1) & ~(pageSize - 1);
+		uintptr_t end   = ((uintptr_t) pAddress + _size) & ~(pageSize - 1);
+		if (start < end)
+		{
+			// shared file pages are written back and read again on the next access
+			madvise((void*) start, end - start, MADV_DONTNEED);
+		}
+	}
+}
+
+#endif // #ifdef _WIN32
+
+
+bool MappedFile::isOpen() const
+{
+	return pData != NULL;
+}
+
+
+char* MappedFile::getData() const
+{
+	return pData;
+}
+
+
+size_t MappedFile::getSize() const
+{
+	return size;
+}
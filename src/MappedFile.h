@@ -0,0 +1,80 @@
+/**
+ * Class for a temporary file that is mapped into memory.
+ * The operating system pages the data in on access and can page it out again,
+ * so the data does not need to fit into RAM.
+ * On Windows, the file is mapped with a file mapping object,
+ * on other systems with mmap().
+ */
+
+#pragma once
+
+#include <string>
+
+
+class MappedFile
+{
+public:
+
+	MappedFile();
+	~MappedFile();
+
+	/**
+	 * Creates the file, filled with zeroes, and maps it into memory for reading and writing.
+	 * The file is deleted when it is closed.
+	 *
+	 * @param filename  the name of the file
+	 * @param size      the size of the file in bytes
+	 *
+	 * @return <code>true</code> if the file was created and mapped,
+	 *         <code>false</code> if not
+	 */
+	bool create(const std::string& filename, size_t size);
+
+	/**
+	 * Unmaps and deletes the file.
+	 */
+	void close();
+
+	/**
+	 * Checks if the file is created and mapped.
+	 *
+	 * @return <code>true</code> if the file is mapped,
+	 *         <code>false</code> if not
+	 */
+	bool isOpen() const;
+
+	/**
+	 * Gets the start of the mapped data.
+	 *
+	 * @return the start of the mapped data or <code>NULL</code> if the file is not mapped
+	 */
+	char* getData() const;
+
+	/**
+	 * Gets the size of the mapped data.
+	 *
+	 * @return the size of the mapped data in bytes
+	 */
+	size_t getSize() const;
+
+	/**
+	 * Removes a range of the mapped data from the working set of the process.
+	 * The data is not lost, it is paged in again on the next access.
+	 *
+	 * @param pAddress  the start of the range
+	 * @param size      the size of the range in bytes
+	 */
+	void release(const void* pAddress, size_t size);
+
+private:
+
+	std::string filename;
+#ifdef _WIN32
+	void*       hFile;
+	void*       hMapping;
+#else
+	int         fdFile;
+#endif
+	char*       pData;
+	size_t      size;
+};
@@ -0,0 +1,179 @@
+#include "MarkerGapFiller.h"
+
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define USE_SSE2
+#include <emmintrin.h>
+#endif
+
+
+// filter gains (alpha-beta-gamma filter with critically damped response for alpha = 0.85)
+static const float ALPHA = 0.85f;
+static const float BETA  = 0.751f;
+static const float GAMMA = 0.332f;
+
+// decay of the acceleration while a marker is missing to avoid predictions drifting away quickly
+static const float ACCELERATION_DECAY = 0.5f;
+
+
+/******************************************************************************
+ * MarkerGapFiller class
+ */
+
+MarkerGapFiller::MarkerGapFiller(int _maxGapLength) :
+	maxGapLength(_maxGapLength)
+{
+	// nothing else to do
+}
+
+
+int MarkerGapFiller::getMaxGapLength() const
+{
+	return maxGapLength;
+}
+
+
+void MarkerGapFiller::setMaxGapLength(int _maxGapLength)
+{
+	maxGapLength = _maxGapLength;
+}
+
+
+void MarkerGapFiller::setMarkerCount(int nMarkers)
+{
+	if (nMarkers == (int)gapLength.size()) return;
+
+	posX.assign(nMarkers, 0); posY.assign(nMarkers, 0); posZ.assign(nMarkers, 0);
+	velX.assign(nMarkers, 0); velY.assign(nMarkers, 0); velZ.assign(nMarkers, 0);
+	accX.assign(nMarkers, 0); accY.assign(nMarkers, 0); accZ.assign(nMarkers, 0);
+	gapLength.assign(nMarkers, -1);
+
+	measX.assign(nMarkers, 0); measY.assign(nMarkers, 0); measZ.assign(nMarkers, 0);
+	measured.assign(nMarkers, 0);
+}
+
+
+void MarkerGapFiller::resetMarker(int idx)
+{
+	gapLength[idx] = -1;
+	measured[idx]  = 0;
+}
+
+
+void MarkerGapFiller::setMarker(int idx, float x, float y, float z)
+{
+	measX[idx] = x;
+	measY[idx] = y;
+	measZ[idx] = z;
+	measured[idx] = 1;
+}
+
+
+void MarkerGapFiller::setMarkerMissing(int idx)
+{
+	measured[idx] = 0;
+}
+
+
+void MarkerGapFiller::update()
+{
+	const int n   = (int)gapLength.size();
+	int       idx = 0;
+
+#ifdef USE_SSE2
+	const __m128  vAlpha      = _mm_set1_ps(ALPHA);
+	const __m128  vBeta       = _mm_set1_ps(BETA);
+	const __m128  vGamma2     = _mm_set1_ps(2.0f * GAMMA);
+	const __m128  vHalf       = _mm_set1_ps(0.5f);
+	const __m128  vDecay      = _mm_set1_ps(ACCELERATION_DECAY);
+	const __m128i vZero       = _mm_setzero_si128();
+	const __m128i vMinusOne   = _mm_set1_epi32(-1);
+	const __m128i vMaxGap     = _mm_set1_epi32(maxGapLength);
+
+	float* arrPos[3]  = { posX.data(),  posY.data(),  posZ.data()  };
+	float* arrVel[3]  = { velX.data(),  velY.data(),  velZ.data()  };
+	float* arrAcc[3]  = { accX.data(),  accY.data(),  accZ.data()  };
+	float* arrMeas[3] = { measX.data(), measY.data(), measZ.data() };
+
+	for (; idx + 4 <= n; idx += 4)
+	{
+		__m128i gap      = _mm_loadu_si128((const __m128i*)(gapLength.data() + idx));
+		__m128i measMask = _mm_cmpgt_epi32(_mm_loadu_si128((const __m128i*)(measured.data() + idx)), vZero);
+		__m128i validGap = _mm_andnot_si128(_mm_cmpgt_epi32(gap, vMaxGap), _mm_cmpgt_epi32(gap, vMinusOne));
+
+		// markers measured for the first time (or after a reset or a long gap) start with their measurement
+		__m128 restart   = _mm_castsi128_ps(_mm_andnot_si128(validGap, measMask));
+		__m128 vMeasured = _mm_castsi128_ps(measMask);
+
+		for (int axis = 0; axis < 3; axis++)
+		{
+			__m128 meas = _mm_loadu_ps(arrMeas[axis] + idx);
+			__m128 pos  = _mm_loadu_ps(arrPos[axis]  + idx);
+			__m128 vel  = _mm_andnot_ps(restart, _mm_loadu_ps(arrVel[axis] + idx));
+			__m128 acc  = _mm_andnot_ps(restart, _mm_loadu_ps(arrAcc[axis] + idx));
+			pos = _mm_or_ps(_mm_and_ps(restart, meas), _mm_andnot_ps(restart, pos));
+
+			// prediction with constant acceleration and correction with the residual
+			__m128 pred = _mm_add_ps(_mm_add_ps(pos, vel), _mm_mul_ps(vHalf, acc));
+			__m128 res  = _mm_and_ps(vMeasured, _mm_sub_ps(meas, pred));
+			__m128 decayedAcc = _mm_or_ps(_mm_and_ps(vMeasured, acc), _mm_andnot_ps(vMeasured, _mm_mul_ps(vDecay, acc)));
+			_mm_storeu_ps(arrPos[axis] + idx, _mm_add_ps(pred, _mm_mul_ps(vAlpha, res)));
+			_mm_storeu_ps(arrVel[axis] + idx, _mm_add_ps(_mm_add_ps(vel, acc), _mm_mul_ps(vBeta, res)));
+			_mm_storeu_ps(arrAcc[axis] + idx, _mm_add_ps(decayedAcc, _mm_mul_ps(vGamma2, res)));
+		}
+
+		// count missing frames (up to one more than the maximum gap length)
+		gap = _mm_sub_epi32(gap, validGap); // validGap is -1 where the gap grows
+		_mm_storeu_si128((__m128i*)(gapLength.data() + idx), _mm_andnot_si128(measMask, gap));
+	}
+#endif
+
+	// remaining markers (or all markers without SSE2)
+	for (; idx < n; idx++)
+	{
+		const bool validGap = (gapLength[idx] >= 0) && (gapLength[idx] <= maxGapLength);
+
+		if (measured[idx] && !validGap)
+		{
+			posX[idx] = measX[idx]; posY[idx] = measY[idx]; posZ[idx] = measZ[idx];
+			velX[idx] = 0;          velY[idx] = 0;          velZ[idx] = 0;
+			accX[idx] = 0;          accY[idx] = 0;          accZ[idx] = 0;
+		}
+
+		const float decay = measured[idx] ? 1.0f : ACCELERATION_DECAY;
+
+		float predX = posX[idx] + velX[idx] + 0.5f * accX[idx];
+		float predY = posY[idx] + velY[idx] + 0.5f * accY[idx];
+		float predZ = posZ[idx] + velZ[idx] + 0.5f * accZ[idx];
+
+		float resX = measured[idx] ? (measX[idx] - predX) : 0.0f;
+		float resY = measured[idx] ? (measY[idx] - predY) : 0.0f;
+		float resZ = measured[idx] ? (measZ[idx] - predZ) : 0.0f;
+
+		posX[idx] = predX + ALPHA * resX;
+		posY[idx] = predY + ALPHA * resY;
+		posZ[idx] = predZ + ALPHA * resZ;
+
+		velX[idx] = velX[idx] + accX[idx] + BETA * resX;
+		velY[idx] = velY[idx] + accY[idx] + BETA * resY;
+		velZ[idx] = velZ[idx] + accZ[idx] + BETA * resZ;
+
+		accX[idx] = decay * accX[idx] + (2.0f * GAMMA) * resX;
+		accY[idx] = decay * accY[idx] + (2.0f * GAMMA) * resY;
+		accZ[idx] = decay * accZ[idx] + (2.0f * GAMMA) * resZ;
+
+		gapLength[idx] = measured[idx] ? 0 : gapLength[idx] + (validGap ? 1 : 0);
+	}
+}
+
+
+bool MarkerGapFiller::getPrediction(int idx, float& x, float& y, float& z) const
+{
+	if (measured[idx] || (gapLength[idx] <= 0) || (gapLength[idx] > maxGapLength))
+	{
+		return false;
+	}
+	x = posX[idx];
+	y = posY[idx];
+	z = posZ[idx];
+	return true;
+}
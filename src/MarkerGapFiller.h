@@ -0,0 +1,98 @@
+/**
+ * Class for bridging short gaps in marker trajectories with predicted positions.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+
+class MarkerGapFiller
+{
+public:
+
+	/**
+	 * Creates a gap filler.
+	 *
+	 * @param maxGapLength  the maximum amount of consecutive frames to predict (0: gap filling disabled)
+	 */
+	MarkerGapFiller(int maxGapLength = 0);
+
+	/**
+	 * Gets the maximum amount of consecutive frames that are predicted.
+	 *
+	 * @return the maximum gap length in frames (0: gap filling disabled)
+	 */
+	int  getMaxGapLength() const;
+
+	/**
+	 * Sets the maximum amount of consecutive frames that are predicted.
+	 *
+	 * @param maxGapLength  the maximum gap length in frames (0: gap filling disabled)
+	 */
+	void setMaxGapLength(int maxGapLength);
+
+	/**
+	 * Sets the amount of markers and resets the filter states if the amount changed.
+	 *
+	 * @param nMarkers  the amount of markers
+	 */
+	void setMarkerCount(int nMarkers);
+
+	/**
+	 * Resets the filter state of a marker, e.g., when the marker belongs to a new person.
+	 *
+	 * @param idx  the index of the marker
+	 */
+	void resetMarker(int idx);
+
+	/**
+	 * Provides the measured position of a marker for the next update.
+	 *
+	 * @param idx  the index of the marker
+	 * @param x    the X coordinate of the marker
+	 * @param y    the Y coordinate of the marker
+	 * @param z    the Z coordinate of the marker
+	 */
+	void setMarker(int idx, float x, float y, float z);
+
+	/**
+	 * Signals that a marker has not been measured for the next update.
+	 *
+	 * @param idx  the index of the marker
+	 */
+	void setMarkerMissing(int idx);
+
+	/**
+	 * Updates the filter states of all markers with the provided measurements.
+	 */
+	void update();
+
+	/**
+	 * Gets the predicted position of a marker that was missing in the last update.
+	 *
+	 * @param idx  the index of the marker
+	 * @param x    the predicted X coordinate of the marker
+	 * @param y    the predicted Y coordinate of the marker
+	 * @param z    the predicted Z coordinate of the marker
+	 *
+	 * @return <code>true</code> if a prediction is available,
+	 *         <code>false</code> if the marker was measured, has never been seen, or the gap is too long
+	 */
+	bool getPrediction(int idx, float& x, float& y, float& z) const;
+
+private:
+
+	int                  maxGapLength;
+
+	// alpha-beta-gamma filter state per marker as structure-of-arrays (velocity and acceleration per frame)
+	std::vector<float>   posX, posY, posZ;
+	std::vector<float>   velX, velY, velZ;
+	std::vector<float>   accX, accY, accZ;
+	std::vector<int32_t> gapLength;    // consecutive missing frames (-1: no valid state)
+
+	// measurements for the next update
+	std::vector<float>   measX, measY, measZ;
+	std::vector<int32_t> measured;     // 1: measurement available, 0: missing
+};
@@ -0,0 +1,236 @@
+#include "MarkerLabeler.h"
+
+#include <cmath>
+
+
+#define MAX_MARKER_ID 0xFFFF // IDs must fit into the lower 16 bits of the NatNet marker ID
+
+
+/******************************************************************************
+ * MarkerLabeler class
+ */
+
+MarkerLabeler::MarkerLabeler(float _maxDistance, int _maxMissingFrames) :
+	maxDistance(_maxDistance),
+	maxMissingFrames(_maxMissingFrames),
+	nextID(1),
+	bucketMask(0)
+{
+	// nothing else to do
+}
+
+
+void MarkerLabeler::reset()
+{
+	trackX.clear();  trackY.clear();  trackZ.clear();
+	trackVX.clear(); trackVY.clear(); trackVZ.clear();
+	trackID.clear();
+	trackMissing.clear();
+	markerID.clear();
+	nextID = 1;
+}
+
+
+uint32_t MarkerLabeler::getBucket(int cellX, int cellY, int cellZ) const
+{
+	return (((uint32_t)cellX * 73856093u) ^ ((uint32_t)cellY * 19349663u) ^ ((uint32_t)cellZ * 83492791u)) & bucketMask;
+}
+
+
+void MarkerLabeler::buildGrid()
+{
+	const int   nTracks     = (int)trackID.size();
+	const float invCellSize = 1.0f / maxDistance;
+
+	// table with at least twice as many buckets as tracks to keep the buckets short
+	uint32_t nBuckets = 64;
+	while (nBuckets < 2 * (uint32_t)nTracks) nBuckets <<= 1;
+	bucketMask = nBuckets - 1;
+
+	bucketStart.assign(nBuckets + 1, 0);
+	bucketTracks.resize(nTracks);
+	trackBucket.resize(nTracks);
+
+	// count tracks per bucket...
+	for (int tIdx = 0; tIdx < nTracks; tIdx++)
+	{
+		uint32_t bucket = getBucket(
+			(int)floorf(trackX[tIdx] * invCellSize),
+			(int)floorf(trackY[tIdx] * invCellSize),
+			(int)floorf(trackZ[tIdx] * invCellSize));
+		trackBucket[tIdx] = bucket;
+		bucketStart[bucket + 1]++;
+	}
+	// ...accumulate to start indices...
+	for (uint32_t bIdx = 0; bIdx < nBuckets; bIdx++)
+	{
+		bucketStart[bIdx + 1] += bucketStart[bIdx];
+	}
+	// ...and distribute (bucketStart[b] temporarily points past the tracks of bucket b)
+	for (int tIdx = 0; tIdx < nTracks; tIdx++)
+	{
+		bucketTracks[bucketStart[trackBucket[tIdx]]++] = tIdx;
+	}
+	for (uint32_t bIdx = nBuckets; bIdx > 0; bIdx--)
+	{
+		bucketStart[bIdx] = bucketStart[bIdx - 1];
+	}
+	bucketStart[0] = 0;
+}
+
+
+int MarkerLabeler::findClosestTrack(float x, float y, float z, const int* pClaims) const
+{
+	const float invCellSize = 1.0f / maxDistance;
+	const int   cellX       = (int)floorf(x * invCellSize);
+	const int   cellY       = (int)floorf(y * invCellSize);
+	const int   cellZ       = (int)floorf(z * invCellSize);
+
+	int   closestTrack    = -1;
+	float closestDistance = maxDistance * maxDistance;
+
+	// cells are as large as the search radius > only the neighbouring cells need to be checked
+	for (int dz = -1; dz <= 1; dz++)
+	{
+		for (int dy = -1; dy <= 1; dy++)
+		{
+			for (int dx = -1; dx <= 1; dx++)
+			{
+				uint32_t bucket = getBucket(cellX + dx, cellY + dy, cellZ + dz);
+				for (int bIdx = bucketStart[bucket]; bIdx < bucketStart[bucket + 1]; bIdx++)
+				{
+					int tIdx = bucketTracks[bIdx];
+					if ((pClaims != nullptr) && (pClaims[tIdx] >= 0)) continue; // already taken
+
+					float distX = trackX[tIdx] - x;
+					float distY = trackY[tIdx] - y;
+					float distZ = trackZ[tIdx] - z;
+					float distance = distX * distX + distY * distY + distZ * distZ;
+					if (distance < closestDistance)
+					{
+						closestDistance = distance;
+						closestTrack    = tIdx;
+					}
+				}
+			}
+		}
+	}
+	return closestTrack;
+}
+
+
+void MarkerLabeler::update(const float* pPositions, int nMarkers)
+{
+	const int nTracks = (int)trackID.size();
+
+	// predict positions with constant velocity
+	for (int tIdx = 0; tIdx < nTracks; tIdx++)
+	{
+		trackX[tIdx] += trackVX[tIdx];
+		trackY[tIdx] += trackVY[tIdx];
+		trackZ[tIdx] += trackVZ[tIdx];
+	}
+	buildGrid();
+
+	// first round: every marker claims its closest prediction,
+	// when several markers claim the same prediction, the closest one wins
+	trackClaim.assign(nTracks, -1);
+	trackClaimDistance.resize(nTracks);
+	markerTrack.assign(nMarkers, -1);
+	for (int mIdx = 0; mIdx < nMarkers; mIdx++)
+	{
+		const float* pPos = pPositions + 3 * mIdx;
+		int tIdx = findClosestTrack(pPos[0], pPos[1], pPos[2], nullptr);
+		if (tIdx >= 0)
+		{
+			float distX = trackX[tIdx] - pPos[0];
+			float distY = trackY[tIdx] - pPos[1];
+			float distZ = trackZ[tIdx] - pPos[2];
+			float distance = distX * distX + distY * distY + distZ * distZ;
+			if ((trackClaim[tIdx] < 0) || (distance < trackClaimDistance[tIdx]))
+			{
+				trackClaim[tIdx]         = mIdx;
+				trackClaimDistance[tIdx] = distance;
+			}
+		}
+	}
+	for (int tIdx = 0; tIdx < nTracks; tIdx++)
+	{
+		if (trackClaim[tIdx] >= 0) markerTrack[trackClaim[tIdx]] = tIdx;
+	}
+
+	// second round: markers that lost their prediction try the closest remaining one
+	for (int mIdx = 0; mIdx < nMarkers; mIdx++)
+	{
+		if (markerTrack[mIdx] >= 0) continue;
+		const float* pPos = pPositions + 3 * mIdx;
+		int tIdx = findClosestTrack(pPos[0], pPos[1], pPos[2], trackClaim.data());
+		if (tIdx >= 0)
+		{
+			trackClaim[tIdx]  = mIdx;
+			markerTrack[mIdx] = tIdx;
+		}
+	}
+
+	// build tracks for the next frame: matched markers first, then new markers, then coasting tracks
+	newX.clear();  newY.clear();  newZ.clear();
+	newVX.clear(); newVY.clear(); newVZ.clear();
+	newID.clear(); newMissing.clear();
+	markerID.resize(nMarkers);
+
+	for (int mIdx = 0; mIdx < nMarkers; mIdx++)
+	{
+		const float* pPos = pPositions + 3 * mIdx;
+		int tIdx = markerTrack[mIdx];
+		int id;
+		if (tIdx >= 0)
+		{
+			// velocity relative to the previous position (= prediction minus previous velocity)
+			id = trackID[tIdx];
+			newVX.push_back(pPos[0] - (trackX[tIdx] - trackVX[tIdx]));
+			newVY.push_back(pPos[1] - (trackY[tIdx] - trackVY[tIdx]));
+			newVZ.push_back(pPos[2] - (trackZ[tIdx] - trackVZ[tIdx]));
+		}
+		else
+		{
+			id = nextID;
+			nextID = (nextID % MAX_MARKER_ID) + 1;
+			newVX.push_back(0);
+			newVY.push_back(0);
+			newVZ.push_back(0);
+		}
+		newX.push_back(pPos[0]);
+		newY.push_back(pPos[1]);
+		newZ.push_back(pPos[2]);
+		newID.push_back(id);
+		newMissing.push_back(0);
+		markerID[mIdx] = id;
+	}
+
+	for (int tIdx = 0; tIdx < nTracks; tIdx++)
+	{
+		if ((trackClaim[tIdx] < 0) && (trackMissing[tIdx] < maxMissingFrames))
+		{
+			// keep unmatched track at its predicted position for a while
+			newX.push_back(trackX[tIdx]);
+			newY.push_back(trackY[tIdx]);
+			newZ.push_back(trackZ[tIdx]);
+			newVX.push_back(trackVX[tIdx]);
+			newVY.push_back(trackVY[tIdx]);
+			newVZ.push_back(trackVZ[tIdx]);
+			newID.push_back(trackID[tIdx]);
+			newMissing.push_back(trackMissing[tIdx] + 1);
+		}
+	}
+
+	trackX.swap(newX);   trackY.swap(newY);   trackZ.swap(newZ);
+	trackVX.swap(newVX); trackVY.swap(newVY); trackVZ.swap(newVZ);
+	trackID.swap(newID);
+	trackMissing.swap(newMissing);
+}
+
+
+int MarkerLabeler::getMarkerID(int markerIdx) const
+{
+	return markerID[markerIdx];
+}
@@ -0,0 +1,87 @@
+/**
+ * Class for assigning stable temporary IDs to unidentified markers across frames.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+
+class MarkerLabeler
+{
+public:
+
+	/**
+	 * Creates a marker labeler.
+	 *
+	 * @param maxDistance      the maximum distance between a predicted and a measured marker position per frame
+	 * @param maxMissingFrames the amount of frames a marker can be missing before its ID is discarded
+	 */
+	MarkerLabeler(float maxDistance = 0.05f, int maxMissingFrames = 5);
+
+	/**
+	 * Discards all tracked markers.
+	 */
+	void reset();
+
+	/**
+	 * Labels the markers of a new frame.
+	 * Each tracked marker is predicted with its last velocity,
+	 * and each new marker is matched to the nearest prediction within the maximum distance.
+	 * Markers without a match receive a new ID.
+	 *
+	 * @param pPositions  array of marker positions (x, y, z per marker)
+	 * @param nMarkers    the amount of markers
+	 */
+	void update(const float* pPositions, int nMarkers);
+
+	/**
+	 * Gets the ID of a marker from the last call to update(...).
+	 *
+	 * @param markerIdx  the index of the marker in the position array
+	 *
+	 * @return the ID of the marker (1...65535)
+	 */
+	int getMarkerID(int markerIdx) const;
+
+private:
+
+	// index of the hash table bucket containing a position
+	uint32_t getBucket(int cellX, int cellY, int cellZ) const;
+
+	// finds the closest prediction to a marker that is not claimed yet (pClaims can be nullptr)
+	int findClosestTrack(float x, float y, float z, const int* pClaims) const;
+
+	// sorts the predicted track positions into the hash table buckets
+	void buildGrid();
+
+private:
+
+	float    maxDistance;
+	int      maxMissingFrames;
+	int      nextID;
+
+	// tracked markers as structure-of-arrays
+	std::vector<float>    trackX,  trackY,  trackZ;  // predicted positions
+	std::vector<float>    trackVX, trackVY, trackVZ; // velocities per frame
+	std::vector<int>      trackID;
+	std::vector<int>      trackMissing;              // amount of frames without match
+
+	// uniform grid over the predicted positions, stored as hash table with counting sort
+	uint32_t              bucketMask;
+	std::vector<int>      bucketStart;               // first index into bucketTracks per bucket
+	std::vector<int>      bucketTracks;              // track indices sorted by bucket
+	std::vector<uint32_t> trackBucket;               // bucket per track
+
+	// per frame matching results
+	std::vector<int>      markerTrack;               // matched track per marker (-1: none)
+	std::vector<int>      markerID;                  // resulting ID per marker
+	std::vector<int>      trackClaim;                // claiming marker per track (-1: none)
+	std::vector<float>    trackClaimDistance;        // squared distance of the claiming marker
+
+	// buffers for building the tracks of the next frame
+	std::vector<float>    newX,  newY,  newZ;
+	std::vector<float>    newVX, newVY, newVZ;
+	std::vector<int>      newID, newMissing;
+};
@@ -3,19 +3,28 @@
 #ifdef USE_CORTEX
 
 #include "Logging.h"
+#include "Portability.h"
 #undef   LOG_CLASS
 #define  LOG_CLASS "MoCapCortex"
 
 #include "VectorMath.h"
 
 #include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
 #include <iterator>
+#include <memory>
 #include <string>
 
 
 #define MAX_UNKNOWN_MARKERS 256 // maximum number of unknown markers
 
 
+// the MoCap system instance that receives the Cortex data callbacks
+// (reset by deinitialise() while the SDK thread might still be calling back)
+static std::atomic<MoCapCortex*> pCallbackInstance(nullptr);
+
 
 /******************************************************************************
  * MoCapCortexConfiguration class
@@ -25,10 +34,17 @@ MoCapCortexConfiguration::MoCapCortexConfiguration() :
 	Configuration("Cortex"),
 	useCortex(false),
 	remoteCortexAddress(""),
-	localCortexAddress("")
+	localCortexAddress(""),
+	eulerOrder(ZYX),
+	gapFillingFrames(0)
 {
 	addParameter("-cortexRemoteAddress", "<address>", "IP Address of the remote interface to connect to Cortex");
 	addParameter("-cortexLocalAddress", " <address>", "IP Address of the local interface to connect to Cortex");
+	addParameter("-cortexEulerOrder", "     <order>", "Rotation order of the Cortex segment angles (XYZ, XZY, YXZ, YZX, ZXY, ZYX, default: ZYX)");
+	addParameter("-cortexGapFilling", "   <frames>", "Predict occluded actor markers for up to this amount of frames (default: 0 = disabled)");
+#ifdef USE_CORTEX_EMULATOR
+	addParameter("-cortexEmulator", "    <settings>", "Use the Cortex emulator with a synthetic scene (settings: <actors>,<segments>,<markers>,<unidentified>,<rate>[,<sceneChange>])");
+#endif
 }
 
 
@@ -47,6 +63,22 @@ bool MoCapCortexConfiguration::handleArgument(unsigned int _idx, const std::stri
 			localCortexAddress = _value;
 			break;
 
+		case 2:
+			success = parseEulerOrder(_value, eulerOrder);
+			break;
+
+		case 3:
+			gapFillingFrames = atoi(_value.c_str());
+			success = (gapFillingFrames >= 0);
+			break;
+
+#ifdef USE_CORTEX_EMULATOR
+		case 4:
+			success = CortexEmulator_ParseSettings(_value, emulatorSettings);
+			useCortex |= success;
+			break;
+#endif
+
 		default:
 			success = false;
 			break;
@@ -83,11 +115,165 @@ void __cdecl callbackMoCapCortexMessageHandler(int iMessageType, char* czMessage
  */
 void __cdecl callbackMoCapCortexDataHandler(sFrameOfData* pFrameOfData)
 {
-	// process data
-	// merely signal new frame, the main system will pick up the data through getFrameData(...)
-	// which uses Cortex_GetCurrentFrame() 
-	// which hopefully will have this frame data
-	signalNewFrame();
+	// hand the frame over to the active instance which converts it 
+	// directly instead of fetching a copy through Cortex_GetCurrentFrame()
+	MoCapCortex* pInstance = pCallbackInstance;
+	if (pInstance != nullptr)
+	{
+		pInstance->handleFrame(pFrameOfData);
+	}
+}
+
+
+/**
+ * Checks if a markerset description matches a Cortex body definition.
+ */
+static bool isSameMarkerSet(const sBodyDef& refBodyDef, const sMarkerSetDescription& refDescr)
+{
+	if ((strcmp(refBodyDef.szName, refDescr.szName) != 0) || (refBodyDef.nMarkers != refDescr.nMarkers))
+	{
+		return false;
+	}
+	for (int mIdx = 0; mIdx < refDescr.nMarkers; mIdx++)
+	{
+		if (strcmp(refBodyDef.szMarkerNames[mIdx], refDescr.szMarkerNames[mIdx]) != 0)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+
+/**
+ * Checks if a skeleton description matches the hierarchy of a Cortex body definition.
+ */
+static bool isSameSkeleton(const sBodyDef& refBodyDef, const sSkeletonDescription& refDescr)
+{
+	const sHierarchy& refHierarchy = refBodyDef.Hierarchy;
+	if ((strcmp(refBodyDef.szName, refDescr.szName) != 0) || (refHierarchy.nSegments != refDescr.nRigidBodies))
+	{
+		return false;
+	}
+	for (int sIdx = 0; sIdx < refDescr.nRigidBodies; sIdx++)
+	{
+		if ((strcmp(refHierarchy.szSegmentNames[sIdx], refDescr.RigidBodies[sIdx].szName) != 0) ||
+		    (refHierarchy.iParents[sIdx] != refDescr.RigidBodies[sIdx].parentID))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+
+/**
+ * Takes over an unchanged markerset description and its data from a previous scene.
+ *
+ * @return the markerset description or <code>nullptr</code> if there is no matching markerset
+ */
+static sMarkerSetDescription* takeMarkerSet(MoCapData& refOld, const sBodyDef& refBodyDef, sMarkerSetData& refMarkerSetData)
+{
+	for (int dIdx = 0; dIdx < refOld.description.nDataDescriptions; dIdx++)
+	{
+		sDataDescription& refDescr = refOld.description.arrDataDescriptions[dIdx];
+		if ((refDescr.type != Descriptor_MarkerSet) || (refDescr.Data.MarkerSetDescription == nullptr) ||
+		    !isSameMarkerSet(refBodyDef, *refDescr.Data.MarkerSetDescription))
+		{
+			continue;
+		}
+
+		for (int mIdx = 0; mIdx < refOld.frame.nMarkerSets; mIdx++)
+		{
+			sMarkerSetData& refOldData = refOld.frame.MocapData[mIdx];
+			if ((refOldData.Markers != nullptr) && (strcmp(refOldData.szName, refBodyDef.szName) == 0))
+			{
+				// move marker array to the new scene
+				refMarkerSetData = refOldData;
+				refOldData.Markers  = nullptr;
+				refOldData.nMarkers = 0;
+
+				sMarkerSetDescription* pDescr = refDescr.Data.MarkerSetDescription;
+				refDescr.Data.MarkerSetDescription = nullptr;
+				return pDescr;
+			}
+		}
+	}
+	return nullptr;
+}
+
+
+/**
+ * Takes over an unchanged rigid body description and its data from a previous scene.
+ *
+ * @return the rigid body description or <code>nullptr</code> if there is no matching rigid body
+ */
+static sRigidBodyDescription* takeRigidBody(MoCapData& refOld, const sBodyDef& refBodyDef, sRigidBodyData& refRigidBodyData)
+{
+	for (int dIdx = 0; dIdx < refOld.description.nDataDescriptions; dIdx++)
+	{
+		sDataDescription& refDescr = refOld.description.arrDataDescriptions[dIdx];
+		if ((refDescr.type != Descriptor_RigidBody) || (refDescr.Data.RigidBodyDescription == nullptr) ||
+		    (strcmp(refDescr.Data.RigidBodyDescription->szName, refBodyDef.szName) != 0))
+		{
+			continue;
+		}
+
+		for (int rIdx = 0; rIdx < refOld.frame.nRigidBodies; rIdx++)
+		{
+			sRigidBodyData& refOldData = refOld.frame.RigidBodies[rIdx];
+			if (refOldData.ID == refDescr.Data.RigidBodyDescription->ID)
+			{
+				// move rigid body data to the new scene
+				refRigidBodyData = refOldData;
+				refOldData.Markers     = nullptr;
+				refOldData.MarkerIDs   = nullptr;
+				refOldData.MarkerSizes = nullptr;
+				refOldData.nMarkers    = 0;
+
+				sRigidBodyDescription* pDescr = refDescr.Data.RigidBodyDescription;
+				refDescr.Data.RigidBodyDescription = nullptr;
+				return pDescr;
+			}
+		}
+	}
+	return nullptr;
+}
+
+
+/**
+ * Takes over an unchanged skeleton description and its data from a previous scene.
+ *
+ * @return the skeleton description or <code>nullptr</code> if there is no matching skeleton
+ */
+static sSkeletonDescription* takeSkeleton(MoCapData& refOld, const sBodyDef& refBodyDef, sSkeletonData& refSkeletonData)
+{
+	for (int dIdx = 0; dIdx < refOld.description.nDataDescriptions; dIdx++)
+	{
+		sDataDescription& refDescr = refOld.description.arrDataDescriptions[dIdx];
+		if ((refDescr.type != Descriptor_Skeleton) || (refDescr.Data.SkeletonDescription == nullptr) ||
+		    !isSameSkeleton(refBodyDef, *refDescr.Data.SkeletonDescription))
+		{
+			continue;
+		}
+
+		for (int sIdx = 0; sIdx < refOld.frame.nSkeletons; sIdx++)
+		{
+			sSkeletonData& refOldData = refOld.frame.Skeletons[sIdx];
+			if ((refOldData.RigidBodyData != nullptr) && (refOldData.skeletonID == refDescr.Data.SkeletonDescription->skeletonID))
+			{
+				// move segment array to the new scene
+				refSkeletonData = refOldData;
+				refOldData.RigidBodyData = nullptr;
+				refOldData.nRigidBodies  = 0;
+
+				sSkeletonDescription* pDescr = refDescr.Data.SkeletonDescription;
+				refDescr.Data.SkeletonDescription = nullptr;
+				return pDescr;
+			}
+		}
+	}
+	return nullptr;
 }
 
 
@@ -100,11 +286,15 @@ MoCapCortex::MoCapCortex(MoCapCortexConfiguration _configuration) :
 	initialised(false),
 	running(true),
 	pCortexInfo(nullptr),
+	pCallbackFrame(nullptr),
+	nSceneDescriptions(0),
 	unitScaleFactor(1.0f),
 	updateRate(100.0f),
-	handleUnknownMarkers(false)
+	handleUnknownMarkers(false),
+	labelMarkers(false),
+	gapFiller(configuration.gapFillingFrames)
 {
-	// nothing else to do
+	eulerConverter.setOrder(configuration.eulerOrder);
 }
 
 
@@ -120,10 +310,15 @@ bool MoCapCortex::initialise()
 			<< (int)cortexSDK_Version[2] << "."
 			<< (int)cortexSDK_Version[3]);
 
+#ifdef USE_CORTEX_EMULATOR
+		CortexEmulator_Configure(configuration.emulatorSettings);
+#endif
+
 		LOG_INFO("Connecting to Cortex server at address " << configuration.remoteCortexAddress
 			<< (configuration.localCortexAddress.empty() ? "" : " from address ") << configuration.localCortexAddress);
 
 		// set up callback handler for logging and streaming
+		pCallbackInstance = this;
 		Cortex_SetErrorMsgHandlerFunc(callbackMoCapCortexMessageHandler);
 		Cortex_SetDataHandlerFunc(callbackMoCapCortexDataHandler);
 
@@ -162,7 +357,7 @@ bool MoCapCortex::initialise()
 				float unitToMillimeter = 1;
 				void *pResponse = nullptr;
 				int  iResponseSize = 0;
-				if (Cortex_Request("GetConversionToMillimeters", &pResponse, &iResponseSize) == RC_Okay)
+				if (Cortex_Request((char*) "GetConversionToMillimeters", &pResponse, &iResponseSize) == RC_Okay)
 				{
 					unitToMillimeter = *((float*)pResponse);
 					LOG_INFO("Units to millimeters: " << unitToMillimeter);
@@ -171,7 +366,7 @@ bool MoCapCortex::initialise()
 
 				// determine update rate
 				updateRate = 100.0f; // default usually around 100
-				if (Cortex_Request("GetContextFrameRate", &pResponse, &iResponseSize) == RC_Okay)
+				if (Cortex_Request((char*) "GetContextFrameRate", &pResponse, &iResponseSize) == RC_Okay)
 				{
 					updateRate = *((float*)pResponse);
 					LOG_INFO("Cortex Framerate: " << updateRate);
@@ -189,6 +384,12 @@ bool MoCapCortex::initialise()
 				Cortex_Exit();
 			}
 		}
+
+		if (!initialised)
+		{
+			Cortex_SetDataHandlerFunc(nullptr);
+			pCallbackInstance = nullptr;
+		}
 	}
 	return initialised;
 }
@@ -216,7 +417,7 @@ void MoCapCortex::setRunning(bool running)
 {
 	void  *pResponse = nullptr;
 	int   iResponseSize = 0;
-	char* czCommand = running ? "LiveMode" : "Pause";
+	char* czCommand = (char*) (running ? "LiveMode" : "Pause");
 	if (Cortex_Request(czCommand, &pResponse, &iResponseSize) == RC_Okay)
 	{
 		this->running = running;
@@ -241,7 +442,7 @@ bool MoCapCortex::getSceneDescription(MoCapData& refData)
 
 		if (pBodyDefs != nullptr)
 		{
-			convertCortexDescriptionToNatNet(*pBodyDefs, refData.description, refData.frame);
+			convertCortexDescriptionToNatNet(*pBodyDefs, refData);
 			Cortex_FreeBodyDefs(pBodyDefs);
 			success = true;
 		}
@@ -261,20 +462,26 @@ bool MoCapCortex::getFrameData(MoCapData& refData)
 
 	if (initialised)
 	{
+		// use the frame from the data callback without copying it,
 		// only request data from Cortex when not getting it via callback
-		sFrameOfData* pFrame = Cortex_GetCurrentFrame();
+		sFrameOfData* pFrame = (pCallbackFrame != nullptr) ? pCallbackFrame : Cortex_GetCurrentFrame();
 
 		if (pFrame != nullptr)
 		{
-			if (!convertCortexFrameToNatNet(*pFrame, refData.frame))
+			success = convertCortexFrameToNatNet(*pFrame, refData.frame);
+			if (!success)
 			{
-				// conversion failed - scene was updated?
-				getSceneDescription(refData);
-				// now try converting the frame again
-				convertCortexFrameToNatNet(*pFrame, refData.frame);
+				// conversion failed - scene was updated
+				// > patch the description with the new body definitions and try converting the frame again
+				success = getSceneDescription(refData) &&
+				          convertCortexFrameToNatNet(*pFrame, refData.frame);
+			}
+
+			// callback frames belong to the Cortex SDK, only free our own copies
+			if (pFrame != pCallbackFrame)
+			{
+				Cortex_FreeFrame(pFrame);
 			}
-			Cortex_FreeFrame(pFrame);
-			success = true;
 		}
 		else
 		{
@@ -286,6 +493,16 @@ bool MoCapCortex::getFrameData(MoCapData& refData)
 }
 
 
+void MoCapCortex::handleFrame(sFrameOfData* pFrameOfData)
+{
+	// the frame pointer is only valid during the callback,
+	// and signalNewFrame() calls getFrameData(...) synchronously
+	pCallbackFrame = pFrameOfData;
+	signalNewFrame();
+	pCallbackFrame = nullptr;
+}
+
+
 bool MoCapCortex::isHandlingUnknownMarkers()
 {
 	return handleUnknownMarkers;
@@ -299,6 +516,24 @@ void MoCapCortex::setHandleUnknownMarkers(bool enable)
 }
 
 
+bool MoCapCortex::isLabelingMarkers()
+{
+	return labelMarkers;
+}
+
+
+void MoCapCortex::setLabelMarkers(bool enable)
+{
+	if (enable && !labelMarkers)
+	{
+		// start with fresh IDs
+		markerLabeler.reset();
+	}
+	labelMarkers = enable;
+	LOG_INFO("Marker labeling: " << (labelMarkers ? "enabled" : "disabled"));
+}
+
+
 bool MoCapCortex::processCommand(const std::string& strCommand)
 {
 	bool processed = false;
@@ -317,6 +552,16 @@ bool MoCapCortex::processCommand(const std::string& strCommand)
 		setHandleUnknownMarkers(false);
 		processed = true;
 	}
+	else if (strCmdLowerCase == "enablemarkerlabeling")
+	{
+		setLabelMarkers(true);
+		processed = true;
+	}
+	else if (strCmdLowerCase == "disablemarkerlabeling")
+	{
+		setLabelMarkers(false);
+		processed = true;
+	}
 
 	return processed;
 }
@@ -327,6 +572,7 @@ bool MoCapCortex::deinitialise()
 	if (initialised)
 	{
 		Cortex_SetDataHandlerFunc(nullptr);
+		pCallbackInstance = nullptr;
 
 		delete pCortexInfo;
 		pCortexInfo = nullptr;
@@ -348,127 +594,273 @@ MoCapCortex::~MoCapCortex()
 }
 
 
-void MoCapCortex::convertCortexDescriptionToNatNet(sBodyDefs& refCortex, sDataDescriptions& refDescr, sFrameOfMocapData& refFrame)
+void MoCapCortex::convertCortexDescriptionToNatNet(sBodyDefs& refCortex, MoCapData& refData)
 {
+	// the server can read the current scene at any time,
+	// so the new scene is built in a separate structure and swapped in at the end.
+	// Descriptions and data arrays that are still valid are taken over from a shallow copy of the current scene,
+	// everything else is released together with that copy after the swap.
+	std::unique_ptr<MoCapData> pOld(new MoCapData());
+	pOld->description = refData.description;
+	pOld->description.nDataDescriptions = std::min(nSceneDescriptions, refData.description.nDataDescriptions);
+	pOld->frame       = refData.frame;
+	pOld->frame.OtherMarkers = nullptr; // stays with the current frame
+	pOld->frame.nForcePlates = 0;       // force plate data is not part of the Cortex scene
+
+	std::unique_ptr<MoCapData> pNew(new MoCapData());
+	sDataDescriptions& refDescr = pNew->description;
+	sFrameOfMocapData& refFrame = pNew->frame;
+
 	int idxDataBlock = 0;
-	int idxMarkerSet = 0;
-	int idxRigidBody = 0;
-	int idxSkeleton = 0;
+	int nReused      = 0;
+	int nCreated     = 0;
 
 	for (int iBodyIdx = 0; iBodyIdx < refCortex.nBodyDefs; iBodyIdx++)
 	{
 		sBodyDef& bodyDef = refCortex.BodyDefs[iBodyIdx];
 
-		// create markerset description and markerset data
-		sMarkerSetDescription* pMarkerSetDescr = new sMarkerSetDescription;
-		sMarkerSetData&        refMarkerSetData = refFrame.MocapData[idxMarkerSet];
+		// reuse or create markerset description and markerset data
+		sMarkerSetData&        refMarkerSetData = refFrame.MocapData[refFrame.nMarkerSets];
+		sMarkerSetDescription* pMarkerSetDescr  = takeMarkerSet(*pOld, bodyDef, refMarkerSetData);
+		if (pMarkerSetDescr != nullptr)
+		{
+			nReused++;
+		}
+		else
+		{
+			pMarkerSetDescr = new sMarkerSetDescription;
 
-		// markerset name
-		strncpy_s(pMarkerSetDescr->szName, bodyDef.szName, sizeof(pMarkerSetDescr->szName));
-		strncpy_s(refMarkerSetData.szName, bodyDef.szName, sizeof(refMarkerSetData.szName));
+			// markerset name
+			strncpy_s(pMarkerSetDescr->szName, bodyDef.szName, sizeof(pMarkerSetDescr->szName));
+			strncpy_s(refMarkerSetData.szName, bodyDef.szName, sizeof(refMarkerSetData.szName));
 
-		// number of markers
-		int nMarkers = bodyDef.nMarkers;
-		pMarkerSetDescr->nMarkers = nMarkers;
-		refMarkerSetData.nMarkers = nMarkers;
+			// number of markers
+			int nMarkers = bodyDef.nMarkers;
+			pMarkerSetDescr->nMarkers = nMarkers;
+			refMarkerSetData.nMarkers = nMarkers;
 
-		// array of marker names
-		pMarkerSetDescr->szMarkerNames = new char*[nMarkers];
-		for (int mIdx = 0; mIdx < bodyDef.nMarkers; mIdx++)
-		{
-			pMarkerSetDescr->szMarkerNames[mIdx] = _strdup(bodyDef.szMarkerNames[mIdx]);
-		}
+			// array of marker names
+			pMarkerSetDescr->szMarkerNames = new char*[nMarkers];
+			for (int mIdx = 0; mIdx < bodyDef.nMarkers; mIdx++)
+			{
+				pMarkerSetDescr->szMarkerNames[mIdx] = MoCapData::duplicateName(bodyDef.szMarkerNames[mIdx]);
+			}
 
-		// array of marker data
-		refMarkerSetData.Markers = new MarkerData[nMarkers];
+			// array of marker data
+			refMarkerSetData.Markers = new MarkerData[nMarkers];
+			nCreated++;
+		}
 
 		// add to description block
 		refDescr.arrDataDescriptions[idxDataBlock].type = Descriptor_MarkerSet;
 		refDescr.arrDataDescriptions[idxDataBlock].Data.MarkerSetDescription = pMarkerSetDescr;
 		idxDataBlock++;
-		idxMarkerSet++;
+		refFrame.nMarkerSets++;
 
 		sHierarchy& refSkeleton = bodyDef.Hierarchy;
 		if (refSkeleton.nSegments == 1)
 		{
 			// one bone skeleton -> treat as rigid body
-			// create rigid body description
-			sRigidBodyDescription* pRigidBodyDescr = new sRigidBodyDescription;
-			strncpy_s(pRigidBodyDescr->szName, bodyDef.szName, sizeof(pRigidBodyDescr->szName)); // rigid body name
-			pRigidBodyDescr->ID = iBodyIdx; // rigid body ID = actor ID
-			pRigidBodyDescr->parentID = -1; // no parent
-			pRigidBodyDescr->offsetx  = 0;   // the offset does not exist in Cortex data
-			pRigidBodyDescr->offsety  = 0;
-			pRigidBodyDescr->offsetz  = 0;
-
-			// pre-fill rigid body frame data structure
-			sRigidBodyData& refRigidBodyData = refFrame.RigidBodies[idxRigidBody];
-			refRigidBodyData.ID          = pRigidBodyDescr->ID;
-			refRigidBodyData.nMarkers    = 0;
-			refRigidBodyData.Markers     = nullptr;
-			refRigidBodyData.MarkerIDs   = nullptr;
-			refRigidBodyData.MarkerSizes = nullptr;
-			refRigidBodyData.MeanError   = 0;
+			// reuse or create rigid body description
+			sRigidBodyData&        refRigidBodyData = refFrame.RigidBodies[refFrame.nRigidBodies];
+			sRigidBodyDescription* pRigidBodyDescr  = takeRigidBody(*pOld, bodyDef, refRigidBodyData);
+			if (pRigidBodyDescr != nullptr)
+			{
+				nReused++;
+			}
+			else
+			{
+				pRigidBodyDescr = new sRigidBodyDescription;
+				strncpy_s(pRigidBodyDescr->szName, bodyDef.szName, sizeof(pRigidBodyDescr->szName)); // rigid body name
+				pRigidBodyDescr->parentID = -1; // no parent
+				pRigidBodyDescr->offsetx  = 0;   // the offset does not exist in Cortex data
+				pRigidBodyDescr->offsety  = 0;
+				pRigidBodyDescr->offsetz  = 0;
+
+				// pre-fill rigid body frame data structure
+				refRigidBodyData.nMarkers    = 0;
+				refRigidBodyData.Markers     = nullptr;
+				refRigidBodyData.MarkerIDs   = nullptr;
+				refRigidBodyData.MarkerSizes = nullptr;
+				refRigidBodyData.MeanError   = 0;
+				nCreated++;
+			}
+			// rigid body ID = actor ID (which can change when other actors are removed)
+			pRigidBodyDescr->ID  = iBodyIdx;
+			refRigidBodyData.ID  = iBodyIdx;
 
 			// add to scene description
 			refDescr.arrDataDescriptions[idxDataBlock].type = Descriptor_RigidBody;
 			refDescr.arrDataDescriptions[idxDataBlock].Data.RigidBodyDescription = pRigidBodyDescr;
 			idxDataBlock++;
-			idxRigidBody++;
+			refFrame.nRigidBodies++;
 		}
 		else if (refSkeleton.nSegments > 0)
 		{
 			// skeleton data included as well
-			// create skeleton description and skeleton data
-			sSkeletonDescription* pSkeletonDescr = new sSkeletonDescription;
-			sSkeletonData&        refSkeletonData = refFrame.Skeletons[idxSkeleton];
-			strncpy_s(pSkeletonDescr->szName, bodyDef.szName, sizeof(pSkeletonDescr->szName)); // markerset name = skeleton name
-			pSkeletonDescr->skeletonID = iBodyIdx; // skeleton ID
-			refSkeletonData.skeletonID = iBodyIdx;
-			int nSegments = refSkeleton.nSegments;
-			pSkeletonDescr->nRigidBodies = nSegments; // number of segments
-			refSkeletonData.nRigidBodies = nSegments;
-			refSkeletonData.RigidBodyData = new sRigidBodyData[nSegments];  // array of skeleton data
-			for (int sIdx = 0; sIdx < nSegments; sIdx++)
+			// reuse or create skeleton description and skeleton data
+			sSkeletonData&        refSkeletonData = refFrame.Skeletons[refFrame.nSkeletons];
+			sSkeletonDescription* pSkeletonDescr  = takeSkeleton(*pOld, bodyDef, refSkeletonData);
+			if (pSkeletonDescr != nullptr)
 			{
-				// create skeleton segment description
-				sRigidBodyDescription& refRigidBodyDescr = pSkeletonDescr->RigidBodies[sIdx];
-				strncpy_s(refRigidBodyDescr.szName, refSkeleton.szSegmentNames[sIdx], sizeof(refRigidBodyDescr.szName)); // segment name
-				refRigidBodyDescr.ID = sIdx; // segment ID
-				refRigidBodyDescr.parentID = refSkeleton.iParents[sIdx]; // segment parent
-				refRigidBodyDescr.offsetx = 0;   // the offset does not exist in Cortex data
-				refRigidBodyDescr.offsety = 0;
-				refRigidBodyDescr.offsetz = 0;
-
-				// pre-fill skeleton segment frame data structure
-				sRigidBodyData&  refRigidBodyData = refSkeletonData.RigidBodyData[sIdx];
-				refRigidBodyData.ID          = refRigidBodyDescr.ID;
-				refRigidBodyData.nMarkers    = 0;
-				refRigidBodyData.Markers     = nullptr;
-				refRigidBodyData.MarkerIDs   = nullptr;
-				refRigidBodyData.MarkerSizes = nullptr;
-				refRigidBodyData.MeanError   = 0;
+				nReused++;
 			}
+			else
+			{
+				pSkeletonDescr = new sSkeletonDescription;
+				strncpy_s(pSkeletonDescr->szName, bodyDef.szName, sizeof(pSkeletonDescr->szName)); // markerset name = skeleton name
+				int nSegments = refSkeleton.nSegments;
+				pSkeletonDescr->nRigidBodies = nSegments; // number of segments
+				refSkeletonData.nRigidBodies = nSegments;
+				refSkeletonData.RigidBodyData = new sRigidBodyData[nSegments];  // array of skeleton data
+				for (int sIdx = 0; sIdx < nSegments; sIdx++)
+				{
+					// create skeleton segment description
+					sRigidBodyDescription& refRigidBodyDescr = pSkeletonDescr->RigidBodies[sIdx];
+					strncpy_s(refRigidBodyDescr.szName, refSkeleton.szSegmentNames[sIdx], sizeof(refRigidBodyDescr.szName)); // segment name
+					refRigidBodyDescr.ID = sIdx; // segment ID
+					refRigidBodyDescr.parentID = refSkeleton.iParents[sIdx]; // segment parent
+					refRigidBodyDescr.offsetx = 0;   // the offset does not exist in Cortex data
+					refRigidBodyDescr.offsety = 0;
+					refRigidBodyDescr.offsetz = 0;
+
+					// pre-fill skeleton segment frame data structure
+					sRigidBodyData&  refRigidBodyData = refSkeletonData.RigidBodyData[sIdx];
+					refRigidBodyData.ID          = refRigidBodyDescr.ID;
+					refRigidBodyData.nMarkers    = 0;
+					refRigidBodyData.Markers     = nullptr;
+					refRigidBodyData.MarkerIDs   = nullptr;
+					refRigidBodyData.MarkerSizes = nullptr;
+					refRigidBodyData.MeanError   = 0;
+				}
+				nCreated++;
+			}
+			// skeleton ID = actor ID (which can change when other actors are removed)
+			pSkeletonDescr->skeletonID = iBodyIdx;
+			refSkeletonData.skeletonID = iBodyIdx;
+
 			// add to description
 			refDescr.arrDataDescriptions[idxDataBlock].type = Descriptor_Skeleton;
 			refDescr.arrDataDescriptions[idxDataBlock].Data.SkeletonDescription = pSkeletonDescr;
 			idxDataBlock++;
-			idxSkeleton++;
+			refFrame.nSkeletons++;
+		}
+	}
+
+	int nCortexDescriptions = idxDataBlock;
+
+	// keep the descriptions that were appended after the Cortex descriptions (e.g., from the interaction system)
+	const sDataDescriptions& refCurrentDescr = refData.description;
+	for (int dIdx = nSceneDescriptions; dIdx < refCurrentDescr.nDataDescriptions; dIdx++)
+	{
+		if (idxDataBlock < MAX_MODELS)
+		{
+			refDescr.arrDataDescriptions[idxDataBlock] = refCurrentDescr.arrDataDescriptions[dIdx];
+			idxDataBlock++;
+		}
+		else
+		{
+			LOG_WARNING("Not enough space for description " << dIdx);
 		}
 	}
+
 	// store amount of data blocks
 	refDescr.nDataDescriptions = idxDataBlock;
 
-	// prepare amount of items in frame data
-	refFrame.nMarkerSets = idxMarkerSet;
-	refFrame.nOtherMarkers = 0;
-	refFrame.OtherMarkers = new MarkerData[MAX_UNKNOWN_MARKERS];
-	refFrame.nRigidBodies = idxRigidBody;
-	refFrame.nSkeletons = idxSkeleton;
-	refFrame.nLabeledMarkers = 0;
-	refFrame.nForcePlates = 0;
-	refFrame.Timecode = 0;
-	refFrame.TimecodeSubframe = 0;
+	int nRemoved = 0;
+	for (int dIdx = 0; dIdx < pOld->description.nDataDescriptions; dIdx++)
+	{
+		if (pOld->description.arrDataDescriptions[dIdx].Data.MarkerSetDescription != nullptr)
+		{
+			nRemoved++; // not taken over > will be released
+		}
+	}
+
+	// marker order might have changed > restart gap filling
+	gapFiller.setMarkerCount(0);
+
+	bool updated = (refCurrentDescr.nDataDescriptions > 0);
+	{
+		std::lock_guard<std::mutex> lock(getSceneDescriptionMutex());
+
+		refData.description = refDescr;
+
+		sFrameOfMocapData& refCurrentFrame = refData.frame;
+		std::copy(refFrame.MocapData,   refFrame.MocapData   + refFrame.nMarkerSets,  refCurrentFrame.MocapData);
+		std::copy(refFrame.RigidBodies, refFrame.RigidBodies + refFrame.nRigidBodies, refCurrentFrame.RigidBodies);
+		std::copy(refFrame.Skeletons,   refFrame.Skeletons   + refFrame.nSkeletons,   refCurrentFrame.Skeletons);
+		refCurrentFrame.nMarkerSets  = refFrame.nMarkerSets;
+		refCurrentFrame.nRigidBodies = refFrame.nRigidBodies;
+		refCurrentFrame.nSkeletons   = refFrame.nSkeletons;
+
+		// prepare amount of items in frame data
+		if (refCurrentFrame.OtherMarkers == nullptr)
+		{
+			refCurrentFrame.nOtherMarkers = 0;
+			refCurrentFrame.OtherMarkers  = new MarkerData[MAX_UNKNOWN_MARKERS];
+		}
+		refCurrentFrame.Timecode = 0;
+		refCurrentFrame.TimecodeSubframe = 0;
+
+		if (updated)
+		{
+			refData.sceneVersion++;
+		}
+
+		// the current scene owns the new descriptions and data now,
+		// the ones that have not been taken over can be released
+		pNew->reset();
+		pOld.reset();
+	}
+	nSceneDescriptions = nCortexDescriptions;
+
+	if (updated)
+	{
+		LOG_INFO("Scene description updated (" 
+			<< nReused << " descriptions kept, " 
+			<< nCreated << " created, " 
+			<< nRemoved << " removed)");
+	}
+}
+
+
+bool MoCapCortex::isMatchingCortexFrame(sFrameOfData& refCortex, sFrameOfMocapData& refNatNet)
+{
+	if (refCortex.nBodies != refNatNet.nMarkerSets)
+	{
+		LOG_INFO("Mismatch in actor count");
+		return false;
+	}
+
+	for (int bIdx = 0; bIdx < refCortex.nBodies; bIdx++)
+	{
+		if ((refCortex.BodyData[bIdx].nMarkers != refNatNet.MocapData[bIdx].nMarkers) ||
+		    (strcmp(refCortex.BodyData[bIdx].szName, refNatNet.MocapData[bIdx].szName) != 0))
+		{
+			LOG_INFO("Mismatch in actor " << refCortex.BodyData[bIdx].szName);
+			return false;
+		}
+	}
+
+	for (int rIdx = 0; rIdx < refNatNet.nRigidBodies; rIdx++)
+	{
+		if (refCortex.BodyData[refNatNet.RigidBodies[rIdx].ID].nSegments != 1)
+		{
+			LOG_INFO("Mismatch in segment count");
+			return false;
+		}
+	}
+
+	for (int sIdx = 0; sIdx < refNatNet.nSkeletons; sIdx++)
+	{
+		if (refCortex.BodyData[refNatNet.Skeletons[sIdx].skeletonID].nSegments != refNatNet.Skeletons[sIdx].nRigidBodies)
+		{
+			LOG_INFO("Mismatch in segment count");
+			return false;
+		}
+	}
+
+	return true;
 }
 
 
@@ -477,9 +869,9 @@ bool MoCapCortex::convertCortexFrameToNatNet(sFrameOfData& refCortex, sFrameOfMo
 	refNatNet.iFrame = refCortex.iFrame;
 	refNatNet.fLatency = refCortex.fDelay;
 
-	if (refCortex.nBodies != refNatNet.nMarkerSets)
+	// scene changed? > description needs to be updated first
+	if (!isMatchingCortexFrame(refCortex, refNatNet))
 	{
-		LOG_ERROR("Mismatch in actor count");
 		return false;
 	}
 
@@ -489,17 +881,36 @@ bool MoCapCortex::convertCortexFrameToNatNet(sFrameOfData& refCortex, sFrameOfMo
 		convertCortexMarkerSetToNatNet(refCortex.BodyData[mIdx], refNatNet.MocapData[mIdx]);
 	}
 
+	// collect the rotations of all rigid body and skeleton segments
+	// so they can be converted in one batch
+	eulerConverter.clear();
+	for (int rIdx = 0; rIdx < refNatNet.nRigidBodies; rIdx++)
+	{
+		int sourceIdx = refNatNet.RigidBodies[rIdx].ID;
+		addCortexSegmentRotation(refCortex.BodyData[sourceIdx].Segments[0]);
+	}
+	for (int sIdx = 0; sIdx < refNatNet.nSkeletons; sIdx++)
+	{
+		sBodyData& refBody = refCortex.BodyData[refNatNet.Skeletons[sIdx].skeletonID];
+		for (int segIdx = 0; segIdx < refBody.nSegments; segIdx++)
+		{
+			addCortexSegmentRotation(refBody.Segments[segIdx]);
+		}
+	}
+	eulerConverter.convert();
+
 	// copy rigid body data
+	size_t rotationIdx = 0;
 	for (int rIdx = 0; rIdx < refNatNet.nRigidBodies; rIdx++)
 	{
 		int sourceIdx = refNatNet.RigidBodies[rIdx].ID;
-		convertCortexSegmentToNatNet(refCortex.BodyData[sourceIdx].Segments[0], refNatNet.RigidBodies[rIdx]);
+		convertCortexSegmentToNatNet(refCortex.BodyData[sourceIdx].Segments[0], rotationIdx++, refNatNet.RigidBodies[rIdx]);
 	}
 
 	if (handleUnknownMarkers)
 	{
 		// copy unidentified marker data
-		refNatNet.nOtherMarkers = refCortex.nUnidentifiedMarkers;
+		refNatNet.nOtherMarkers = std::min(refCortex.nUnidentifiedMarkers, MAX_UNKNOWN_MARKERS);
 		for (int mIdx = 0; mIdx < refNatNet.nOtherMarkers; mIdx++)
 		{
 			convertCortexMarkerToNatNet(refCortex.UnidentifiedMarkers[mIdx], refNatNet.OtherMarkers[mIdx]);
@@ -507,14 +918,27 @@ bool MoCapCortex::convertCortexFrameToNatNet(sFrameOfData& refCortex, sFrameOfMo
 	}
 	else
 	{
-		refNatNet.OtherMarkers = 0;
+		refNatNet.nOtherMarkers = 0;
+	}
+
+	refNatNet.nLabeledMarkers = 0;
+	if (labelMarkers)
+	{
+		// track unidentified markers with stable IDs
+		labelCortexMarkers(refCortex, refNatNet);
+	}
+
+	if (gapFiller.getMaxGapLength() > 0)
+	{
+		// predict occluded actor markers
+		fillCortexMarkerGaps(refCortex, refNatNet);
 	}
 
 	// copy skeleton data
 	for (int sIdx = 0; sIdx < refNatNet.nSkeletons; sIdx++)
 	{
 		int sourceIdx = refNatNet.Skeletons[sIdx].skeletonID;
-		convertCortexSegmentsToNatNet(refCortex.BodyData[sourceIdx], refNatNet.Skeletons[sIdx]);
+		convertCortexSegmentsToNatNet(refCortex.BodyData[sourceIdx], rotationIdx, refNatNet.Skeletons[sIdx]);
 	}
 
 	return true;
@@ -554,10 +978,111 @@ void MoCapCortex::convertCortexMarkerSetToNatNet(sBodyData& refCortex, sMarkerSe
 }
 
 
-void MoCapCortex::convertCortexSegmentToNatNet(double refCortex[], sRigidBodyData& refNatNet)
+void MoCapCortex::labelCortexMarkers(sFrameOfData& refCortex, sFrameOfMocapData& refNatNet)
+{
+	// collect valid positions (in units)
+	arrUnknownPositions.clear();
+	for (int mIdx = 0; mIdx < refCortex.nUnidentifiedMarkers; mIdx++)
+	{
+		tMarkerData& refMarker = refCortex.UnidentifiedMarkers[mIdx];
+		if (refMarker[0] < XEMPTY)
+		{
+			arrUnknownPositions.push_back(refMarker[0] * unitScaleFactor);
+			arrUnknownPositions.push_back(refMarker[1] * unitScaleFactor);
+			arrUnknownPositions.push_back(refMarker[2] * unitScaleFactor);
+		}
+	}
+
+	int nMarkers = (int)arrUnknownPositions.size() / 3;
+	markerLabeler.update(arrUnknownPositions.data(), nMarkers);
+
+	for (int mIdx = 0; (mIdx < nMarkers) && (refNatNet.nLabeledMarkers < MAX_LABELED_MARKERS); mIdx++)
+	{
+		sMarker& refLabeled = refNatNet.LabeledMarkers[refNatNet.nLabeledMarkers++];
+		refLabeled.ID     = markerLabeler.getMarkerID(mIdx); // model ID 0 in the upper 16 bits
+		refLabeled.x      = arrUnknownPositions[3 * mIdx + 0];
+		refLabeled.y      = arrUnknownPositions[3 * mIdx + 1];
+		refLabeled.z      = arrUnknownPositions[3 * mIdx + 2];
+		refLabeled.size   = 0;
+		refLabeled.params = 0;
+	}
+}
+
+
+void MoCapCortex::fillCortexMarkerGaps(sFrameOfData& refCortex, sFrameOfMocapData& refNatNet)
+{
+	// pass all actor markers to the filter
+	int nMarkers = 0;
+	for (int msIdx = 0; msIdx < refNatNet.nMarkerSets; msIdx++)
+	{
+		nMarkers += refNatNet.MocapData[msIdx].nMarkers;
+	}
+	gapFiller.setMarkerCount(nMarkers);
+
+	int filterIdx = 0;
+	for (int msIdx = 0; msIdx < refNatNet.nMarkerSets; msIdx++)
+	{
+		sBodyData& refBody = refCortex.BodyData[msIdx];
+		for (int mIdx = 0; mIdx < refBody.nMarkers; mIdx++, filterIdx++)
+		{
+			tMarkerData& refMarker = refBody.Markers[mIdx];
+			if (refMarker[0] < XEMPTY)
+			{
+				gapFiller.setMarker(filterIdx,
+					refMarker[0] * unitScaleFactor,
+					refMarker[1] * unitScaleFactor,
+					refMarker[2] * unitScaleFactor);
+			}
+			else
+			{
+				gapFiller.setMarkerMissing(filterIdx);
+			}
+		}
+	}
+	gapFiller.update();
+
+	// replace the zeroed positions of missing markers by predictions
+	// and flag them as occluded labeled markers (model ID: markerset index + 1)
+	filterIdx = 0;
+	for (int msIdx = 0; msIdx < refNatNet.nMarkerSets; msIdx++)
+	{
+		sMarkerSetData& refMarkerSet = refNatNet.MocapData[msIdx];
+		for (int mIdx = 0; mIdx < refMarkerSet.nMarkers; mIdx++, filterIdx++)
+		{
+			MarkerData& refMarker = refMarkerSet.Markers[mIdx];
+			if (gapFiller.getPrediction(filterIdx, refMarker[0], refMarker[1], refMarker[2]) &&
+			    (refNatNet.nLabeledMarkers < MAX_LABELED_MARKERS))
+			{
+				sMarker& refLabeled = refNatNet.LabeledMarkers[refNatNet.nLabeledMarkers++];
+				refLabeled.ID     = ((msIdx + 1) << 16) | (mIdx + 1);
+				refLabeled.x      = refMarker[0];
+				refLabeled.y      = refMarker[1];
+				refLabeled.z      = refMarker[2];
+				refLabeled.size   = 0;
+				refLabeled.params = MARKER_OCCLUDED;
+			}
+		}
+	}
+}
+
+
+void MoCapCortex::addCortexSegmentRotation(double refCortex[])
+{
+	if (refCortex[0] < XEMPTY) // check for valid data
+	{
+		eulerConverter.add((float)refCortex[3], (float)refCortex[4], (float)refCortex[5]);
+	}
+	else
+	{
+		// segment data not available -> neutral pose
+		eulerConverter.add(0, 0, 0);
+	}
+}
+
+
+void MoCapCortex::convertCortexSegmentToNatNet(double refCortex[], size_t rotationIdx, sRigidBodyData& refNatNet)
 {
-	Vector3D   pos;
-	Quaternion rot;
+	Vector3D pos;
 
 	if (refCortex[0] < XEMPTY) // check for valid data
 	{
@@ -565,16 +1090,8 @@ void MoCapCortex::convertCortexSegmentToNatNet(double refCortex[], sRigidBodyDat
 		pos.y = (float)refCortex[1] * unitScaleFactor;
 		pos.z = (float)refCortex[2] * unitScaleFactor;
 
-		// convert Euler rotation from Cortex (default: ZYX) to Quaternion
-		Quaternion rotX(1, 0, 0, (float)RADIANS(refCortex[3])); // rotX
-		Quaternion rotY(0, 1, 0, (float)RADIANS(refCortex[4])); // rotY
-		Quaternion rotZ(0, 0, 1, (float)RADIANS(refCortex[5])); // rotZ
-		rot.mult(rotZ).mult(rotY).mult(rotX);
-
 		refNatNet.params    = STATUS_TRACKED;
-		refNatNet.MeanError = (refCortex[0] < XEMPTY) ?
-		                        (float)refCortex[6] * unitScaleFactor : // ATTENTION: Abusing mean error for bone length
-		                        0.0f;
+		refNatNet.MeanError = (float)refCortex[6] * unitScaleFactor; // ATTENTION: Abusing mean error for bone length
 	}
 	else
 	{
@@ -587,14 +1104,12 @@ void MoCapCortex::convertCortexSegmentToNatNet(double refCortex[], sRigidBodyDat
 	refNatNet.y = pos.y;
 	refNatNet.z = pos.z;
 
-	refNatNet.qx = rot.x;
-	refNatNet.qy = rot.y;
-	refNatNet.qz = rot.z;
-	refNatNet.qw = rot.w;
+	// rotation has been converted from Euler angles in the batch before
+	eulerConverter.getQuaternion(rotationIdx, refNatNet.qx, refNatNet.qy, refNatNet.qz, refNatNet.qw);
 }
 
 
-void MoCapCortex::convertCortexSegmentsToNatNet(sBodyData& refCortex, sSkeletonData& refNatNet)
+void MoCapCortex::convertCortexSegmentsToNatNet(sBodyData& refCortex, size_t& refRotationIdx, sSkeletonData& refNatNet)
 {
 	if (refCortex.nSegments != refNatNet.nRigidBodies)
 	{
@@ -604,7 +1119,7 @@ void MoCapCortex::convertCortexSegmentsToNatNet(sBodyData& refCortex, sSkeletonD
 
 	for (int sIdx = 0; sIdx < refCortex.nSegments; sIdx++)
 	{
-		convertCortexSegmentToNatNet(refCortex.Segments[sIdx], refNatNet.RigidBodyData[sIdx]);
+		convertCortexSegmentToNatNet(refCortex.Segments[sIdx], refRotationIdx++, refNatNet.RigidBodyData[sIdx]);
 	}
 }
 
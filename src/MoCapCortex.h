@@ -8,10 +8,16 @@
 
 #ifdef USE_CORTEX
 
+#ifndef USE_CORTEX_EMULATOR
 #pragma comment(lib, "Cortex_SDK.lib")
+#endif
 
 #include "MoCapSystem.h"
 #include "Configuration.h"
+#include "EulerConverter.h"
+#include "MarkerLabeler.h"
+#include "MarkerGapFiller.h"
+#include "CortexEmulator.h"
 #include "Cortex.h"
 
 
@@ -27,6 +33,12 @@ public:
 	bool        useCortex;
 	std::string remoteCortexAddress;
 	std::string localCortexAddress;
+	EulerOrder  eulerOrder;
+	int         gapFillingFrames;
+
+#ifdef USE_CORTEX_EMULATOR
+	CortexEmulatorSettings emulatorSettings;
+#endif
 };
 
 
@@ -63,13 +75,44 @@ public:
 	 */
 	void  setHandleUnknownMarkers(bool enable);
 
+	/**
+	 * Checks if unknown markers are labeled with IDs that are stable across frames.
+	 *
+	 * @return <code>true</code> if unknown markers are labeled
+	 */
+	bool  isLabelingMarkers();
+
+	/**
+	 * Enables or disables labeling of unknown markers.
+	 * Labeled markers are sent as NatNet labeled markers with model ID 0.
+	 *
+	 * @param enable  <code>true</code> to enable labeling of unknown markers
+	 */
+	void  setLabelMarkers(bool enable);
+
+	/**
+	 * Converts and streams a frame received through the Cortex data callback.
+	 *
+	 * @param pFrameOfData  the frame from the callback (owned by the Cortex SDK)
+	 */
+	void  handleFrame(sFrameOfData* pFrameOfData);
+
 
 private:
 
 	/**
 	 * Converts the scene description from Cortex to NatNet.
+	 * Descriptions and data of bodies that have not changed since the last call are kept,
+	 * only added or changed bodies are created and removed ones are released.
+	 * Descriptions that other parts of the server have appended are kept after the Cortex descriptions.
+	 * The new scene replaces the current one while the scene description mutex is locked.
 	 */
-	void convertCortexDescriptionToNatNet(sBodyDefs& refCortex, sDataDescriptions& refDescr, sFrameOfMocapData& refFrame);
+	void convertCortexDescriptionToNatNet(sBodyDefs& refCortex, MoCapData& refData);
+
+	/**
+	 * Checks if the structure of a Cortex frame matches the current scene description.
+	 */
+	bool isMatchingCortexFrame(sFrameOfData& refCortex, sFrameOfMocapData& refNatNet);
 
 	/**
 	 * Converts frame data from Cortex to NatNet.
@@ -77,21 +120,33 @@ private:
 	bool convertCortexFrameToNatNet(sFrameOfData& refCortex, sFrameOfMocapData& refFrame);
 	void convertCortexMarkerToNatNet(tMarkerData& refCortex, MarkerData& refNatNet);
 	void convertCortexMarkerSetToNatNet(sBodyData& refCortex, sMarkerSetData& refNatNet);
-	void convertCortexSegmentToNatNet(double refCortex[], sRigidBodyData& refNatNet);
-	void convertCortexSegmentsToNatNet(sBodyData& refCortex, sSkeletonData& refNatNet);
+	void labelCortexMarkers(sFrameOfData& refCortex, sFrameOfMocapData& refNatNet);
+	void fillCortexMarkerGaps(sFrameOfData& refCortex, sFrameOfMocapData& refNatNet);
+	void addCortexSegmentRotation(double refCortex[]);
+	void convertCortexSegmentToNatNet(double refCortex[], size_t rotationIdx, sRigidBodyData& refNatNet);
+	void convertCortexSegmentsToNatNet(sBodyData& refCortex, size_t& refRotationIdx, sSkeletonData& refNatNet);
 
 private:
 
 	MoCapCortexConfiguration configuration;
 
-	bool       initialised;
-	bool       running;
+	bool          initialised;
+	bool          running;
 	
-	sHostInfo* pCortexInfo;
+	sHostInfo*    pCortexInfo;
+	sFrameOfData* pCallbackFrame; // frame from the data callback while it is being processed
+
+	int           nSceneDescriptions; // descriptions at the start of the scene that belong to Cortex
+
+	float         unitScaleFactor;
+	float         updateRate;
+	bool          handleUnknownMarkers;
+	bool          labelMarkers;
 
-	float      unitScaleFactor;
-	float      updateRate;
-	bool       handleUnknownMarkers;
+	EulerConverter     eulerConverter;        // batch conversion of the segment rotations per frame
+	MarkerLabeler      markerLabeler;         // tracking of unknown markers
+	MarkerGapFiller    gapFiller;             // prediction of occluded actor markers
+	std::vector<float> arrUnknownPositions;   // positions of the unknown markers for labeling
 
 };
 
@@ -27,6 +27,7 @@ void MoCapData::reset()
 	// reset data structure
 	memset(&description, 0, sizeof(description));
 	memset(&frame, 0, sizeof(frame));
+	sceneVersion = 0;
 }
 
 
@@ -53,6 +54,14 @@ void MoCapData::applyScale(float scale)
 		rigidBody.MeanError *= scale; // "abused" for bone length
 	}
 
+	for (int lmIdx = 0; lmIdx < frame.nLabeledMarkers; lmIdx++)
+	{
+		sMarker& marker = frame.LabeledMarkers[lmIdx];
+		marker.x *= scale;
+		marker.y *= scale;
+		marker.z *= scale;
+	}
+
 	for (int sIdx = 0; sIdx < frame.nSkeletons; sIdx++)
 	{
 		sSkeletonData& skeleton = frame.Skeletons[sIdx];
@@ -183,6 +192,15 @@ void MoCapData::resetSkeletonData(sSkeletonData&  refSkeletonData) const
 }
 
 
+char* MoCapData::duplicateName(const char* czName)
+{
+	size_t len   = strlen(czName) + 1;
+	char*  czDup = new char[len];
+	memcpy(czDup, czName, len);
+	return czDup;
+}
+
+
 void MoCapData::freeNatNetDescription()
 {
 	for (int dataBlockIdx = 0; dataBlockIdx < description.nDataDescriptions; dataBlockIdx++)
@@ -226,6 +244,9 @@ void MoCapData::freeNatNetDescription()
 
 void MoCapData::freeNatNetMarkerSetDescription(sMarkerSetDescription* pMarkerSet)
 {
+	// description might have been taken over by another instance
+	if (pMarkerSet == nullptr) return;
+
 	// release marker names
 	for (int mIdx = 0; mIdx < pMarkerSet->nMarkers; mIdx++)
 	{
@@ -7,10 +7,15 @@
 
 #include "NatNetTypes.h"
 
+#include <iosfwd>
+
 // constants for the RigidBody.param field
 #define STATUS_NOT_TRACKED ((short) 0x00)
 #define STATUS_TRACKED     ((short) 0x01)
 
+// constants for the LabeledMarker.params field
+#define MARKER_OCCLUDED    ((short) 0x01) // position is predicted because the marker was not visible
+
 
 class MoCapData
 {
@@ -32,6 +37,16 @@ public:
 	void resetRigidBodyData(sRigidBodyData& refRigidBodyData) const;
 	void resetSkeletonData( sSkeletonData&  refSkeletonData) const;
 
+	/**
+	 * Creates a copy of a name for a description structure,
+	 * allocated the same way that the structures are released.
+	 *
+	 * @param czName  the name to copy
+	 *
+	 * @return the copy of the name
+	 */
+	static char* duplicateName(const char* czName);
+
 private:
 
 	// Internal methods for freeing dynamically allocated data structures
@@ -50,6 +65,19 @@ private:
 public:
 	sDataDescriptions description;
 	sFrameOfMocapData frame;
+	int               sceneVersion; // incremented whenever the description changes after the initial setup
 
 };
 
+
+/**
+ * Prints the model definition into an output stream. 
+ */
+void printModelDefinitions(std::ostream& refOutput, sDataDescriptions& refData);
+
+
+/**
+* Prints the current frame information into an output stream.
+*/
+void printFrameOfData(std::ostream& refOutput, sFrameOfMocapData& refData);
+
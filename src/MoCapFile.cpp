@@ -1,6 +1,7 @@
 #include "MoCapFile.h"
 
 #include "Logging.h"
+#include "Portability.h"
 #undef   LOG_CLASS
 
 #include <algorithm>
@@ -65,7 +66,7 @@ bool MoCapFileWriter::writeSceneDescription(const MoCapData& refData)
 	if (openFile())
 	{
 		// header
-		writeTag(TAG_HEADER); write(2); write(updateRate);  nextLine(); // 2: File version
+		writeTag(TAG_HEADER); write(3); write(updateRate);  nextLine(); // 3: File version
 
 		// description block intro and count
 		writeTag(TAG_SECTION_DESCRIPTIONS); write(refData.description.nDataDescriptions); nextLine();
@@ -371,7 +372,10 @@ void MoCapFileWriter::writeFrameDataColumnNames(const MoCapData& refData)
 				sprintf_s(czChannelName, "C%d", chIdx);
 			}
 
-			writeColumnName(czForcePlateName, czChannelName);
+			// variable length: "values" heads the first of subframeCount value columns,
+			// so the amount of columns per channel can change from line to line
+			// and readers need to use the count instead of the column headers
+			writeColumnNames(czForcePlateName, czChannelName, 2, "subframeCount", "values");
 		}
 	}
 }
@@ -415,8 +419,13 @@ void MoCapFileWriter::writeForcePlateData(const sForcePlateData& data)
 	write(data.nChannels);
 	for (int cIdx = 0; cIdx < data.nChannels; cIdx++)
 	{
-		// file stores only one frame per tick, 
-		write(data.ChannelData[cIdx].Values[0]);
+		// all subframes of the tick (since file version 3)
+		const sAnalogChannelData& refChannel = data.ChannelData[cIdx];
+		write(refChannel.nFrames);
+		for (int sIdx = 0; sIdx < refChannel.nFrames; sIdx++)
+		{
+			write(refChannel.Values[sIdx]);
+		}
 	}
 }
 
@@ -1001,8 +1010,8 @@ bool MoCapFileReader::readHeader()
 				<< ", Sample Rate: " << updateRate << "Hz"
 				<< ", Descriptions: " << nDescriptions << ")");
 
-			// file version 1 and 2 are valid so far
-			success = (fileVersion >= 1) && (fileVersion <= 2);
+			// file version 1 to 3 are valid so far
+			success = (fileVersion >= 1) && (fileVersion <= 3);
 		}
 	}
 	else
@@ -1021,7 +1030,7 @@ void MoCapFileReader::readMarkerSetDescription(sMarkerSetDescription& descr, sMa
 	descr.szMarkerNames = new char*[descr.nMarkers];
 	for (int mIdx = 0; mIdx < descr.nMarkers; mIdx++)
 	{
-		descr.szMarkerNames[mIdx] = _strdup(readString());
+		descr.szMarkerNames[mIdx] = MoCapData::duplicateName(readString());
 	}
 
 	data.nMarkers = descr.nMarkers;
@@ -1140,8 +1149,21 @@ void MoCapFileReader::readForcePlateData(sForcePlateData& data)
 	for (int cIdx = 0; cIdx < nChannels; cIdx++)
 	{
 		sAnalogChannelData& refChannel = data.ChannelData[limitArrayIdx(cIdx, data.nChannels)];
-		refChannel.nFrames = 1; // file stores only one sample per tick
-		refChannel.Values[0] = readFloat();
+		// subframes (file version 1 and 2 store only one sample per tick)
+		int nSubframes = (fileVersion > 2) ? readInt() : 1;
+		refChannel.nFrames = std::max(0, std::min(nSubframes, MAX_ANALOG_SUBFRAMES));
+		for (int sIdx = 0; sIdx < nSubframes; sIdx++)
+		{
+			if (sIdx < refChannel.nFrames)
+			{
+				refChannel.Values[sIdx] = readFloat();
+			}
+			else
+			{
+				// more subframes than fit > skip the rest so that the following columns stay in place
+				readString();
+			}
+		}
 	}
 }
 
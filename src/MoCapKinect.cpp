@@ -17,6 +17,8 @@
 #define MAX_USERS        NUI_SKELETON_MAX_TRACKED_COUNT
 #define USER_NOT_TRACKED -1
 
+#define BONE_CONVERGENCE_FRAMES 90 // average bone lengths over the first 3s of tracking
+
 
 /**
  * Structure for associating marker names with their Kinect skeleton ID
@@ -55,18 +57,9 @@ const int MARKER_DESCRIPTION_COUNT = sizeof(MARKER_DESCRIPTION) / sizeof(MARKER_
 
 
 /**
- * Structure for associating bone names and parent/child points with their Kinect skeleton IDs
+ * Bone names and parent/child points with their Kinect skeleton IDs
  */
-struct sBoneDescription
-{
-	const char*                       czBoneName;
-	const int                         parentIndex;
-	const NUI_SKELETON_POSITION_INDEX kParent;
-	const NUI_SKELETON_POSITION_INDEX kPoint;
-	const NUI_SKELETON_POSITION_INDEX kEnd;
-};
-
-const sBoneDescription BONE_DESCRIPTION[]
+const sSkeletonBone BONE_DESCRIPTION[]
 {
 	{ "Hip",           -1, NUI_SKELETON_POSITION_HIP_CENTER,      NUI_SKELETON_POSITION_HIP_CENTER,      NUI_SKELETON_POSITION_HIP_CENTER },
 	{ "Spine",          0, NUI_SKELETON_POSITION_HIP_CENTER,      NUI_SKELETON_POSITION_HIP_CENTER,      NUI_SKELETON_POSITION_SPINE },
@@ -101,10 +94,14 @@ const int BONE_DESCRIPTION_COUNT = sizeof(BONE_DESCRIPTION) / sizeof(BONE_DESCRI
 MoCapKinectConfiguration::MoCapKinectConfiguration() :
 	Configuration("Kinect"),
 	useKinect(false),
-	seatedMode(false)
+	seatedMode(false),
+	gapFillingFrames(0),
+	boneAdaptationRate(0)
 {
 	addOption("-useKinect",  "Search for and use a Kinect sensor if connected");
 	addOption("-seatedMode", "Do not track the legs and feet");
+	addParameter("-kinectGapFilling", "<frames>", "Predict untracked joints for up to this amount of frames (default: 0 = disabled)");
+	addParameter("-kinectBoneAdaptation", "<rate>", "Adaptation rate of the bone lengths after the first 3s of tracking (default: 0 = frozen)");
 }
 
 
@@ -121,6 +118,16 @@ bool MoCapKinectConfiguration::handleArgument(unsigned int _idx, const std::stri
 			seatedMode = true;
 			break;
 
+		case 2:
+			gapFillingFrames = atoi(_value.c_str());
+			success = (gapFillingFrames >= 0);
+			break;
+
+		case 3:
+			boneAdaptationRate = (float)atof(_value.c_str());
+			success = (boneAdaptationRate >= 0) && (boneAdaptationRate <= 1);
+			break;
+
 		default:
 			success = false;
 			break;
@@ -138,13 +145,37 @@ MoCapKinect::MoCapKinect(MoCapKinectConfiguration configuration) :
 	configuration(configuration),
 	initialised(false),
 	running(true),
-	pNuiSensor(nullptr)
+	pNuiSensor(nullptr),
+	skeletonSolver(BONE_DESCRIPTION, BONE_DESCRIPTION_COUNT),
+	gapFiller(configuration.gapFillingFrames)
 {
+	// seated mode only tracks the joints from the shoulder centre to the hands,
+	// bones with other joints would keep the estimates from ever freezing
+	BoneLengthEstimator estimator(BONE_DESCRIPTION_COUNT, BONE_CONVERGENCE_FRAMES, configuration.boneAdaptationRate);
+	for (int bIdx = 0; configuration.seatedMode && (bIdx < BONE_DESCRIPTION_COUNT); bIdx++)
+	{
+		const sSkeletonBone& bone = BONE_DESCRIPTION[bIdx];
+		const int arrJoints[] = { bone.jointParent, bone.jointPoint, bone.jointEnd };
+		for (int joint : arrJoints)
+		{
+			if ((joint < NUI_SKELETON_POSITION_SHOULDER_CENTER) || (joint > NUI_SKELETON_POSITION_HAND_RIGHT))
+			{
+				estimator.excludeBone(bIdx);
+			}
+		}
+	}
+
 	// assume no tracked users in the beginning
 	for (int userIdx = 0; userIdx < MAX_USERS; userIdx++)
 	{
 		userSkeletonIdx.push_back(USER_NOT_TRACKED);
+		boneEstimators.push_back(estimator);
 	}
+	gapFiller.setMarkerCount(MAX_USERS * MARKER_DESCRIPTION_COUNT);
+
+	// hip orientation from the spine and the hip axis
+	// (a user facing the sensor has the left hip at -X, so this pose is not rotated)
+	skeletonSolver.setRootJoints(NUI_SKELETON_POSITION_SPINE, NUI_SKELETON_POSITION_HIP_LEFT, NUI_SKELETON_POSITION_HIP_RIGHT);
 }
 
 
@@ -362,9 +393,6 @@ void MoCapKinect::handleSkeletonData(const NUI_SKELETON_FRAME& refSkeletonFrame,
 
 			const NUI_SKELETON_DATA& skeleton = refSkeletonFrame.SkeletonData[userSkeletonIdx[userIdx]];
 
-			NUI_SKELETON_BONE_ORIENTATION boneOrientations[NUI_SKELETON_POSITION_COUNT];
-			NuiSkeletonCalculateBoneOrientations(&skeleton, boneOrientations);
-
 			sMarkerSetData& msData = refData.frame.MocapData[userIdx];
 			// go through all bones
 			for (int mIdx = 0; mIdx < msData.nMarkers; mIdx++)
@@ -372,6 +400,7 @@ void MoCapKinect::handleSkeletonData(const NUI_SKELETON_FRAME& refSkeletonFrame,
 				int            skeletonIdx = MARKER_DESCRIPTION[mIdx].index;
 				const Vector4& point = skeleton.SkeletonPositions[skeletonIdx];
 				MarkerData&    msMarker = msData.Markers[mIdx];
+				int            filterIdx = userIdx * MARKER_DESCRIPTION_COUNT + mIdx;
 
 				switch (skeleton.eSkeletonPositionTrackingState[skeletonIdx])
 				{
@@ -381,6 +410,7 @@ void MoCapKinect::handleSkeletonData(const NUI_SKELETON_FRAME& refSkeletonFrame,
 						msMarker[0] = point.x;
 						msMarker[1] = point.y + yOffset; // TODO: see above re transformation
 						msMarker[2] = point.z;
+						gapFiller.setMarker(filterIdx, msMarker[0], msMarker[1], msMarker[2]);
 						break;
 
 					default:
@@ -388,6 +418,7 @@ void MoCapKinect::handleSkeletonData(const NUI_SKELETON_FRAME& refSkeletonFrame,
 						msMarker[0] = 0;
 						msMarker[1] = 0;
 						msMarker[2] = 0;
+						gapFiller.setMarkerMissing(filterIdx);
 						break;
 				}
 			}
@@ -395,30 +426,7 @@ void MoCapKinect::handleSkeletonData(const NUI_SKELETON_FRAME& refSkeletonFrame,
 			sSkeletonData& skeleData = refData.frame.Skeletons[userIdx];
 			if (skeleton.eTrackingState == NUI_SKELETON_TRACKED)
 			{
-				for (int j = 0; j < BONE_DESCRIPTION_COUNT; j++)
-				{
-					sRigidBodyData& rigidData = skeleData.RigidBodyData[j];
-					if (j == 0) 
-					{
-						const Vector4& point = skeleton.SkeletonPositions[NUI_SKELETON_POSITION_HIP_CENTER];
-						rigidData.x = point.x;
-						rigidData.y = point.y + yOffset; // TODO: see above re transformation
-						rigidData.z = point.z;
-					}
-					else 
-					{
-						rigidData.x = 0;
-						rigidData.y = calculateBoneOffset(j, skeleton);
-						rigidData.z = 0;
-					}
-					NUI_SKELETON_BONE_ORIENTATION& orientation = boneOrientations[BONE_DESCRIPTION[j].kEnd];
-					rigidData.qw = orientation.hierarchicalRotation.rotationQuaternion.w;
-					rigidData.qx = orientation.hierarchicalRotation.rotationQuaternion.x;
-					rigidData.qy = orientation.hierarchicalRotation.rotationQuaternion.y;
-					rigidData.qz = orientation.hierarchicalRotation.rotationQuaternion.z;
-					rigidData.MeanError = calculateBoneLength(j, skeleton);
-					rigidData.params = STATUS_TRACKED;
-				}
+				handleSkeletonBones(skeleton, yOffset, boneEstimators[userIdx], skeleData);
 			}
 			else
 			{
@@ -433,48 +441,99 @@ void MoCapKinect::handleSkeletonData(const NUI_SKELETON_FRAME& refSkeletonFrame,
 			refData.resetMarkerData(msData);
 			sSkeletonData& skeleData = refData.frame.Skeletons[userIdx];
 			refData.resetSkeletonData(skeleData);
+
+			// next user might be somebody else > no predictions
+			for (int mIdx = 0; mIdx < MARKER_DESCRIPTION_COUNT; mIdx++)
+			{
+				gapFiller.resetMarker(userIdx * MARKER_DESCRIPTION_COUNT + mIdx);
+			}
 		}
 	}
+
+	refData.frame.nLabeledMarkers = 0;
+	if (gapFiller.getMaxGapLength() > 0)
+	{
+		fillMarkerGaps(refData);
+	}
 }
 
 
-//Find RigidData.y of the bone
-float MoCapKinect::calculateBoneOffset(int aindex, NUI_SKELETON_DATA skeleton)
+void MoCapKinect::fillMarkerGaps(MoCapData& refData)
 {
-	const Vector4& endPoint = skeleton.SkeletonPositions[BONE_DESCRIPTION[aindex].kPoint];
-	const Vector4& startPoint = skeleton.SkeletonPositions[BONE_DESCRIPTION[aindex].kParent];
-	float e = 0;
-	float x = endPoint.x - startPoint.x;
-	float y = endPoint.y - startPoint.y;
-	float z = endPoint.z - startPoint.z;
-
-	x = x * x;
-	y = y * y;
-	z = z * z;
+	gapFiller.update();
 
-	e = sqrt(x + y + z);
-
-	return e;
+	// replace the zeroed positions of untracked joints by predictions
+	// and flag them as occluded labeled markers (model ID: user index + 1)
+	for (int userIdx = 0; userIdx < MAX_USERS; userIdx++)
+	{
+		sMarkerSetData& msData = refData.frame.MocapData[userIdx];
+		for (int mIdx = 0; mIdx < msData.nMarkers; mIdx++)
+		{
+			MarkerData& msMarker = msData.Markers[mIdx];
+			if (gapFiller.getPrediction(userIdx * MARKER_DESCRIPTION_COUNT + mIdx, msMarker[0], msMarker[1], msMarker[2]))
+			{
+				sMarker& refLabeled = refData.frame.LabeledMarkers[refData.frame.nLabeledMarkers++];
+				refLabeled.ID     = ((userIdx + 1) << 16) | (mIdx + 1);
+				refLabeled.x      = msMarker[0];
+				refLabeled.y      = msMarker[1];
+				refLabeled.z      = msMarker[2];
+				refLabeled.size   = 0;
+				refLabeled.params = MARKER_OCCLUDED;
+			}
+		}
+	}
 }
 
 
-//Find the length of the bone
-float MoCapKinect::calculateBoneLength(int aindex, NUI_SKELETON_DATA skeleton)
+void MoCapKinect::handleSkeletonBones(const NUI_SKELETON_DATA& refSkeleton, float yOffset, BoneLengthEstimator& refEstimator, sSkeletonData& refSkeletonData)
 {
-	const Vector4& endPoint = skeleton.SkeletonPositions[BONE_DESCRIPTION[aindex].kEnd];
-	const Vector4& startPoint = skeleton.SkeletonPositions[BONE_DESCRIPTION[aindex].kPoint];
-	float e = 0;
-	float x = endPoint.x - startPoint.x;
-	float y = endPoint.y - startPoint.y;
-	float z = endPoint.z - startPoint.z;
-
-	x = x * x;
-	y = y * y;
-	z = z * z;
+	// convert joint positions for the solver
+	Vector3D joints[NUI_SKELETON_POSITION_COUNT];
+	for (int jIdx = 0; jIdx < NUI_SKELETON_POSITION_COUNT; jIdx++)
+	{
+		const Vector4& point = refSkeleton.SkeletonPositions[jIdx];
+		joints[jIdx].set(point.x, point.y, point.z);
+	}
+	// offsets are not needed any more once the estimates are frozen
+	bool frozen = refEstimator.isFrozen();
+	skeletonSolver.solve(joints, !frozen);
 
-	e = sqrt(x + y + z);
+	for (int bIdx = 0; bIdx < BONE_DESCRIPTION_COUNT; bIdx++)
+	{
+		sRigidBodyData& rigidData = refSkeletonData.RigidBodyData[bIdx];
+
+		// only use bones with reliably tracked joints for the estimates
+		const sSkeletonBone& bone = BONE_DESCRIPTION[bIdx];
+		if (!frozen &&
+			(refSkeleton.eSkeletonPositionTrackingState[bone.jointParent] == NUI_SKELETON_POSITION_TRACKED) &&
+			(refSkeleton.eSkeletonPositionTrackingState[bone.jointPoint]  == NUI_SKELETON_POSITION_TRACKED) &&
+			(refSkeleton.eSkeletonPositionTrackingState[bone.jointEnd]    == NUI_SKELETON_POSITION_TRACKED))
+		{
+			refEstimator.addMeasurement(bIdx, skeletonSolver.getOffset(bIdx), skeletonSolver.getLength(bIdx));
+		}
+		bool estimated = refEstimator.hasEstimate(bIdx);
 
-	return e;
+		if (bIdx == 0)
+		{
+			const Vector3D& point = joints[NUI_SKELETON_POSITION_HIP_CENTER];
+			rigidData.x = point.x;
+			rigidData.y = point.y + yOffset; // TODO: see above re transformation
+			rigidData.z = point.z;
+		}
+		else
+		{
+			rigidData.x = 0;
+			rigidData.y = estimated ? refEstimator.getOffset(bIdx) : skeletonSolver.getOffset(bIdx);
+			rigidData.z = 0;
+		}
+		const Quaternion& rotation = skeletonSolver.getRotation(bIdx);
+		rigidData.qw = rotation.w;
+		rigidData.qx = rotation.x;
+		rigidData.qy = rotation.y;
+		rigidData.qz = rotation.z;
+		rigidData.MeanError = estimated ? refEstimator.getLength(bIdx) : skeletonSolver.getLength(bIdx);
+		rigidData.params = STATUS_TRACKED;
+	}
 }
 
 
@@ -488,6 +547,7 @@ void MoCapKinect::checkUserLost(const NUI_SKELETON_FRAME& refSkeletonFrame)
 			if (skeleton.eTrackingState == NUI_SKELETON_NOT_TRACKED)
 			{
 				userSkeletonIdx[userIdx] = USER_NOT_TRACKED;
+				boneEstimators[userIdx].reset();
 				LOG_INFO("Lost user " << userIdx);
 			}
 		}
@@ -507,11 +567,13 @@ void MoCapKinect::checkUserFound(const NUI_SKELETON_FRAME& refSkeletonFrame)
 			if (userSkeletonIdx[0] < 0 && skeletonIdx != userSkeletonIdx[1])
 			{
 				userSkeletonIdx[0] = skeletonIdx;
+				boneEstimators[0].reset();
 				LOG_INFO("Found user 0 (skeleton Idx " << skeletonIdx << ")");
 			}
 			else if (userSkeletonIdx[1] < 0 && skeletonIdx != userSkeletonIdx[0])
 			{
 				userSkeletonIdx[1] = skeletonIdx;
+				boneEstimators[1].reset();
 				LOG_INFO("Found user 1 (skeleton Idx " << skeletonIdx << ")");
 			}
 		}
@@ -11,6 +11,9 @@
 
 #include "MoCapSystem.h"
 #include "Configuration.h"
+#include "BoneLengthEstimator.h"
+#include "MarkerGapFiller.h"
+#include "SkeletonSolver.h"
 
 #include <Windows.h>
 #include <NuiApi.h>
@@ -29,6 +32,8 @@ public:
 
 	bool  useKinect;
 	bool  seatedMode;
+	int   gapFillingFrames;
+	float boneAdaptationRate;
 };
 
 
@@ -53,8 +58,8 @@ public:
 private:
 
 	void  handleSkeletonData(const NUI_SKELETON_FRAME& refSkeletonFrame, MoCapData& refData);
-	float calculateBoneLength(int aindex, NUI_SKELETON_DATA skeleton);
-	float calculateBoneOffset(int aindex, NUI_SKELETON_DATA skeleton);
+	void  fillMarkerGaps(MoCapData& refData);
+	void  handleSkeletonBones(const NUI_SKELETON_DATA& refSkeleton, float yOffset, BoneLengthEstimator& refEstimator, sSkeletonData& refSkeletonData);
 	void  checkUserLost(const NUI_SKELETON_FRAME& refSkeletonFrame);
 	void  checkUserFound(const NUI_SKELETON_FRAME& refSkeletonFrame);
 	void  readRigidBodyDescription(sRigidBodyDescription& descr, sRigidBodyData& data, int rbodies);
@@ -70,6 +75,9 @@ private:
 	HANDLE           kinectHandle;
 
 	std::vector<int> userSkeletonIdx;
+	SkeletonSolver   skeletonSolver;
+	std::vector<BoneLengthEstimator> boneEstimators;
+	MarkerGapFiller  gapFiller;
 };
 
 #endif // #ifdef USE_KINECT
@@ -3,27 +3,63 @@
 #ifdef USE_PIECEMETA
 
 #include "Logging.h"
+#include "Portability.h"
 #undef   LOG_CLASS
 #define  LOG_CLASS "MoCapPieceMeta"
 
+#ifdef _WIN32
+#define NOMINMAX
 #include <windows.h>
 #include <WinInet.h>
+#include <psapi.h>
+#else
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0 // a closed connection fails the send() instead of raising SIGPIPE
+#endif
+#endif
 
 #include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <charconv>
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <cstring>
 #include <fstream>
 #include <iostream>
 #include <iomanip>
 #include <locale>
+#include <thread>
 
 #include "json11.hpp"
 
+#ifdef _WIN32
 #pragma comment(lib,"Wininet.lib")
+#pragma comment(lib,"Psapi.lib")
+#endif
 
 // uncomment to create file with package information
 // #define DUMP_PACKAGE_INFO_TO_FILE
 
 #define PIECEMETA_BASE_URL "http://api.piecemeta.com/"
 
+// header of stream cache files: magic number, version, first frame, frame count
+#define CACHE_FILE_MAGIC   0x434D5050 // "PPMC"
+#define CACHE_FILE_VERSION 1
+
+#define FILE_URL_PREFIX "file://"
+
+#define DOWNLOAD_CHUNK_SIZE   6000 // frames per request
+#define DOWNLOAD_MAX_ATTEMPTS 3    // attempts per request before giving up
+
+#define COLUMN_ALIGNMENT      4096 // columns in the column file start on a new page
+#define COLUMN_WINDOW_FRAMES  4096 // frames per window that is released from memory after playback
+
 
 /**
  * Class for managing stream parameter name and type associations
@@ -72,7 +108,7 @@ MoCapPieceMeta::StreamConfiguration::StreamConfiguration(const std::string& name
 	name(name)
 {
 	// store strings and associted parameter types in the map
-	int  lastIdx = min(config.size(), _last - timestamp);
+	int  lastIdx = std::min((int) config.size(), (int) (_last - timestamp));
 	for (int idx = 0; idx < lastIdx; idx++)
 	{
 		configuration[config[idx]] = eStreamType(timestamp + idx);
@@ -124,13 +160,21 @@ MoCapPieceMetaConfiguration::MoCapPieceMetaConfiguration() :
 	usePieceMeta(false),
 	maximumFrameCount(INT_MAX),
 	listOnly(false),
+	connectionCount(4),
 	packageFilter(""),
-	channelFilters()
+	channelFilters(),
+	baseURL(PIECEMETA_BASE_URL),
+	cacheDirectory(""),
+	columnFile("")
 {
 	addParameter("-pieceMetaPackage", "<package name>",    "Load a PieceMeta package");
 	addParameter("-channelFilter",    "<channel filter>",  "Filter to select channels with (this option can be used multiple times)");
 	addParameter("-maxFrame",         "<frame number>",    "Read data only up to the given frame number");
 	addOption(   "-listOnly",                              "Only list the packages and filtered channels, but do not start the actual server");
+	addParameter("-pieceMetaBaseURL", "<URL>",             "Base URL of the PieceMeta API, can be a file:// URL of a local copy (default: " PIECEMETA_BASE_URL ")");
+	addParameter("-pieceMetaCache",   "<directory>",       "Directory for caching downloaded stream data");
+	addParameter("-pieceMetaConnections", "<count>",       "Amount of concurrent downloads (default: 4)");
+	addParameter("-pieceMetaColumnFile",  "<filename>",    "Keep the stream data in a memory mapped file instead of RAM (for very large packages)");
 }
 
 
@@ -157,6 +201,25 @@ bool MoCapPieceMetaConfiguration::handleArgument(unsigned int _idx, const std::s
 			listOnly = true;
 			break;
 
+		case 4:
+			baseURL = _value;
+			if (!baseURL.empty() && (baseURL.back() != '/')) baseURL += '/';
+			break;
+
+		case 5:
+			cacheDirectory = _value;
+			if (!cacheDirectory.empty() && (cacheDirectory.back() != '/') && (cacheDirectory.back() != '\\')) cacheDirectory += '/';
+			break;
+
+		case 6:
+			connectionCount = atoi(_value.c_str());
+			success = (connectionCount > 0);
+			break;
+
+		case 7:
+			columnFile = _value;
+			break;
+
 		default: 
 			success = false;
 			break;
@@ -174,9 +237,24 @@ MoCapPieceMeta::MoCapPieceMeta(MoCapPieceMetaConfiguration configuration) :
 	configuration(configuration),
 	initialised(false),
 	running(true),
-	updateRate(100.0f)
+	updateRate(100.0f),
+	nextChunk(0),
+	activeLoaders(0),
+	stopLoading(false),
+	availableFrames(0),
+	loadingComplete(true),
+	columnFile(),
+	activeWindow(0)
 {
-	
+	if (!configuration.cacheDirectory.empty())
+	{
+		// make sure the cache exists
+#ifdef _WIN32
+		CreateDirectoryA(configuration.cacheDirectory.c_str(), NULL);
+#else
+		mkdir(configuration.cacheDirectory.c_str(), 0755);
+#endif
+	}
 }
 
 
@@ -312,30 +390,35 @@ bool MoCapPieceMeta::initialise()
 			{
 				if (activeChannels.size() > 0)
 				{
-					// load data for all active channels
+					// collect the streams of all active channels
+					std::vector<sStream*> streams;
 					for (size_t cIdx = 0; cIdx < activeChannels.size(); cIdx++)
 					{
 						int channelIdx = activeChannels[cIdx];
 						sChannel& channel = activePackage.channels[channelIdx];
 
-						LOG_INFO_START("Channel " << channelIdx << 
+						LOG_INFO("Channel " << channelIdx <<
 							" (#" << cIdx <<
 							", " << channel.title <<
 							", " << channel.frameCount << " frames"
 							", " << channel.frameRate << " fps"
-							", " << channel.pConfiguration->getName() <<
-							"): Loading stream data...   0% ");
+							", " << channel.pConfiguration->getName() << ")");
 
-						// read frames
-						int numStreams  = channel.streams.size();
-						for (int sIdx = 0; sIdx < numStreams; sIdx++)
+						for (auto sIter = channel.streams.begin(); sIter != channel.streams.end(); sIter++)
 						{
-							LOG_INFO_MID("\b\b\b\b\b" << std::setw(3) << std::right << (sIdx * 100 / numStreams) << "% ");
-							sStream& stream = channel.streams[sIdx];
-							readStreamData(stream);
+							streams.push_back(&(*sIter));
 						}
-						LOG_INFO_MID("\b\b\b\b\b100%  ");
-						LOG_INFO_END();
+					}
+
+					// load data for all streams at once
+					bool dataRead = readStreamData(streams);
+
+					for (size_t cIdx = 0; cIdx < activeChannels.size(); cIdx++)
+					{
+						int channelIdx = activeChannels[cIdx];
+						sChannel& channel = activePackage.channels[channelIdx];
+
+						channel.prepareColumns();
 
 						if (updateRate == 0)
 						{
@@ -348,25 +431,35 @@ bool MoCapPieceMeta::initialise()
 							LOG_WARNING("Different framerate for channel " << cIdx);
 						}
 
-						maxFrame = max(maxFrame, channel.frameCount);
+						maxFrame = std::max(maxFrame, channel.frameCount);
 
 						/*
 						// print data of the 10 first frames
 						for (int frame = 0; frame < 10; frame++)
 						{
 							LOG_INFO("  Frame " << frame << ":");
-							for (auto iter = channel.groupNames.cbegin(); iter != channel.groupNames.cend(); iter++)
+							std::vector<MarkerData> markers(channel.groupNames.size());
+							channel.getPositions(frame, markers.data(), markers.size());
+							for (size_t gIdx = 0; gIdx < markers.size(); gIdx++)
 							{
-								float vec[3] = { 0,0,0 };
-								channel.getPosition(100, *iter, vec);
-								LOG_INFO("    " << *iter << ": " << vec[0] << "," << vec[1] << "," << vec[2]);
+								LOG_INFO("    " << channel.groupNames[gIdx] << ": " << markers[gIdx][0] << "," << markers[gIdx][1] << "," << markers[gIdx][2]);
 							}
 						}
 						*/
 					}
 
 					currentFrame = 0;
-					initialised  = true;
+					activeWindow = 0;
+					initialised  = dataRead;
+
+					if (initialised)
+					{
+						reportMemoryUsage();
+					}
+					else
+					{
+						LOG_ERROR("Could not read the stream data");
+					}
 				}
 				else
 				{
@@ -444,7 +537,7 @@ bool MoCapPieceMeta::getSceneDescription(MoCapData& refData)
 
 			for (int m = 0; m < pMarkerDesc->nMarkers; m++)
 			{
-				pMarkerDesc->szMarkerNames[m] = _strdup(channel.groupNames.at(m).c_str());
+				pMarkerDesc->szMarkerNames[m] = MoCapData::duplicateName(channel.groupNames.at(m).c_str());
 			}
 
 			// add to description list
@@ -484,14 +577,14 @@ bool MoCapPieceMeta::getFrameData(MoCapData& refData)
 
 			// do markers
 			sMarkerSetData& msData = refData.frame.MocapData[cIdx];
-			for (int mIdx = 0; mIdx < msData.nMarkers; mIdx++)
-			{
-				const std::string groupName = channel.groupNames.at(mIdx);
-				channel.getPosition(currentFrame, groupName, msData.Markers[mIdx], true);
-			}
+			channel.getPositions(currentFrame, msData.Markers, msData.nMarkers);
 		}
 
-		currentFrame = (currentFrame + 1) % maxFrame;
+		// while the data is still loading or when a chunk has failed, loop within the loaded range
+		updateLoadedFrames();
+		int playableFrames = std::min(maxFrame, availableFrames);
+		currentFrame = (playableFrames > 0) ? (currentFrame + 1) % playableFrames : 0;
+		releasePlayedWindow();
 
 		success = true;
 	}
@@ -504,12 +597,25 @@ bool MoCapPieceMeta::processCommand(const std::string& strCommand)
 {
 	bool processed = false;
 
+	// convert command to lowercase
+	std::string strCmdLowerCase;
+	std::transform(strCommand.begin(), strCommand.end(), std::back_inserter(strCmdLowerCase), ::tolower);
+
+	if (strCmdLowerCase == "memoryusage")
+	{
+		reportMemoryUsage();
+		processed = true;
+	}
+
 	return processed;
 }
 
 
 bool MoCapPieceMeta::deinitialise()
 {
+	stopLoaders();
+	columnFile.close();
+
 	if (initialised)
 	{
 		LOG_INFO("Deinitialised");
@@ -529,7 +635,30 @@ MoCapPieceMeta::~MoCapPieceMeta()
 bool MoCapPieceMeta::readURL(const std::string& url, std::string &content)
 {
 	bool success = false;
-	
+
+	if (url.compare(0, strlen(FILE_URL_PREFIX), FILE_URL_PREFIX) == 0)
+	{
+		// local file: strip prefix and query (e.g., "file:///C:/PieceMeta/streams/1234.json?from=0&to=6000")
+		std::string path = url.substr(strlen(FILE_URL_PREFIX));
+		path = path.substr(0, path.find('?'));
+		if ((path.length() > 2) && (path[0] == '/') && (path[2] == ':')) path = path.substr(1);
+
+		std::ifstream file(path, std::ios::in | std::ios::binary);
+		if (file)
+		{
+			std::stringstream buffer;
+			buffer << file.rdbuf();
+			content = buffer.str();
+			success = true;
+		}
+		else
+		{
+			LOG_ERROR("Could not open " << url);
+		}
+		return success;
+	}
+
+#ifdef _WIN32
 	// prepare request:
 
 	HINTERNET hInt = InternetOpen(
@@ -549,31 +678,131 @@ bool MoCapPieceMeta::readURL(const std::string& url, std::string &content)
 	HINTERNET hUrl = InternetOpenUrl(hInt, wURL.c_str(), NULL, 0, dwRequestFlags, NULL);
 	if (hUrl)
 	{
-		// success: read content
-		DWORD dwBytesRead = 0;
-		content.clear();
-		while (InternetReadFile(hUrl, readBuffer, sizeof(readBuffer) - 1, &dwBytesRead) && (dwBytesRead > 0))
+		// error responses (e.g., an overloaded server) are not content
+		DWORD dwStatus = 200;
+		DWORD dwSize   = sizeof(dwStatus);
+		HttpQueryInfo(hUrl, HTTP_QUERY_STATUS_CODE | HTTP_QUERY_FLAG_NUMBER, &dwStatus, &dwSize, NULL);
+		if (dwStatus == 200)
 		{
-			readBuffer[dwBytesRead] = '\0';
-			content += readBuffer;
+			// success: read content
+			char  readBuffer[65536]; // local buffer, readURL can be called from several threads
+			DWORD dwBytesRead = 0;
+			content.clear();
+			while (InternetReadFile(hUrl, readBuffer, sizeof(readBuffer) - 1, &dwBytesRead) && (dwBytesRead > 0))
+			{
+				readBuffer[dwBytesRead] = '\0';
+				content += readBuffer;
+			}
+			success = true;
+		}
+		else
+		{
+			LOG_ERROR("Could not read " << url << " (status " << dwStatus << ")");
 		}
 		InternetCloseHandle(hUrl);
-		success = true;
 	}
 	else
 	{
 		LOG_ERROR("Could not open " << url);
 	}
 	InternetCloseHandle(hInt);
+#else
+	// plain HTTP/1.0 request: the server closes the connection after the content and does not split it into chunks
+	const std::string prefix = "http://";
+	if (url.compare(0, prefix.length(), prefix) != 0)
+	{
+		LOG_ERROR("Unsupported URL " << url);
+		return false;
+	}
+	size_t      pathStart = url.find('/', prefix.length());
+	std::string host      = url.substr(prefix.length(), pathStart - prefix.length());
+	std::string path      = (pathStart == std::string::npos) ? "/" : url.substr(pathStart);
+	std::string port      = "80";
+	size_t      portStart = host.find(':');
+	if (portStart != std::string::npos)
+	{
+		port = host.substr(portStart + 1);
+		host = host.substr(0, portStart);
+	}
+
+	// connect to the first address that accepts the connection
+	addrinfo hints = {};
+	hints.ai_family   = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	addrinfo* pAddresses = NULL;
+	int       fdSocket   = -1;
+	if (getaddrinfo(host.c_str(), port.c_str(), &hints, &pAddresses) == 0)
+	{
+		for (addrinfo* pAddress = pAddresses; (pAddress != NULL) && (fdSocket < 0); pAddress = pAddress->ai_next)
+		{
+			fdSocket = socket(pAddress->ai_family, pAddress->ai_socktype, pAddress->ai_protocol);
+			if ((fdSocket >= 0) && (connect(fdSocket, pAddress->ai_addr, pAddress->ai_addrlen) != 0))
+			{
+				::close(fdSocket);
+				fdSocket = -1;
+			}
+		}
+		freeaddrinfo(pAddresses);
+	}
+	if (fdSocket < 0)
+	{
+		LOG_ERROR("Could not open " << url);
+		return false;
+	}
+
+	// do not wait forever for a server that stopped responding
+	timeval timeout = { 30, 0 };
+	setsockopt(fdSocket, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+	std::string request = "GET " + path + " HTTP/1.0\r\nHost: " + host + "\r\nConnection: close\r\n\r\n";
+	size_t      sent    = 0;
+	while (sent < request.length())
+	{
+		ssize_t nBytes = send(fdSocket, request.c_str() + sent, request.length() - sent, MSG_NOSIGNAL);
+		if (nBytes <= 0) break;
+		sent += nBytes;
+	}
+
+	std::string response;
+	if (sent == request.length())
+	{
+		char    readBuffer[65536]; // local buffer, readURL can be called from several threads
+		ssize_t nBytes;
+		while ((nBytes = recv(fdSocket, readBuffer, sizeof(readBuffer), 0)) > 0)
+		{
+			response.append(readBuffer, nBytes);
+		}
+	}
+	::close(fdSocket);
+
+	// status line (e.g., "HTTP/1.1 200 OK"), header lines, empty line, content
+	int    status       = 0;
+	size_t contentStart = response.find("\r\n\r\n");
+	if ((sscanf(response.c_str(), "HTTP/%*d.%*d %d", &status) == 1) && (status == 200) && (contentStart != std::string::npos))
+	{
+		content = response.substr(contentStart + 4);
+		success = true;
+	}
+	else
+	{
+		LOG_ERROR("Could not read " << url << " (status " << status << ")");
+	}
+#endif
 	return success;
 }
 
 
+bool MoCapPieceMeta::isLocalURL() const
+{
+	return configuration.baseURL.compare(0, strlen(FILE_URL_PREFIX), FILE_URL_PREFIX) == 0;
+}
+
+
 std::vector<MoCapPieceMeta::sPackage> MoCapPieceMeta::readPackages()
 {
 	std::vector<sPackage> packages;
 	std::string response;
-	if (readURL(PIECEMETA_BASE_URL "packages.json", response))
+	if (readURL(configuration.baseURL + "packages.json", response))
 	{
 		std::string errorMsg;
 		json11::Json json = json11::Json::parse(response, errorMsg);
@@ -601,7 +830,7 @@ bool MoCapPieceMeta::readChannels(sPackage& package)
 	bool success = false;
 	package.channels.clear();
 
-	std::string request = PIECEMETA_BASE_URL "packages/" + package.uuid + "/channels.json";
+	std::string request = configuration.baseURL + "packages/" + package.uuid + "/channels.json";
 	std::string response;
 	if (MoCapPieceMeta::readURL(request, response))
 	{
@@ -631,7 +860,7 @@ bool MoCapPieceMeta::readStreams(sChannel& channel)
 	bool success = false;
 	channel.streams.clear();
 
-	std::string request = PIECEMETA_BASE_URL "channels/" + channel.uuid + "/streams.json";
+	std::string request = configuration.baseURL + "channels/" + channel.uuid + "/streams.json";
 	std::string response;
 	if (MoCapPieceMeta::readURL(request, response))
 	{
@@ -656,48 +885,348 @@ bool MoCapPieceMeta::readStreams(sChannel& channel)
 }
 
 
-bool MoCapPieceMeta::readStreamData(sStream& stream)
+bool MoCapPieceMeta::readStreamData(std::vector<sStream*>& streams)
 {
 	const char rotSymbol[]  = { '|', '/', '-', '\\'};
 	int        rotSymbolIdx = 0;
 
-	bool success = true;
-	stream.data.clear();
-	
-	int idxFrom  = 0;
-	int stepsize = 6000;
-	while ((idxFrom < stream.frameCount) && success)
-	{
-		// display rotating bar
-		LOG_INFO_MID(rotSymbol[rotSymbolIdx] << "\b");
+	stopLoaders();
+	allocateStreamData(streams);
+
+	// take streams from the cache, the others need to be downloaded
+	// (chunks are written directly into their place in the data array)
+	std::vector<sStream*> downloads;
+	for (auto sIter = streams.begin(); sIter != streams.end(); sIter++)
+	{
+		sStream& stream = **sIter;
+		if (readStreamCache(stream))
+		{
+			stream.loadedFrames = stream.frameCount;
+		}
+		else
+		{
+			stream.loadedFrames = 0;
+			downloads.push_back(&stream);
+		}
+	}
+
+	// split into chunks: first chunk of all streams, then the second chunk of all streams, etc.
+	// so that the loaded range of all streams grows at the same speed
+	chunks.clear();
+	long long stepsize = isLocalURL() ? INT_MAX : DOWNLOAD_CHUNK_SIZE; // local files cannot deliver partial data
+	for (long long idxFrom = 0; ; idxFrom += stepsize)
+	{
+		size_t nChunks = chunks.size();
+		for (auto sIter = downloads.begin(); sIter != downloads.end(); sIter++)
+		{
+			sStream& stream = **sIter;
+			if (idxFrom < stream.frameCount)
+			{
+				sChunk chunk;
+				chunk.pStream = &stream;
+				chunk.idxFrom = (int) idxFrom;
+				chunk.idxTo   = (int) std::min(idxFrom + stepsize, (long long) stream.frameCount);
+				chunk.state   = CHUNK_PENDING;
+				chunks.push_back(chunk);
+			}
+		}
+		if (chunks.size() == nChunks) break;
+	}
+
+	availableFrames = INT_MAX;
+	loadingComplete = chunks.empty();
+	if (loadingComplete) return true;
+
+	// start the loader threads that keep on loading in the background
+	nextChunk     = 0;
+	stopLoading   = false;
+	int nLoaders  = std::min(configuration.connectionCount, (int) chunks.size());
+	activeLoaders = nLoaders;
+	for (int lIdx = 0; lIdx < nLoaders; lIdx++)
+	{
+		loaderThreads.push_back(std::thread(&MoCapPieceMeta::loaderThread, this));
+	}
+
+	// playback can start as soon as the first chunk of every stream is there
+	LOG_INFO_START("Loading stream data (" << streams.size() << " streams, " << chunks.size() << " requests)...   0% ");
+	// (without the first chunk of a stream, there is nothing to play and no reason to load the rest)
+	bool playable = updateLoadedFrames();
+	while (playable && (availableFrames == 0) && !loadingComplete)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(100));
+		playable = updateLoadedFrames();
+
+		int nStarted = 0;
+		for (auto sIter = downloads.begin(); sIter != downloads.end(); sIter++)
+		{
+			if ((*sIter)->loadedFrames > 0) nStarted++;
+		}
+		LOG_INFO_MID("\b\b\b\b\b\b" << rotSymbol[rotSymbolIdx] << std::setw(3) << std::right << (nStarted * 100 / downloads.size()) << "% ");
 		rotSymbolIdx = (rotSymbolIdx + 1) % sizeof(rotSymbol);
+	}
+	LOG_INFO_MID("\b\b\b\b\b\b" << (playable ? " 100%  " : " failed"));
+	LOG_INFO_END();
+
+	if (!playable || (availableFrames == 0))
+	{
+		stopLoaders();
+		LOG_ERROR("Could not load the first frames of all streams");
+		return false;
+	}
+	if (!loadingComplete)
+	{
+		LOG_INFO("Starting playback with " << availableFrames << " frames, loading the rest in the background");
+	}
+	return true;
+}
+
+
+void MoCapPieceMeta::allocateStreamData(std::vector<sStream*>& streams)
+{
+	columnFile.close();
+
+	bool useColumnFile = !configuration.columnFile.empty();
+	if (useColumnFile)
+	{
+		// one column per stream, each starting on a new page so that windows can be released independently
+		std::vector<size_t> offsets;
+		size_t fileSize = 0;
+		for (auto sIter = streams.begin(); sIter != streams.end(); sIter++)
+		{
+			offsets.push_back(fileSize);
+			size_t columnSize = (*sIter)->frameCount * sizeof(float);
+			fileSize += (columnSize + COLUMN_ALIGNMENT - 1) / COLUMN_ALIGNMENT * COLUMN_ALIGNMENT;
+		}
+
+		useColumnFile = (fileSize > 0) && columnFile.create(configuration.columnFile, fileSize);
+		if (useColumnFile)
+		{
+			for (size_t sIdx = 0; sIdx < streams.size(); sIdx++)
+			{
+				sStream& stream = *streams[sIdx];
+				std::vector<float>().swap(stream.data); // free memory
+				stream.pData = (float*) (columnFile.getData() + offsets[sIdx]);
+			}
+			LOG_INFO("Using column file " << configuration.columnFile << " (" << (fileSize >> 20) << "MB)");
+		}
+		else
+		{
+			LOG_WARNING("Could not create column file, keeping stream data in memory");
+		}
+	}
+
+	if (!useColumnFile)
+	{
+		for (auto sIter = streams.begin(); sIter != streams.end(); sIter++)
+		{
+			sStream& stream = **sIter;
+			stream.data.assign(stream.frameCount, 0.0f);
+			stream.pData = stream.data.data();
+		}
+	}
+}
+
+
+void MoCapPieceMeta::releasePlayedWindow()
+{
+	if (!columnFile.isOpen()) return;
+
+	int window = currentFrame / COLUMN_WINDOW_FRAMES;
+	if (window == activeWindow) return;
+
+	// playback has left the window > release it from the working set of all streams
+	for (size_t cIdx = 0; cIdx < activeChannels.size(); cIdx++)
+	{
+		sChannel& channel = activePackage.channels[activeChannels[cIdx]];
+		for (auto sIter = channel.streams.cbegin(); sIter != channel.streams.cend(); sIter++)
+		{
+			int idxFrom = activeWindow * COLUMN_WINDOW_FRAMES;
+			int idxTo   = std::min(idxFrom + COLUMN_WINDOW_FRAMES, (int) sIter->frameCount);
+			if ((sIter->pData != NULL) && (idxFrom < idxTo))
+			{
+				columnFile.release(sIter->pData + idxFrom, (idxTo - idxFrom) * sizeof(float));
+			}
+		}
+	}
+	activeWindow = window;
+}
+
+
+void MoCapPieceMeta::reportMemoryUsage()
+{
+	size_t dataSize = 0;
+	for (size_t cIdx = 0; cIdx < activeChannels.size(); cIdx++)
+	{
+		const sChannel& channel = activePackage.channels[activeChannels[cIdx]];
+		for (auto sIter = channel.streams.cbegin(); sIter != channel.streams.cend(); sIter++)
+		{
+			dataSize += sIter->frameCount * sizeof(float);
+		}
+	}
+
+	size_t workingSet = 0;
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters;
+	counters.cb = sizeof(counters);
+	if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+	{
+		workingSet = counters.WorkingSetSize;
+	}
+#else
+	// second value: resident pages
+	std::ifstream statm("/proc/self/statm");
+	size_t totalPages = 0, residentPages = 0;
+	if (statm >> totalPages >> residentPages)
+	{
+		workingSet = residentPages * (size_t) sysconf(_SC_PAGESIZE);
+	}
+#endif
+
+	LOG_INFO("Memory usage: " << (dataSize >> 20) << "MB stream data " <<
+		(columnFile.isOpen() ? "in column file" : "in memory") <<
+		", " << (workingSet >> 20) << "MB working set");
+}
+
+
+void MoCapPieceMeta::loaderThread()
+{
+	int nChunks = chunks.size();
+	for (int cIdx = nextChunk++; (cIdx < nChunks) && !stopLoading; cIdx = nextChunk++)
+	{
+		sChunk& chunk   = chunks[cIdx];
+		bool    success = readStreamChunk(chunk);
+
+		std::lock_guard<std::mutex> lock(mtxChunks);
+		chunk.state = success ? CHUNK_LOADED : CHUNK_FAILED;
+	}
+
+	if ((--activeLoaders == 0) && !stopLoading)
+	{
+		// last loader > cache the streams with complete data
+		std::map<sStream*, bool> complete;
+		{
+			std::lock_guard<std::mutex> lock(mtxChunks);
+			for (auto cIter = chunks.begin(); cIter != chunks.end(); cIter++)
+			{
+				auto streamIter = complete.insert(std::make_pair(cIter->pStream, true)).first;
+				streamIter->second = streamIter->second && (cIter->state == CHUNK_LOADED);
+			}
+		}
+		for (auto streamIter = complete.begin(); streamIter != complete.end(); streamIter++)
+		{
+			if (streamIter->second)
+			{
+				writeStreamCache(*streamIter->first);
+			}
+			else
+			{
+				LOG_ERROR("Could not read all data of stream " << streamIter->first->uuid);
+			}
+		}
+	}
+}
+
+
+bool MoCapPieceMeta::updateLoadedFrames()
+{
+	if (loadingComplete) return (availableFrames > 0);
+
+	std::lock_guard<std::mutex> lock(mtxChunks);
+
+	// chunks are sorted by their first frame > one pass extends the loaded range of each stream
+	// (the range of a stream ends at its first failed chunk, so playback never reaches the missing data)
+	bool complete    = true;
+	bool failed      = false;
+	bool failedStart = false;
+	for (auto cIter = chunks.begin(); cIter != chunks.end(); cIter++)
+	{
+		sStream& stream = *cIter->pStream;
+		if (cIter->state == CHUNK_PENDING)
+		{
+			complete = false;
+		}
+		else if (cIter->state == CHUNK_FAILED)
+		{
+			failed      = true;
+			failedStart = failedStart || (cIter->idxFrom == 0);
+		}
+		else if (stream.loadedFrames == cIter->idxFrom)
+		{
+			stream.loadedFrames = cIter->idxTo;
+		}
+	}
+
+	// range that is loaded for all streams
+	availableFrames = INT_MAX;
+	for (auto cIter = chunks.begin(); cIter != chunks.end(); cIter++)
+	{
+		const sStream& stream = *cIter->pStream;
+		if (stream.loadedFrames < stream.frameCount)
+		{
+			availableFrames = std::min(availableFrames, stream.loadedFrames);
+		}
+	}
+
+	loadingComplete = complete;
+	if (loadingComplete && failed)
+	{
+		LOG_WARNING("Could not load all stream data, playback is limited to the first " << availableFrames << " frames");
+	}
+	else if (loadingComplete && initialised)
+	{
+		LOG_INFO("All stream data loaded");
+	}
+	return !failedStart;
+}
+
+
+void MoCapPieceMeta::stopLoaders()
+{
+	stopLoading = true;
+	for (auto tIter = loaderThreads.begin(); tIter != loaderThreads.end(); tIter++)
+	{
+		tIter->join();
+	}
+	loaderThreads.clear();
+	loadingComplete = true;
+}
+
+
+bool MoCapPieceMeta::readStreamChunk(const sChunk& chunk)
+{
+	sStream& stream = *chunk.pStream;
+
+	std::stringstream request;
+	request << configuration.baseURL << "streams/" << stream.uuid << ".json"
+	        << "?from=" << chunk.idxFrom << "&to=" << chunk.idxTo;
+
+	bool success = false;
+	for (int attempt = 1; (attempt <= DOWNLOAD_MAX_ATTEMPTS) && !success && !stopLoading; attempt++)
+	{
+		if (attempt > 1)
+		{
+			// give the server some time before retrying
+			std::this_thread::sleep_for(std::chrono::seconds(attempt - 1));
+		}
 
-		// determine from/to indices and build query
-		int idxTo = min(idxFrom + stepsize, stream.frameCount);
-		std::stringstream request;
-		request << PIECEMETA_BASE_URL "streams/" << stream.uuid << ".json"
-		        << "?from=" << idxFrom << "&to=" << idxTo;
-		
 		// execute query
 		std::string response;
-		if (MoCapPieceMeta::readURL(request.str(), response))
+		if (readURL(request.str(), response))
 		{
-			std::string errorMsg;
-			json11::Json json = json11::Json::parse(response, errorMsg);
-			if (errorMsg.empty() && json.is_object())
+			// data received > parse directly into the place of the chunk
+			int nFrames = parseFrames(response, stream.pData + chunk.idxFrom, chunk.idxTo - chunk.idxFrom);
+			if (nFrames == chunk.idxTo - chunk.idxFrom)
 			{
-				// data received > parse
-				const std::vector<json11::Json>& channelJson = json["frames"].array_items();
-				for (std::vector<json11::Json>::const_iterator i = channelJson.cbegin(); i != channelJson.cend(); ++i)
-				{
-					stream.data.push_back((float) (*i).number_value());
-				}
-				idxFrom = idxTo;
+				success = true;
+			}
+			else if (nFrames >= 0)
+			{
+				// a truncated response would leave frames at 0
+				LOG_ERROR("Could not read stream data (" << nFrames << " instead of " << (chunk.idxTo - chunk.idxFrom) << " frames)");
 			}
 			else
 			{
-				LOG_ERROR("Could not read stream data (" << errorMsg << ")");
-				success = false;
+				LOG_ERROR("Could not read stream data (invalid frames array)");
 			}
 		}
 	}
@@ -705,6 +1234,137 @@ bool MoCapPieceMeta::readStreamData(sStream& stream)
 }
 
 
+int MoCapPieceMeta::parseFrames(const std::string& json, float* pData, int maxCount)
+{
+	// Stream data responses are large arrays of numbers.
+	// Scanning them directly avoids building a JSON object for every single value.
+	const char* pos = json.c_str();
+	const char* end = pos + json.length();
+
+	// find the "frames" key
+	const char*  key       = "\"frames\"";
+	const size_t keyLength = strlen(key);
+	while (true)
+	{
+		pos = strstr(pos, key);
+		if (pos == nullptr) return -1;
+		pos += keyLength;
+		while (isspace((unsigned char) *pos)) pos++;
+		if (*pos == ':') break;
+	}
+	pos++;
+	while (isspace((unsigned char) *pos)) pos++;
+	if (*pos != '[') return -1;
+	pos++;
+	while (isspace((unsigned char) *pos)) pos++;
+	if (*pos == ']') return 0;
+
+	// read values until the end of the array
+	int count = 0;
+	while (true)
+	{
+		double value = 0;
+		if (strncmp(pos, "null", 4) == 0)
+		{
+			pos += 4; // same as json11: null > 0
+		}
+		else
+		{
+			// from_chars does not depend on the locale and is several times faster than strtod,
+			// reading double like json11 does keeps the rounding of the values the same
+			std::from_chars_result result = std::from_chars(pos, end, value);
+			if (result.ec != std::errc()) return -1;
+			pos = result.ptr;
+		}
+
+		if (count < maxCount)
+		{
+			pData[count++] = (float) value;
+		}
+
+		while (isspace((unsigned char) *pos)) pos++;
+		if (*pos == ']') break;
+		if (*pos != ',') return -1;
+		pos++;
+		while (isspace((unsigned char) *pos)) pos++;
+	}
+
+	return count;
+}
+
+
+std::string MoCapPieceMeta::getCacheFileName(const sStream& stream) const
+{
+	std::stringstream filename;
+	filename << configuration.cacheDirectory << stream.uuid << "_0_" << stream.frameCount << ".bin";
+	return filename.str();
+}
+
+
+bool MoCapPieceMeta::readStreamCache(sStream& stream)
+{
+	if (configuration.cacheDirectory.empty()) return false;
+
+	bool success = false;
+	std::ifstream file(getCacheFileName(stream), std::ios::in | std::ios::binary);
+	if (file)
+	{
+		int32_t header[4] = { 0 };
+		file.read((char*) header, sizeof(header));
+		if (file &&
+		    (header[0] == CACHE_FILE_MAGIC) && (header[1] == CACHE_FILE_VERSION) &&
+		    (header[2] == 0) && (header[3] == stream.frameCount))
+		{
+			file.read((char*) stream.pData, stream.frameCount * sizeof(float));
+			success = !file.fail();
+		}
+
+		if (!success)
+		{
+			LOG_WARNING("Invalid cache file for stream " << stream.uuid);
+			std::fill(stream.pData, stream.pData + stream.frameCount, 0.0f);
+		}
+	}
+	return success;
+}
+
+
+bool MoCapPieceMeta::writeStreamCache(const sStream& stream)
+{
+	if (configuration.cacheDirectory.empty()) return false;
+
+	// write into temporary file first so that an interrupted write does not leave a broken cache file
+	std::string filename = getCacheFileName(stream);
+	std::string tempname = filename + ".tmp";
+	bool success = false;
+	{
+		std::ofstream file(tempname, std::ios::out | std::ios::binary | std::ios::trunc);
+		if (file)
+		{
+			int32_t header[4] = { CACHE_FILE_MAGIC, CACHE_FILE_VERSION, 0, (int32_t) stream.frameCount };
+			file.write((const char*) header, sizeof(header));
+			file.write((const char*) stream.pData, stream.frameCount * sizeof(float));
+			success = !file.fail();
+		}
+	}
+
+	if (success)
+	{
+#ifdef _WIN32
+		success = (MoveFileExA(tempname.c_str(), filename.c_str(), MOVEFILE_REPLACE_EXISTING) != 0);
+#else
+		success = (rename(tempname.c_str(), filename.c_str()) == 0);
+#endif
+	}
+	if (!success)
+	{
+		LOG_WARNING("Could not write cache file for stream " << stream.uuid);
+		remove(tempname.c_str());
+	}
+	return success;
+}
+
+
 /******************************************************************************
  * MoCapPieceMeta::sPackage class
  */
@@ -787,12 +1447,11 @@ void MoCapPieceMeta::sChannel::analyseStreamData()
 	frameCount = 0;
 	frameRate  = 0;
 
-	int numStreams = streams.size();
 	for (auto sIter = streams.cbegin() ; sIter != streams.end() ; sIter++)
 	{
 		const sStream& stream = *sIter;
-		frameCount = max(stream.frameCount, frameCount);
-		frameRate  = max(stream.fps, frameRate);
+		frameCount = std::max((int) stream.frameCount, frameCount);
+		frameRate  = std::max(stream.fps, frameRate);
 
 		// if not existing, add stream group to list of groups
 		if (!stream.group.empty() && std::find(groupNames.begin(), groupNames.end(), stream.group) == groupNames.end())
@@ -814,81 +1473,107 @@ void MoCapPieceMeta::sChannel::analyseStreamData()
 void MoCapPieceMeta::sChannel::setConfiguration(const StreamConfiguration* pConfiguration)
 {
 	this->pConfiguration = pConfiguration;
-	streamGroupMap.clear();
-	// go through all streams
+
+	// sort the streams into groups and types
+	tStreamGroupMap streamGroupMap;
 	for (auto sIter = streams.begin(); sIter != streams.end(); sIter++)
 	{
 		sStream& stream = *sIter;
-
-		// find the stream group type map
-		auto groupIter = streamGroupMap.find(stream.group);
-		if (groupIter == streamGroupMap.end())
-		{
-			streamGroupMap[stream.group]; // make sure the entry exists
-			groupIter = streamGroupMap.find(stream.group);
-		}
-
-		// insert stream into type map of that group
 		eStreamType type = pConfiguration->getStreamType(stream);
-		groupIter->second[type] = &stream;
+		streamGroupMap[stream.group][type] = &stream;
 	}
-}
 
-
-float MoCapPieceMeta::sChannel::getTimestamp(int frame)
-{
-	float timestamp = 0;
-	
-	// find the empty group (there is only one timestamp per channel)
+	// resolve the timestamp stream (there is only one timestamp per channel, in the empty group)
+	timestampColumn = sColumn();
 	auto groupIter = streamGroupMap.find("");
 	if (groupIter != streamGroupMap.end())
 	{
-		// found it > find the timestamp stream
-		auto typeMap = (*groupIter).second;
-		auto streamIter = typeMap.find(eStreamType::timestamp);
-		if (streamIter != typeMap.end())
+		auto streamIter = groupIter->second.find(eStreamType::timestamp);
+		if (streamIter != groupIter->second.end())
 		{
-			// found it > get timestamp value
-			auto stream = (*streamIter).second;
-			if ((frame >= 0) && (frame < stream->frameCount))
+			timestampColumn.pStream = streamIter->second;
+		}
+	}
+
+	// resolve the X/Y/Z streams of each marker in the order of the group names
+	const eStreamType arrTypes[] = { posX, posY, posZ };
+	markerColumns.assign(groupNames.size() * 3, sColumn());
+	for (size_t gIdx = 0; gIdx < groupNames.size(); gIdx++)
+	{
+		groupIter = streamGroupMap.find(groupNames[gIdx]);
+		if (groupIter == streamGroupMap.end()) continue;
+
+		for (int tIdx = 0; tIdx < 3; tIdx++)
+		{
+			auto streamIter = groupIter->second.find(arrTypes[tIdx]);
+			if (streamIter != groupIter->second.end())
 			{
-				timestamp = stream->data[frame];
+				markerColumns[gIdx * 3 + tIdx].pStream = streamIter->second;
 			}
 		}
 	}
-	return timestamp;
+	prepareColumns();
 }
 
 
-void MoCapPieceMeta::sChannel::getPosition(int frame, const std::string& group, float vecPos[3], bool reset)
+void MoCapPieceMeta::sChannel::prepareColumns()
 {
-	// find the group
-	auto groupIter = streamGroupMap.find(group);
-	if (groupIter != streamGroupMap.end())
+	static const float ZERO_COLUMN[1] = { 0 };
+
+	timestampColumn.prepare(ZERO_COLUMN);
+	for (auto cIter = markerColumns.begin(); cIter != markerColumns.end(); cIter++)
 	{
-		auto typeMap = (*groupIter).second;
-		// iterate through X/Y/Z position types
-		const eStreamType arrTypes[] = { posX, posY, posZ };
-		for (int tIdx = 0; tIdx < 3; tIdx++)
+		cIter->prepare(ZERO_COLUMN);
+	}
+}
+
+
+float MoCapPieceMeta::sChannel::getTimestamp(int frame) const
+{
+	return timestampColumn.pData[std::min(frame, timestampColumn.lastFrame)];
+}
+
+
+void MoCapPieceMeta::sChannel::getPositions(int frame, MarkerData* pMarkers, int nMarkers) const
+{
+	nMarkers = std::min(nMarkers, (int) groupNames.size());
+	const sColumn* pColumn = markerColumns.data();
+	for (int mIdx = 0; mIdx < nMarkers; mIdx++)
+	{
+		float* pPos = pMarkers[mIdx];
+		for (int tIdx = 0; tIdx < 3; tIdx++, pColumn++)
 		{
-			auto streamIter = typeMap.find(arrTypes[tIdx]);
-			if (streamIter != typeMap.end())
-			{
-				// found the type > get the value
-				auto stream = (*streamIter).second;
-				if ((frame >= 0) && (frame < stream->frameCount))
-				{
-					vecPos[tIdx] = stream->data[frame];
-				}
-				reset = false;
-			}
+			pPos[tIdx] = pColumn->pData[std::min(frame, pColumn->lastFrame)];
 		}
 	}
+}
 
-	if (reset)
+
+/******************************************************************************
+ * MoCapPieceMeta::sChannel::sColumn class
+ */
+
+MoCapPieceMeta::sChannel::sColumn::sColumn() :
+	pStream(NULL),
+	pData(NULL),
+	lastFrame(0)
+{
+	// nothing else to do
+}
+
+
+void MoCapPieceMeta::sChannel::sColumn::prepare(const float* pZeroColumn)
+{
+	if ((pStream != NULL) && (pStream->pData != NULL) && (pStream->frameCount > 0))
+	{
+		pData     = pStream->pData;
+		lastFrame = pStream->frameCount - 1;
+	}
+	else
 	{
-		// no data found > reset to 0
-		vecPos[0] = vecPos[1] = vecPos[2] = 0;
+		// no data > always 0
+		pData     = pZeroColumn;
+		lastFrame = 0;
 	}
 }
 
@@ -898,7 +1583,9 @@ void MoCapPieceMeta::sChannel::getPosition(int frame, const std::string& group,
  */
 
 MoCapPieceMeta::sStream::sStream(sChannel& channel, const json11::Json& json, int maxFrameCount) :
-	channel(&channel)
+	channel(&channel),
+	loadedFrames(0),
+	pData(NULL)
 {
 	if (json.is_object())
 	{
@@ -907,15 +1594,14 @@ MoCapPieceMeta::sStream::sStream(sChannel& channel, const json11::Json& json, in
 		uuid       = json["uuid"].string_value();
 		fps        = (float) json["fps"].number_value();
 		frameCount = json["frameCount"].int_value();
-		frameCount = min(frameCount, maxFrameCount); // limit to maximum
+		frameCount = std::min(frameCount, (long) maxFrameCount); // limit to maximum
 	}
 }
 
 
 const MoCapPieceMeta::StreamConfiguration* MoCapPieceMeta::findConfiguration(const std::vector<std::string>& names)
 {
-	int configIdx = -1;
-	for (int idx = 0; idx < STREAM_CONFIGURATION_COUNT; idx++)
+	for (size_t idx = 0; idx < STREAM_CONFIGURATION_COUNT; idx++)
 	{
 		if (STREAM_CONFIGURATIONS[idx].matches(names))
 		{
@@ -10,9 +10,13 @@
 
 #include "MoCapSystem.h"
 #include "Configuration.h"
+#include "MappedFile.h"
 
-#include <string>
+#include <atomic>
 #include <map>
+#include <mutex>
+#include <string>
+#include <thread>
 #include <vector>
 
 #include "json11.hpp"
@@ -30,8 +34,12 @@ public:
 	bool                     usePieceMeta;
 	int                      maximumFrameCount;
 	bool                     listOnly;
+	int                      connectionCount;
 	std::string              packageFilter;
 	std::vector<std::string> channelFilters;
+	std::string              baseURL;
+	std::string              cacheDirectory;
+	std::string              columnFile;
 };
 
 
@@ -54,17 +62,32 @@ public:
 	virtual bool  processCommand(const std::string& strCommand);
 	virtual bool  deinitialise();
 
+	/**
+	 * Reads the values of the "frames" array of a stream data response
+	 * without building the complete JSON structure.
+	 *
+	 * @param json      the response to parse
+	 * @param pData     the array to write the values into
+	 * @param maxCount  the maximum amount of values to write, further values are skipped
+	 *
+	 * @return the amount of values written,
+	 *         or -1 if the response does not contain a valid frames array
+	 */
+	static int parseFrames(const std::string& json, float* pData, int maxCount);
+
 private:
 
 	// Forward declarations
 	struct sPackage;
 	struct sChannel;
 	struct sStream;
+	struct sChunk;
 	class  StreamConfiguration;
 
 
 	/**
 	 * Reads a URL into a string.
+	 * URLs starting with <code>file://</code> are read from the local file system.
 	 *
 	 * @param url     the URL to read
 	 * @param content the string to read the URL into
@@ -74,6 +97,14 @@ private:
 	bool readURL(const std::string& url, std::string& content);
 
 
+	/**
+	 * Checks if the base URL points to the local file system.
+	 *
+	 * @return <code>true</code> if the data is read from local files
+	 */
+	bool isLocalURL() const;
+
+
 	/**
 	 * Reads all packages from PieceMeta.
 	 *
@@ -105,14 +136,103 @@ private:
 
 
 	/**
-	* Reads the data for a stream.
+	* Reads the data for several streams.
+	* Streams that are not in the cache are downloaded in chunks by several background threads.
+	* The function returns as soon as the first chunk of every stream has been loaded.
+	*
+	* @param streams  the streams to read the data for
+	*
+	* @return <code>true</code> if data was read successfully,
+	*         <code>false</code> if not
+	*/
+	bool readStreamData(std::vector<sStream*>& streams);
+
+
+	/**
+	* Allocates the data of the streams, either in memory or in the column file.
+	*
+	* @param streams  the streams to allocate the data for
+	*/
+	void allocateStreamData(std::vector<sStream*>& streams);
+
+
+	/**
+	* Releases the frame window that playback has left from the working set
+	* when the stream data is in the column file.
+	*/
+	void releasePlayedWindow();
+
+
+	/**
+	* Prints the size of the stream data and the working set of the process.
+	*/
+	void reportMemoryUsage();
+
+
+	/**
+	* Background thread that loads chunks until all are loaded.
+	*/
+	void loaderThread();
+
+
+	/**
+	* Updates the range of frames that has been loaded for all streams.
+	*
+	* @return <code>false</code> if the first chunk of a stream has failed,
+	*         i.e., if playback cannot start, <code>true</code> if not
+	*/
+	bool updateLoadedFrames();
+
+
+	/**
+	* Stops the background threads that load stream data.
+	*/
+	void stopLoaders();
+
+
+	/**
+	* Reads one chunk of stream data and retries if the request fails.
+	* Can be called from several threads at the same time for different chunks.
 	*
-	* @param stream  the stream to read the data for
+	* @param chunk  the chunk to read
 	*
 	* @return <code>true</code> if data was read successfully,
 	*         <code>false</code> if not
 	*/
-	bool readStreamData(sStream& stream);
+	bool readStreamChunk(const sChunk& chunk);
+
+
+	/**
+	 * Gets the name of the cache file for the data of a stream.
+	 * The name is built from the stream UUID and the frame range.
+	 *
+	 * @param stream  the stream to get the cache file name for
+	 *
+	 * @return the cache file name
+	 */
+	std::string getCacheFileName(const sStream& stream) const;
+
+
+	/**
+	 * Reads the data for a stream from the cache.
+	 *
+	 * @param stream  the stream to read the data for
+	 *
+	 * @return <code>true</code> if the data was found in the cache,
+	 *         <code>false</code> if not
+	 */
+	bool readStreamCache(sStream& stream);
+
+
+	/**
+	 * Writes the data of a stream into the cache.
+	 *
+	 * @param stream  the stream to write the data of
+	 *
+	 * @return <code>true</code> if the data was written successfully,
+	 *         <code>false</code> if not
+	 */
+	bool writeStreamCache(const sStream& stream);
 
 
 	/**
@@ -153,7 +273,7 @@ private:
 	/**
 	 * Inner class for a package
 	 */
-	struct MoCapPieceMeta::sPackage
+	struct sPackage
 	{
 		std::string  title;
 		std::string  description;
@@ -172,7 +292,7 @@ private:
 	/**
 	 * Inner class for a package channel
 	 */
-	struct MoCapPieceMeta::sChannel
+	struct sChannel
 	{
 		sPackage*    package;
 
@@ -189,23 +309,40 @@ private:
 		std::vector<std::string>    groupNames;
 		std::vector<std::string>    streamNames;
 		const StreamConfiguration*  pConfiguration;
-		tStreamGroupMap             streamGroupMap;
+
+		/**
+		 * Stream data column, resolved once so that playback needs no lookups.
+		 * Frames beyond the end of the data repeat the last value.
+		 */
+		struct sColumn
+		{
+			const sStream* pStream;
+			const float*   pData;
+			int            lastFrame;
+
+			sColumn();
+			void prepare(const float* pZeroColumn);
+		};
+
+		sColumn                     timestampColumn;
+		std::vector<sColumn>        markerColumns; // X/Y/Z per marker in the order of groupNames
 
 		sChannel(sPackage& package, const json11::Json& json);
 		
 		void  analyseStreamData();
 		
 		void  setConfiguration(const StreamConfiguration* pConfiguration);
+		void  prepareColumns(); // call after the stream data has been (re)allocated
 		
-		float getTimestamp(int frame);
-		void  getPosition(int frame, const std::string& group, float vecPos[3], bool reset);
+		float getTimestamp(int frame) const;
+		void  getPositions(int frame, MarkerData* pMarkers, int nMarkers) const;
 	};
 
 
 	/**
 	 * Inner class for a channel stream
 	 */
-	struct MoCapPieceMeta::sStream
+	struct sStream
 	{
 		sChannel*   channel;
 
@@ -214,13 +351,32 @@ private:
 		std::string group;
 		long        frameCount;
 		float       fps;
+		int         loadedFrames; // frames at the start of the data that have been loaded
 
-		std::vector<float> data;
+		std::vector<float> data;  // stream data in memory
+		float*             pData; // stream data, either in data or in the column file
 
 		sStream(sChannel& channel, const json11::Json& json, int maxFrameCount);
 	};
 
 
+	/**
+	 * Inner class for a part of the stream data to download
+	 */
+	enum eChunkState
+	{
+		CHUNK_PENDING, CHUNK_LOADED, CHUNK_FAILED
+	};
+
+	struct sChunk
+	{
+		sStream*    pStream;
+		int         idxFrom;
+		int         idxTo;
+		eChunkState state;  // guarded by mtxChunks
+	};
+
+
 private:
 
 	MoCapPieceMetaConfiguration configuration;
@@ -234,7 +390,17 @@ private:
 	std::vector<int> activeChannels;
 	int              longestChannel;
 
-	char readBuffer[65536];
+	std::vector<sChunk>      chunks;          // stream data chunks in the order of their first frame
+	std::mutex               mtxChunks;
+	std::vector<std::thread> loaderThreads;
+	std::atomic<int>         nextChunk;
+	std::atomic<int>         activeLoaders;
+	std::atomic<bool>        stopLoading;
+	int                      availableFrames; // frames that have been loaded for all streams
+	bool                     loadingComplete;
+
+	MappedFile               columnFile;
+	int                      activeWindow;    // frame window of the column file that is being played
 
 	static const StreamConfiguration STREAM_CONFIGURATIONS[];
 };
@@ -5,12 +5,17 @@
 #pragma once
 
 #include "MoCapData.h"
+#include <mutex>
 #include <string>
 
 
 // this function can be used by the class to stream frames
 extern void signalNewFrame();
 
+// this mutex has to be locked while a class changes the scene description
+// after it has been published, because the server reads it when clients request it
+extern std::mutex& getSceneDescriptionMutex();
+
 /**
  * Pure virtual base class for the minimum MoCap system methods.
  */
@@ -44,6 +44,7 @@
 #include "NatNetTypes.h"
 #include "NatNetServer.h"
 #include "MoCapData.h"
+#include "ForwardKinematics.h"
 #include "Configuration.h"
 #include "Version.h"
 
@@ -87,17 +88,18 @@ public:
 		// 1503 is taken by Windows messenger, 1512 is taken by WINS -> so let's use 1508, 1509
 		commandPort(1508),
 		dataPort(1509),
-		interactionControllerPort(0),
 		writeData(false),
-		globalScale(1.0f)
+		globalScale(1.0f),
+		worldSkeletons(false)
 	{
 		addOption(   "-h",                                       "Print Help");
 		addParameter("-serverName",                 "<name>",    "Name of MoCap Server (default: '" + serverName + "')");
 		addParameter("-serverAddress",              "<address>", "IP Address of MotionServer (default: " + serverAddress + ")");
 		addParameter("-multicastAddress",           "<address>", "IP Address of multicast MotionServer (default: Unicast)");
-		addParameter("-interactionControllerPort",  "<number>",  "COM port of XBee interaction controller (-1: scan)");
+		addParameter("-interactionControllerPort",  "<number>",  "COM port of XBee interaction controller (-1: scan, repeat for several controllers)");
 		addOption(   "-writeFile",                               "Write MoCap data into timestamped files");
 		addParameter("-scale",                      "<scale>",   "Global scale for position data (default: 1.0)");
+		addOption(   "-worldSkeletons",                          "Add skeletons with world space bone poses");
 	}
 
 
@@ -124,9 +126,13 @@ public:
 				useMulticast = true;
 				break;
 
-			case 4: // COM port number for XBee interaction controller
-				strmValue >> interactionControllerPort;
+			case 4: // COM port number for XBee interaction controller (can be used several times)
+			{
+				int portNumber = 0;
+				strmValue >> portNumber;
+				interactionControllerPorts.push_back(portNumber);
 				break;
+			}
 
 			case 5: // write file
 				writeData = true;
@@ -136,6 +142,10 @@ public:
 				strmValue >> globalScale;
 				break;
 
+			case 7: // world space skeletons
+				worldSkeletons = true;
+				break;
+
 			default:
 				success = false;
 				break;
@@ -157,9 +167,11 @@ public:
 
 	bool        writeData;
 
-	int         interactionControllerPort;
+	std::vector<int> interactionControllerPorts;
 
 	float       globalScale;
+
+	bool        worldSkeletons;
 };
 
 
@@ -230,6 +242,8 @@ sPacket       packetOut;
 
 MoCapFileWriter* pMoCapFileWriter;
 
+ForwardKinematics* pForwardKinematics;
+
 // Interaction system variables
 InteractionSystem* pInteractionSystem;
 
@@ -440,59 +454,65 @@ MoCapSystem* detectMoCapSystem()
 
 
 /**
- * Detects the XBee interaction system controller.
+ * Detects the XBee interaction system controllers.
  *
- * @return  the controller instance
+ * @return  the interaction system instance with all controllers that were found
  *          (or <code>nullptr</code> if no controller was found)
  */
 InteractionSystem* detectInteractionSystem()
 {
 	InteractionSystem* pSystem = nullptr;
-	
-	if (config.pMain->interactionControllerPort > 255)
-	{
-		// invalid > don't use
-		config.pMain->interactionControllerPort = 0;
-	}
-
-	int scanFrom = config.pMain->interactionControllerPort;
-	int scanTo   = config.pMain->interactionControllerPort + 1;
-	if (config.pMain->interactionControllerPort < 0)
-	{
-		scanFrom = 1;
-		scanTo = 256;
-		LOG_INFO("Scanning for Interaction System...");
-	}
-	else if (config.pMain->interactionControllerPort > 0)
-	{
-		LOG_INFO("Searching Interaction System on COM" << config.pMain->interactionControllerPort);
-	}
 
-	// scan ports 
-	for (int iPort = scanFrom; iPort < scanTo; iPort++)
+	// collect the ports to use
+	std::vector<int> arrPortNumbers;
+	for (int portNumber : config.pMain->interactionControllerPorts)
 	{
-		if (iPort == 10) continue; // TODO: remove later (hack to avoid getting stuck on COM10 on my laptop)
-
-		std::unique_ptr<SerialPort> pSerialPort(new SerialPort(iPort));
-		if (pSerialPort->exists() && pSerialPort->open())
+		if (portNumber < 0)
 		{
-			pSystem = new InteractionSystem(pSerialPort);
-			if (pSystem->initialise())
+			LOG_INFO("Scanning for Interaction System...");
+			for (int iPort = 1; iPort < 256; iPort++)
 			{
-				LOG_INFO("Found Interaction System on COM" << iPort);
-			} 
-			else
+				if (iPort == 10) continue; // TODO: remove later (hack to avoid getting stuck on COM10 on my laptop)
+
+				if (SerialPort(iPort).exists() &&
+				    (std::find(arrPortNumbers.begin(), arrPortNumbers.end(), iPort) == arrPortNumbers.end()))
+				{
+					arrPortNumbers.push_back(iPort);
+				}
+			}
+		}
+		else if ((portNumber > 0) && (portNumber < 256))
+		{
+			LOG_INFO("Searching Interaction System on COM" << portNumber);
+			if (std::find(arrPortNumbers.begin(), arrPortNumbers.end(), portNumber) == arrPortNumbers.end())
 			{
-				pSystem->deinitialise();
-				delete pSystem;
-				pSystem = nullptr;
+				arrPortNumbers.push_back(portNumber);
 			}
 		}
+		else if (portNumber > 0)
+		{
+			// invalid > don't use
+			LOG_WARNING("Invalid Interaction System port COM" << portNumber);
+		}
 	}
 
-	if (!pSystem)
+	if (!arrPortNumbers.empty())
 	{
-		LOG_INFO("Cound not find Interaction System");
+		std::vector<std::unique_ptr<SerialPort>> arrPorts;
+		for (int portNumber : arrPortNumbers)
+		{
+			arrPorts.push_back(std::unique_ptr<SerialPort>(new SerialPort(portNumber)));
+		}
+
+		// all coordinators that are found are used together
+		pSystem = new InteractionSystem(arrPorts);
+		if (!pSystem->initialise())
+		{
+			pSystem->deinitialise();
+			delete pSystem;
+			pSystem = nullptr;
+			LOG_INFO("Cound not find Interaction System");
+		}
 	}
 
 	return pSystem;
@@ -582,6 +602,17 @@ bool isServerRunning()
 }
 
 
+/**
+ * Gets the mutex that guards the scene description against the server reading it for clients.
+ *
+ * @return the mutex to lock while changing the scene description
+ */
+std::mutex& getSceneDescriptionMutex()
+{
+	return mtxServer;
+}
+
+
 /**
  * Called from MoCap subsystems when they actively provide a new frame.
  *
@@ -592,13 +623,39 @@ void signalNewFrame()
 	mtxMoCap.lock();
 	if (pMoCapSystem && pMoCapSystem->isActive() && pMocapData)
 	{
+		// the MoCap system only knows its own skeletons
+		if (pForwardKinematics)
+		{
+			pForwardKinematics->removeWorldSkeletonData(*pMocapData);
+		}
+
 		if (pMoCapSystem->getFrameData(*pMocapData))
 		{
 			if (pInteractionSystem)
 			{
+				if (pInteractionSystem->hasNewDevices())
+				{
+					// devices discovered after the server has started > add to the scene
+					mtxServer.lock();
+					pInteractionSystem->getSceneDescription(*pMocapData);
+					pMocapData->sceneVersion++;
+					mtxServer.unlock();
+				}
 				pInteractionSystem->getFrameData(*pMocapData);
 			}
 
+			if (pForwardKinematics)
+			{
+				if (pForwardKinematics->needsUpdate(*pMocapData))
+				{
+					// scene has changed > replace the world space skeletons in the scene
+					mtxServer.lock();
+					pForwardKinematics->updateDescriptions(*pMocapData);
+					mtxServer.unlock();
+				}
+				pForwardKinematics->addWorldSkeletonData(*pMocapData);
+			}
+
 			pMocapData->applyScale(config.pMain->globalScale);
 
 			mtxServer.lock();
@@ -954,15 +1011,36 @@ int main(int nArguments, char* arrArguments[])
 				{
 					if (pMocapData->frame.nForcePlates == 0)
 					{
+						if (pMoCapFileWriter)
+						{
+							// the description in the file cannot change later > wait for all devices
+							pInteractionSystem->waitForDiscovery();
+						}
 						pInteractionSystem->getSceneDescription(*pMocapData);
 					}
 					else
 					{
 						// force platyes already defined (e.g., through file playback) > sorry, no realtime data possible
 						LOG_WARNING("Cannot use real-time Interaction System data");
+						mtxMoCap.lock();
+						pInteractionSystem->deinitialise();
+						delete pInteractionSystem;
+						pInteractionSystem = nullptr;
+						mtxMoCap.unlock();
 					}
 				}
 
+				// add world space skeletons?
+				if (config.pMain->worldSkeletons)
+				{
+					// the MoCap system might already be signalling frames
+					mtxMoCap.lock();
+					pForwardKinematics = new ForwardKinematics();
+					pForwardKinematics->updateDescriptions(*pMocapData);
+					pForwardKinematics->addWorldSkeletonData(*pMocapData);
+					mtxMoCap.unlock();
+				}
+
 				// if enabled, write description to file
 				if (pMoCapFileWriter)
 				{
@@ -1086,6 +1164,14 @@ int main(int nArguments, char* arrArguments[])
 				pMoCapSystem = nullptr;
 			}
 
+			if (pForwardKinematics)
+			{
+				// the descriptions belong to the forward kinematics, not to the MoCap data
+				pForwardKinematics->removeWorldSkeletons(*pMocapData);
+				delete pForwardKinematics;
+				pForwardKinematics = nullptr;
+			}
+
 			if (pMocapData)
 			{
 				delete pMocapData;
@@ -0,0 +1,79 @@
+/**
+ * Replacements for the Microsoft specific C runtime functions that are used by the MoCap modules,
+ * so that these modules can also be compiled with other compilers (e.g., for the tests on POSIX systems).
+ * With the Microsoft compiler, this header does not define anything.
+ */
+
+#pragma once
+
+#ifndef _MSC_VER
+
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <strings.h>
+
+
+#ifndef __cdecl
+#define __cdecl
+#endif
+
+
+inline int strcpy_s(char* czDest, size_t destSize, const char* czSrc)
+{
+	snprintf(czDest, destSize, "%s", czSrc);
+	return 0;
+}
+
+template<size_t destSize>
+inline int strcpy_s(char (&czDest)[destSize], const char* czSrc)
+{
+	return strcpy_s(czDest, destSize, czSrc);
+}
+
+
+template<size_t destSize>
+inline int strncpy_s(char (&czDest)[destSize], const char* czSrc, size_t count)
+{
+	// like with the Microsoft version, the result is always terminated
+	size_t len = strnlen(czSrc, count < destSize ? count : destSize - 1);
+	memcpy(czDest, czSrc, len);
+	czDest[len] = '\0';
+	return 0;
+}
+
+
+inline int sprintf_s(char* czDest, size_t destSize, const char* czFormat, ...)
+{
+	va_list args;
+	va_start(args, czFormat);
+	int len = vsnprintf(czDest, destSize, czFormat, args);
+	va_end(args);
+	return len;
+}
+
+template<size_t destSize>
+inline int sprintf_s(char (&czDest)[destSize], const char* czFormat, ...)
+{
+	va_list args;
+	va_start(args, czFormat);
+	int len = vsnprintf(czDest, destSize, czFormat, args);
+	va_end(args);
+	return len;
+}
+
+
+inline int _stricmp(const char* czString1, const char* czString2)
+{
+	return strcasecmp(czString1, czString2);
+}
+
+
+inline int localtime_s(struct tm* pResult, const time_t* pTime)
+{
+	return (localtime_r(pTime, pResult) != NULL) ? 0 : -1;
+}
+
+
+#endif // #ifndef _MSC_VER
@@ -3,6 +3,16 @@
 #include <ios>
 #include <locale>
 
+#ifndef _WIN32
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <unistd.h>
+#endif
+
 #include "Logging.h"
 #undef   LOG_CLASS
 #define  LOG_CLASS "SerialPort"
@@ -14,8 +24,14 @@
 
 SerialPort::SerialPort(int portNumber) :
 	m_iPortNumber(portNumber),
+#ifdef _WIN32
 	m_hPort(0)
+#else
+	m_fdPort(-1),
+	m_timeout(0)
+#endif
 {
+#ifdef _WIN32
 	// build short name from port number
 	std::stringstream strPortName;
 	strPortName << "COM" << m_iPortNumber;
@@ -25,9 +41,57 @@ SerialPort::SerialPort(int portNumber) :
 	std::stringstream strFileName;
 	strFileName << "\\\\.\\COM" << m_iPortNumber;
 	m_strFileName = strFileName.str();
+#else
+	// build device name from port number (COM1 = first USB serial device)
+	std::stringstream strPortName;
+	strPortName << "/dev/ttyUSB" << (m_iPortNumber - 1);
+	m_strPortName = strPortName.str();
+	m_strFileName = m_strPortName;
+#endif
+}
+
+
+SerialPort::SerialPort(const std::string& deviceName) :
+	m_iPortNumber(0),
+	m_strPortName(deviceName),
+	m_strFileName(deviceName),
+#ifdef _WIN32
+	m_hPort(0)
+#else
+	m_fdPort(-1),
+	m_timeout(0)
+#endif
+{
+#ifdef _WIN32
+	// COM ports above 9 can only be opened with the device namespace prefix
+	m_strFileName = "\\\\.\\" + deviceName;
+#endif
+}
+
+
+const std::string& SerialPort::getName() const
+{
+	return m_strPortName;
+}
+
+
+SerialPort::~SerialPort()
+{
+	if (isOpen())
+	{
+		close();
+	}
 }
 
 
+
+#ifdef _WIN32
+
+/******************************************************************************
+ * Windows implementation using the communication API
+ */
+
+
 bool SerialPort::exists() const
 {
 	// source: http://stackoverflow.com/questions/1205383/listing-serial-com-ports-on-windows
@@ -170,8 +234,11 @@ bool SerialPort::setTimeout(DWORD timeout)
 		// read previous timeouts
 		if (::GetCommTimeouts(m_hPort, &timeouts))
 		{
-			// success > change timeout
-			timeouts.ReadTotalTimeoutConstant = timeout;
+			// success > change timeout:
+			// return immediately with whatever is available, or wait up to the timeout for the first byte
+			timeouts.ReadIntervalTimeout        = MAXDWORD;
+			timeouts.ReadTotalTimeoutMultiplier = MAXDWORD;
+			timeouts.ReadTotalTimeoutConstant   = timeout;
 		}
 		else
 		{
@@ -210,15 +277,6 @@ DWORD SerialPort::receive(void* pBuffer, DWORD nBytesToReceive) const
 }
 
 
-SerialPort::~SerialPort()
-{
-	if (isOpen())
-	{
-		close();
-	}
-}
-
-
 void SerialPort::handleError(const char* strFunction) const
 {
 	LPVOID lpMsgBuf;
@@ -240,3 +298,233 @@ void SerialPort::handleError(const char* strFunction) const
 	LocalFree(lpMsgBuf);
 }
 
+#else
+
+/******************************************************************************
+ * POSIX implementation using a termios device with non-blocking I/O
+ */
+
+static const int SEND_TIMEOUT = 1000; // maximum time to wait for the device to accept data in ms
+
+
+/**
+ * Converts a baudrate into the termios speed constant.
+ *
+ * @param baudRate  the baudrate to convert
+ *
+ * @return the speed constant or B0 if the baudrate is not supported
+ */
+static speed_t getSpeedConstant(DWORD baudRate)
+{
+	switch (baudRate)
+	{
+		case   1200: return B1200;
+		case   2400: return B2400;
+		case   4800: return B4800;
+		case   9600: return B9600;
+		case  19200: return B19200;
+		case  38400: return B38400;
+		case  57600: return B57600;
+		case 115200: return B115200;
+		case 230400: return B230400;
+		default:     return B0;
+	}
+}
+
+
+bool SerialPort::exists() const
+{
+	return (::access(m_strFileName.c_str(), F_OK) == 0);
+}
+
+
+bool SerialPort::open()
+{
+	if (!isOpen())
+	{
+		m_fdPort = ::open(m_strFileName.c_str(), O_RDWR | O_NOCTTY | O_NONBLOCK);
+		if (m_fdPort < 0)
+		{
+			handleError("opening serial port");
+			m_fdPort = -1;
+		}
+		else
+		{
+			// don't share port
+			::ioctl(m_fdPort, TIOCEXCL);
+
+			// raw 8N1 data without any character translation, echo, or flow control
+			struct termios tio;
+			if (::tcgetattr(m_fdPort, &tio) == 0)
+			{
+				::cfmakeraw(&tio);
+				tio.c_cflag |=  (CLOCAL | CREAD);
+				tio.c_cflag &= ~(CSTOPB | CRTSCTS);
+				tio.c_cc[VMIN]  = 0;
+				tio.c_cc[VTIME] = 0;
+				if (::tcsetattr(m_fdPort, TCSANOW, &tio) != 0)
+				{
+					handleError("setting serial port state");
+				}
+			}
+			else
+			{
+				handleError("getting serial port state");
+			}
+			// LOG_INFO("Opened serial port " << m_strPortName);
+		}
+	}
+
+	return isOpen();
+}
+
+
+bool SerialPort::isOpen() const
+{
+	return (m_fdPort >= 0);
+}
+
+
+bool SerialPort::close()
+{
+	if (isOpen())
+	{
+		if (::close(m_fdPort) == 0)
+		{
+			// LOG_INFO("Closed serial port " << m_strPortName);
+			m_fdPort = -1;
+		}
+		else
+		{
+			handleError("closing serial port");
+		}
+	}
+	return !isOpen();
+}
+
+
+bool SerialPort::setBaudrate(DWORD baudRate)
+{
+	bool success = false;
+
+	if (isOpen())
+	{
+		speed_t        speed = getSpeedConstant(baudRate);
+		struct termios tio;
+		if (speed == B0)
+		{
+			LOG_ERROR("Unsupported baudrate " << baudRate << " for serial port " << m_strPortName);
+		}
+		else if (::tcgetattr(m_fdPort, &tio) != 0)
+		{
+			handleError("getting serial port state");
+		}
+		else
+		{
+			::cfsetispeed(&tio, speed);
+			::cfsetospeed(&tio, speed);
+			if (::tcsetattr(m_fdPort, TCSANOW, &tio) == 0)
+			{
+				// LOG_INFO("Set baudrate of serial port " << m_strPortName << " to " << baudRate);
+				success = true;
+			}
+			else
+			{
+				handleError("setting serial port state");
+			}
+		}
+	}
+
+	return success;
+}
+
+
+DWORD SerialPort::getTimeout() const
+{
+	return isOpen() ? m_timeout : 0;
+}
+
+
+bool SerialPort::setTimeout(DWORD timeout)
+{
+	// the timeout is applied when waiting for data in receive()
+	m_timeout = timeout;
+	return isOpen();
+}
+
+
+DWORD SerialPort::send(const void* pBuffer, DWORD nBytesToSend) const
+{
+	const uint8_t* pData      = (const uint8_t*) pBuffer;
+	DWORD          nBytesSent = 0;
+
+	while (isOpen() && (nBytesSent < nBytesToSend))
+	{
+		ssize_t nBytes = ::write(m_fdPort, pData + nBytesSent, nBytesToSend - nBytesSent);
+		if (nBytes > 0)
+		{
+			nBytesSent += (DWORD) nBytes;
+		}
+		else if ((nBytes < 0) && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+		{
+			// output buffer is full > wait until the device accepts more data
+			struct pollfd pfd = { m_fdPort, POLLOUT, 0 };
+			if (::poll(&pfd, 1, SEND_TIMEOUT) == 0)
+			{
+				LOG_ERROR("Timeout while sending data to serial port " << m_strPortName);
+				break;
+			}
+		}
+		else
+		{
+			handleError("sending data");
+			break;
+		}
+	}
+
+	return nBytesSent;
+}
+
+
+DWORD SerialPort::receive(void* pBuffer, DWORD nBytesToReceive) const
+{
+	DWORD nBytesReceived = 0;
+
+	if (isOpen())
+	{
+		// wait up to the timeout for the first byte, then return with whatever is available
+		struct pollfd pfd = { m_fdPort, POLLIN, 0 };
+		int ready = ::poll(&pfd, 1, (int) m_timeout);
+		if ((ready > 0) && (pfd.revents & POLLIN))
+		{
+			ssize_t nBytes = ::read(m_fdPort, pBuffer, nBytesToReceive);
+			if (nBytes > 0)
+			{
+				nBytesReceived = (DWORD) nBytes;
+			}
+			else if ((nBytes < 0) && (errno != EAGAIN) && (errno != EINTR))
+			{
+				handleError("receiving data");
+			}
+		}
+		else if (ready > 0)
+		{
+			// device hung up (e.g., unplugged) > behave like a timeout instead of returning immediately
+			::poll(NULL, 0, (int) m_timeout);
+		}
+		else if ((ready < 0) && (errno != EINTR))
+		{
+			handleError("waiting for data");
+		}
+	}
+
+	return nBytesReceived;
+}
+
+
+void SerialPort::handleError(const char* strFunction) const
+{
+	LOG_ERROR("Error while " << strFunction << ": " << strerror(errno));
+}
+
+#endif // #ifdef _WIN32
@@ -1,9 +1,17 @@
 /**
  * Class for managing serial port connections and packet based communication.
+ * On Windows, the port uses the Win32 communication API,
+ * on other systems a termios terminal device with non-blocking I/O.
  */
 #pragma once
 
+#ifdef _WIN32
 #include <Windows.h>
+#else
+#include <cstdint>
+typedef uint32_t DWORD; // keep the same API as on Windows
+#endif
+
 #include <string>
 
 
@@ -13,11 +21,27 @@ public:
 
 	/**
 	 * Creates a serial port COMx with the port number x.
+	 * On systems other than Windows, this is the device /dev/ttyUSB(x-1).
 	 *
 	 * @param portNumber  the number of the COM port
 	 */
 	SerialPort(int portNumber);
 
+	/**
+	 * Creates a serial port for a device name, 
+	 * e.g., "COM12" or "/dev/ttyS0", or the pseudo terminal of an emulator.
+	 *
+	 * @param deviceName  the name of the device
+	 */
+	SerialPort(const std::string& deviceName);
+
+	/**
+	 * Gets the name of the serial port.
+	 *
+	 * @return the name of the port, e.g., "COM1" or "/dev/ttyUSB0"
+	 */
+	const std::string& getName() const;
+
 	/**
 	 * Checks if the COM port exists at all.
 	 * Note: This does not automatically mean that it can be opened.
@@ -65,6 +89,8 @@ public:
 
 	/**
 	 * Sets the read timeout of the serial port.
+	 * A read returns as soon as any data is available,
+	 * or after the timeout when no data arrived at all.
 	 *
 	 * @param timeout  the read timeout in milliseconds
 	 *
@@ -89,7 +115,8 @@ public:
 	 * @param nBytesToReceive  the amount of bytes to receive
 	 *
 	 * @return the amount of bytes actually received. 
-	 *         May be less than <code>nBytesToReceive</code> (or even 0) when a timeout happened
+	 *         May be less than <code>nBytesToReceive</code> when less data was available,
+	 *         or 0 when a timeout happened
 	 */
 	DWORD receive(void* pBuffer, DWORD nBytesToReceive) const;
 
@@ -111,10 +138,15 @@ private:
 
 private:
 
-	int          m_iPortNumber;  //< port number from the constructor
-	std::string  m_strPortName;  //< short name, e.g., "COM1"
-	std::string  m_strFileName;  //< Windows filename, e.g., "\\.\COM1"
+	int          m_iPortNumber;  //< port number from the constructor (0 if created by name)
+	std::string  m_strPortName;  //< short name, e.g., "COM1" or "/dev/ttyUSB0"
+	std::string  m_strFileName;  //< filename, e.g., "\\.\COM1" or "/dev/ttyUSB0"
+#ifdef _WIN32
 	HANDLE       m_hPort;        //< Windows file handle to the serial port
+#else
+	int          m_fdPort;       //< file descriptor of the terminal device (-1 if closed)
+	DWORD        m_timeout;      //< read timeout in milliseconds
+#endif
 };
 
 
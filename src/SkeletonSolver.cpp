@@ -0,0 +1,146 @@
+#include "SkeletonSolver.h"
+
+
+/******************************************************************************
+ * SkeletonSolver class
+ */
+
+SkeletonSolver::SkeletonSolver(const sSkeletonBone* _pBones, int _nBones) :
+	pBones(_pBones),
+	nBones(_nBones),
+	jointUp(-1),
+	jointSideStart(-1),
+	jointSideEnd(-1),
+	absoluteRotation(_nBones),
+	rotation(_nBones),
+	offset(_nBones, 0),
+	length(_nBones, 0)
+{
+	// nothing else to do
+}
+
+
+int SkeletonSolver::getBoneCount() const
+{
+	return nBones;
+}
+
+
+const sSkeletonBone& SkeletonSolver::getBone(int boneIdx) const
+{
+	return pBones[boneIdx];
+}
+
+
+void SkeletonSolver::setRootJoints(int _jointUp, int _jointSideStart, int _jointSideEnd)
+{
+	jointUp        = _jointUp;
+	jointSideStart = _jointSideStart;
+	jointSideEnd   = _jointSideEnd;
+}
+
+
+bool SkeletonSolver::calculateRootRotation(const sSkeletonBone& refBone, const Vector3D* pJoints, Quaternion& refRotation) const
+{
+	if ((jointUp < 0) || (jointSideStart < 0) || (jointSideEnd < 0)) return false;
+
+	Vector3D up   = pJoints[jointUp]      - pJoints[refBone.jointPoint];
+	Vector3D side = pJoints[jointSideEnd] - pJoints[jointSideStart];
+	float upLength = up.length();
+	if (upLength <= 0) return false;
+	up.set(up.x / upLength, up.y / upLength, up.z / upLength);
+
+	// side axis perpendicular to the up axis
+	float upSide = side.dot(up);
+	side.set(side.x - upSide * up.x, side.y - upSide * up.y, side.z - upSide * up.z);
+	float sideLength = side.length();
+	if (sideLength < 1e-6f) return false;
+	side.set(side.x / sideLength, side.y / sideLength, side.z / sideLength);
+
+	// tilt the Y axis onto the up axis, then turn the tilted X axis around the up axis onto the side axis
+	// (an angle instead of a shortest arc, because both axes can point in opposite directions)
+	Quaternion tilt = Quaternion::shortestArc(Vector3D(0, 1, 0), up);
+	Vector3D   axisX = tilt.rotate(Vector3D(1, 0, 0));
+	float      angle = atan2f(axisX.cross(side).dot(up), axisX.dot(side));
+	refRotation = Quaternion(up.x, up.y, up.z, angle);
+	refRotation.mult(tilt).normalize();
+	return true;
+}
+
+
+void SkeletonSolver::solve(const Vector3D* pJoints, bool calculateOffsets)
+{
+	const Vector3D axisY(0, 1, 0);
+
+	// the bone table is sorted so that parents are always solved before their children
+	for (int boneIdx = 0; boneIdx < nBones; boneIdx++)
+	{
+		const sSkeletonBone& bone = pBones[boneIdx];
+
+		const Vector3D& jointParent = pJoints[bone.jointParent];
+		const Vector3D& jointPoint  = pJoints[bone.jointPoint];
+		const Vector3D& jointEnd    = pJoints[bone.jointEnd];
+
+		if (calculateOffsets)
+		{
+			offset[boneIdx] = (jointPoint - jointParent).length();
+		}
+		Vector3D direction = jointEnd - jointPoint;
+		length[boneIdx] = direction.length();
+
+		Quaternion parentRotation;
+		if (bone.parentIndex >= 0)
+		{
+			parentRotation = absoluteRotation[bone.parentIndex];
+		}
+
+		Quaternion& absRotation = absoluteRotation[boneIdx];
+		Quaternion& relRotation = rotation[boneIdx];
+		if ((bone.parentIndex < 0) && calculateRootRotation(bone, pJoints, absRotation))
+		{
+			relRotation = absRotation;
+		}
+		else if (length[boneIdx] > 0)
+		{
+			// rotate the Y axis of the parent onto the bone direction
+			float invLength = 1.0f / length[boneIdx];
+			direction.set(direction.x * invLength, direction.y * invLength, direction.z * invLength);
+			absRotation = Quaternion::shortestArc(parentRotation.rotate(axisY), direction);
+			absRotation.mult(parentRotation).normalize();
+
+			// relative rotation = inverse(parent) * absolute
+			relRotation = parentRotation;
+			relRotation.conjugate().mult(absRotation);
+		}
+		else
+		{
+			// no direction > same orientation as the parent
+			absRotation = parentRotation;
+			relRotation = Quaternion();
+		}
+	}
+}
+
+
+const Quaternion& SkeletonSolver::getAbsoluteRotation(int boneIdx) const
+{
+	return absoluteRotation[boneIdx];
+}
+
+
+const Quaternion& SkeletonSolver::getRotation(int boneIdx) const
+{
+	return rotation[boneIdx];
+}
+
+
+float SkeletonSolver::getOffset(int boneIdx) const
+{
+	return offset[boneIdx];
+}
+
+
+float SkeletonSolver::getLength(int boneIdx) const
+{
+	return length[boneIdx];
+}
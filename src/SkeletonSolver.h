@@ -0,0 +1,132 @@
+/**
+ * Class for calculating bone orientations, offsets, and lengths of a skeleton from joint positions.
+ */
+
+#pragma once
+
+#include "VectorMath.h"
+
+#include <vector>
+
+
+/**
+ * Structure for describing a bone by its parent bone and the joints it is attached to.
+ * The bone starts at the joint jointPoint and points towards the joint jointEnd.
+ * jointParent is the start joint of the parent bone.
+ */
+struct sSkeletonBone
+{
+	const char* czBoneName;
+	int         parentIndex;   // index of the parent bone (-1: root), must be smaller than the bone index
+	int         jointParent;
+	int         jointPoint;
+	int         jointEnd;
+};
+
+
+class SkeletonSolver
+{
+public:
+
+	/**
+	 * Creates a skeleton solver.
+	 *
+	 * @param pBones  the bone table (must stay valid while the solver is used)
+	 * @param nBones  the amount of bones in the table
+	 */
+	SkeletonSolver(const sSkeletonBone* pBones, int nBones);
+
+	/**
+	 * Gets the amount of bones.
+	 *
+	 * @return the amount of bones
+	 */
+	int getBoneCount() const;
+
+	/**
+	 * Gets the description of a bone.
+	 *
+	 * @param boneIdx  the index of the bone
+	 *
+	 * @return the bone description
+	 */
+	const sSkeletonBone& getBone(int boneIdx) const;
+
+	/**
+	 * Defines the joints that determine the orientation of the root bones.
+	 * The Y axis of a root bone points from its start joint towards the up joint,
+	 * and its X axis points from the first side joint towards the second side joint
+	 * (projected onto the plane perpendicular to the Y axis).
+	 * Without these joints, root bones only rotate their Y axis onto the bone direction
+	 * and lose the rotation around it.
+	 *
+	 * @param jointUp         the joint above the start joint of the root bones (-1: none)
+	 * @param jointSideStart  the joint the X axis points away from, e.g., the left hip
+	 * @param jointSideEnd    the joint the X axis points towards, e.g., the right hip
+	 */
+	void setRootJoints(int jointUp, int jointSideStart, int jointSideEnd);
+
+	/**
+	 * Calculates the orientations, offsets, and lengths of all bones.
+	 * The Y axis of each bone points along the bone.
+	 * Each bone orientation is the shortest rotation from the Y axis of its parent bone,
+	 * so there is no twist around the bone axis relative to the parent.
+	 * Root bones are oriented by the joints defined with setRootJoints(...).
+	 *
+	 * @param pJoints           array of joint positions, indexed by the joint indices of the bone table
+	 * @param calculateOffsets  <code>false</code> to skip the offsets, e.g., when they are known already
+	 */
+	void solve(const Vector3D* pJoints, bool calculateOffsets = true);
+
+	/**
+	 * Gets the orientation of a bone in world coordinates.
+	 *
+	 * @param boneIdx  the index of the bone
+	 *
+	 * @return the absolute orientation of the bone
+	 */
+	const Quaternion& getAbsoluteRotation(int boneIdx) const;
+
+	/**
+	 * Gets the orientation of a bone relative to its parent bone.
+	 *
+	 * @param boneIdx  the index of the bone
+	 *
+	 * @return the hierarchical orientation of the bone
+	 */
+	const Quaternion& getRotation(int boneIdx) const;
+
+	/**
+	 * Gets the distance between the start of the parent bone and the start of a bone.
+	 *
+	 * @param boneIdx  the index of the bone
+	 *
+	 * @return the offset of the bone
+	 */
+	float getOffset(int boneIdx) const;
+
+	/**
+	 * Gets the length of a bone.
+	 *
+	 * @param boneIdx  the index of the bone
+	 *
+	 * @return the length of the bone
+	 */
+	float getLength(int boneIdx) const;
+
+private:
+
+	// calculates the orientation of a root bone from the root joints (returns false if they are degenerate)
+	bool calculateRootRotation(const sSkeletonBone& refBone, const Vector3D* pJoints, Quaternion& refRotation) const;
+
+private:
+
+	const sSkeletonBone*    pBones;
+	int                     nBones;
+	int                     jointUp, jointSideStart, jointSideEnd;
+
+	std::vector<Quaternion> absoluteRotation;
+	std::vector<Quaternion> rotation;
+	std::vector<float>      offset;
+	std::vector<float>      length;
+};
@@ -1,5 +1,5 @@
 /**
- * Simple Quaternion class to convert euler angles from Cortex to quaternions.
+ * Simple vector and quaternion classes for converting and solving rotations.
  */
 
 #pragma once
@@ -22,11 +22,46 @@ public:
 		x = y = z = 0;
 	}
 
+	Vector3D(float x, float y, float z)
+	{
+		this->x = x; this->y = y; this->z = z;
+	}
+
 	void set(float x, float y, float z)
 	{
 		this->x = x; this->y = y; this->z = z;
 	}
 
+	float length() const
+	{
+		return sqrtf(x*x + y*y + z*z);
+	}
+
+	Vector3D& normalize()
+	{
+		float len = length();
+		if (len > 0)
+		{
+			x /= len; y /= len; z /= len;
+		}
+		return *this;
+	}
+
+	float dot(const Vector3D& v) const
+	{
+		return x*v.x + y*v.y + z*v.z;
+	}
+
+	Vector3D cross(const Vector3D& v) const
+	{
+		return Vector3D(y*v.z - z*v.y, z*v.x - x*v.z, x*v.y - y*v.x);
+	}
+
+	Vector3D operator-(const Vector3D& v) const
+	{
+		return Vector3D(x - v.x, y - v.y, z - v.z);
+	}
+
 };
 
 
@@ -69,4 +104,54 @@ public:
 		w = _w; x = _x; y = _y; z = _z;
 		return *this;
 	}
+
+	Quaternion& conjugate()
+	{
+		x = -x; y = -y; z = -z;
+		return *this;
+	}
+
+	Quaternion& normalize()
+	{
+		float len = sqrtf(x*x + y*y + z*z + w*w);
+		if (len > 0)
+		{
+			x /= len; y /= len; z /= len; w /= len;
+		}
+		return *this;
+	}
+
+	Vector3D rotate(const Vector3D& v) const
+	{
+		// v' = v + 2w (q x v) + 2 q x (q x v) with q = (x, y, z)
+		Vector3D q(x, y, z);
+		Vector3D t = q.cross(v);
+		t.set(2*t.x, 2*t.y, 2*t.z);
+		Vector3D u = q.cross(t);
+		return Vector3D(v.x + w*t.x + u.x, v.y + w*t.y + u.y, v.z + w*t.z + u.z);
+	}
+
+	/**
+	 * Creates the shortest rotation from one unit vector to another.
+	 */
+	static Quaternion shortestArc(const Vector3D& from, const Vector3D& to)
+	{
+		Quaternion q;
+		float d = from.dot(to);
+		if (d < -0.999999f)
+		{
+			// opposite vectors > rotate by 180 degrees around any perpendicular axis
+			Vector3D axis = Vector3D(1, 0, 0).cross(from);
+			if (axis.length() < 1e-6f) axis = Vector3D(0, 1, 0).cross(from);
+			axis.normalize();
+			q.x = axis.x; q.y = axis.y; q.z = axis.z; q.w = 0;
+		}
+		else
+		{
+			Vector3D c = from.cross(to);
+			q.x = c.x; q.y = c.y; q.z = c.z; q.w = 1 + d;
+			q.normalize();
+		}
+		return q;
+	}
 };
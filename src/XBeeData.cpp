@@ -1,166 +1,248 @@
 #include "XBeeData.h"
 #include "XBeePacket.h"
 
+#include <cstdlib> // _byteswap_... on Windows
+#include <cstring>
+
+
+// XBee data is Big Endian, so numbers are loaded in one piece and byte-swapped on Little Endian hosts
+#if defined(_MSC_VER)
+	#define BYTESWAP_16(x) _byteswap_ushort(x)
+	#define BYTESWAP_32(x) _byteswap_ulong(x)
+	#define BYTESWAP_64(x) _byteswap_uint64(x)
+	#define HOST_IS_LITTLE_ENDIAN true
+#else
+	#define BYTESWAP_16(x) __builtin_bswap16(x)
+	#define BYTESWAP_32(x) __builtin_bswap32(x)
+	#define BYTESWAP_64(x) __builtin_bswap64(x)
+	#define HOST_IS_LITTLE_ENDIAN (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+#endif
+
+
+static inline uint16_t loadBigEndian16(const uint8_t* pData)
+{
+	uint16_t value;
+	memcpy(&value, pData, sizeof(value));
+	return HOST_IS_LITTLE_ENDIAN ? BYTESWAP_16(value) : value;
+}
+
+
+static inline uint32_t loadBigEndian32(const uint8_t* pData)
+{
+	uint32_t value;
+	memcpy(&value, pData, sizeof(value));
+	return HOST_IS_LITTLE_ENDIAN ? BYTESWAP_32(value) : value;
+}
+
+
+static inline uint64_t loadBigEndian64(const uint8_t* pData)
+{
+	uint64_t value;
+	memcpy(&value, pData, sizeof(value));
+	return HOST_IS_LITTLE_ENDIAN ? BYTESWAP_64(value) : value;
+}
+
+
 
 /******************************************************************************
- * XBeeReadBuffer class
+ * XBeeReadView class
  */
 
-uint8_t* XBeeReadBuffer::prepareBuffer(uint16_t length)
+XBeeReadView::XBeeReadView() :
+	m_pData(nullptr),
+	m_size(0),
+	m_read(0)
 {
-	// prepare receive buffer: data length +4: +1x delimiter, +2x length bytes, +1 checksum
-	m_buffer.reserve(length + 4);
-	m_buffer.clear();
-	m_read = m_buffer.cbegin();
+	// nothing else to do
+}
 
-	// reconstruct the header
-	m_buffer.push_back(XBeePacket::START_DELIMITER);
-	m_buffer.push_back((uint8_t) ((length >> 8) & 0xFF));
-	m_buffer.push_back((uint8_t) ((length     ) & 0xFF));
 
-	// fill up with 0 to create buffer space
-	m_buffer.insert(m_buffer.end(), length + 1, 0);
-	
-	// return buffer position
-	return m_buffer.data();
+XBeeReadView::XBeeReadView(const uint8_t* pData, size_t size) :
+	m_pData(pData),
+	m_size(size),
+	m_read(0)
+{
+	// nothing else to do
 }
 
 
-void XBeeReadBuffer::copy(const XBeeReadBuffer& refBuffer, size_t startPos, size_t endPos)
+XBeeReadView XBeeReadView::getViewAt(size_t startPos, size_t endPos) const
 {
-	m_buffer.clear();
-	m_buffer.assign(
-		refBuffer.m_buffer.cbegin() + startPos,
-		refBuffer.m_buffer.cbegin() + endPos);
-	m_read = m_buffer.cbegin();
+	// limit the part to this view
+	endPos   = (endPos   < m_size) ? endPos   : m_size;
+	startPos = (startPos < endPos)  ? startPos : endPos;
+	return XBeeReadView(m_pData + startPos, endPos - startPos);
 }
 
 
-uint8_t XBeeReadBuffer::getByteAt(size_t pos) const
+uint8_t XBeeReadView::getByteAt(size_t pos) const
 {
-	m_read = m_buffer.cbegin() + pos;
+	m_read = pos;
 	return getNextByte();
 }
 
 
-uint8_t XBeeReadBuffer::getNextByte() const
+uint8_t XBeeReadView::getNextByte() const
 {
-	uint8_t result = *m_read; m_read++;
-	return result;
+	const uint8_t* pValue = advance(sizeof(uint8_t));
+	return (pValue != nullptr) ? *pValue : 0;
 }
 
 
-uint16_t XBeeReadBuffer::getUInt16At(size_t pos) const
+uint16_t XBeeReadView::getUInt16At(size_t pos) const
 {
-	// interpret the buffer as a 16 bit int (big endian)
-	m_read = m_buffer.cbegin() + pos;
+	m_read = pos;
 	return getNextUInt16();
 }
 
 
-uint16_t XBeeReadBuffer::getNextUInt16() const
+uint16_t XBeeReadView::getNextUInt16() const
 {
-	// interpret the buffer as a 16 bit int (big endian)
-	uint16_t      result  = *m_read; m_read++;
-	result <<= 8; result |= *m_read; m_read++;
-	return result;
+	const uint8_t* pValue = advance(sizeof(uint16_t));
+	return (pValue != nullptr) ? loadBigEndian16(pValue) : 0;
 }
 
 
-uint32_t XBeeReadBuffer::getUInt32At(size_t pos) const
+uint32_t XBeeReadView::getUInt32At(size_t pos) const
 {
-	// interpret the buffer as a 32 bit int (big endian)
-	m_read = m_buffer.cbegin() + pos;
+	m_read = pos;
 	return getNextUInt32();
 }
 
 
-uint32_t XBeeReadBuffer::getNextUInt32() const
+uint32_t XBeeReadView::getNextUInt32() const
 {
-	// interpret the buffer as a 32 bit int (big endian)
-	uint32_t      result  = *m_read; m_read++;
-	result <<= 8; result |= *m_read; m_read++;
-	result <<= 8; result |= *m_read; m_read++;
-	result <<= 8; result |= *m_read; m_read++;
-	return result;
+	const uint8_t* pValue = advance(sizeof(uint32_t));
+	return (pValue != nullptr) ? loadBigEndian32(pValue) : 0;
 }
 
 
-uint64_t XBeeReadBuffer::getUInt64At(size_t pos) const
+uint64_t XBeeReadView::getUInt64At(size_t pos) const
 {
-	// interpret the buffer as a 64 bit int (big endian)
-	m_read = m_buffer.cbegin() + pos;
+	m_read = pos;
 	return getNextUInt64();
 }
 
 
-uint64_t XBeeReadBuffer::getNextUInt64() const
+uint64_t XBeeReadView::getNextUInt64() const
 {
-	// interpret the buffer as a 64 bit int (big endian)
-	uint64_t      result  = *m_read; m_read++;
-	result <<= 8; result |= *m_read; m_read++;
-	result <<= 8; result |= *m_read; m_read++;
-	result <<= 8; result |= *m_read; m_read++;
-	result <<= 8; result |= *m_read; m_read++;
-	result <<= 8; result |= *m_read; m_read++;
-	result <<= 8; result |= *m_read; m_read++;
-	result <<= 8; result |= *m_read; m_read++;
-	return result;
+	const uint8_t* pValue = advance(sizeof(uint64_t));
+	return (pValue != nullptr) ? loadBigEndian64(pValue) : 0;
 }
 
 
-std::string XBeeReadBuffer::getStringAt(size_t pos, size_t len) const
+std::string_view XBeeReadView::getStringViewAt(size_t pos, size_t len) const
 {
-	m_read = m_buffer.cbegin() + pos;
-	return getNextString(len);
+	m_read = pos;
+	return getNextStringView(len);
 }
 
 
-std::string XBeeReadBuffer::getNextString(size_t len) const
+std::string_view XBeeReadView::getNextStringView(size_t len) const
 {
+	// maximum length: remainder of buffer
+	if (m_read > m_size) m_read = m_size;
+	size_t remaining = m_size - m_read;
+	if ((len == 0) || (len > remaining))
+	{
+		len = remaining;
+	}
 	if (len == 0)
 	{
-		// maximum length: remainder of buffer
-		len = m_buffer.cend() - m_read;
+		return std::string_view();
 	}
-	std::string str;
-	while (len > 0)
+
+	const char* pStart = (const char*) (m_pData + m_read);
+	const char* pEnd   = (const char*) memchr(pStart, '\0', len);
+	if (pEnd != nullptr)
 	{
-		if (*m_read != '\0')
-		{
-			str.append(1, *m_read);
-			len--;
-		}
-		else
-		{
-			// found terminating '\0' > stop here
-			len = 0;
-		}
+		// found terminating '\0' > stop here and skip it
+		len = pEnd - pStart;
 		m_read++;
 	}
-	return str;
+	m_read += len;
+	return std::string_view(pStart, len);
 }
 
 
-size_t XBeeReadBuffer::size() const
+std::string XBeeReadView::getStringAt(size_t pos, size_t len) const
 {
-	return m_buffer.size();
+	return std::string(getStringViewAt(pos, len));
+}
+
+
+std::string XBeeReadView::getNextString(size_t len) const
+{
+	return std::string(getNextStringView(len));
+}
+
+
+size_t XBeeReadView::size() const
+{
+	return m_size;
 }
 
 
-uint8_t XBeeReadBuffer::calculateChecksum() const
+uint8_t XBeeReadView::calculateChecksum() const
 {
 	uint8_t checksum = 0;
-	for (size_t i = 3; i < m_buffer.size(); i++)
+	for (size_t i = 3; i < m_size; i++)
 	{
-		checksum += m_buffer[i];
+		checksum += m_pData[i];
 	}
 	return checksum;
 }
 
 
-const void* XBeeReadBuffer::data() const
+const void* XBeeReadView::data() const
+{
+	return m_pData;
+}
+
+
+const uint8_t* XBeeReadView::advance(size_t length) const
 {
+	if ((m_read > m_size) || (length > m_size - m_read))
+	{
+		// not enough data left > the view counts as completely read
+		m_read = m_size;
+		return nullptr;
+	}
+	const uint8_t* pValue = m_pData + m_read;
+	m_read += length;
+	return pValue;
+}
+
+
+
+
+/******************************************************************************
+ * XBeeReadBuffer class
+ */
+
+XBeeReadBuffer::XBeeReadBuffer() :
+	XBeeReadView()
+{
+	// nothing else to do
+}
+
+
+uint8_t* XBeeReadBuffer::prepareBuffer(uint16_t length)
+{
+	// prepare receive buffer: data length +4: +1x delimiter, +2x length bytes, +1 checksum
+	// (the memory is only reallocated when a frame is larger than any before)
+	m_buffer.resize(length + 4);
+
+	// reconstruct the header
+	m_buffer[0] = XBeePacket::START_DELIMITER;
+	m_buffer[1] = (uint8_t) ((length >> 8) & 0xFF);
+	m_buffer[2] = (uint8_t) ((length     ) & 0xFF);
+
+	m_pData = m_buffer.data();
+	m_size  = m_buffer.size();
+	m_read  = 0;
+
+	// return buffer position
 	return m_buffer.data();
 }
 
@@ -183,6 +265,12 @@ void XBeeWriteBuffer::addByte(uint8_t value)
 }
 
 
+void XBeeWriteBuffer::setByteAt(size_t pos, uint8_t value)
+{
+	m_buffer[pos] = value;
+}
+
+
 void XBeeWriteBuffer::setUInt16At(size_t pos, uint16_t value)
 {
 	m_buffer[pos] = (uint8_t)((value >> 8) & 0xFF); pos++;
@@ -250,3 +338,105 @@ const void* XBeeWriteBuffer::data() const
 
 
 
+/******************************************************************************
+ * XBeeFrameReader class
+ */
+
+XBeeFrameReader::XBeeFrameReader() :
+	m_readPos(0),
+	m_writePos(0),
+	m_skippedBytes(0)
+{
+	// nothing else to do
+}
+
+
+void XBeeFrameReader::clear()
+{
+	m_readPos = m_writePos;
+}
+
+
+uint8_t* XBeeFrameReader::getWritePointer(size_t& refMaxBytes)
+{
+	size_t writeIdx  = m_writePos & (BUFFER_SIZE - 1);
+	size_t freeBytes = BUFFER_SIZE - (m_writePos - m_readPos);
+	// only up to the end of the buffer, the rest can be received next time
+	refMaxBytes = (freeBytes < BUFFER_SIZE - writeIdx) ? freeBytes : BUFFER_SIZE - writeIdx;
+	return m_buffer + writeIdx;
+}
+
+
+void XBeeFrameReader::commitWrite(size_t nBytes)
+{
+	m_writePos += nBytes;
+}
+
+
+bool XBeeFrameReader::extractFrame(XBeeReadBuffer& refFrame)
+{
+	while (true)
+	{
+		// search for start delimiter
+		while ((m_writePos > m_readPos) && (peek(0) != XBeePacket::START_DELIMITER))
+		{
+			skip(1);
+			m_skippedBytes++;
+		}
+
+		size_t available = m_writePos - m_readPos;
+		if (available < 3) return false; // length not there yet
+
+		// frames that are empty or too large for the buffer can only be corrupted data
+		uint16_t dataLen = (((uint16_t) peek(1)) << 8) | ((uint16_t) peek(2));
+		if ((dataLen == 0) || (dataLen + 4u > BUFFER_SIZE))
+		{
+			skip(1);
+			m_skippedBytes++;
+			continue;
+		}
+
+		// +4: delimiter, 2x length, checksum
+		if (available < dataLen + 4u) return false; // frame not complete yet
+
+		uint8_t checksum = 0;
+		for (size_t i = 3; i < dataLen + 4u; i++)
+		{
+			checksum += peek(i);
+		}
+		if (checksum != 255)
+		{
+			// false start delimiter or corrupted frame > search from the next byte
+			skip(1);
+			m_skippedBytes++;
+			continue;
+		}
+
+		// valid frame > copy payload and checksum
+		uint8_t* pFrame = refFrame.prepareBuffer(dataLen);
+		for (size_t i = 3; i < dataLen + 4u; i++)
+		{
+			pFrame[i] = peek(i);
+		}
+		skip(dataLen + 4);
+		return true;
+	}
+}
+
+
+size_t XBeeFrameReader::getSkippedBytes() const
+{
+	return m_skippedBytes;
+}
+
+
+uint8_t XBeeFrameReader::peek(size_t offset) const
+{
+	return m_buffer[(m_readPos + offset) & (BUFFER_SIZE - 1)];
+}
+
+
+void XBeeFrameReader::skip(size_t nBytes)
+{
+	m_readPos += nBytes;
+}
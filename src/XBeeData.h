@@ -7,34 +7,44 @@
 
 #pragma once
 
+#include <cstdint>
 #include <memory>
 #include <vector>
 #include <string>
+#include <string_view>
 
 /******************************************************************************
  * Class for extracting numbers and strings from a byte buffer in Big Endian order.
+ * The view does not own or copy the bytes, so it is only valid as long as the underlying buffer.
+ * Numbers that would extend past the end of the view are read as 0.
  */
-class XBeeReadBuffer
+class XBeeReadView
 {
 public:
 
 	/**
-	 * Prepares the buffer for receiving into.
-	 *
-	 * @param length the length of the pure data bytes to receive
+	 * Creates an empty view.
+	 */
+	XBeeReadView();
+
+	/**
+	 * Creates a view of a range of bytes.
 	 *
-	 * @return pointer to the beginning of the buffer
+	 * @param pData  pointer to the first byte
+	 * @param size   the amount of bytes
 	 */
-	uint8_t* prepareBuffer(uint16_t length);
+	XBeeReadView(const uint8_t* pData, size_t size);
 
 	/**
-	 * Copies data from another buffer.
+	 * Gets a view of a part of the buffer without copying the data.
+	 * The part is limited to the end of this view.
+	 *
+	 * @param startPos  the position of the first byte of the part
+	 * @param endPos    the position after the last byte of the part
 	 *
-	 * @param refBuffer  the buffer to copy from
-	 * @param startPos   the position to start copying from
-	 * @param endPos     the position to end copying
+	 * @return the view of the part
 	 */
-	void copy(const XBeeReadBuffer& refBuffer, size_t startPos, size_t endPos);
+	XBeeReadView getViewAt(size_t startPos, size_t endPos) const;
 
 	/**
 	 * Function for extracting a byte from the buffer.
@@ -100,6 +110,27 @@ public:
 	 */
 	uint64_t getNextUInt64() const;
 
+	/**
+	 * Function for extracting a string from a specific position in the buffer without copying it.
+	 *
+	 * @param pos  the position from where to extract
+	 * @param len  the maximum number of characters to extract
+	 *             (0: extract until the end of the buffer or encountering a '\0')
+	 *
+	 * @return the view of the string (only valid as long as the buffer)
+	 */
+	std::string_view getStringViewAt(size_t pos, size_t len = 0) const;
+
+	/**
+	 * Function for extracting the next string from the buffer without copying it.
+	 *
+	 * @param len  the maximum number of characters to extract
+	 *             (0: extract until the end of the buffer or encountering a '\0')
+	 *
+	 * @return the view of the string (only valid as long as the buffer)
+	 */
+	std::string_view getNextStringView(size_t len = 0) const;
+
 	/**
 	 * Function for extracting a string from a specific position in the buffer.
 	 *
@@ -144,8 +175,53 @@ public:
 
 protected:
 
-	        std::vector<uint8_t>                 m_buffer;
-	mutable std::vector<uint8_t>::const_iterator m_read;
+	/**
+	 * Moves the read position over the next value.
+	 *
+	 * @param length  the amount of bytes of the value
+	 *
+	 * @return the pointer to the value or
+	 *         <code>nullptr</code> if the value exceeds the view
+	 */
+	const uint8_t* advance(size_t length) const;
+
+protected:
+
+	        const uint8_t* m_pData;
+	        size_t         m_size;
+	mutable size_t         m_read; // position of the next byte to extract
+
+};
+
+
+
+/******************************************************************************
+ * Class for receiving into a byte buffer and extracting numbers and strings in Big Endian order.
+ * The buffer memory is reused for every received frame.
+ */
+class XBeeReadBuffer : public XBeeReadView
+{
+public:
+
+	XBeeReadBuffer();
+
+	// views of the buffer would point into the wrong memory after copying
+	XBeeReadBuffer(const XBeeReadBuffer&) = delete;
+	XBeeReadBuffer& operator=(const XBeeReadBuffer&) = delete;
+
+	/**
+	 * Prepares the buffer for receiving into.
+	 * Views of the previous content become invalid.
+	 *
+	 * @param length the length of the pure data bytes to receive
+	 *
+	 * @return pointer to the beginning of the buffer
+	 */
+	uint8_t* prepareBuffer(uint16_t length);
+
+protected:
+
+	std::vector<uint8_t> m_buffer;
 
 };
 
@@ -170,6 +246,14 @@ public:
 	 */
 	void addByte(uint8_t value);
 
+	/**
+	 * Sets a byte in the buffer.
+	 *
+	 * @param pos    the position where to change the byte
+	 * @param value  the value to change
+	 */
+	void setByteAt(size_t pos, uint8_t value);
+
 	/**
 	 * Sets a 16 bit integer number in the buffer.
 	 *
@@ -228,3 +312,70 @@ protected:
 };
 
 
+
+/******************************************************************************
+ * Ring buffer for raw received data that extracts complete XBee API frames.
+ * Data is received in large chunks and parsed incrementally.
+ * Corrupted data is skipped by searching for the next start delimiter.
+ */
+class XBeeFrameReader
+{
+public:
+
+	static const size_t BUFFER_SIZE = 4096; // needs to be a power of 2
+
+public:
+
+	XBeeFrameReader();
+
+	/**
+	 * Discards all data in the buffer.
+	 */
+	void clear();
+
+	/**
+	 * Gets the free space in the buffer that can be received into in one piece.
+	 *
+	 * @param refMaxBytes  returns the amount of bytes that can be received
+	 *
+	 * @return pointer to the free space
+	 */
+	uint8_t* getWritePointer(size_t& refMaxBytes);
+
+	/**
+	 * Adds received data to the buffer.
+	 *
+	 * @param nBytes  the amount of bytes that was received into the space from <code>getWritePointer</code>
+	 */
+	void commitWrite(size_t nBytes);
+
+	/**
+	 * Extracts the next complete frame with a valid checksum from the buffer.
+	 *
+	 * @param refFrame  the buffer to copy the frame into (including start delimiter, length, and checksum)
+	 *
+	 * @return <code>true</code> if a frame was extracted,
+	 *         <code>false</code> if more data is needed
+	 */
+	bool extractFrame(XBeeReadBuffer& refFrame);
+
+	/**
+	 * Gets the amount of bytes that were skipped because they did not form a valid frame.
+	 *
+	 * @return  the total amount of skipped bytes
+	 */
+	size_t getSkippedBytes() const;
+
+private:
+
+	uint8_t peek(size_t offset) const;
+	void    skip(size_t nBytes);
+
+private:
+
+	uint8_t  m_buffer[BUFFER_SIZE];
+	size_t   m_readPos;      // total amount of bytes read from the buffer
+	size_t   m_writePos;     // total amount of bytes written to the buffer
+	size_t   m_skippedBytes; // total amount of bytes skipped during resynchronisation
+
+};
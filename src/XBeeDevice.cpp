@@ -1,6 +1,7 @@
 #include "XBeeDevice.h"
 #include "XBeePacket.h"
 
+#include <cmath>
 #include <iostream>
 #include <vector>
 
@@ -11,6 +12,10 @@
 #undef  LOG_DATA // define to get memory dumps of the received packets
 
 
+static const int DEFAULT_DISCOVERY_TIMEOUT = 6000; // in ms, used when NT cannot be read (XBee default)
+static const int DISCOVERY_MARGIN          = 500;  // in ms, additional time for the last responses to arrive
+
+
 /******************************************************************************
  * XBeeDevice class
  */
@@ -71,8 +76,16 @@ XBeeCoordinator::XBeeCoordinator(SerialPort& refPort) :
 	XBeeDevice(),
 	m_serialPort(refPort),
 	m_frameCounter(1),
-	m_numOfRetries(3)
+	m_numOfRetries(3),
+	m_discovering(false),
+	m_discoveryFrameID(0),
+	m_pendingCount(0)
 {
+	for (auto& refCommand : m_arrPendingCommands)
+	{
+		refCommand.active = false;
+	}
+
 	// prepare serial port
 	if (!m_serialPort.isOpen())
 	{
@@ -129,7 +142,8 @@ XBeeCoordinator::XBeeCoordinator(SerialPort& refPort) :
 
 XBeeCoordinator::~XBeeCoordinator()
 {
-	// clean up the list of nodes
+	// clean up the list of nodes (after the commands that might refer to them)
+	cancelCommands();
 	m_arrNodes.clear();
 
 	// no need to hug the serial port any longer
@@ -140,10 +154,17 @@ XBeeCoordinator::~XBeeCoordinator()
 bool XBeeCoordinator::send(XBeePacket_Send& refPacket)
 {
 	// set FrameID
-	refPacket.setFrameID(m_frameCounter);
+	{
+		std::lock_guard<std::mutex> lock(m_mtxCommands);
+		refPacket.setFrameID(allocateFrameID());
+	}
+	return sendPacket(refPacket);
+}
 
-	// advance frame ID counter for next package (never let it be 0)
-	m_frameCounter = 1 + (m_frameCounter % 255);
+
+bool XBeeCoordinator::sendPacket(XBeePacket_Send& refPacket)
+{
+	std::lock_guard<std::mutex> lock(m_mtxSend);
 
 	// create data buffer
 	m_bufOut.clear();
@@ -181,38 +202,59 @@ bool XBeeCoordinator::send(XBeePacket_Send& refPacket)
 }
 
 
-std::unique_ptr<XBeePacket_Receive> XBeeCoordinator::receive()
+const XBeePacket_Receive* XBeeCoordinator::receive()
 {
-	// create corresponding packet class instance
-	std::unique_ptr<XBeePacket_Receive> pPacket = NULL;
+	XBeePacket_Receive* pPacket = NULL;
 
 	if (receivePacket())
 	{
-		// create specific packet subclass
+		// select the packet instance for the frame type
 		auto frameTypeID = m_bufIn.getByteAt(3);
 		switch (frameTypeID)
 		{
 		case XBeePacket_AT_CommandResponse::FRAME_TYPE_ID:
-			pPacket = std::make_unique<XBeePacket_AT_CommandResponse>();
-			pPacket->unmarshal(m_bufIn);
+			pPacket = &m_rcvCommandResponse;
 			break;
 
 		case XBeePacket_RemoteAT_CommandResponse::FRAME_TYPE_ID:
-			pPacket = std::make_unique<XBeePacket_RemoteAT_CommandResponse>();
-			pPacket->unmarshal(m_bufIn);
+			pPacket = &m_rcvRemoteCommandResponse;
 			break;
 
 		case XBeePacket_IO_DataSample::FRAME_TYPE_ID:
-			pPacket = std::make_unique<XBeePacket_IO_DataSample>();
-			pPacket->unmarshal(m_bufIn);
+			pPacket = &m_rcvDataSample;
 			break;
 
 		default:
 			LOG_ERROR("Unhandled frame type 0x" << std::hex << (int)frameTypeID);
 			break;
 		}
+
+		if ((pPacket != NULL) && !pPacket->unmarshal(m_bufIn))
+		{
+			// frame too short for its type (e.g., corrupted data that happened to pass the checksum)
+			LOG_WARNING("Invalid frame of type 0x" << std::hex << (int)frameTypeID << " with " << std::dec << m_bufIn.size() << " bytes");
+			pPacket = NULL;
+		}
+
+		if (pPacket == &m_rcvCommandResponse)
+		{
+			handleDiscoveryResponse(m_rcvCommandResponse);
+			handleCommandResponse(m_rcvCommandResponse);
+		}
+		else if (pPacket == &m_rcvRemoteCommandResponse)
+		{
+			handleCommandResponse(m_rcvRemoteCommandResponse);
+		}
+	}
+
+	if (m_discovering && (std::chrono::steady_clock::now() >= m_discoveryEnd))
+	{
+		LOG_INFO("Discovery complete (" << m_arrNodes.size() << " devices found)");
+		m_discovering = false;
 	}
 
+	handleCommandTimeouts();
+
 	return pPacket;
 }
 
@@ -279,36 +321,106 @@ bool XBeeCoordinator::process(XBeePacket_Send& refSend, XBeePacket_Receive& refR
 }
 
 
+bool XBeeCoordinator::sendAsync(XBeePacket_AT_Command& refCommand, ResponseHandler handler, int timeout)
+{
+	bool success = false;
+
+	// register the command before sending, so that a quick response can be matched
+	uint8_t frameID = 0;
+	{
+		std::lock_guard<std::mutex> lock(m_mtxCommands);
+		frameID = allocateFrameID();
+		if (frameID > 0)
+		{
+			sPendingCommand& refPending = m_arrPendingCommands[frameID];
+			refPending.active         = true;
+			refPending.responseTypeID = (refCommand.getFrameTypeID() == XBeePacket_RemoteAT_Command::FRAME_TYPE_ID) ?
+				XBeePacket_RemoteAT_CommandResponse::FRAME_TYPE_ID :
+				XBeePacket_AT_CommandResponse::FRAME_TYPE_ID;
+			refPending.handler        = handler;
+			refPending.deadline       = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout);
+			m_pendingCount++;
+		}
+	}
+
+	if (frameID > 0)
+	{
+		refCommand.setFrameID(frameID);
+		success = sendPacket(refCommand);
+		if (!success)
+		{
+			std::lock_guard<std::mutex> lock(m_mtxCommands);
+			m_arrPendingCommands[frameID].active  = false;
+			m_arrPendingCommands[frameID].handler = nullptr;
+			m_pendingCount--;
+		}
+	}
+	else
+	{
+		LOG_WARNING("Too many pending commands");
+	}
+
+	return success;
+}
+
+
+int XBeeCoordinator::getPendingCommandCount() const
+{
+	std::lock_guard<std::mutex> lock(m_mtxCommands);
+	return m_pendingCount;
+}
+
+
 void XBeeCoordinator::setNumberOfRetries(int retries)
 {
-	m_numOfRetries = max(1, retries);
+	m_numOfRetries = (retries > 1) ? retries : 1;
 }
 
 
-int XBeeCoordinator::scanDevices()
+bool XBeeCoordinator::startDiscovery()
 {
+	// forget the nodes (after the commands that might refer to them)
+	cancelCommands();
 	m_arrNodes.clear();
-	DWORD oldTimeout = m_serialPort.getTimeout();
+	int timeout = DEFAULT_DISCOVERY_TIMEOUT;
 
 	XBeePacket_AT_Command         command("NT"); // read discovery timeout
 	XBeePacket_AT_CommandResponse response;
 	if (process(command, response))
 	{
-		// returned discovery timeout in in 100mx
-		m_serialPort.setTimeout(response.getInt16() * 100);
+		// returned discovery timeout in in 100ms
+		timeout = response.getInt16() * 100;
 	}
 
-	// start discovery
+	// start discovery, the responses are collected by receive()
 	command.setCommand("ND");
-	if (process(command, response))
+	bool success = send(command);
+	if (success)
 	{
-		// parse discovery results
-		m_arrNodes.push_back(
-			std::unique_ptr<XBeeRemoteDevice>(
-				new XBeeRemoteDevice(*this, response.getRawData())));
+		m_discoveryFrameID = command.getFrameID();
+		m_discoveryEnd     = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout + DISCOVERY_MARGIN);
+		m_discovering      = true;
 	}
 
-	m_serialPort.setTimeout(oldTimeout);
+	return success;
+}
+
+
+bool XBeeCoordinator::isDiscovering() const
+{
+	return m_discovering;
+}
+
+
+int XBeeCoordinator::scanDevices()
+{
+	if (startDiscovery())
+	{
+		while (isDiscovering())
+		{
+			receive();
+		}
+	}
 
 	return (int) m_arrNodes.size();
 }
@@ -322,55 +434,145 @@ const std::vector<std::unique_ptr<XBeeRemoteDevice>>&  XBeeCoordinator::getConne
 
 bool XBeeCoordinator::receivePacket()
 {
-	uint8_t start = 0;
-	DWORD   rcvLen = 0;
+	size_t skippedBytes = m_frameReader.getSkippedBytes();
+
+	// is there still a complete packet from the last time?
+	bool success = m_frameReader.extractFrame(m_bufIn);
+	while (!success)
+	{
+		// no > receive whatever is available
+		size_t   maxBytes = 0;
+		uint8_t* pBuffer  = m_frameReader.getWritePointer(maxBytes);
+		DWORD    rcvLen   = m_serialPort.receive(pBuffer, (DWORD) maxBytes);
+		if (rcvLen < 1)
+		{
+			break; // nothing received (timeout) > get out
+		}
+		m_frameReader.commitWrite(rcvLen);
+		success = m_frameReader.extractFrame(m_bufIn);
+	}
 
-	// is there anything at all?
-	rcvLen = m_serialPort.receive(&start, 1);
-	if (rcvLen < 1)
+	if (m_frameReader.getSkippedBytes() != skippedBytes)
 	{
-		return false; // nope > get out
+		LOG_ERROR("Skipped " << (m_frameReader.getSkippedBytes() - skippedBytes) << " bytes of invalid data");
 	}
 
-	// is the first byte correct?
-	if (start != XBeePacket::START_DELIMITER)
+#ifdef LOG_DATA
+	if (success)
 	{
-		LOG_ERROR("Received response has invalid start delimiter (0x" << std::hex << (int)start << ")");
-		return false;
+		printMemory(std::cout, m_bufIn.data(), m_bufIn.size());
 	}
+#endif
 
-	// receive the length
-	uint8_t len[2] = { 0, 0 };
-	if (m_serialPort.receive(len, 2) != 2)
+	return success;
+}
+
+
+uint8_t XBeeCoordinator::allocateFrameID()
+{
+	// m_mtxCommands is locked by the caller
+	uint8_t frameID = 0;
+	for (int attempt = 0; (attempt < 255) && (frameID == 0); attempt++)
 	{
-		LOG_ERROR("Response without data length");
-		return false;
+		uint8_t candidate = m_frameCounter;
+		// advance frame ID counter for next package (never let it be 0)
+		m_frameCounter = 1 + (m_frameCounter % 255);
+		// skip frame IDs that responses are still expected for
+		if (!m_arrPendingCommands[candidate].active &&
+		    !(m_discovering && (candidate == m_discoveryFrameID)))
+		{
+			frameID = candidate;
+		}
 	}
+	return frameID;
+}
 
-	// what is the size of the data?
-	uint16_t dataLen = (((uint16_t)len[0]) << 8) | ((uint16_t)len[1]);
-	// prepare receive buffer: data length +4: +1x delimiter +2x length bytes
-	uint8_t* pBuffer = m_bufIn.prepareBuffer(dataLen);
-	// receive (+3: receive the rest, +1: also receive checksum)
-	rcvLen = m_serialPort.receive(pBuffer + 3, dataLen + 1);
 
-#ifdef LOG_DATA
-	printMemory(std::cout, m_bufIn.data(), rcvLen + 3);
-#endif
+void XBeeCoordinator::handleCommandResponse(const XBeePacket_AT_CommandResponse& refResponse)
+{
+	ResponseHandler handler;
+	{
+		std::lock_guard<std::mutex> lock(m_mtxCommands);
+		sPendingCommand& refPending = m_arrPendingCommands[refResponse.getFrameID()];
+		if (refPending.active && (refPending.responseTypeID == refResponse.getFrameTypeID()))
+		{
+			handler = std::move(refPending.handler);
+			refPending.active  = false;
+			refPending.handler = nullptr;
+			m_pendingCount--;
+		}
+	}
 
-	if (rcvLen != (dataLen + 1))
+	// call the handler without the lock, so that it can send further commands
+	if (handler)
 	{
-		LOG_ERROR("Received packet incomplete (expected: " << dataLen << ", received " << rcvLen << ")");
-		return false;
+		handler(&refResponse);
 	}
+}
 
-	if (m_bufIn.calculateChecksum() != 255)
+
+void XBeeCoordinator::handleCommandTimeouts()
+{
+	std::vector<ResponseHandler> arrHandlers;
 	{
-		LOG_ERROR("Invalid checksum");
-		return false;
+		std::lock_guard<std::mutex> lock(m_mtxCommands);
+		if (m_pendingCount > 0)
+		{
+			auto now = std::chrono::steady_clock::now();
+			for (auto& refPending : m_arrPendingCommands)
+			{
+				if (refPending.active && (now >= refPending.deadline))
+				{
+					arrHandlers.push_back(std::move(refPending.handler));
+					refPending.active  = false;
+					refPending.handler = nullptr;
+					m_pendingCount--;
+				}
+			}
+		}
 	}
 
-	return true;
+	for (auto& handler : arrHandlers)
+	{
+		if (handler)
+		{
+			handler(nullptr);
+		}
+	}
+}
+
+
+void XBeeCoordinator::cancelCommands()
+{
+	std::lock_guard<std::mutex> lock(m_mtxCommands);
+	for (auto& refPending : m_arrPendingCommands)
+	{
+		refPending.active  = false;
+		refPending.handler = nullptr;
+	}
+	m_pendingCount = 0;
+}
+
+
+void XBeeCoordinator::handleDiscoveryResponse(const XBeePacket_AT_CommandResponse& refResponse)
+{
+	if (m_discovering &&
+	    (refResponse.getFrameID() == m_discoveryFrameID) &&
+	    (refResponse.getCommand() == "ND"))
+	{
+		if (refResponse.getRawData().size() > 0)
+		{
+			XBeeRemoteDevice* pNode = new XBeeRemoteDevice(*this, refResponse.getRawData());
+			m_arrNodes.push_back(std::unique_ptr<XBeeRemoteDevice>(pNode));
+			pNode->requestTelemetry();
+		}
+		else
+		{
+			// empty response marks the end of the discovery
+			LOG_INFO("Discovery complete (" << m_arrNodes.size() << " devices found)");
+			m_discovering = false;
+		}
+	}
 }
 
 
@@ -380,31 +582,24 @@ bool XBeeCoordinator::receivePacket()
  * XBeeRemoteDevice class
  */
 
-XBeeRemoteDevice::XBeeRemoteDevice(XBeeCoordinator& refCoordinator, const XBeeReadBuffer& refBuffer) :
+XBeeRemoteDevice::XBeeRemoteDevice(XBeeCoordinator& refCoordinator, const XBeeReadView& refBuffer) :
 	XBeeDevice(),
-	m_coordinator(refCoordinator)
+	m_coordinator(refCoordinator),
+	m_batteryVoltage(0),
+	m_signalStrength(0)
 {
 	// Network discovery response (ND) comes in the following order:
 	m_networkAddress = refBuffer.getUInt16At(0);  // MY (network address)
 	m_serialNumber   = refBuffer.getNextUInt64(); // SH and SL (serial#)
-	m_strName        = refBuffer.getNextString(); // NI (name)
+	m_strName.assign(refBuffer.getNextStringView()); // NI (name)
 	m_parentAddress  = refBuffer.getNextUInt16(); // Parent network addess
 	m_deviceType     = (DeviceType)refBuffer.getNextByte(); // Device type
 	//	STATUS<CR>(1 Byte: Reserved)
 	//	PROFILE_ID<CR>(2 Bytes)
 	//	MANUFACTURER_ID<CR>(2 Bytes)
-
-	// read battery voltage
-	XBeePacket_RemoteAT_Command         command("%V");
-	XBeePacket_RemoteAT_CommandResponse response;
-	if (m_coordinator.process(command, response))
-	{
-		int voltageEncoded = response.getInt16();
-		// convert from 10 bit A/D value with 1.2V as reference to voltage
-		m_batteryVoltage = voltageEncoded / 1024.0f * 1.2f; 
-	}
 }
 
+
 uint16_t XBeeRemoteDevice::getParentAddress() const
 {
 	return m_parentAddress;
@@ -422,3 +617,45 @@ float XBeeRemoteDevice::getBatteryVoltage() const
 	return m_batteryVoltage;
 }
 
+
+int XBeeRemoteDevice::getSignalStrength() const
+{
+	return m_signalStrength;
+}
+
+
+bool XBeeRemoteDevice::requestTelemetry()
+{
+	// both requests are pending at the same time
+	XBeePacket_RemoteAT_Command command("%V");
+	command.setSerialNumber(m_serialNumber);
+	command.setNetworkAddress(m_networkAddress);
+	bool sentVoltage = m_coordinator.sendAsync(command,
+		[this](const XBeePacket_AT_CommandResponse* pResponse)
+		{
+			if ((pResponse != nullptr) && pResponse->isOK())
+			{
+				bool firstReading   = (m_batteryVoltage == 0);
+				int  voltageEncoded = pResponse->getInt16();
+				// convert from 10 bit A/D value with 1.2V as reference to voltage
+				m_batteryVoltage = voltageEncoded / 1024.0f * 1.2f;
+				if (firstReading)
+				{
+					LOG_INFO("Battery of '" << m_strName << "': " << (roundf(m_batteryVoltage * 10) / 10) << "V");
+				}
+			}
+		});
+
+	// RSSI of the last packet that the device received
+	command.setCommand("DB");
+	bool sentStrength = m_coordinator.sendAsync(command,
+		[this](const XBeePacket_AT_CommandResponse* pResponse)
+		{
+			if ((pResponse != nullptr) && pResponse->isOK() && (pResponse->getRawData().size() > 0))
+			{
+				m_signalStrength = -(int) pResponse->getRawData().getByteAt(0);
+			}
+		});
+
+	return sentVoltage && sentStrength;
+}
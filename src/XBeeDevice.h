@@ -10,6 +10,11 @@
 #include "SerialPort.h"
 #include "XBeePacket.h"
 
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+
 
 // forward declarations
 class XBeeRemoteDevice;
@@ -91,6 +96,16 @@ protected:
  */
 class XBeeCoordinator : public XBeeDevice
 {
+public:
+
+	/**
+	 * Function that is called by receive() with the response to an asynchronous command,
+	 * or with <code>nullptr</code> if no response was received in time.
+	 */
+	typedef std::function<void(const XBeePacket_AT_CommandResponse* pResponse)> ResponseHandler;
+
+	static const int DEFAULT_COMMAND_TIMEOUT = 2000; // in ms, time to wait for the response to an asynchronous command
+
 public:
 
 	/**
@@ -129,13 +144,19 @@ public:
 
 	/**
 	 * Receives an unspecific packet from an XBee device.
+	 * The packet belongs to the coordinator and is only valid until the next call,
+	 * so that receiving does not allocate any memory.
+	 * Discovery responses are added to the list of connected devices
+	 * and remote AT command responses are passed on to the addressed device.
 	 *
 	 * @return received packet or \c nullptr if an error occured
 	 */
-	std::unique_ptr<XBeePacket_Receive> receive();
+	const XBeePacket_Receive* receive();
 
 	/**
 	 * Sends a packet to an XBee device and waits for the reply.
+	 * Only to be used while no other thread calls receive(),
+	 * because any other packets that are received in the meantime are discarded.
 	 *
 	 * @param refSend     the packet to send
 	 * @param refReceive  the packet to receive
@@ -144,6 +165,30 @@ public:
 	 */
 	bool process(XBeePacket_Send& refSend, XBeePacket_Receive& refReceive);
 
+	/**
+	 * Sends an AT or remote AT command without waiting for the response.
+	 * Up to 255 commands can be pending at the same time, each with its own frame ID,
+	 * and the responses can arrive in any order.
+	 * The handler is called by receive() when the response arrives or when the timeout has passed,
+	 * so the thread that calls receive() is never blocked by the command.
+	 * This function can be called from any thread.
+	 *
+	 * @param refCommand  the command to send
+	 * @param handler     the function to call with the response
+	 * @param timeout     the time to wait for the response in ms
+	 *
+	 * @return <code>true</code> if the command was sent,
+	 *         <code>false</code> if not (the handler is not called)
+	 */
+	bool sendAsync(XBeePacket_AT_Command& refCommand, ResponseHandler handler, int timeout = DEFAULT_COMMAND_TIMEOUT);
+
+	/**
+	 * Gets the amount of asynchronous commands that are waiting for a response.
+	 *
+	 * @return the amount of pending commands
+	 */
+	int getPendingCommandCount() const;
+
 	/**
 	 * Sets the number of retries when a received packet is not as expected.
 	 *
@@ -152,7 +197,23 @@ public:
 	void setNumberOfRetries(int retries);
 
 	/**
-	 * Scans for any other connected devices.
+	 * Starts the discovery of connected devices without waiting for the responses.
+	 * Each device is added to the list of connected devices as soon as its response
+	 * is received by receive().
+	 *
+	 * @return <code>true</code> if the discovery was started
+	 */
+	bool startDiscovery();
+
+	/**
+	 * Checks if a device discovery is still in progress.
+	 *
+	 * @return <code>true</code> if more discovery responses can be received
+	 */
+	bool isDiscovering() const;
+
+	/**
+	 * Scans for any other connected devices and waits until the discovery is complete.
 	 *
 	 * @return  number of connected devices found
 	 */
@@ -160,6 +221,8 @@ public:
 
 	/**
 	 * Gets the list of connected devices.
+	 * The list is only to be accessed from the thread that calls receive(),
+	 * because it grows while a discovery is in progress.
 	 *
 	 * @return  the list of connected devices
 	 */
@@ -169,22 +232,89 @@ public:
 protected:
 
 	/**
-	 * Receives a specific packet from an XBee device.
+	 * Receives the next packet from an XBee device.
+	 * Data is read from the serial port in chunks, so several packets can be received at once.
 	 *
-	 * @return <code>true</code> if reception was successful and fata is in the buffer
+	 * @return <code>true</code> if reception was successful and data is in the buffer
 	 */
 	bool receivePacket();
 
+	/**
+	 * Gets a frame ID that is not used by a pending command.
+	 *
+	 * @return the frame ID (1...255) or 0 if all frame IDs are in use
+	 */
+	uint8_t allocateFrameID();
+
+	/**
+	 * Sends a packet with the frame ID that has already been set.
+	 *
+	 * @param refPacket  the packet to send
+	 *
+	 * @return <code>true</code> if sending was successful
+	 */
+	bool sendPacket(XBeePacket_Send& refPacket);
+
+	/**
+	 * Calls the handler of the pending command that a response belongs to.
+	 *
+	 * @param refResponse  the received response
+	 */
+	void handleCommandResponse(const XBeePacket_AT_CommandResponse& refResponse);
+
+	/**
+	 * Calls the handlers of pending commands without response within their timeout.
+	 */
+	void handleCommandTimeouts();
+
+	/**
+	 * Discards all pending commands without calling their handlers.
+	 */
+	void cancelCommands();
+
+	/**
+	 * Adds a device for a response to the discovery command.
+	 *
+	 * @param refResponse  the received AT command response
+	 */
+	void handleDiscoveryResponse(const XBeePacket_AT_CommandResponse& refResponse);
+
 protected:
 
+	/**
+	 * Asynchronous command that is waiting for a response.
+	 */
+	struct sPendingCommand
+	{
+		bool                                  active;
+		uint8_t                               responseTypeID; // frame type ID of the expected response
+		ResponseHandler                       handler;
+		std::chrono::steady_clock::time_point deadline;
+	};
+
 	SerialPort&      m_serialPort;   // the serial port to use for this device
+	std::mutex       m_mtxSend;      // sending from several threads
 	uint8_t          m_frameCounter; // current frame ID for command/response pairs
 	int              m_numOfRetries; // the number of receive retries
-	XBeeReadBuffer   m_bufIn;        // buffer for incoming data
+	XBeeFrameReader  m_frameReader;  // buffer for raw incoming data
+	XBeeReadBuffer   m_bufIn;        // buffer for incoming packets
 	XBeeWriteBuffer  m_bufOut;       // buffer for outgoing data
 
+	// packets for receive() that are reused instead of allocated for every frame
+	XBeePacket_AT_CommandResponse       m_rcvCommandResponse;
+	XBeePacket_RemoteAT_CommandResponse m_rcvRemoteCommandResponse;
+	XBeePacket_IO_DataSample            m_rcvDataSample;
+
 	std::vector<std::unique_ptr<XBeeRemoteDevice>> m_arrNodes;  // connected XBee nodes
 
+	std::atomic<bool>                     m_discovering;      // discovery responses are expected
+	uint8_t                               m_discoveryFrameID; // frame ID of the discovery command
+	std::chrono::steady_clock::time_point m_discoveryEnd;     // time when no more responses are expected
+
+	sPendingCommand    m_arrPendingCommands[256]; // indexed by frame ID (0 is not used)
+	int                m_pendingCount;
+	mutable std::mutex m_mtxCommands;             // guards frame IDs and pending commands
+
 };
 
 
@@ -207,11 +337,12 @@ public:
 
 	/**
 	 * Creates a XBee remote device class for a specific coordinator.
+	 * No commands are sent to the device, so this can be called while data is being received.
 	 *
 	 * @param refCoordinator  the coordinator for this device
 	 * @param refBuffer       the buffer to extract information from (generated by a "ND" command)
 	 */
-	XBeeRemoteDevice(XBeeCoordinator& refCoordinator, const XBeeReadBuffer& refBuffer);
+	XBeeRemoteDevice(XBeeCoordinator& refCoordinator, const XBeeReadView& refBuffer);
 
 	virtual ~XBeeRemoteDevice() { };
 
@@ -232,16 +363,32 @@ public:
 	/**
 	 * Gets the level of the battery in Volts.
 	 *
-	 * @return  the voltage of the battery
+	 * @return  the voltage of the battery (0 until the response to requestTelemetry() has been received)
 	 */
 	float getBatteryVoltage() const;
 
+	/**
+	 * Gets the strength of the last received signal.
+	 *
+	 * @return  the signal strength in dBm (0 until the response to requestTelemetry() has been received)
+	 */
+	int getSignalStrength() const;
+
+	/**
+	 * Sends requests for the battery voltage and the signal strength without waiting for the responses.
+	 * The values are updated when the responses arrive.
+	 *
+	 * @return <code>true</code> if the requests were sent
+	 */
+	bool requestTelemetry();
+
 protected:
 
-	XBeeCoordinator&  m_coordinator;
-	uint16_t          m_parentAddress;
-	DeviceType        m_deviceType;
-	float             m_batteryVoltage;
+	XBeeCoordinator&   m_coordinator;
+	uint16_t           m_parentAddress;
+	DeviceType         m_deviceType;
+	std::atomic<float> m_batteryVoltage;
+	std::atomic<int>   m_signalStrength;
 
 };
 
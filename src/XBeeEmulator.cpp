@@ -0,0 +1,602 @@
+#include "XBeeEmulator.h"
+
+#ifndef _WIN32
+
+#include "XBeePacket.h"
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "Logging.h"
+#undef   LOG_CLASS
+#define  LOG_CLASS "XBeeEmulator"
+
+
+// AT command status values
+static const uint8_t STATUS_OK              = 0;
+static const uint8_t STATUS_INVALID_COMMAND = 2;
+static const uint8_t STATUS_TX_FAILURE      = 4;
+
+// values of the emulated nodes
+static const uint64_t SERIAL_NUMBER_BASE   = 0x0013A200408A0000ULL;
+static const uint16_t NETWORK_ADDRESS_BASE = 0x1000;
+static const uint16_t VERSION_SW           = 0x21A7;
+static const uint16_t VERSION_HW           = 0x1E46;
+static const uint16_t DISCOVERY_TIMEOUT    = 0x000A; // NT in 100ms
+static const uint16_t PROFILE_ID           = 0xC105;
+static const uint16_t MANUFACTURER_ID      = 0x101E;
+static const uint8_t  SIGNAL_STRENGTH      = 0x2D;   // DB in -dBm
+static const uint16_t JOYSTICK_PIN_MASK    = 0x00FC; // DIO2...DIO7 are used by the joystick
+static const uint16_t JOYSTICK_IDLE_STATE  = 0x00FC; // pins are high while no button is pressed
+
+
+/******************************************************************************
+ * XBeeEmulator class
+ */
+
+XBeeEmulator::XBeeEmulator(const XBeeEmulatorSettings& refSettings) :
+	m_settings(refSettings),
+	m_fdMaster(-1),
+	m_fdSlave(-1),
+	m_strDeviceName(""),
+	m_running(false),
+	m_hostConnected(false),
+	m_discoveryActive(false),
+	m_discoveryFrameID(0),
+	m_discoveryNextNode(0),
+	m_capturing(false),
+	m_sentSamples(0),
+	m_droppedFrames(0)
+{
+	m_fdWakeup[0] = -1;
+	m_fdWakeup[1] = -1;
+
+	// coordinator
+	sNode node;
+	node.serialNumber   = SERIAL_NUMBER_BASE;
+	node.networkAddress = 0x0000;
+	node.name           = "Emulated Coordinator";
+	node.deviceType     = 0x00;
+	node.batteryVoltage = 3300;
+	node.inputState     = 0;
+	node.stateChanged   = false;
+	m_arrNodes.push_back(node);
+
+	// joystick devices
+	for (int devIdx = 0; devIdx < m_settings.nDevices; devIdx++)
+	{
+		std::stringstream strName;
+		strName << "Joystick " << (devIdx + 1);
+		node.serialNumber   = SERIAL_NUMBER_BASE + devIdx + 1;
+		node.networkAddress = NETWORK_ADDRESS_BASE + devIdx + 1;
+		node.name           = strName.str();
+		node.deviceType     = 0x02; // end device
+		node.batteryVoltage = 3000 - 100 * (devIdx % 5);
+		node.inputState     = JOYSTICK_IDLE_STATE;
+		m_arrNodes.push_back(node);
+	}
+}
+
+
+XBeeEmulator::~XBeeEmulator()
+{
+	stop();
+}
+
+
+bool XBeeEmulator::start()
+{
+	if (isRunning())
+	{
+		return true;
+	}
+
+	// create pseudo terminal
+	m_fdMaster = ::posix_openpt(O_RDWR | O_NOCTTY);
+	if ((m_fdMaster < 0) || (::grantpt(m_fdMaster) != 0) || (::unlockpt(m_fdMaster) != 0))
+	{
+		LOG_ERROR("Could not create pseudo terminal: " << strerror(errno));
+		stop();
+		return false;
+	}
+	m_strDeviceName = ::ptsname(m_fdMaster);
+	::fcntl(m_fdMaster, F_SETFL, ::fcntl(m_fdMaster, F_GETFL) | O_NONBLOCK);
+
+	// keep the slave side open so that reading the master does not fail while the host has not connected yet
+	m_fdSlave = ::open(m_strDeviceName.c_str(), O_RDWR | O_NOCTTY);
+	struct termios tio;
+	if ((m_fdSlave < 0) || (::tcgetattr(m_fdSlave, &tio) != 0))
+	{
+		LOG_ERROR("Could not open pseudo terminal " << m_strDeviceName << ": " << strerror(errno));
+		stop();
+		return false;
+	}
+	// no echo or character translation of the binary frames
+	::cfmakeraw(&tio);
+	::tcsetattr(m_fdSlave, TCSANOW, &tio);
+
+	if (::pipe(m_fdWakeup) != 0)
+	{
+		LOG_ERROR("Could not create wakeup pipe: " << strerror(errno));
+		stop();
+		return false;
+	}
+	::fcntl(m_fdWakeup[1], F_SETFL, ::fcntl(m_fdWakeup[1], F_GETFL) | O_NONBLOCK);
+
+	m_frameReader.clear();
+	m_hostConnected   = false;
+	m_discoveryActive = false;
+	m_running         = true;
+	m_thread        = std::thread(&XBeeEmulator::emulatorThread, this);
+
+	LOG_INFO("Emulating " << m_settings.nDevices << " devices with "
+		<< m_settings.sampleRate << " samples/s on " << m_strDeviceName);
+
+	return true;
+}
+
+
+void XBeeEmulator::stop()
+{
+	if (m_thread.joinable())
+	{
+		m_running = false;
+		uint8_t wakeup = 0;
+		::write(m_fdWakeup[1], &wakeup, 1);
+		m_thread.join();
+
+		LOG_INFO("Stopped after sending " << m_sentSamples << " samples ("
+			<< m_droppedFrames << " frames dropped)");
+	}
+
+	int* arrFds[] = { &m_fdMaster, &m_fdSlave, &m_fdWakeup[0], &m_fdWakeup[1] };
+	for (int* pFd : arrFds)
+	{
+		if (*pFd >= 0)
+		{
+			::close(*pFd);
+			*pFd = -1;
+		}
+	}
+}
+
+
+bool XBeeEmulator::isRunning() const
+{
+	return m_running;
+}
+
+
+const std::string& XBeeEmulator::getDeviceName() const
+{
+	return m_strDeviceName;
+}
+
+
+void XBeeEmulator::setInputState(int deviceIdx, uint16_t state)
+{
+	if ((deviceIdx >= 0) && (deviceIdx < m_settings.nDevices))
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mtxState);
+			sNode& refNode = m_arrNodes[deviceIdx + 1];
+			refNode.inputState   = state;
+			refNode.stateChanged = true;
+		}
+		// let the emulator thread send the change right away
+		uint8_t wakeup = 1;
+		::write(m_fdWakeup[1], &wakeup, 1);
+	}
+}
+
+
+void XBeeEmulator::startCapture()
+{
+	std::lock_guard<std::mutex> lock(m_mtxSend);
+	m_arrCapture.clear();
+	m_capturing = true;
+}
+
+
+std::vector<uint8_t> XBeeEmulator::stopCapture()
+{
+	std::lock_guard<std::mutex> lock(m_mtxSend);
+	m_capturing = false;
+	return std::move(m_arrCapture);
+}
+
+
+bool XBeeEmulator::replay(const std::vector<uint8_t>& arrStream)
+{
+	// the emulator thread waits with its own frames until the stream is sent
+	std::lock_guard<std::mutex> lock(m_mtxSend);
+
+	size_t sent = 0;
+	while (m_running && (sent < arrStream.size()))
+	{
+		ssize_t nBytes = ::write(m_fdMaster, arrStream.data() + sent, arrStream.size() - sent);
+		if (nBytes > 0)
+		{
+			sent += (size_t) nBytes;
+		}
+		else if ((nBytes < 0) && (errno != EAGAIN) && (errno != EINTR))
+		{
+			LOG_ERROR("Error while replaying: " << strerror(errno));
+			break;
+		}
+		else
+		{
+			// terminal buffer is full > wait for the host to read
+			struct pollfd pollOut = { m_fdMaster, POLLOUT, 0 };
+			if (::poll(&pollOut, 1, 1000) == 0)
+			{
+				LOG_ERROR("Host stopped reading while replaying");
+				break;
+			}
+		}
+	}
+	return (sent == arrStream.size());
+}
+
+
+uint64_t XBeeEmulator::getSentSamples() const
+{
+	return m_sentSamples;
+}
+
+
+uint64_t XBeeEmulator::getDroppedFrames() const
+{
+	return m_droppedFrames;
+}
+
+
+void XBeeEmulator::emulatorThread()
+{
+	typedef std::chrono::steady_clock clock;
+
+	const bool              periodic     = (m_settings.sampleRate > 0);
+	const clock::duration   samplePeriod = periodic ?
+		std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(1.0 / m_settings.sampleRate)) :
+		clock::duration::zero();
+	clock::time_point       nextSample   = clock::now();
+
+	struct pollfd arrPoll[2] = {
+		{ m_fdMaster,    POLLIN, 0 },
+		{ m_fdWakeup[0], POLLIN, 0 }
+	};
+
+	while (m_running)
+	{
+		// wait for commands, state changes, or until the next periodic sample or discovery response is due
+		int timeout = -1;
+		if (m_hostConnected && periodic)
+		{
+			auto wait = std::chrono::duration_cast<std::chrono::microseconds>(nextSample - clock::now()).count();
+			timeout = (wait > 0) ? (int) ((wait + 999) / 1000) : 0;
+		}
+		if (m_discoveryActive)
+		{
+			// the nodes respond evenly spread over the discovery timeout, followed by the final empty response
+			clock::time_point nextResponse = m_discoveryStart +
+				std::chrono::milliseconds(DISCOVERY_TIMEOUT * 100 * m_discoveryNextNode / m_arrNodes.size());
+			auto wait = std::chrono::duration_cast<std::chrono::microseconds>(nextResponse - clock::now()).count();
+			int  responseTimeout = (wait > 0) ? (int) ((wait + 999) / 1000) : 0;
+			timeout = ((timeout < 0) || (responseTimeout < timeout)) ? responseTimeout : timeout;
+		}
+		if (!m_arrDelayedFrames.empty())
+		{
+			auto wait = std::chrono::duration_cast<std::chrono::microseconds>(m_arrDelayedFrames.front().first - clock::now()).count();
+			int  frameTimeout = (wait > 0) ? (int) ((wait + 999) / 1000) : 0;
+			timeout = ((timeout < 0) || (frameTimeout < timeout)) ? frameTimeout : timeout;
+		}
+
+		if (::poll(arrPoll, 2, timeout) < 0)
+		{
+			if (errno == EINTR) continue;
+			LOG_ERROR("Error while waiting for data: " << strerror(errno));
+			m_running = false;
+			break;
+		}
+
+		if (arrPoll[1].revents & POLLIN)
+		{
+			uint8_t arrWakeup[64];
+			::read(m_fdWakeup[0], arrWakeup, sizeof(arrWakeup));
+		}
+
+		if (arrPoll[0].revents & POLLIN)
+		{
+			// receive commands from the host
+			size_t   maxBytes = 0;
+			uint8_t* pBuffer  = m_frameReader.getWritePointer(maxBytes);
+			ssize_t  nBytes   = ::read(m_fdMaster, pBuffer, maxBytes);
+			if (nBytes > 0)
+			{
+				m_frameReader.commitWrite((size_t) nBytes);
+				while (m_frameReader.extractFrame(m_bufIn))
+				{
+					handleFrame(m_bufIn);
+				}
+			}
+		}
+
+		if (m_discoveryActive)
+		{
+			sendDiscoveryResponses();
+		}
+
+		sendDelayedFrames();
+
+		if (!m_hostConnected)
+		{
+			continue;
+		}
+
+		// send samples of devices with changed inputs and periodic samples of all devices
+		clock::time_point now = clock::now();
+		bool sendAll = periodic && (now >= nextSample);
+		for (size_t nodeIdx = 1; nodeIdx < m_arrNodes.size(); nodeIdx++)
+		{
+			const sNode& refNode = m_arrNodes[nodeIdx];
+			uint16_t state   = 0;
+			bool     changed = false;
+			{
+				std::lock_guard<std::mutex> lock(m_mtxState);
+				state   = refNode.inputState;
+				changed = refNode.stateChanged;
+				m_arrNodes[nodeIdx].stateChanged = false;
+			}
+			if (changed || sendAll)
+			{
+				sendSample(refNode, state);
+			}
+		}
+
+		if (sendAll)
+		{
+			nextSample += samplePeriod;
+			if (nextSample < now)
+			{
+				// too far behind (e.g., host not reading) > don't send a burst to catch up
+				nextSample = now + samplePeriod;
+			}
+		}
+	}
+}
+
+
+void XBeeEmulator::handleFrame(const XBeeReadBuffer& refFrame)
+{
+	uint8_t frameTypeID = refFrame.getByteAt(3);
+	uint8_t frameID     = refFrame.getByteAt(4);
+
+	if (frameTypeID == XBeePacket_AT_Command::FRAME_TYPE_ID)
+	{
+		// delimiter, length, frame type, frame ID, command, [parameter,] checksum
+		std::string strCommand   = refFrame.getStringAt(5, 2);
+		bool        hasParameter = refFrame.size() > 8;
+		m_hostConnected = true;
+
+		if (strCommand == "ND")
+		{
+			// node discovery: the responses are sent by the emulator thread when they are due
+			m_discoveryActive   = true;
+			m_discoveryFrameID  = frameID;
+			m_discoveryNextNode = 1;
+			m_discoveryStart    = std::chrono::steady_clock::now();
+		}
+		else
+		{
+			beginFrame(XBeePacket_AT_CommandResponse::FRAME_TYPE_ID);
+			m_bufOut.addByte(frameID);
+			m_bufOut.addString(strCommand, 2);
+			if (hasParameter)
+			{
+				// setting a parameter > accept, but there is nothing to change
+				m_bufOut.addByte(STATUS_OK);
+			}
+			else
+			{
+				// status comes before the value > correct it afterwards for unknown commands
+				size_t statusPos = m_bufOut.size();
+				m_bufOut.addByte(STATUS_OK);
+				if (!addParameter(m_arrNodes[0], strCommand))
+				{
+					m_bufOut.setByteAt(statusPos, STATUS_INVALID_COMMAND);
+				}
+			}
+			sendFrame();
+		}
+	}
+	else if (frameTypeID == XBeePacket_RemoteAT_Command::FRAME_TYPE_ID)
+	{
+		// delimiter, length, frame type, frame ID, serial#, address, options, command, [parameter,] checksum
+		uint64_t    serialNumber   = refFrame.getUInt64At(5);
+		uint16_t    networkAddress = refFrame.getNextUInt16();
+		/* options */                refFrame.getNextByte();
+		std::string strCommand     = refFrame.getNextString(2);
+		bool        hasParameter   = refFrame.size() > 19;
+		m_hostConnected = true;
+
+		// find addressed node (serial# 0 is the coordinator)
+		const sNode* pNode = NULL;
+		for (const sNode& refNode : m_arrNodes)
+		{
+			if (((serialNumber == 0) && (&refNode == &m_arrNodes[0])) ||
+			    ((serialNumber != 0) && (serialNumber == refNode.serialNumber)) ||
+			    ((networkAddress != 0xFFFE) && (networkAddress == refNode.networkAddress)))
+			{
+				pNode = &refNode;
+				break;
+			}
+		}
+
+		beginFrame(XBeePacket_RemoteAT_CommandResponse::FRAME_TYPE_ID);
+		m_bufOut.addByte(frameID);
+		m_bufOut.addUInt64((pNode != NULL) ? pNode->serialNumber   : serialNumber);
+		m_bufOut.addUInt16((pNode != NULL) ? pNode->networkAddress : networkAddress);
+		m_bufOut.addString(strCommand, 2);
+		if (pNode == NULL)
+		{
+			m_bufOut.addByte(STATUS_TX_FAILURE);
+		}
+		else if (hasParameter)
+		{
+			m_bufOut.addByte(STATUS_OK);
+		}
+		else
+		{
+			size_t statusPos = m_bufOut.size();
+			m_bufOut.addByte(STATUS_OK);
+			if (!addParameter(*pNode, strCommand))
+			{
+				m_bufOut.setByteAt(statusPos, STATUS_INVALID_COMMAND);
+			}
+		}
+		// responses from remote devices take a round trip over the radio link
+		sendFrame((pNode == &m_arrNodes[0]) ? 0 : m_settings.remoteDelay);
+	}
+	else
+	{
+		LOG_WARNING("Unhandled frame type 0x" << std::hex << (int) frameTypeID);
+	}
+}
+
+
+bool XBeeEmulator::addParameter(const sNode& refNode, const std::string& strCommand)
+{
+	bool known = true;
+	if      (strCommand == "SH") { m_bufOut.addUInt16((uint16_t) (refNode.serialNumber >> 48)); m_bufOut.addUInt16((uint16_t) (refNode.serialNumber >> 32)); }
+	else if (strCommand == "SL") { m_bufOut.addUInt16((uint16_t) (refNode.serialNumber >> 16)); m_bufOut.addUInt16((uint16_t) (refNode.serialNumber      )); }
+	else if (strCommand == "MY") { m_bufOut.addUInt16(refNode.networkAddress); }
+	else if (strCommand == "NI") { m_bufOut.addString(refNode.name); }
+	else if (strCommand == "VR") { m_bufOut.addUInt16(VERSION_SW); }
+	else if (strCommand == "HV") { m_bufOut.addUInt16(VERSION_HW); }
+	else if (strCommand == "NT") { m_bufOut.addUInt16(DISCOVERY_TIMEOUT); }
+	else if (strCommand == "%V") { m_bufOut.addUInt16(refNode.batteryVoltage); }
+	else if (strCommand == "DB") { m_bufOut.addByte(SIGNAL_STRENGTH); }
+	else                         { known = false; }
+	return known;
+}
+
+
+void XBeeEmulator::beginFrame(uint8_t frameTypeID)
+{
+	m_bufOut.clear();
+	m_bufOut.addByte(XBeePacket::START_DELIMITER);
+	m_bufOut.addByte(0); // length placeholder
+	m_bufOut.addByte(0);
+	m_bufOut.addByte(frameTypeID);
+}
+
+
+void XBeeEmulator::sendFrame(int delay)
+{
+	m_bufOut.setUInt16At(1, (uint16_t) (m_bufOut.size() - 3));
+	m_bufOut.addByte((uint8_t) 255 - m_bufOut.calculateChecksum());
+
+	if (delay > 0)
+	{
+		// keep a copy until it is due (all frames have the same delay, so the list stays in order)
+		const uint8_t* pData = (const uint8_t*) m_bufOut.data();
+		m_arrDelayedFrames.push_back(std::make_pair(
+			std::chrono::steady_clock::now() + std::chrono::milliseconds(delay),
+			std::vector<uint8_t>(pData, pData + m_bufOut.size())));
+	}
+	else
+	{
+		writeFrame((const uint8_t*) m_bufOut.data(), m_bufOut.size());
+	}
+}
+
+
+void XBeeEmulator::writeFrame(const uint8_t* pData, size_t size)
+{
+	std::lock_guard<std::mutex> lock(m_mtxSend);
+
+	// like a radio link, the frame is lost when the host does not keep up
+	ssize_t nBytes = ::write(m_fdMaster, pData, size);
+	if (nBytes != (ssize_t) size)
+	{
+		m_droppedFrames++;
+	}
+	else if (m_capturing)
+	{
+		m_arrCapture.insert(m_arrCapture.end(), pData, pData + size);
+	}
+}
+
+
+void XBeeEmulator::sendDelayedFrames()
+{
+	auto   now        = std::chrono::steady_clock::now();
+	size_t nDueFrames = 0;
+	while ((nDueFrames < m_arrDelayedFrames.size()) && (m_arrDelayedFrames[nDueFrames].first <= now))
+	{
+		const std::vector<uint8_t>& refFrame = m_arrDelayedFrames[nDueFrames].second;
+		writeFrame(refFrame.data(), refFrame.size());
+		nDueFrames++;
+	}
+	m_arrDelayedFrames.erase(m_arrDelayedFrames.begin(), m_arrDelayedFrames.begin() + nDueFrames);
+}
+
+
+void XBeeEmulator::sendDiscoveryResponses()
+{
+	auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - m_discoveryStart).count();
+
+	// one response per remote node, node i after i/(n+1) of the discovery timeout
+	while (m_discoveryActive &&
+	       (elapsed >= (long long) (DISCOVERY_TIMEOUT * 100 * m_discoveryNextNode / m_arrNodes.size())))
+	{
+		beginFrame(XBeePacket_AT_CommandResponse::FRAME_TYPE_ID);
+		m_bufOut.addByte(m_discoveryFrameID);
+		m_bufOut.addString("ND", 2);
+		m_bufOut.addByte(STATUS_OK);
+		if (m_discoveryNextNode < m_arrNodes.size())
+		{
+			const sNode& refNode = m_arrNodes[m_discoveryNextNode];
+			m_bufOut.addUInt16(refNode.networkAddress);
+			m_bufOut.addUInt64(refNode.serialNumber);
+			m_bufOut.addString(refNode.name);
+			m_bufOut.addByte(0);
+			m_bufOut.addUInt16(m_arrNodes[0].networkAddress); // parent
+			m_bufOut.addByte(refNode.deviceType);
+			m_bufOut.addByte(0); // status
+			m_bufOut.addUInt16(PROFILE_ID);
+			m_bufOut.addUInt16(MANUFACTURER_ID);
+			m_discoveryNextNode++;
+		}
+		else
+		{
+			// final response without data after the discovery timeout
+			m_discoveryActive = false;
+		}
+		sendFrame();
+	}
+}
+
+
+void XBeeEmulator::sendSample(const sNode& refNode, uint16_t state)
+{
+	beginFrame(XBeePacket_IO_DataSample::FRAME_TYPE_ID);
+	m_bufOut.addUInt64(refNode.serialNumber);
+	m_bufOut.addUInt16(refNode.networkAddress);
+	m_bufOut.addByte(0x01); // options: packet acknowledged
+	m_bufOut.addByte(1);    // one sample
+	m_bufOut.addUInt16(JOYSTICK_PIN_MASK);
+	m_bufOut.addByte(0);    // no analog channels
+	m_bufOut.addUInt16(state & JOYSTICK_PIN_MASK);
+	sendFrame();
+	m_sentSamples++;
+}
+
+
+#endif // #ifndef _WIN32
@@ -0,0 +1,250 @@
+/**
+ * Emulator of an XBee coordinator with a network of joystick devices.
+ * The emulator creates a pseudo terminal that a SerialPort can open instead of a real device,
+ * answers the AT and remote AT commands that XBeeCoordinator uses
+ * (with the discovery responses spread over the discovery timeout like on a real network),
+ * and streams IO data samples of the emulated joysticks.
+ * This allows testing and profiling the interaction system without any hardware attached.
+ * Only available on POSIX systems.
+ */
+
+#pragma once
+
+#ifndef _WIN32
+
+#include "XBeeData.h"
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+/**
+ * Parameters of the emulated XBee network.
+ */
+struct XBeeEmulatorSettings
+{
+	int   nDevices;    // amount of joystick devices
+	float sampleRate;  // IO data samples per second and device (0: only send samples when the input state changes)
+	int   remoteDelay; // time in ms until the response of a remote device to an AT command arrives
+
+	XBeeEmulatorSettings() :
+		nDevices(2),
+		sampleRate(50),
+		remoteDelay(40)
+	{
+		// nothing else to do
+	}
+};
+
+
+/**
+ * Class for emulating an XBee coordinator on a pseudo terminal.
+ */
+class XBeeEmulator
+{
+public:
+
+	/**
+	 * Creates an XBee emulator.
+	 *
+	 * @param refSettings  the parameters of the emulated network
+	 */
+	XBeeEmulator(const XBeeEmulatorSettings& refSettings);
+
+	/**
+	 * Stops the emulator and releases the pseudo terminal.
+	 */
+	~XBeeEmulator();
+
+	/**
+	 * Creates the pseudo terminal and starts the emulator thread.
+	 *
+	 * @return <code>true</code> if the emulator was started
+	 */
+	bool start();
+
+	/**
+	 * Stops the emulator thread and closes the pseudo terminal.
+	 */
+	void stop();
+
+	/**
+	 * Checks if the emulator is running.
+	 *
+	 * @return <code>true</code> if the emulator is running
+	 */
+	bool isRunning() const;
+
+	/**
+	 * Gets the name of the pseudo terminal device to open with a SerialPort.
+	 *
+	 * @return the name of the device, e.g., "/dev/pts/3"
+	 */
+	const std::string& getDeviceName() const;
+
+	/**
+	 * Changes the digital input pins of a joystick device.
+	 * Like the change detection of a real XBee, an IO data sample is sent immediately.
+	 *
+	 * @param deviceIdx  the index of the device (0...nDevices-1)
+	 * @param state      the state of the input pins (a pin is low while a button is pressed)
+	 */
+	void setInputState(int deviceIdx, uint16_t state);
+
+	/**
+	 * Starts recording the bytes that the emulator sends to the host.
+	 */
+	void startCapture();
+
+	/**
+	 * Stops recording the bytes that the emulator sends to the host.
+	 *
+	 * @return the bytes that were sent since startCapture()
+	 */
+	std::vector<uint8_t> stopCapture();
+
+	/**
+	 * Sends a recorded byte stream to the host, e.g., from stopCapture() or from a real coordinator.
+	 * Unlike the frames of the emulated network, the stream is not dropped when the host does not keep up.
+	 * The function waits until the host has read it, and the emulator sends its own frames afterwards.
+	 *
+	 * @param arrStream  the bytes to send
+	 *
+	 * @return <code>true</code> if the whole stream was sent
+	 */
+	bool replay(const std::vector<uint8_t>& arrStream);
+
+	/**
+	 * Gets the amount of IO data samples that have been sent.
+	 *
+	 * @return the amount of IO data samples
+	 */
+	uint64_t getSentSamples() const;
+
+	/**
+	 * Gets the amount of frames that could not be sent
+	 * because the host did not read the pseudo terminal quickly enough.
+	 *
+	 * @return the amount of dropped frames
+	 */
+	uint64_t getDroppedFrames() const;
+
+private:
+
+	/**
+	 * Emulated XBee node with the information that is returned for AT commands.
+	 */
+	struct sNode
+	{
+		uint64_t    serialNumber;
+		uint16_t    networkAddress;
+		std::string name;
+		uint8_t     deviceType;
+		uint16_t    batteryVoltage; // in mV
+		uint16_t    inputState;     // guarded by m_mtxState
+		bool        stateChanged;   // guarded by m_mtxState
+	};
+
+	/**
+	 * Thread that receives commands from the host and sends IO data samples.
+	 */
+	void emulatorThread();
+
+	/**
+	 * Answers a frame that was received from the host.
+	 *
+	 * @param refFrame  the received frame
+	 */
+	void handleFrame(const XBeeReadBuffer& refFrame);
+
+	/**
+	 * Adds the value of an AT command parameter of a node to the frame.
+	 *
+	 * @param refNode     the node to read the parameter of
+	 * @param strCommand  the AT command
+	 *
+	 * @return <code>true</code> if the command is known
+	 */
+	bool addParameter(const sNode& refNode, const std::string& strCommand);
+
+	/**
+	 * Starts a new frame in the output buffer.
+	 *
+	 * @param frameTypeID  the frame type ID
+	 */
+	void beginFrame(uint8_t frameTypeID);
+
+	/**
+	 * Fills in length and checksum of the frame in the output buffer and sends it.
+	 *
+	 * @param delay  the time in ms to wait before the frame is sent (0: send immediately)
+	 */
+	void sendFrame(int delay = 0);
+
+	/**
+	 * Writes a frame to the pseudo terminal.
+	 *
+	 * @param pData  the frame to write
+	 * @param size   the amount of bytes of the frame
+	 */
+	void writeFrame(const uint8_t* pData, size_t size);
+
+	/**
+	 * Sends the delayed frames that are due.
+	 */
+	void sendDelayedFrames();
+
+	/**
+	 * Sends the discovery responses that are due.
+	 */
+	void sendDiscoveryResponses();
+
+	/**
+	 * Sends an IO data sample of a node.
+	 *
+	 * @param refNode  the node to send the sample of
+	 * @param state    the state of the digital input pins
+	 */
+	void sendSample(const sNode& refNode, uint16_t state);
+
+private:
+
+	XBeeEmulatorSettings m_settings;
+
+	int                  m_fdMaster;      // master side of the pseudo terminal
+	int                  m_fdSlave;       // slave side, kept open so that the terminal does not hang up
+	int                  m_fdWakeup[2];   // pipe for waking up the emulator thread
+	std::string          m_strDeviceName; // name of the slave device
+
+	std::vector<sNode>   m_arrNodes;      // coordinator first, then the joystick devices
+	std::mutex           m_mtxState;
+
+	std::thread          m_thread;
+	std::atomic<bool>    m_running;
+	bool                 m_hostConnected; // samples are only sent after the first command from the host
+
+	bool                                  m_discoveryActive;   // discovery responses are outstanding
+	uint8_t                               m_discoveryFrameID;  // frame ID of the discovery command
+	size_t                                m_discoveryNextNode; // index of the next node to respond
+	std::chrono::steady_clock::time_point m_discoveryStart;    // time of the discovery command
+
+	std::vector<std::pair<std::chrono::steady_clock::time_point, std::vector<uint8_t>>> m_arrDelayedFrames; // in order of time
+
+	XBeeFrameReader      m_frameReader;
+	XBeeReadBuffer       m_bufIn;
+	XBeeWriteBuffer      m_bufOut;
+
+	std::mutex           m_mtxSend;       // serialises writing frames and replaying streams
+	bool                 m_capturing;     // guarded by m_mtxSend
+	std::vector<uint8_t> m_arrCapture;    // guarded by m_mtxSend
+
+	std::atomic<uint64_t> m_sentSamples;
+	std::atomic<uint64_t> m_droppedFrames;
+};
+
+
+#endif // #ifndef _WIN32
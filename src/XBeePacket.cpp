@@ -131,13 +131,19 @@ XBeePacket_AT_CommandResponse::XBeePacket_AT_CommandResponse() :
 
 bool XBeePacket_AT_CommandResponse::unmarshal(const XBeeReadBuffer& refBuffer)
 {
+	// the coordinator reuses its packets > nothing may remain from the previous frame
+	m_frameID = 0;
+	m_strCommand.clear();
+	m_status  = Status::OK;
+	m_bufData = XBeeReadView();
+
 	bool success = false;
-	if (XBeePacket_Receive::unmarshal(refBuffer))
+	if (XBeePacket_Receive::unmarshal(refBuffer) && (refBuffer.size() >= MIN_FRAME_SIZE))
 	{
-		m_frameID    = refBuffer.getByteAt(4);              // frame ID in pos 4
-		m_strCommand = refBuffer.getNextString(2);          // AT command name in pos 5 and 6
-		m_status     = (Status) refBuffer.getNextByte();    // command status in pos 7 
-		m_bufData.copy(refBuffer, 8, refBuffer.size() - 1); // rest of data (-1 = checksum byte)
+		m_frameID = refBuffer.getByteAt(4);                        // frame ID in pos 4
+		m_strCommand.assign(refBuffer.getNextStringView(2));       // AT command name in pos 5 and 6
+		m_status  = (Status) refBuffer.getNextByte();              // command status in pos 7 
+		m_bufData = refBuffer.getViewAt(8, refBuffer.size() - 1);  // rest of data (-1 = checksum byte)
 		success = true;
 	}
 	return success;
@@ -183,7 +189,7 @@ std::string XBeePacket_AT_CommandResponse::getString() const
 }
 
 
-const XBeeReadBuffer& XBeePacket_AT_CommandResponse::getRawData() const
+const XBeeReadView& XBeePacket_AT_CommandResponse::getRawData() const
 {
 	return m_bufData;
 }
@@ -240,15 +246,23 @@ XBeePacket_RemoteAT_CommandResponse::XBeePacket_RemoteAT_CommandResponse() :
 
 bool XBeePacket_RemoteAT_CommandResponse::unmarshal(const XBeeReadBuffer& refBuffer)
 {
+	// the coordinator reuses its packets > nothing may remain from the previous frame
+	m_frameID        = 0;
+	m_serialNumber   = 0;
+	m_networkAddress = 0;
+	m_strCommand.clear();
+	m_status         = Status::OK;
+	m_bufData        = XBeeReadView();
+
 	bool success = false;
-	if (XBeePacket_Receive::unmarshal(refBuffer))
+	if (XBeePacket_Receive::unmarshal(refBuffer) && (refBuffer.size() >= MIN_FRAME_SIZE))
 	{
-		m_frameID        = refBuffer.getByteAt(4);     // frame ID in pos 4
-		m_serialNumber   = refBuffer.getNextUInt64();  // serial number in pos 5
-		m_networkAddress = refBuffer.getNextUInt16();  // network address in pos 13
-		m_strCommand     = refBuffer.getNextString(2); // AT command name in pos 15 and 16
-		m_status = (Status) refBuffer.getByteAt(17);   // command status in pos 17
-		m_bufData.copy(refBuffer, 18, refBuffer.size() - 1); // rest of data (-1 = checksum byte)
+		m_frameID        = refBuffer.getByteAt(4);                        // frame ID in pos 4
+		m_serialNumber   = refBuffer.getNextUInt64();                     // serial number in pos 5
+		m_networkAddress = refBuffer.getNextUInt16();                     // network address in pos 13
+		m_strCommand.assign(refBuffer.getNextStringView(2));              // AT command name in pos 15 and 16
+		m_status         = (Status) refBuffer.getByteAt(17);              // command status in pos 17
+		m_bufData        = refBuffer.getViewAt(18, refBuffer.size() - 1); // rest of data (-1 = checksum byte)
 		success = true;
 	}
 	return success;
@@ -285,8 +299,14 @@ XBeePacket_IO_DataSample::XBeePacket_IO_DataSample() :
 
 bool XBeePacket_IO_DataSample::unmarshal(const XBeeReadBuffer& refBuffer)
 {
+	// the coordinator reuses its packets > nothing may remain from the previous frame
+	m_serialNumber      = 0;
+	m_networkAddress    = 0;
+	m_digitalInputMask  = 0;
+	m_digitalInputState = 0;
+
 	bool success = false;
-	if (XBeePacket_Receive::unmarshal(refBuffer))
+	if (XBeePacket_Receive::unmarshal(refBuffer) && (refBuffer.size() >= MIN_FRAME_SIZE))
 	{
 		m_serialNumber   = refBuffer.getUInt64At(4);    // pos 4: 64 bit serial#
 		m_networkAddress = refBuffer.getNextUInt16();   // pos 12: 16 bit address
@@ -295,9 +315,12 @@ bool XBeePacket_IO_DataSample::unmarshal(const XBeeReadBuffer& refBuffer)
 		if (m_digitalInputMask > 0)
 		{
 			m_digitalInputState = refBuffer.getUInt16At(19); // pos 19: channel state
+			success = (refBuffer.size() >= MIN_FRAME_SIZE + 2);
+		}
+		else
+		{
+			success = true;
 		}
-
-		success = true;
 	}
 	return success;
 }
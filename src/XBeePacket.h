@@ -215,7 +215,8 @@ class XBeePacket_AT_CommandResponse : public XBeePacket_Receive
 {
 public:
 
-	static const uint8_t FRAME_TYPE_ID = 0x88;
+	static const uint8_t FRAME_TYPE_ID  = 0x88;
+	static const size_t  MIN_FRAME_SIZE = 9;  // delimiter, length, frame type, frame ID, command, status, checksum
 
 	// AT command status codes
 	enum Status
@@ -285,16 +286,17 @@ public:
 
 	/**
 	 * Gets the raw response result buffer.
+	 * The buffer is a view of the received frame and only valid until the next frame is received.
 	 *
 	 * @return the response result buffer
 	 */
-	const XBeeReadBuffer& getRawData() const;
+	const XBeeReadView& getRawData() const;
 
 protected:
 
-	std::string    m_strCommand;
-	Status         m_status;
-	XBeeReadBuffer m_bufData;
+	std::string  m_strCommand;
+	Status       m_status;
+	XBeeReadView m_bufData; // view of the received frame, not a copy
 
 };
 
@@ -358,7 +360,8 @@ class XBeePacket_RemoteAT_CommandResponse : public XBeePacket_AT_CommandResponse
 {
 public:
 
-	static const uint8_t FRAME_TYPE_ID = 0x97;
+	static const uint8_t FRAME_TYPE_ID  = 0x97;
+	static const size_t  MIN_FRAME_SIZE = 19; // delimiter, length, frame type, frame ID, serial#, address, command, status, checksum
 
 public:
 
@@ -406,7 +409,8 @@ class XBeePacket_IO_DataSample : public XBeePacket_Receive
 {
 public:
 
-	static const uint8_t FRAME_TYPE_ID = 0x92;
+	static const uint8_t FRAME_TYPE_ID  = 0x92;
+	static const size_t  MIN_FRAME_SIZE = 20; // delimiter, length, frame type, serial#, address, options, sample count, masks, checksum
 
 public:
 
@@ -0,0 +1,71 @@
+/**
+ * Measures the throughput of the batch conversion of Euler angles to quaternions
+ * compared to multiplying the quaternions of the single axes per rotation.
+ */
+
+#include "Test.h"
+
+#include "EulerConverter.h"
+#include "VectorMath.h"
+
+#include <random>
+
+
+int main()
+{
+	// the segments of 20 actors with 50 segments each
+	const int ROTATIONS = 1000;
+	const int FRAMES    = 5000;
+
+	std::mt19937 rng(42);
+	std::uniform_real_distribution<float> random(-180, 180);
+	std::vector<float> arrAngles(3 * ROTATIONS);
+	for (float& refAngle : arrAngles)
+	{
+		refAngle = random(rng);
+	}
+
+	// batch conversion
+	EulerConverter converter;
+	double checksumBatch = 0;
+	std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+	for (int fIdx = 0; fIdx < FRAMES; fIdx++)
+	{
+		converter.clear();
+		for (int rIdx = 0; rIdx < ROTATIONS; rIdx++)
+		{
+			converter.add(arrAngles[3 * rIdx], arrAngles[3 * rIdx + 1], arrAngles[3 * rIdx + 2] + fIdx * 1e-3f);
+		}
+		converter.convert();
+		for (int rIdx = 0; rIdx < ROTATIONS; rIdx++)
+		{
+			float qx, qy, qz, qw;
+			converter.getQuaternion(rIdx, qx, qy, qz, qw);
+			checksumBatch += qx + qy + qz + qw;
+		}
+	}
+	double timeBatch = secondsSince(t0);
+
+	// single axis quaternions (ZYX)
+	double checksumScalar = 0;
+	t0 = std::chrono::steady_clock::now();
+	for (int fIdx = 0; fIdx < FRAMES; fIdx++)
+	{
+		for (int rIdx = 0; rIdx < ROTATIONS; rIdx++)
+		{
+			float      angleZ = arrAngles[3 * rIdx + 2] + fIdx * 1e-3f;
+			Quaternion rot;
+			rot.mult(Quaternion(0, 0, 1, (float) RADIANS(angleZ)))
+			   .mult(Quaternion(0, 1, 0, (float) RADIANS(arrAngles[3 * rIdx + 1])))
+			   .mult(Quaternion(1, 0, 0, (float) RADIANS(arrAngles[3 * rIdx])));
+			checksumScalar += rot.x + rot.y + rot.z + rot.w;
+		}
+	}
+	double timeScalar = secondsSince(t0);
+
+	CHECK_CLOSE(checksumBatch, checksumScalar, 1e-5 * ROTATIONS * FRAMES);
+	const double nRotations = (double) ROTATIONS * FRAMES;
+	std::cout << "Batch conversion:        " << (timeBatch  * 1e9 / nRotations) << " ns/rotation = " << (nRotations / timeBatch  / 1e6) << " M rotations/s" << std::endl;
+	std::cout << "Single axis quaternions: " << (timeScalar * 1e9 / nRotations) << " ns/rotation = " << (nRotations / timeScalar / 1e6) << " M rotations/s" << std::endl;
+	return TEST_RESULT();
+}
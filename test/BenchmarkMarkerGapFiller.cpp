@@ -0,0 +1,135 @@
+/**
+ * Measures the throughput of the gap filler for thousands of markers
+ * compared to the same filter with its state stored per marker and branches for missing markers.
+ * The filter update itself is reported separately from the calls that set and get each marker.
+ */
+
+#include "Test.h"
+
+#include "MarkerGapFiller.h"
+
+#include <random>
+#include <vector>
+
+
+// filter gains and decay of MarkerGapFiller
+static const float ALPHA = 0.85f;
+static const float BETA  = 0.751f;
+static const float GAMMA = 0.332f;
+static const float ACCELERATION_DECAY = 0.5f;
+
+
+/**
+ * Alpha-beta-gamma filter of a single marker as array-of-structures reference.
+ */
+struct MarkerFilter
+{
+	float pos[3], vel[3], acc[3];
+	int   gapLength = -1;
+
+	void update(const float* pMeasurement, int maxGapLength)
+	{
+		if (pMeasurement != nullptr)
+		{
+			if ((gapLength < 0) || (gapLength > maxGapLength))
+			{
+				for (int a = 0; a < 3; a++) { pos[a] = pMeasurement[a]; vel[a] = 0; acc[a] = 0; }
+			}
+			for (int a = 0; a < 3; a++)
+			{
+				float pred = pos[a] + vel[a] + 0.5f * acc[a];
+				float res  = pMeasurement[a] - pred;
+				pos[a] = pred + ALPHA * res;
+				vel[a] = vel[a] + acc[a] + BETA * res;
+				acc[a] = acc[a] + 2.0f * GAMMA * res;
+			}
+			gapLength = 0;
+		}
+		else if (gapLength >= 0)
+		{
+			for (int a = 0; a < 3; a++)
+			{
+				pos[a] = pos[a] + vel[a] + 0.5f * acc[a];
+				vel[a] = vel[a] + acc[a];
+				acc[a] = ACCELERATION_DECAY * acc[a];
+			}
+			if (gapLength <= maxGapLength) gapLength++;
+		}
+	}
+};
+
+
+int main()
+{
+	const int MARKERS = 10000;
+	const int FRAMES  = 2000;
+	const int MAX_GAP = 10;
+
+	// markers on circles with different radii and speeds, each missing in about 5% of the frames
+	std::mt19937 rng(42);
+	std::uniform_real_distribution<float> random(0, 1);
+	std::vector<float> arrRadius(MARKERS), arrSpeed(MARKERS);
+	for (int mIdx = 0; mIdx < MARKERS; mIdx++)
+	{
+		arrRadius[mIdx] = 0.1f + random(rng);
+		arrSpeed[mIdx]  = 0.01f + 0.05f * random(rng);
+	}
+	std::vector<float>   arrPositions(3 * MARKERS);
+	std::vector<uint8_t> arrMissing(MARKERS);
+
+	MarkerGapFiller           filler(MAX_GAP);
+	std::vector<MarkerFilter> arrFilters(MARKERS);
+	filler.setMarkerCount(MARKERS);
+
+	double timeArrays = 0, timeUpdate = 0, timeStructs = 0;
+	double checksumArrays = 0, checksumStructs = 0;
+	for (int fIdx = 0; fIdx < FRAMES; fIdx++)
+	{
+		for (int mIdx = 0; mIdx < MARKERS; mIdx++)
+		{
+			float angle = arrSpeed[mIdx] * fIdx;
+			arrPositions[3 * mIdx]     = arrRadius[mIdx] * cosf(angle);
+			arrPositions[3 * mIdx + 1] = 1.0f;
+			arrPositions[3 * mIdx + 2] = arrRadius[mIdx] * sinf(angle);
+			arrMissing[mIdx] = (random(rng) < 0.05f);
+		}
+
+		// structure-of-arrays filter
+		std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+		for (int mIdx = 0; mIdx < MARKERS; mIdx++)
+		{
+			const float* pPos = &arrPositions[3 * mIdx];
+			if (arrMissing[mIdx]) filler.setMarkerMissing(mIdx); else filler.setMarker(mIdx, pPos[0], pPos[1], pPos[2]);
+		}
+		std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+		filler.update();
+		timeUpdate += secondsSince(t1);
+		for (int mIdx = 0; mIdx < MARKERS; mIdx++)
+		{
+			float x, y, z;
+			if (filler.getPrediction(mIdx, x, y, z)) checksumArrays += x + y + z;
+		}
+		timeArrays += secondsSince(t0);
+
+		// array-of-structures filter
+		t0 = std::chrono::steady_clock::now();
+		for (int mIdx = 0; mIdx < MARKERS; mIdx++)
+		{
+			MarkerFilter& refFilter = arrFilters[mIdx];
+			refFilter.update(arrMissing[mIdx] ? nullptr : &arrPositions[3 * mIdx], MAX_GAP);
+			if (arrMissing[mIdx] && (refFilter.gapLength > 0) && (refFilter.gapLength <= MAX_GAP))
+			{
+				checksumStructs += refFilter.pos[0] + refFilter.pos[1] + refFilter.pos[2];
+			}
+		}
+		timeStructs += secondsSince(t0);
+	}
+
+	CHECK(checksumArrays != 0);
+	CHECK_CLOSE(checksumArrays, checksumStructs, 1e-3 * std::fabs(checksumStructs));
+	const double nUpdates = (double) MARKERS * FRAMES;
+	std::cout << "Structure-of-arrays update:         " << (timeUpdate  * 1e9 / nUpdates) << " ns/marker = " << (nUpdates / timeUpdate  / 1e6) << " M markers/s" << std::endl;
+	std::cout << "Structure-of-arrays with set/get:   " << (timeArrays  * 1e9 / nUpdates) << " ns/marker = " << (nUpdates / timeArrays  / 1e6) << " M markers/s" << std::endl;
+	std::cout << "Array-of-structures with branches:  " << (timeStructs * 1e9 / nUpdates) << " ns/marker = " << (nUpdates / timeStructs / 1e6) << " M markers/s" << std::endl;
+	return TEST_RESULT();
+}
@@ -0,0 +1,70 @@
+/**
+ * Measures the time for labeling frames of moving unidentified markers with growing amounts of markers.
+ * The time per marker should stay about the same, and 1000 markers must fit into a frame at 200 Hz.
+ */
+
+#include "Test.h"
+
+#include "MarkerLabeler.h"
+
+#include <random>
+#include <vector>
+
+
+/**
+ * Labels frames of markers that drift through a 4 m x 2 m x 4 m volume.
+ *
+ * @return the time per frame in seconds
+ */
+static double runLabeler(int nMarkers, int nFrames)
+{
+	std::mt19937 rng(42);
+	std::uniform_real_distribution<float> randomPosition(-2, 2);
+	std::uniform_real_distribution<float> randomVelocity(-0.005f, 0.005f);
+
+	std::vector<float> arrPositions(3 * nMarkers), arrVelocities(3 * nMarkers);
+	for (int idx = 0; idx < 3 * nMarkers; idx++)
+	{
+		arrPositions[idx]  = randomPosition(rng) * (((idx % 3) == 1) ? 0.5f : 1.0f);
+		arrVelocities[idx] = randomVelocity(rng);
+	}
+
+	MarkerLabeler labeler;
+	double time     = 0;
+	long   checksum = 0;
+	for (int frame = 0; frame < nFrames; frame++)
+	{
+		for (int idx = 0; idx < 3 * nMarkers; idx++)
+		{
+			arrPositions[idx] += arrVelocities[idx];
+		}
+
+		std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+		labeler.update(arrPositions.data(), nMarkers);
+		time += secondsSince(t0);
+
+		checksum += labeler.getMarkerID(frame % nMarkers);
+	}
+	CHECK(checksum > 0);
+	return time / nFrames;
+}
+
+
+int main()
+{
+	const int FRAMES = 1000;
+
+	for (int nMarkers = 500; nMarkers <= 8000; nMarkers *= 2)
+	{
+		double timePerFrame  = runLabeler(nMarkers, FRAMES);
+		double timePerMarker = timePerFrame / nMarkers;
+		if (nMarkers == 1000)
+		{
+			// budget of a frame at 200 Hz
+			CHECK(timePerFrame < 0.005);
+		}
+		std::cout << nMarkers << " markers: " << (timePerFrame * 1e6) << " us/frame = "
+			<< (timePerMarker * 1e9) << " ns/marker" << std::endl;
+	}
+	return TEST_RESULT();
+}
@@ -0,0 +1,145 @@
+/**
+ * Measures the time and the allocations for converting Cortex frames that the emulator emits at a high rate,
+ * once in place through the data callback and once through a copy from Cortex_GetCurrentFrame()
+ * like the callback did before.
+ *
+ * Usage: BenchmarkMoCapCortex [emulator settings, default: 4,20,40,10,20000]
+ */
+
+#include "Test.h"
+
+#include "MoCapCortex.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+
+
+// counts all allocations of the program
+// (GCC does not see that the replaced operators belong together)
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+static std::atomic<size_t> g_allocations(0);
+
+void* operator new(size_t size)
+{
+	g_allocations++;
+	void* p = malloc(size);
+	if (p == nullptr) throw std::bad_alloc();
+	return p;
+}
+
+void operator delete(void* p) noexcept         { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+
+
+// measurements of one data path, only accessed by the emulator thread until it has stopped
+struct Measurement
+{
+	int    frames;
+	double time;
+	size_t allocations;
+};
+
+static MoCapCortex* g_pCortex    = nullptr;
+static MoCapData*   g_pData      = nullptr;
+static std::mutex   g_mtxData;
+static std::mutex   g_mtxScene;
+static bool         g_refetching = false;
+static Measurement  g_measurements[2];
+
+
+// the server lock for the scene description
+std::mutex& getSceneDescriptionMutex()
+{
+	return g_mtxScene;
+}
+
+
+// converts each frame like the server does
+void signalNewFrame()
+{
+	std::lock_guard<std::mutex> lock(g_mtxData);
+	Measurement& refMeasurement = g_measurements[g_refetching ? 1 : 0];
+	size_t allocations = g_allocations;
+	std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+	bool success = g_pCortex->getFrameData(*g_pData);
+	refMeasurement.time        += secondsSince(t0);
+	refMeasurement.allocations += g_allocations - allocations;
+	if (success) refMeasurement.frames++;
+}
+
+
+/**
+ * Data handler that only signals the frame,
+ * so that getFrameData() fetches a copy with Cortex_GetCurrentFrame().
+ */
+static void refetchDataHandler(sFrameOfData* pFrameOfData)
+{
+	g_refetching = true;
+	signalNewFrame();
+	g_refetching = false;
+}
+
+
+/**
+ * Streams frames from the emulator for a while.
+ *
+ * @param refetch  <code>true</code> to replace the data callback of MoCapCortex by one that only signals frames
+ *
+ * @return the measurement of the data path
+ */
+static Measurement runCortex(const MoCapCortexConfiguration& refConfig, bool refetch)
+{
+	std::unique_ptr<MoCapData> pData(new MoCapData());
+	MoCapCortex cortex(refConfig);
+	{
+		std::lock_guard<std::mutex> lock(g_mtxData);
+		g_pCortex = &cortex;
+		g_pData   = pData.get();
+		g_measurements[0] = g_measurements[1] = Measurement();
+
+		CHECK(cortex.initialise());
+		CHECK(cortex.getSceneDescription(*pData));
+		cortex.setHandleUnknownMarkers(true);
+		if (refetch)
+		{
+			Cortex_SetDataHandlerFunc(refetchDataHandler);
+		}
+	}
+	std::this_thread::sleep_for(std::chrono::seconds(2));
+	CHECK(cortex.deinitialise());
+
+	// frames that arrived before the handler was replaced are not counted
+	return g_measurements[refetch ? 1 : 0];
+}
+
+
+static void printMeasurement(const char* czPath, const Measurement& refMeasurement)
+{
+	std::cout << czPath << ": " << refMeasurement.frames << " frames, "
+		<< (refMeasurement.time * 1e6 / refMeasurement.frames) << " us/frame = "
+		<< (refMeasurement.frames / refMeasurement.time) << " frames/s, "
+		<< ((double) refMeasurement.allocations / refMeasurement.frames) << " allocations/frame" << std::endl;
+}
+
+
+int main(int argc, char** argv)
+{
+	MoCapCortexConfiguration config;
+	config.useCortex = true;
+	CHECK(CortexEmulator_ParseSettings((argc > 1) ? argv[1] : "4,20,40,10,20000", config.emulatorSettings));
+
+	Measurement inPlace = runCortex(config, false);
+	Measurement refetch = runCortex(config, true);
+	CHECK(inPlace.frames > 0);
+	CHECK(refetch.frames > 0);
+	// apart from buffers that grow with the first frames, the callback frame is converted without allocations
+	CHECK(inPlace.allocations < (size_t) inPlace.frames / 100);
+
+	printMeasurement("Callback frame in place ", inPlace);
+	printMeasurement("Copy of the current frame", refetch);
+	return TEST_RESULT();
+}
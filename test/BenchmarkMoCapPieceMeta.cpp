@@ -0,0 +1,119 @@
+/**
+ * Measures the time for reading the frames of PieceMeta stream data responses
+ * with the scanner of the PieceMeta module
+ * compared to building the json11 structure and copying the values from it like before,
+ * for responses of a single chunk up to several megabytes.
+ */
+
+#include "Test.h"
+
+#include "MoCapPieceMeta.h"
+
+#include <cstdio>
+#include <mutex>
+#include <random>
+#include <vector>
+
+
+static std::mutex g_mtxScene;
+
+
+// not used, the benchmark only parses
+std::mutex& getSceneDescriptionMutex()
+{
+	return g_mtxScene;
+}
+
+
+void signalNewFrame()
+{
+}
+
+
+/**
+ * Builds a stream data response with positions in mm and an occasional null for a missing value.
+ */
+static std::string createResponse(int nFrames, std::mt19937& rng)
+{
+	std::uniform_real_distribution<float> random(-2000, 2000);
+	std::string response = "{\"uuid\":\"0d8c7e1c-4b6a-4a2e-9f3e-5c1d2b3a4f5e\",\"title\":\"x\",\"group\":\"LFHD\",\"fps\":100,\"frames\":[";
+	char value[32];
+	for (int fIdx = 0; fIdx < nFrames; fIdx++)
+	{
+		if (fIdx > 0) response += ',';
+		if (rng() % 100 == 0)
+		{
+			response += "null";
+		}
+		else
+		{
+			snprintf(value, sizeof(value), "%.7g", random(rng));
+			response += value;
+		}
+	}
+	response += "]}";
+	return response;
+}
+
+
+/**
+ * Reads the frames like the PieceMeta module did before: json11 structure, then copying each value.
+ *
+ * @return the amount of values written, or -1 if the response could not be parsed
+ */
+static int parseFramesJson11(const std::string& response, float* pData, int maxCount)
+{
+	std::string errorMsg;
+	json11::Json json = json11::Json::parse(response, errorMsg);
+	if (!errorMsg.empty() || !json.is_object()) return -1;
+
+	const std::vector<json11::Json>& frames = json["frames"].array_items();
+	int nFrames = std::min((int) frames.size(), maxCount);
+	for (int fIdx = 0; fIdx < nFrames; fIdx++)
+	{
+		pData[fIdx] = (float) frames[fIdx].number_value();
+	}
+	return nFrames;
+}
+
+
+int main()
+{
+	const int TOTAL_VALUES = 5000000; // per response size
+	const int arrSizes[]   = { 6000, 200000, 1000000 };
+
+	std::mt19937 rng(42);
+	for (int nFrames : arrSizes)
+	{
+		std::string response = createResponse(nFrames, rng);
+		std::vector<float> arrScanner(nFrames), arrJson11(nFrames);
+		int repetitions = std::max(1, TOTAL_VALUES / nFrames);
+
+		int nScanner = 0;
+		std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+		for (int rIdx = 0; rIdx < repetitions; rIdx++)
+		{
+			nScanner = MoCapPieceMeta::parseFrames(response, arrScanner.data(), nFrames);
+		}
+		double timeScanner = secondsSince(t0);
+
+		int nJson11 = 0;
+		t0 = std::chrono::steady_clock::now();
+		for (int rIdx = 0; rIdx < repetitions; rIdx++)
+		{
+			nJson11 = parseFramesJson11(response, arrJson11.data(), nFrames);
+		}
+		double timeJson11 = secondsSince(t0);
+
+		CHECK(nScanner == nFrames);
+		CHECK(nJson11 == nFrames);
+		CHECK(arrScanner == arrJson11);
+
+		const double nValues = (double) nFrames * repetitions;
+		const double nBytes  = (double) response.length() * repetitions;
+		std::cout << nFrames << " frames (" << (response.length() >> 10) << "kB):" << std::endl;
+		std::cout << "  Scanner: " << (timeScanner * 1e9 / nValues) << " ns/value = " << (nBytes / timeScanner / 1e6) << " MB/s" << std::endl;
+		std::cout << "  json11:  " << (timeJson11  * 1e9 / nValues) << " ns/value = " << (nBytes / timeJson11  / 1e6) << " MB/s" << std::endl;
+	}
+	return TEST_RESULT();
+}
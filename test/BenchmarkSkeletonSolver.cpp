@@ -0,0 +1,99 @@
+/**
+ * Measures the time for solving the Kinect skeleton per frame,
+ * compared to the offset and length helpers that MoCapKinect used before the solver,
+ * which received the whole skeleton data by value for every bone.
+ */
+
+#include "Test.h"
+
+#include "KinectSkeleton.h"
+
+#include <cstdint>
+
+
+// layout of NUI_SKELETON_DATA
+struct KinectSkeletonData
+{
+	int32_t  eTrackingState;
+	uint32_t dwTrackingID;
+	uint32_t dwEnrollmentIndex;
+	uint32_t dwUserIndex;
+	float    Position[4];
+	float    SkeletonPositions[JOINT_COUNT][4];
+	int32_t  eSkeletonPositionTrackingState[JOINT_COUNT];
+	uint32_t dwQualityFlags;
+};
+
+
+// distance between two joints of a skeleton that is passed by value like before
+// (not inlined, because the compiler could then skip the copy, which it did not for the MoCapKinect members)
+__attribute__((noinline)) static float calculateDistance(int joint1, int joint2, KinectSkeletonData skeleton)
+{
+	const float* p1 = skeleton.SkeletonPositions[joint1];
+	const float* p2 = skeleton.SkeletonPositions[joint2];
+	float x = p1[0] - p2[0];
+	float y = p1[1] - p2[1];
+	float z = p1[2] - p2[2];
+	return sqrtf(x * x + y * y + z * z);
+}
+
+
+int main()
+{
+	const int FRAMES = 200000;
+
+	// a user turning around and waving
+	std::vector<Vector3D> arrPoses(JOINT_COUNT * 360);
+	for (int pIdx = 0; pIdx < 360; pIdx++)
+	{
+		Vector3D* pJoints = &arrPoses[JOINT_COUNT * pIdx];
+		getRestPose(pJoints);
+		float angle = pIdx * 3.14159265f / 180;
+		pJoints[HAND_RIGHT].set(0.25f + 0.1f * cosf(angle), 1.6f, 1.9f + 0.1f * sinf(angle));
+		rotatePose(pJoints, Quaternion(0, 1, 0, angle));
+	}
+
+	// solver
+	SkeletonSolver solver = createKinectSolver();
+	double checksumSolver = 0;
+	std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+	for (int fIdx = 0; fIdx < FRAMES; fIdx++)
+	{
+		solver.solve(&arrPoses[JOINT_COUNT * (fIdx % 360)]);
+		for (int bIdx = 0; bIdx < KINECT_BONE_COUNT; bIdx++)
+		{
+			checksumSolver += solver.getOffset(bIdx) + solver.getLength(bIdx);
+		}
+	}
+	double timeSolver = secondsSince(t0);
+
+	// offsets and lengths with the skeleton data by value
+	std::vector<KinectSkeletonData> arrSkeletons(360);
+	for (int pIdx = 0; pIdx < 360; pIdx++)
+	{
+		for (int jIdx = 0; jIdx < JOINT_COUNT; jIdx++)
+		{
+			const Vector3D& refJoint = arrPoses[JOINT_COUNT * pIdx + jIdx];
+			float* pPosition = arrSkeletons[pIdx].SkeletonPositions[jIdx];
+			pPosition[0] = refJoint.x; pPosition[1] = refJoint.y; pPosition[2] = refJoint.z; pPosition[3] = 1;
+		}
+	}
+	double checksumCopies = 0;
+	t0 = std::chrono::steady_clock::now();
+	for (int fIdx = 0; fIdx < FRAMES; fIdx++)
+	{
+		const KinectSkeletonData& refSkeleton = arrSkeletons[fIdx % 360];
+		for (int bIdx = 0; bIdx < KINECT_BONE_COUNT; bIdx++)
+		{
+			const sSkeletonBone& bone = KINECT_BONES[bIdx];
+			checksumCopies += calculateDistance(bone.jointPoint, bone.jointParent, refSkeleton)
+			                + calculateDistance(bone.jointEnd,   bone.jointPoint,  refSkeleton);
+		}
+	}
+	double timeCopies = secondsSince(t0);
+
+	CHECK_CLOSE(checksumSolver, checksumCopies, 1e-6 * checksumCopies);
+	std::cout << "Solver (orientations, offsets, lengths): " << (timeSolver * 1e9 / FRAMES) << " ns/skeleton = " << (FRAMES / timeSolver / 1e6) << " M skeletons/s" << std::endl;
+	std::cout << "Offsets and lengths with copies:         " << (timeCopies * 1e9 / FRAMES) << " ns/skeleton = " << (FRAMES / timeCopies / 1e6) << " M skeletons/s" << std::endl;
+	return TEST_RESULT();
+}
@@ -0,0 +1,144 @@
+/**
+ * Measures how many packets per second XBeeCoordinator::receive() handles
+ * and how many allocations it makes, by replaying a captured stream through the serial port.
+ *
+ * Usage: BenchmarkXBeeCoordinator [captureFile]
+ *
+ * Without a capture file (e.g., recorded from a real coordinator with "cat /dev/ttyUSB0 > capture.bin"),
+ * the stream is captured from the emulator while its joysticks change their inputs.
+ */
+
+#include "Test.h"
+
+#include "XBeeEmulator.h"
+#include "XBeeDevice.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <new>
+#include <thread>
+
+
+// counts all allocations of the program
+static std::atomic<size_t> g_allocations(0);
+
+void* operator new(size_t size)
+{
+	g_allocations++;
+	void* p = malloc(size);
+	if (p == nullptr) throw std::bad_alloc();
+	return p;
+}
+
+void operator delete(void* p) noexcept         { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+
+
+/**
+ * Captures IO data samples from the emulator while the coordinator receives them.
+ */
+static std::vector<uint8_t> captureSamples(XBeeEmulator& refEmulator, XBeeCoordinator& refCoordinator, int nDevices, uint64_t nSamples)
+{
+	std::atomic<bool> running(true);
+	std::thread receiver([&] { while (running) refCoordinator.receive(); });
+
+	refEmulator.startCapture();
+	uint64_t start = refEmulator.getSentSamples();
+	for (int i = 0; refEmulator.getSentSamples() - start < nSamples; i++)
+	{
+		// alternate the button and axis pins of the devices
+		refEmulator.setInputState(i % nDevices, (i & 1) ? 0x00FC : 0x0048);
+		if (i % 64 == 63) std::this_thread::yield();
+	}
+	std::vector<uint8_t> arrStream = refEmulator.stopCapture();
+
+	running = false;
+	receiver.join();
+	return arrStream;
+}
+
+
+/**
+ * Counts the frames in a captured stream.
+ */
+static uint64_t countFrames(const std::vector<uint8_t>& arrStream)
+{
+	XBeeFrameReader reader;
+	XBeeReadBuffer  frame;
+	uint64_t        nFrames = 0;
+	size_t          pos     = 0;
+	while (pos < arrStream.size())
+	{
+		size_t   space;
+		uint8_t* pWrite = reader.getWritePointer(space);
+		size_t   nBytes = std::min(space, arrStream.size() - pos);
+		std::copy(arrStream.begin() + pos, arrStream.begin() + pos + nBytes, pWrite);
+		reader.commitWrite(nBytes);
+		pos += nBytes;
+		while (reader.extractFrame(frame)) nFrames++;
+	}
+	return nFrames;
+}
+
+
+int main(int argc, char** argv)
+{
+	const int nDevices = 8;
+	XBeeEmulatorSettings settings;
+	settings.nDevices   = nDevices;
+	settings.sampleRate = 0;
+	XBeeEmulator emulator(settings);
+	CHECK(emulator.start());
+	SerialPort      port(emulator.getDeviceName());
+	XBeeCoordinator coordinator(port);
+
+	std::vector<uint8_t> arrStream;
+	if (argc > 1)
+	{
+		std::ifstream file(argv[1], std::ios::binary);
+		arrStream.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	}
+	else
+	{
+		arrStream = captureSamples(emulator, coordinator, nDevices, 200000);
+	}
+	uint64_t nFrames = countFrames(arrStream);
+	CHECK(nFrames > 0);
+
+	// replay while receiving with the coordinator
+	std::atomic<bool> replayed(false);
+	std::thread replayer([&] { CHECK(emulator.replay(arrStream)); replayed = true; });
+
+	uint64_t nPackets    = 0;
+	uint64_t nSamples    = 0;
+	uint64_t checksum    = 0;
+	size_t   allocations = g_allocations;
+	std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+	while ((nPackets < nFrames) && !(replayed && (secondsSince(t0) > 10)))
+	{
+		const XBeePacket_Receive* pPacket = coordinator.receive();
+		if (pPacket != nullptr)
+		{
+			nPackets++;
+			if (pPacket->getFrameTypeID() == XBeePacket_IO_DataSample::FRAME_TYPE_ID)
+			{
+				const XBeePacket_IO_DataSample* pSample = (const XBeePacket_IO_DataSample*) pPacket;
+				checksum += pSample->getNetworkAddress() + pSample->getDigitalInputState();
+				nSamples++;
+			}
+		}
+	}
+	double time = secondsSince(t0);
+	allocations = g_allocations - allocations;
+	replayer.join();
+
+	CHECK(nPackets == nFrames);
+	CHECK(allocations == 0);
+	std::cout << "Replayed " << arrStream.size() << " bytes: "
+		<< nPackets << " of " << nFrames << " packets (" << nSamples << " IO samples) in " << time << "s = "
+		<< (nPackets / time) << " packets/s, "
+		<< allocations << " allocations (checksum " << checksum << ")" << std::endl;
+	return TEST_RESULT();
+}
@@ -0,0 +1,79 @@
+/**
+ * Measures the time and the allocations for parsing received XBee frames:
+ * a node discovery response, a remote AT command response, and an IO data sample.
+ */
+
+#include "Test.h"
+
+#include "XBeeFrames.h"
+#include "XBeePacket.h"
+
+#include <cstdlib>
+#include <new>
+
+
+// counts all allocations of the program
+static size_t g_allocations = 0;
+
+void* operator new(size_t size)
+{
+	g_allocations++;
+	void* p = malloc(size);
+	if (p == nullptr) throw std::bad_alloc();
+	return p;
+}
+
+void operator delete(void* p) noexcept         { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+
+
+int main()
+{
+	XBeeReadBuffer bufSample, bufDiscovery, bufRemote;
+	CHECK(receiveFrame(bufSample,    PAYLOAD_IO_SAMPLE));
+	CHECK(receiveFrame(bufDiscovery, PAYLOAD_DISCOVERY_RESPONSE));
+	CHECK(receiveFrame(bufRemote,    PAYLOAD_REMOTE_RESPONSE));
+
+	XBeePacket_IO_DataSample            sample;
+	XBeePacket_AT_CommandResponse       discovery;
+	XBeePacket_RemoteAT_CommandResponse remote;
+	CHECK(sample.unmarshal(bufSample));
+	CHECK(discovery.unmarshal(bufDiscovery));
+	CHECK(remote.unmarshal(bufRemote));
+
+	// check the parsed content once
+	const XBeeReadView& refData = discovery.getRawData();
+	CHECK(refData.getUInt16At(0) == 0x1234);
+	CHECK(refData.getNextUInt64() == 0x0013A20040112233ull);
+	CHECK(refData.getNextStringView() == "Joystick 1");
+	CHECK(refData.getNextUInt16() == 0xFFFE);
+	CHECK(refData.getNextByte() == 1);
+	CHECK(sample.getSerialNumber() == 0x0102030405060708ull);
+	CHECK(sample.getNetworkAddress() == 0x1234);
+	CHECK(sample.getDigitalInputMask() == 0x001F);
+	CHECK(sample.getDigitalInputState() == 0x0015);
+	CHECK(remote.getCommand() == "DB");
+	CHECK(remote.getRawData().getByteAt(0) == 0x2D);
+
+	const int ITERATIONS = 2000000;
+	size_t   allocations = g_allocations;
+	uint64_t checksum    = 0;
+	std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+	for (int i = 0; i < ITERATIONS; i++)
+	{
+		sample.unmarshal(bufSample);
+		discovery.unmarshal(bufDiscovery);
+		remote.unmarshal(bufRemote);
+		const XBeeReadView& refView = discovery.getRawData();
+		checksum += sample.getSerialNumber() + sample.getDigitalInputState()
+			+ refView.getUInt16At(0) + refView.getNextUInt64() + refView.getNextStringView().size() + refView.getNextUInt16()
+			+ remote.getRawData().getByteAt(0);
+	}
+	double time = secondsSince(t0);
+	allocations = g_allocations - allocations;
+
+	CHECK(allocations == 0);
+	std::cout << "Parsing 3 frames: " << (time * 1e9 / ITERATIONS) << " ns, "
+		<< ((double) allocations / ITERATIONS) << " allocations (checksum " << checksum << ")" << std::endl;
+	return TEST_RESULT();
+}
@@ -0,0 +1,211 @@
+/**
+ * Minimal HTTP server on the loopback interface as a stand-in for web APIs in the tests.
+ * Every connection is answered by its own thread with a single response (HTTP/1.0 style),
+ * so that concurrent requests of the module under test can be observed.
+ */
+
+#pragma once
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+class HttpServer
+{
+public:
+	/**
+	 * Function that answers a request.
+	 * Is called from several threads at the same time.
+	 *
+	 * @param path     the requested path including the query (e.g., "/streams/1.json?from=0&to=100")
+	 * @param content  the string to write the response content into
+	 *
+	 * @return the HTTP status code of the response
+	 */
+	typedef std::function<int(const std::string& path, std::string& content)> Handler;
+
+	HttpServer(Handler handler, int delayMs = 0);
+	~HttpServer();
+
+	/**
+	 * Starts listening on a free port of the loopback interface.
+	 *
+	 * @return <code>true</code> if the server is running, <code>false</code> if not
+	 */
+	bool start();
+
+	void stop();
+
+	std::string getBaseURL() const;
+	int         getRequestCount() const;
+	int         getMaxConnections() const;
+
+private:
+	void acceptThread();
+	void connectionThread(int fdConnection);
+
+	Handler                  handler;
+	int                      delayMs;     // time each response is delayed, so that concurrent requests overlap
+	int                      fdListen;
+	int                      port;
+	std::thread              acceptor;
+	std::vector<std::thread> connections;
+	std::mutex               mtxConnections;
+	std::atomic<bool>        stopping;
+	std::atomic<int>         requestCount;
+	std::atomic<int>         activeConnections;
+	std::atomic<int>         maxConnections;
+};
+
+
+
+inline HttpServer::HttpServer(Handler handler, int delayMs) :
+	handler(handler),
+	delayMs(delayMs),
+	fdListen(-1),
+	port(0),
+	stopping(false),
+	requestCount(0),
+	activeConnections(0),
+	maxConnections(0)
+{
+	// nothing else to do
+}
+
+
+inline HttpServer::~HttpServer()
+{
+	stop();
+}
+
+
+inline bool HttpServer::start()
+{
+	fdListen = socket(AF_INET, SOCK_STREAM, 0);
+	if (fdListen < 0) return false;
+
+	sockaddr_in address = {};
+	address.sin_family      = AF_INET;
+	address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	address.sin_port        = 0; // any free port
+	socklen_t length = sizeof(address);
+	if ((bind(fdListen, (sockaddr*) &address, sizeof(address)) != 0) ||
+	    (listen(fdListen, 64) != 0) ||
+	    (getsockname(fdListen, (sockaddr*) &address, &length) != 0))
+	{
+		close(fdListen);
+		fdListen = -1;
+		return false;
+	}
+	port = ntohs(address.sin_port);
+
+	stopping = false;
+	acceptor = std::thread(&HttpServer::acceptThread, this);
+	return true;
+}
+
+
+inline void HttpServer::stop()
+{
+	if (fdListen < 0) return;
+
+	// unblock accept()
+	stopping = true;
+	shutdown(fdListen, SHUT_RDWR);
+	acceptor.join();
+	close(fdListen);
+	fdListen = -1;
+
+	std::lock_guard<std::mutex> lock(mtxConnections);
+	for (auto tIter = connections.begin(); tIter != connections.end(); tIter++)
+	{
+		tIter->join();
+	}
+	connections.clear();
+}
+
+
+inline std::string HttpServer::getBaseURL() const
+{
+	return "http://127.0.0.1:" + std::to_string(port) + "/";
+}
+
+
+inline int HttpServer::getRequestCount() const
+{
+	return requestCount;
+}
+
+
+inline int HttpServer::getMaxConnections() const
+{
+	return maxConnections;
+}
+
+
+inline void HttpServer::acceptThread()
+{
+	while (!stopping)
+	{
+		int fdConnection = accept(fdListen, NULL, NULL);
+		if (fdConnection < 0) break;
+
+		std::lock_guard<std::mutex> lock(mtxConnections);
+		connections.push_back(std::thread(&HttpServer::connectionThread, this, fdConnection));
+	}
+}
+
+
+inline void HttpServer::connectionThread(int fdConnection)
+{
+	int active = ++activeConnections;
+	int maximum = maxConnections;
+	while ((active > maximum) && !maxConnections.compare_exchange_weak(maximum, active)) {}
+
+	// read the request header
+	std::string request;
+	char        buffer[4096];
+	while (request.find("\r\n\r\n") == std::string::npos)
+	{
+		ssize_t nBytes = recv(fdConnection, buffer, sizeof(buffer), 0);
+		if (nBytes <= 0) break;
+		request.append(buffer, nBytes);
+	}
+
+	// request line: "GET <path> HTTP/1.0"
+	int         status = 400;
+	std::string content;
+	size_t      pathStart = request.find(' ');
+	size_t      pathEnd   = (pathStart == std::string::npos) ? std::string::npos : request.find(' ', pathStart + 1);
+	if ((request.compare(0, 4, "GET ") == 0) && (pathEnd != std::string::npos))
+	{
+		requestCount++;
+		std::this_thread::sleep_for(std::chrono::milliseconds(delayMs));
+		status = handler(request.substr(pathStart + 1, pathEnd - pathStart - 1), content);
+	}
+
+	std::string response =
+		"HTTP/1.0 " + std::to_string(status) + ((status == 200) ? " OK" : " Error") + "\r\n" +
+		"Content-Type: application/json\r\n" +
+		"Content-Length: " + std::to_string(content.length()) + "\r\n" +
+		"Connection: close\r\n\r\n" + content;
+	size_t sent = 0;
+	while (sent < response.length())
+	{
+		ssize_t nBytes = send(fdConnection, response.c_str() + sent, response.length() - sent, MSG_NOSIGNAL);
+		if (nBytes <= 0) break;
+		sent += nBytes;
+	}
+
+	activeConnections--;
+	close(fdConnection);
+}
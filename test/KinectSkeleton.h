@@ -0,0 +1,101 @@
+/**
+ * Bone table and poses of the Kinect skeleton for the skeleton solver tests and benchmarks.
+ * The joint indices and bones are the same as in MoCapKinect.
+ */
+
+#pragma once
+
+#include "SkeletonSolver.h"
+
+
+// joint indices of the Kinect SDK (NUI_SKELETON_POSITION_INDEX)
+enum KinectJoint
+{
+	HIP_CENTER, SPINE, SHOULDER_CENTER, HEAD,
+	SHOULDER_LEFT,  ELBOW_LEFT,  WRIST_LEFT,  HAND_LEFT,
+	SHOULDER_RIGHT, ELBOW_RIGHT, WRIST_RIGHT, HAND_RIGHT,
+	HIP_LEFT,  KNEE_LEFT,  ANKLE_LEFT,  FOOT_LEFT,
+	HIP_RIGHT, KNEE_RIGHT, ANKLE_RIGHT, FOOT_RIGHT,
+	JOINT_COUNT
+};
+
+
+const sSkeletonBone KINECT_BONES[]
+{
+	{ "Hip",           -1, HIP_CENTER,      HIP_CENTER,      HIP_CENTER },
+	{ "Spine",          0, HIP_CENTER,      HIP_CENTER,      SPINE },
+	{ "Neck" ,          1, HIP_CENTER,      SPINE,           SHOULDER_CENTER },
+	{ "Head",           2, SPINE,           SHOULDER_CENTER, HEAD },
+	{ "ClavicleLeft",   2, SPINE,           SHOULDER_CENTER, SHOULDER_LEFT },
+	{ "UpperArmLeft",   4, SHOULDER_CENTER, SHOULDER_LEFT,   ELBOW_LEFT },
+	{ "LowerArmLeft",   5, SHOULDER_LEFT,   ELBOW_LEFT,      WRIST_LEFT },
+	{ "HandLeft",       6, ELBOW_LEFT,      WRIST_LEFT,      HAND_LEFT },
+	{ "ClavicleRight",  2, SPINE,           SHOULDER_CENTER, SHOULDER_RIGHT },
+	{ "UpperArmRight",  8, SHOULDER_CENTER, SHOULDER_RIGHT,  ELBOW_RIGHT },
+	{ "LowerArmRight",  9, SHOULDER_RIGHT,  ELBOW_RIGHT,     WRIST_RIGHT },
+	{ "HandRight",     10, ELBOW_RIGHT,     WRIST_RIGHT,     HAND_RIGHT },
+	{ "HipLeft",        0, HIP_CENTER,      HIP_CENTER,      HIP_LEFT },
+	{ "UpperLegLeft",  12, HIP_CENTER,      HIP_LEFT,        KNEE_LEFT },
+	{ "LowerLegLeft",  13, HIP_LEFT,        KNEE_LEFT,       ANKLE_LEFT },
+	{ "FootLeft",      14, KNEE_LEFT,       ANKLE_LEFT,      FOOT_LEFT },
+	{ "HipRight",       0, HIP_CENTER,      HIP_CENTER,      HIP_RIGHT },
+	{ "UpperLegRight", 16, HIP_CENTER,      HIP_RIGHT,       KNEE_RIGHT },
+	{ "LowerLegRight", 17, HIP_RIGHT,       KNEE_RIGHT,      ANKLE_RIGHT },
+	{ "FootRight",     18, KNEE_RIGHT,      ANKLE_RIGHT,     FOOT_RIGHT },
+};
+
+const int KINECT_BONE_COUNT = sizeof(KINECT_BONES) / sizeof(KINECT_BONES[0]);
+
+
+/**
+ * Creates a solver for the Kinect bones with the same root joints as MoCapKinect.
+ */
+inline SkeletonSolver createKinectSolver()
+{
+	SkeletonSolver solver(KINECT_BONES, KINECT_BONE_COUNT);
+	solver.setRootJoints(SPINE, HIP_LEFT, HIP_RIGHT);
+	return solver;
+}
+
+
+/**
+ * Sets the joints of a user standing 2 m in front of the sensor and facing it,
+ * with slightly bent arms and legs (Kinect coordinates: the left side of the user is at -X).
+ */
+inline void getRestPose(Vector3D arrJoints[JOINT_COUNT])
+{
+	arrJoints[HIP_CENTER]     .set( 0.00f, 0.90f, 2.00f);
+	arrJoints[SPINE]          .set( 0.00f, 1.20f, 2.00f);
+	arrJoints[SHOULDER_CENTER].set( 0.00f, 1.45f, 2.00f);
+	arrJoints[HEAD]           .set( 0.00f, 1.65f, 1.98f);
+	arrJoints[SHOULDER_LEFT]  .set(-0.18f, 1.42f, 2.00f);
+	arrJoints[ELBOW_LEFT]     .set(-0.22f, 1.15f, 2.02f);
+	arrJoints[WRIST_LEFT]     .set(-0.24f, 0.90f, 1.92f);
+	arrJoints[HAND_LEFT]      .set(-0.25f, 0.82f, 1.90f);
+	arrJoints[SHOULDER_RIGHT] .set( 0.18f, 1.42f, 2.00f);
+	arrJoints[ELBOW_RIGHT]    .set( 0.22f, 1.15f, 2.02f);
+	arrJoints[WRIST_RIGHT]    .set( 0.24f, 0.90f, 1.92f);
+	arrJoints[HAND_RIGHT]     .set( 0.25f, 0.82f, 1.90f);
+	arrJoints[HIP_LEFT]       .set(-0.10f, 0.85f, 2.00f);
+	arrJoints[KNEE_LEFT]      .set(-0.11f, 0.48f, 1.97f);
+	arrJoints[ANKLE_LEFT]     .set(-0.11f, 0.08f, 2.02f);
+	arrJoints[FOOT_LEFT]      .set(-0.11f, 0.03f, 1.90f);
+	arrJoints[HIP_RIGHT]      .set( 0.10f, 0.85f, 2.00f);
+	arrJoints[KNEE_RIGHT]     .set( 0.11f, 0.48f, 1.97f);
+	arrJoints[ANKLE_RIGHT]    .set( 0.11f, 0.08f, 2.02f);
+	arrJoints[FOOT_RIGHT]     .set( 0.11f, 0.03f, 1.90f);
+}
+
+
+/**
+ * Rotates a pose around its hip centre.
+ */
+inline void rotatePose(Vector3D arrJoints[JOINT_COUNT], const Quaternion& refRotation)
+{
+	const Vector3D centre = arrJoints[HIP_CENTER];
+	for (int jIdx = 0; jIdx < JOINT_COUNT; jIdx++)
+	{
+		Vector3D offset = refRotation.rotate(arrJoints[jIdx] - centre);
+		arrJoints[jIdx].set(centre.x + offset.x, centre.y + offset.y, centre.z + offset.z);
+	}
+}
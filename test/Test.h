@@ -0,0 +1,38 @@
+/**
+ * Minimal helpers for the test programs.
+ * Each test program is a standalone executable that prints its measurements
+ * and returns a non-zero exit code if any check failed.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+
+static int g_testFailures = 0;
+
+/**
+ * Checks a condition and reports the location if it does not hold.
+ */
+#define CHECK(x) { if (!(x)) { std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " #x << std::endl; g_testFailures++; } }
+
+/**
+ * Checks that two values differ by no more than a tolerance.
+ */
+#define CHECK_CLOSE(a, b, eps) { double _a = (a), _b = (b); if (!(std::fabs(_a - _b) <= (eps))) { std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " #a " = " << _a << ", " #b " = " << _b << std::endl; g_testFailures++; } }
+
+/**
+ * Prints the result of the test program and returns its exit code.
+ */
+#define TEST_RESULT() ((g_testFailures == 0) ? (std::cout << "PASSED" << std::endl, 0) : (std::cout << "FAILED (" << g_testFailures << " checks)" << std::endl, 1))
+
+
+/**
+ * Gets the time in seconds that has passed since a point in time.
+ */
+inline double secondsSince(std::chrono::steady_clock::time_point t0)
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
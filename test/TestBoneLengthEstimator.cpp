@@ -0,0 +1,162 @@
+/**
+ * Tests the bone length estimator:
+ * convergence to the mean of the measurements, freezing,
+ * adaptation to changes after convergence, reset, and bones that cannot be tracked.
+ */
+
+#include "Test.h"
+
+#include "BoneLengthEstimator.h"
+
+#include <random>
+
+
+static const int BONES  = 3;
+static const int FRAMES = 90;
+
+
+/**
+ * Adds noisy measurements around 0.1 * (bone + 1) for the offset and 0.2 * (bone + 1) for the length to some bones.
+ *
+ * @return the mean of the offset measurements of the first bone
+ */
+static double addMeasurements(BoneLengthEstimator& refEstimator, int nFrames, int firstBone, int lastBone, std::mt19937& rng)
+{
+	std::uniform_real_distribution<float> noise(-0.02f, 0.02f);
+	double sum = 0;
+	for (int fIdx = 0; fIdx < nFrames; fIdx++)
+	{
+		for (int bIdx = firstBone; bIdx <= lastBone; bIdx++)
+		{
+			float offset = 0.1f * (bIdx + 1) + noise(rng);
+			float length = 0.2f * (bIdx + 1) + noise(rng);
+			refEstimator.addMeasurement(bIdx, offset, length);
+			if (bIdx == firstBone) sum += offset;
+		}
+	}
+	return sum / nFrames;
+}
+
+
+/**
+ * Averages the measurements until all bones are converged, then ignores further measurements.
+ */
+static void testConvergence()
+{
+	std::mt19937 rng(1);
+	BoneLengthEstimator estimator(BONES, FRAMES);
+	for (int bIdx = 0; bIdx < BONES; bIdx++) CHECK(!estimator.hasEstimate(bIdx));
+
+	// the last bone is measured later than the others
+	double mean = addMeasurements(estimator, FRAMES, 0, BONES - 2, rng);
+	CHECK_CLOSE(estimator.getOffset(0), mean, 1e-5);
+	CHECK(estimator.hasEstimate(0));
+	CHECK(!estimator.hasEstimate(BONES - 1));
+	CHECK(!estimator.isFrozen());
+
+	addMeasurements(estimator, FRAMES - 1, BONES - 1, BONES - 1, rng);
+	CHECK(estimator.hasEstimate(BONES - 1));
+	CHECK(!estimator.isFrozen());
+	addMeasurements(estimator, 1, BONES - 1, BONES - 1, rng);
+	CHECK(estimator.isFrozen());
+	for (int bIdx = 0; bIdx < BONES; bIdx++)
+	{
+		CHECK_CLOSE(estimator.getOffset(bIdx), 0.1 * (bIdx + 1), 0.01);
+		CHECK_CLOSE(estimator.getLength(bIdx), 0.2 * (bIdx + 1), 0.01);
+	}
+
+	// frozen: measurements do not change the estimate
+	float offset = estimator.getOffset(0);
+	float length = estimator.getLength(0);
+	estimator.addMeasurement(0, 5, 5);
+	CHECK(estimator.getOffset(0) == offset);
+	CHECK(estimator.getLength(0) == length);
+}
+
+
+/**
+ * Follows a change after convergence with the adaptation rate, and never freezes.
+ */
+static void testAdaptation()
+{
+	const float RATE = 0.1f;
+	BoneLengthEstimator estimator(1, FRAMES, RATE);
+	for (int fIdx = 0; fIdx < FRAMES; fIdx++) estimator.addMeasurement(0, 1, 2);
+	CHECK_CLOSE(estimator.getOffset(0), 1, 1e-6);
+	CHECK(!estimator.isFrozen());
+
+	// the distance to the new value shrinks by the rate with every measurement
+	const int STEPS = 10;
+	for (int fIdx = 0; fIdx < STEPS; fIdx++) estimator.addMeasurement(0, 2, 4);
+	double remaining = std::pow(1 - RATE, STEPS);
+	CHECK_CLOSE(estimator.getOffset(0), 2 - 1 * remaining, 1e-5);
+	CHECK_CLOSE(estimator.getLength(0), 4 - 2 * remaining, 1e-5);
+	CHECK(!estimator.isFrozen());
+}
+
+
+/**
+ * Discards the estimates, e.g., for a new user.
+ */
+static void testReset()
+{
+	std::mt19937 rng(2);
+	BoneLengthEstimator estimator(BONES, FRAMES);
+	addMeasurements(estimator, FRAMES, 0, BONES - 1, rng);
+	CHECK(estimator.isFrozen());
+
+	estimator.reset();
+	CHECK(!estimator.isFrozen());
+	for (int bIdx = 0; bIdx < BONES; bIdx++)
+	{
+		CHECK(!estimator.hasEstimate(bIdx));
+		CHECK(estimator.getOffset(bIdx) == 0);
+		CHECK(estimator.getLength(bIdx) == 0);
+	}
+
+	// a new user is averaged from scratch
+	for (int fIdx = 0; fIdx < FRAMES; fIdx++)
+	{
+		for (int bIdx = 0; bIdx < BONES; bIdx++) estimator.addMeasurement(bIdx, 0.5f, 0.7f);
+	}
+	CHECK(estimator.isFrozen());
+	CHECK_CLOSE(estimator.getOffset(1), 0.5, 1e-6);
+	CHECK_CLOSE(estimator.getLength(1), 0.7, 1e-6);
+}
+
+
+/**
+ * Freezes without the bones that cannot be tracked, also after a reset.
+ */
+static void testExcludedBones()
+{
+	std::mt19937 rng(3);
+	BoneLengthEstimator estimator(BONES, FRAMES);
+
+	// excluded after it has been measured and converged
+	addMeasurements(estimator, FRAMES, BONES - 1, BONES - 1, rng);
+	estimator.excludeBone(BONES - 1);
+	estimator.excludeBone(BONES - 1);
+	CHECK(!estimator.hasEstimate(BONES - 1));
+	CHECK(!estimator.isFrozen());
+
+	addMeasurements(estimator, FRAMES, 0, BONES - 1, rng);
+	CHECK(estimator.isFrozen());
+	CHECK(!estimator.hasEstimate(BONES - 1));
+
+	estimator.reset();
+	CHECK(!estimator.isFrozen());
+	addMeasurements(estimator, FRAMES, 0, BONES - 2, rng);
+	CHECK(estimator.isFrozen());
+	CHECK(!estimator.hasEstimate(BONES - 1));
+}
+
+
+int main()
+{
+	testConvergence();
+	testAdaptation();
+	testReset();
+	testExcludedBones();
+	return TEST_RESULT();
+}
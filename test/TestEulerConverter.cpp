@@ -0,0 +1,134 @@
+/**
+ * Tests the batch conversion of Euler angles to quaternions
+ * against the product of the single axis quaternions for all rotation orders.
+ */
+
+#include "Test.h"
+
+#include "EulerConverter.h"
+#include "VectorMath.h"
+
+#include <random>
+
+
+// axes of the quaternion product per rotation order (see EulerOrder)
+static const int ORDER_AXES[][3] =
+{
+	{ 0, 1, 2 }, { 0, 2, 1 }, { 1, 0, 2 }, { 1, 2, 0 }, { 2, 0, 1 }, { 2, 1, 0 }
+};
+
+
+/**
+ * Converts Euler angles by multiplying the quaternions of the single axes,
+ * like MoCapCortex did before the batch conversion.
+ */
+static Quaternion convertScalar(EulerOrder order, const float arrDegrees[3])
+{
+	Quaternion rot;
+	for (int fIdx = 0; fIdx < 3; fIdx++)
+	{
+		int axis = ORDER_AXES[order][fIdx];
+		rot.mult(Quaternion(axis == 0, axis == 1, axis == 2, (float) RADIANS(arrDegrees[axis])));
+	}
+	return rot;
+}
+
+
+/**
+ * Converts random and special angles with every rotation order.
+ * The batch size is not a multiple of 4, so both the vectorised and the scalar path are used.
+ */
+static void testOrders()
+{
+	std::mt19937 rng(42);
+	std::uniform_real_distribution<float> random(-720, 720);
+
+	std::vector<float> arrAngles;
+	const float arrSpecial[] = { 0, 45, -45, 90, -90, 180, -180, 270, 360, -360, 720 };
+	for (float a : arrSpecial)
+	{
+		for (float b : arrSpecial)
+		{
+			arrAngles.insert(arrAngles.end(), { a, b, a + b });
+		}
+	}
+	while (arrAngles.size() < 3 * 1003)
+	{
+		arrAngles.push_back(random(rng));
+	}
+
+	for (int order = XYZ; order <= ZYX; order++)
+	{
+		EulerConverter converter;
+		converter.setOrder((EulerOrder) order);
+		CHECK(converter.getOrder() == order);
+		for (size_t idx = 0; idx < arrAngles.size(); idx += 3)
+		{
+			CHECK(converter.add(arrAngles[idx], arrAngles[idx + 1], arrAngles[idx + 2]) == idx / 3);
+		}
+		converter.convert();
+
+		float maxError = 0;
+		for (size_t idx = 0; idx < converter.size(); idx++)
+		{
+			Quaternion expected = convertScalar((EulerOrder) order, &arrAngles[3 * idx]);
+			float qx, qy, qz, qw;
+			converter.getQuaternion(idx, qx, qy, qz, qw);
+			maxError = std::max(maxError, std::fabs(qx - expected.x));
+			maxError = std::max(maxError, std::fabs(qy - expected.y));
+			maxError = std::max(maxError, std::fabs(qz - expected.z));
+			maxError = std::max(maxError, std::fabs(qw - expected.w));
+		}
+		CHECK(maxError < 2e-6f);
+		std::cout << getEulerOrderName((EulerOrder) order) << ": maximum error " << maxError << std::endl;
+	}
+}
+
+
+/**
+ * Checks that the half angle sine and cosine of an angle do not depend on its position in the batch.
+ */
+static void testBatchPositions()
+{
+	const float arrDegrees[] = { 10, 200, -300, 89.5f, 10, 200, -300 };
+	float arrSin[7], arrCos[7];
+	calculateHalfAngleSinCos(arrDegrees, arrSin, arrCos, 7);
+	for (int idx = 0; idx < 7; idx++)
+	{
+		CHECK_CLOSE(arrSin[idx], sin(RADIANS(arrDegrees[idx]) / 2), 1e-6);
+		CHECK_CLOSE(arrCos[idx], cos(RADIANS(arrDegrees[idx]) / 2), 1e-6);
+	}
+	for (int idx = 0; idx < 3; idx++)
+	{
+		CHECK(arrSin[idx] == arrSin[idx + 4]);
+		CHECK(arrCos[idx] == arrCos[idx + 4]);
+	}
+}
+
+
+/**
+ * Parses the names of the rotation orders.
+ */
+static void testOrderNames()
+{
+	for (int order = XYZ; order <= ZYX; order++)
+	{
+		EulerOrder parsed = XYZ;
+		CHECK(parseEulerOrder(getEulerOrderName((EulerOrder) order), parsed));
+		CHECK(parsed == order);
+	}
+	EulerOrder parsed = XYZ;
+	CHECK(parseEulerOrder("zxy", parsed));
+	CHECK(parsed == ZXY);
+	CHECK(!parseEulerOrder("XYX", parsed));
+	CHECK(parsed == ZXY);
+}
+
+
+int main()
+{
+	testOrders();
+	testBatchPositions();
+	testOrderNames();
+	return TEST_RESULT();
+}
@@ -0,0 +1,148 @@
+/**
+ * Tests the world space skeletons of the forward kinematics:
+ * the poses of a bone chain, descriptions that stay unchanged between scene changes,
+ * and the update of the descriptions when skeletons are added.
+ */
+
+#include "Test.h"
+
+#include "ForwardKinematics.h"
+#include "VectorMath.h"
+
+#include <cstring>
+#include <memory>
+
+
+/**
+ * Adds a skeleton with a chain of bones to the scene, each bone 1 unit along the Y axis of its parent.
+ */
+static void addSkeleton(MoCapData& refData, int skeletonID, int nBones)
+{
+	sSkeletonDescription* pDescr = new sSkeletonDescription();
+	snprintf(pDescr->szName, sizeof(pDescr->szName), "Skeleton%d", skeletonID);
+	pDescr->skeletonID   = skeletonID;
+	pDescr->nRigidBodies = nBones;
+	for (int bIdx = 0; bIdx < nBones; bIdx++)
+	{
+		snprintf(pDescr->RigidBodies[bIdx].szName, sizeof(pDescr->RigidBodies[bIdx].szName), "Bone%d", bIdx);
+		pDescr->RigidBodies[bIdx].ID       = bIdx + 1;
+		pDescr->RigidBodies[bIdx].parentID = bIdx; // 0: no parent
+	}
+	sDataDescription& refBlock = refData.description.arrDataDescriptions[refData.description.nDataDescriptions++];
+	refBlock.type = Descriptor_Skeleton;
+	refBlock.Data.SkeletonDescription = pDescr;
+
+	sSkeletonData& refSkeleton = refData.frame.Skeletons[refData.frame.nSkeletons++];
+	refSkeleton.skeletonID    = skeletonID;
+	refSkeleton.nRigidBodies  = nBones;
+	refSkeleton.RigidBodyData = new sRigidBodyData[nBones]();
+	for (int bIdx = 0; bIdx < nBones; bIdx++)
+	{
+		sRigidBodyData& refBone = refSkeleton.RigidBodyData[bIdx];
+		refBone.ID     = bIdx + 1;
+		refBone.y      = (bIdx == 0) ? 0.0f : 1.0f;
+		refBone.qw     = 1;
+		refBone.params = STATUS_TRACKED;
+	}
+}
+
+
+/**
+ * Rotates all bones of a skeleton by an angle around the Z axis relative to their parent.
+ */
+static void setBoneRotations(MoCapData& refData, int sIdx, float angle)
+{
+	Quaternion rotation(0, 0, 1, angle);
+	sSkeletonData& refSkeleton = refData.frame.Skeletons[sIdx];
+	for (int bIdx = 0; bIdx < refSkeleton.nRigidBodies; bIdx++)
+	{
+		refSkeleton.RigidBodyData[bIdx].qx = rotation.x;
+		refSkeleton.RigidBodyData[bIdx].qy = rotation.y;
+		refSkeleton.RigidBodyData[bIdx].qz = rotation.z;
+		refSkeleton.RigidBodyData[bIdx].qw = rotation.w;
+	}
+}
+
+
+/**
+ * Streams frames like the server does and checks the world space poses and the descriptions.
+ */
+static void testStreaming()
+{
+	std::unique_ptr<MoCapData> pData(new MoCapData());
+	addSkeleton(*pData, 1, 3);
+
+	ForwardKinematics kinematics;
+	CHECK(kinematics.needsUpdate(*pData));
+	kinematics.updateDescriptions(*pData);
+	kinematics.addWorldSkeletonData(*pData);
+	CHECK(pData->description.nDataDescriptions == 2);
+	CHECK(pData->frame.nSkeletons == 2);
+
+	const sDataDescription& refWorldBlock = pData->description.arrDataDescriptions[1];
+	CHECK(refWorldBlock.type == Descriptor_Skeleton);
+	const sSkeletonDescription* pWorldDescr = refWorldBlock.Data.SkeletonDescription;
+	CHECK(strcmp(pWorldDescr->szName, "Skeleton1_World") == 0);
+	CHECK(pWorldDescr->skeletonID == 1001);
+	CHECK(pWorldDescr->RigidBodies[2].parentID == -1);
+
+	// a description appended by another part of the server, e.g., the interaction system
+	sForcePlateDescription* pPlate = new sForcePlateDescription();
+	sDataDescription& refPlateBlock = pData->description.arrDataDescriptions[pData->description.nDataDescriptions++];
+	refPlateBlock.type = Descriptor_ForcePlate;
+	refPlateBlock.Data.ForcePlateDescription = pPlate;
+
+	for (int frame = 0; frame < 10; frame++)
+	{
+		kinematics.removeWorldSkeletonData(*pData);
+		CHECK(pData->frame.nSkeletons == 1);
+
+		// each bone turns by another 90 degrees around Z
+		setBoneRotations(*pData, 0, (float) (M_PI / 2));
+		CHECK(!kinematics.needsUpdate(*pData));
+		kinematics.addWorldSkeletonData(*pData);
+
+		// the description is not touched between scene changes
+		CHECK(pData->description.nDataDescriptions == 3);
+		CHECK(pData->description.arrDataDescriptions[1].Data.SkeletonDescription == pWorldDescr);
+
+		CHECK(pData->frame.nSkeletons == 2);
+		const sSkeletonData& refWorld = pData->frame.Skeletons[1];
+		CHECK(refWorld.skeletonID == 1001);
+		// root at the origin pointing along -X, second bone at (-1, 0, 0) pointing along -Y,
+		// third bone at (-1, -1, 0) pointing along +X
+		CHECK_CLOSE(refWorld.RigidBodyData[1].x, -1, 1e-5);
+		CHECK_CLOSE(refWorld.RigidBodyData[1].y,  0, 1e-5);
+		CHECK_CLOSE(refWorld.RigidBodyData[2].x, -1, 1e-5);
+		CHECK_CLOSE(refWorld.RigidBodyData[2].y, -1, 1e-5);
+		CHECK_CLOSE(std::fabs(refWorld.RigidBodyData[2].qz), std::sqrt(0.5), 1e-5);
+		CHECK_CLOSE(std::fabs(refWorld.RigidBodyData[2].qw), std::sqrt(0.5), 1e-5);
+	}
+
+	// a new skeleton with a new scene version
+	kinematics.removeWorldSkeletonData(*pData);
+	addSkeleton(*pData, 2, 2);
+	pData->sceneVersion++;
+	CHECK(kinematics.needsUpdate(*pData));
+	kinematics.updateDescriptions(*pData);
+	kinematics.addWorldSkeletonData(*pData);
+	CHECK(pData->frame.nSkeletons == 4);
+	const sDataDescriptions& refDescr = pData->description;
+	CHECK(refDescr.nDataDescriptions == 5);
+	CHECK(refDescr.arrDataDescriptions[1].type == Descriptor_ForcePlate);
+	CHECK(strcmp(refDescr.arrDataDescriptions[3].Data.SkeletonDescription->szName, "Skeleton1_World") == 0);
+	CHECK(strcmp(refDescr.arrDataDescriptions[4].Data.SkeletonDescription->szName, "Skeleton2_World") == 0);
+	CHECK(!kinematics.needsUpdate(*pData));
+
+	// the MoCap data only releases its own descriptions
+	kinematics.removeWorldSkeletons(*pData);
+	CHECK(pData->description.nDataDescriptions == 3);
+	CHECK(pData->frame.nSkeletons == 2);
+}
+
+
+int main()
+{
+	testStreaming();
+	return TEST_RESULT();
+}
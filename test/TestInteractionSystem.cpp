@@ -0,0 +1,357 @@
+/**
+ * Tests the interaction system against the emulated XBee network:
+ * asynchronous discovery, several coordinators, consistent channel values,
+ * sub-frames including the recording file, and the alignment to the frame timestamps.
+ */
+
+#include "Test.h"
+
+#include "XBeeEmulator.h"
+#include "InteractionSystem.h"
+#include "MoCapFile.h"
+
+#include <atomic>
+#include <cstdio>
+#include <glob.h>
+#include <random>
+#include <thread>
+
+
+typedef std::chrono::steady_clock Clock;
+
+// input pin states of the emulated joysticks (a pin is low while the button is pressed)
+static const uint16_t STATE_RELEASED       = 0x00FC;
+static const uint16_t STATE_BUTTON1        = 0x00F8;
+static const uint16_t STATE_BUTTON1_AXIS_Y = 0x0048;
+
+
+// the file reader signals new frames to the server
+void signalNewFrame() { }
+
+
+/**
+ * Creates an interaction system for the given serial ports.
+ */
+static std::unique_ptr<InteractionSystem> createSystem(std::initializer_list<std::string> arrPortNames)
+{
+	std::vector<std::unique_ptr<SerialPort>> arrPorts;
+	for (const std::string& strName : arrPortNames)
+	{
+		arrPorts.push_back(std::unique_ptr<SerialPort>(new SerialPort(strName)));
+	}
+	return std::unique_ptr<InteractionSystem>(new InteractionSystem(arrPorts));
+}
+
+
+/**
+ * Checks that initialise() does not wait for the discovery
+ * and that the devices are added to the scene as they are found.
+ */
+static void testDiscovery()
+{
+	XBeeEmulatorSettings settings;
+	settings.nDevices = 3;
+	XBeeEmulator emulator(settings);
+	CHECK(emulator.start());
+
+	std::unique_ptr<InteractionSystem> pSystem = createSystem({ emulator.getDeviceName() });
+	Clock::time_point t0 = Clock::now();
+	CHECK(pSystem->initialise());
+	double timeInitialise = secondsSince(t0);
+	CHECK(timeInitialise < 0.2);
+
+	std::unique_ptr<MoCapData> pData(new MoCapData());
+	pSystem->getSceneDescription(*pData);
+	int initialDevices = pData->description.nDataDescriptions;
+	double timeAllDevices = -1;
+	while (secondsSince(t0) < 3)
+	{
+		if (pSystem->hasNewDevices())
+		{
+			// only the new devices are appended
+			pSystem->getSceneDescription(*pData);
+		}
+		if ((timeAllDevices < 0) && (pData->description.nDataDescriptions == settings.nDevices))
+		{
+			timeAllDevices = secondsSince(t0);
+		}
+		pSystem->getFrameData(*pData);
+		std::this_thread::sleep_for(std::chrono::milliseconds(5));
+	}
+	CHECK(initialDevices < settings.nDevices);
+	CHECK(timeAllDevices > 0);
+	CHECK(!pSystem->isDiscovering());
+	CHECK(pData->description.nDataDescriptions == settings.nDevices);
+	CHECK(pData->frame.nForcePlates == settings.nDevices);
+	pSystem->deinitialise();
+
+	std::cout << "Discovery: initialise() took " << timeInitialise << "s, "
+		<< "all " << settings.nDevices << " devices in the scene after " << timeAllDevices << "s" << std::endl;
+}
+
+
+/**
+ * Uses two coordinators whose networks have the same addresses, plus a port that does not exist.
+ */
+static void testMultipleCoordinators()
+{
+	XBeeEmulatorSettings settings;
+	settings.nDevices = 2;
+	XBeeEmulator emulatorA(settings), emulatorB(settings);
+	CHECK(emulatorA.start());
+	CHECK(emulatorB.start());
+
+	std::unique_ptr<InteractionSystem> pSystem = createSystem({ emulatorA.getDeviceName(), "/dev/nonexistent_port", emulatorB.getDeviceName() });
+	CHECK(pSystem->initialise());
+	pSystem->waitForDiscovery();
+
+	std::unique_ptr<MoCapData> pData(new MoCapData());
+	pSystem->getSceneDescription(*pData);
+	CHECK(pData->description.nDataDescriptions == 4);
+	for (int dIdx = 0; dIdx < pData->description.nDataDescriptions; dIdx++)
+	{
+		CHECK(pData->description.arrDataDescriptions[dIdx].Data.ForcePlateDescription->ID == dIdx + 1);
+	}
+
+	// press a button on one device of the second network only
+	emulatorB.setInputState(0, STATE_BUTTON1);
+	std::this_thread::sleep_for(std::chrono::milliseconds(100));
+	pSystem->getFrameData(*pData);
+	int pressed = 0;
+	for (int pIdx = 0; pIdx < pData->frame.nForcePlates; pIdx++)
+	{
+		const sAnalogChannelData& refButton = pData->frame.ForcePlates[pIdx].ChannelData[0];
+		if (refButton.Values[refButton.nFrames - 1] > 0.5f) pressed++;
+	}
+	CHECK(pressed == 1);
+	pSystem->deinitialise();
+
+	std::cout << "Multiple coordinators: " << pData->frame.nForcePlates << " plates, button pressed on " << pressed << std::endl;
+}
+
+
+/**
+ * Changes a button and an axis of the same sample while frames are read at 1kHz.
+ * Both values of a sub-frame must always come from the same sample.
+ */
+static void testConsistentValues()
+{
+	XBeeEmulatorSettings settings;
+	settings.nDevices   = 1;
+	settings.sampleRate = 0;
+	XBeeEmulator emulator(settings);
+	CHECK(emulator.start());
+
+	std::unique_ptr<InteractionSystem> pSystem = createSystem({ emulator.getDeviceName() });
+	CHECK(pSystem->initialise());
+	pSystem->waitForDiscovery();
+
+	std::atomic<bool> running(true);
+	std::thread toggler([&]
+	{
+		for (int i = 0; running; i++)
+		{
+			emulator.setInputState(0, (i & 1) ? STATE_RELEASED : STATE_BUTTON1_AXIS_Y);
+			std::this_thread::sleep_for(std::chrono::microseconds(20));
+		}
+	});
+
+	std::unique_ptr<MoCapData> pData(new MoCapData());
+	pSystem->getSceneDescription(*pData);
+	long subFrames = 0, torn = 0;
+	Clock::time_point t0 = Clock::now();
+	while (secondsSince(t0) < 2)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		pSystem->getFrameData(*pData);
+		const sForcePlateData& refPlate = pData->frame.ForcePlates[0];
+		// the axes of the last sub-frame are interpolated to the frame time
+		for (int sIdx = 0; sIdx < refPlate.ChannelData[0].nFrames - 1; sIdx++)
+		{
+			if (refPlate.ChannelData[0].Values[sIdx] != refPlate.ChannelData[7].Values[sIdx]) torn++;
+			subFrames++;
+		}
+	}
+	running = false;
+	toggler.join();
+	pSystem->deinitialise();
+
+	CHECK(subFrames > 1000);
+	CHECK(torn == 0);
+	std::cout << "Consistency: " << subFrames << " sub-frames, " << torn << " torn, " << emulator.getSentSamples() << " samples" << std::endl;
+}
+
+
+/**
+ * Finds the newest recording in the current directory.
+ */
+static std::string findRecording()
+{
+	std::string strFilename;
+	glob_t files;
+	if (glob("MotionServer File *.mot", 0, NULL, &files) == 0)
+	{
+		// timestamp names sort chronologically
+		strFilename = files.gl_pathv[files.gl_pathc - 1];
+	}
+	globfree(&files);
+	return strFilename;
+}
+
+
+/**
+ * Presses a button for 2ms every 25ms while frames are read at 60Hz.
+ * Every press must appear in the sub-frames, live and after reading the recording back.
+ */
+static void testSubFrames()
+{
+	XBeeEmulatorSettings settings;
+	settings.nDevices   = 1;
+	settings.sampleRate = 0;
+	XBeeEmulator emulator(settings);
+	CHECK(emulator.start());
+
+	std::unique_ptr<InteractionSystem> pSystem = createSystem({ emulator.getDeviceName() });
+	CHECK(pSystem->initialise());
+	pSystem->waitForDiscovery();
+
+	std::atomic<bool> running(true);
+	std::atomic<int>  presses(0);
+	std::thread toggler([&]
+	{
+		while (running)
+		{
+			emulator.setInputState(0, STATE_BUTTON1);
+			std::this_thread::sleep_for(std::chrono::milliseconds(2));
+			emulator.setInputState(0, STATE_RELEASED);
+			presses++;
+			std::this_thread::sleep_for(std::chrono::milliseconds(23));
+		}
+	});
+
+	std::unique_ptr<MoCapData> pData(new MoCapData());
+	pSystem->getSceneDescription(*pData);
+	std::unique_ptr<MoCapFileWriter> pWriter(new MoCapFileWriter(60));
+	CHECK(pWriter->writeSceneDescription(*pData));
+
+	const int FRAMES = 180;
+	int   seen = 0, maxSubFrames = 0;
+	float lastValue = 0;
+	for (int fIdx = 0; fIdx < FRAMES; fIdx++)
+	{
+		std::this_thread::sleep_for(std::chrono::microseconds(16667));
+		pData->frame.iFrame = fIdx;
+		pSystem->getFrameData(*pData);
+		const sAnalogChannelData& refButton = pData->frame.ForcePlates[0].ChannelData[0];
+		maxSubFrames = std::max(maxSubFrames, refButton.nFrames);
+		for (int sIdx = 0; sIdx < refButton.nFrames; sIdx++)
+		{
+			if ((refButton.Values[sIdx] > 0.5f) && (lastValue < 0.5f)) seen++;
+			lastValue = refButton.Values[sIdx];
+		}
+		CHECK(pWriter->writeFrameData(*pData));
+	}
+	running = false;
+	toggler.join();
+	pSystem->deinitialise();
+	pWriter.reset();
+
+	// a press that is still going on at the end can be missing
+	CHECK(seen >= presses - 1);
+	CHECK(maxSubFrames > 1);
+
+	std::string strFilename = findRecording();
+	CHECK(!strFilename.empty());
+	MoCapFileReaderConfiguration config;
+	config.filename = strFilename;
+	MoCapFileReader reader(config);
+	CHECK(reader.initialise());
+	std::unique_ptr<MoCapData> pRead(new MoCapData());
+	CHECK(reader.getSceneDescription(*pRead));
+	int readFrames = 0, readSeen = 0;
+	lastValue = 0;
+	while ((readFrames < FRAMES) && reader.getFrameData(*pRead))
+	{
+		readFrames++;
+		const sAnalogChannelData& refButton = pRead->frame.ForcePlates[0].ChannelData[0];
+		for (int sIdx = 0; sIdx < refButton.nFrames; sIdx++)
+		{
+			if ((refButton.Values[sIdx] > 0.5f) && (lastValue < 0.5f)) readSeen++;
+			lastValue = refButton.Values[sIdx];
+		}
+	}
+	reader.deinitialise();
+	remove(strFilename.c_str());
+
+	CHECK(readFrames == FRAMES);
+	CHECK(readSeen == seen);
+	std::cout << "Sub-frames: " << presses << " presses, " << seen << " seen live (up to " << maxSubFrames << " sub-frames), "
+		<< readSeen << " in " << readFrames << " recorded frames" << std::endl;
+}
+
+
+/**
+ * Toggles the button every 50ms and delivers 100Hz frames with 0-8ms random delay.
+ * The button state of each frame must match its timestamp, not its delivery time.
+ */
+static void testTimestampAlignment()
+{
+	XBeeEmulatorSettings settings;
+	settings.nDevices   = 1;
+	settings.sampleRate = 0;
+	XBeeEmulator emulator(settings);
+	CHECK(emulator.start());
+
+	std::unique_ptr<InteractionSystem> pSystem = createSystem({ emulator.getDeviceName() });
+	CHECK(pSystem->initialise());
+	pSystem->waitForDiscovery();
+
+	std::unique_ptr<MoCapData> pData(new MoCapData());
+	pSystem->getSceneDescription(*pData);
+
+	Clock::time_point t0 = Clock::now();
+	std::thread toggler([&]
+	{
+		for (int k = 0; k < 60; k++)
+		{
+			std::this_thread::sleep_until(t0 + std::chrono::microseconds(5000 + k * 50000));
+			emulator.setInputState(0, (k & 1) ? STATE_RELEASED : STATE_BUTTON1);
+		}
+	});
+
+	std::mt19937 random(1);
+	std::uniform_int_distribution<int> delay(0, 8000);
+	int frames = 0, wrong = 0;
+	for (int fIdx = 0; fIdx < 300; fIdx++)
+	{
+		double frameTime = fIdx * 0.01;
+		bool   pressed   = (frameTime > 0.005) && ((((int) ((frameTime - 0.005) / 0.05)) & 1) == 0);
+		std::this_thread::sleep_until(t0 + std::chrono::microseconds((long) (frameTime * 1e6)));
+		std::this_thread::sleep_for(std::chrono::microseconds(delay(random)));
+		pData->frame.fTimestamp = 1000.0 + frameTime;
+		pSystem->getFrameData(*pData);
+		if (fIdx > 10)
+		{
+			// skip the frames the clock offset is learned from
+			const sAnalogChannelData& refButton = pData->frame.ForcePlates[0].ChannelData[0];
+			frames++;
+			if ((refButton.Values[refButton.nFrames - 1] > 0.5f) != pressed) wrong++;
+		}
+	}
+	toggler.join();
+	pSystem->deinitialise();
+
+	CHECK(wrong <= 2);
+	std::cout << "Timestamp alignment: " << wrong << " of " << frames << " frames with the wrong button state" << std::endl;
+}
+
+
+int main()
+{
+	testDiscovery();
+	testMultipleCoordinators();
+	testConsistentValues();
+	testSubFrames();
+	testTimestampAlignment();
+	return TEST_RESULT();
+}
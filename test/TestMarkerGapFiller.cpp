@@ -0,0 +1,165 @@
+/**
+ * Tests the gap filling of marker trajectories:
+ * predictions within short gaps of moving markers, gaps longer than the maximum length,
+ * disabled gap filling, resets, and the independence of the markers in a batch.
+ */
+
+#include "Test.h"
+
+#include "MarkerGapFiller.h"
+
+#include <vector>
+
+
+/**
+ * Position of a thrown marker: constant velocity along X, gravity along Y (units per frame).
+ */
+static void getThrownPosition(int frame, float& x, float& y, float& z)
+{
+	x = 1.0f + 0.02f * frame;
+	y = 1.0f + 0.05f * frame - 0.0005f * frame * frame;
+	z = -0.5f;
+}
+
+
+/**
+ * Lets a moving marker disappear for a short gap and checks that the predictions follow the trajectory.
+ */
+static void testShortGap()
+{
+	MarkerGapFiller filler(10);
+	filler.setMarkerCount(1);
+
+	float x, y, z, px, py, pz;
+	for (int frame = 0; frame < 60; frame++)
+	{
+		getThrownPosition(frame, x, y, z);
+		bool missing = (frame >= 50) && (frame < 55);
+		if (missing) filler.setMarkerMissing(0); else filler.setMarker(0, x, y, z);
+		filler.update();
+
+		CHECK(filler.getPrediction(0, px, py, pz) == missing);
+		if (missing)
+		{
+			// the error grows with the gap length, but stays far below the distance to the origin
+			float error = std::sqrt((px - x) * (px - x) + (py - y) * (py - y) + (pz - z) * (pz - z));
+			CHECK(error < 0.002f * (frame - 49));
+		}
+	}
+}
+
+
+/**
+ * Lets a marker disappear for longer than the maximum gap length.
+ * Only the first frames of the gap are predicted, and the marker restarts at its measurement.
+ */
+static void testLongGap()
+{
+	MarkerGapFiller filler(3);
+	filler.setMarkerCount(1);
+
+	float px, py, pz;
+	for (int frame = 0; frame < 20; frame++)
+	{
+		filler.setMarker(0, 0.1f * frame, 0, 0);
+		filler.update();
+	}
+	for (int frame = 0; frame < 10; frame++)
+	{
+		filler.setMarkerMissing(0);
+		filler.update();
+		CHECK(filler.getPrediction(0, px, py, pz) == (frame < 3));
+	}
+
+	// no velocity from before the gap
+	filler.setMarker(0, 5, 0, 0);
+	filler.update();
+	filler.setMarkerMissing(0);
+	filler.update();
+	CHECK(filler.getPrediction(0, px, py, pz));
+	CHECK_CLOSE(px, 5, 1e-6);
+}
+
+
+/**
+ * Checks the cases without predictions: disabled gap filling, markers that were never seen, and resets.
+ */
+static void testNoPrediction()
+{
+	MarkerGapFiller filler;
+	CHECK(filler.getMaxGapLength() == 0);
+	filler.setMarkerCount(2);
+
+	float px, py, pz;
+	filler.setMarker(0, 1, 2, 3);
+	filler.setMarkerMissing(1);
+	filler.update();
+	CHECK(!filler.getPrediction(0, px, py, pz));
+	CHECK(!filler.getPrediction(1, px, py, pz));
+	filler.setMarkerMissing(0);
+	filler.update();
+	CHECK(!filler.getPrediction(0, px, py, pz));
+
+	filler.setMaxGapLength(5);
+	filler.setMarker(0, 1, 2, 3);
+	filler.update();
+	filler.setMarkerMissing(0);
+	filler.update();
+	CHECK(filler.getPrediction(0, px, py, pz));
+	CHECK(!filler.getPrediction(1, px, py, pz));
+
+	// the same amount of markers keeps the state
+	filler.setMarkerCount(2);
+	CHECK(filler.getPrediction(0, px, py, pz));
+
+	filler.resetMarker(0);
+	filler.setMarkerMissing(0);
+	filler.update();
+	CHECK(!filler.getPrediction(0, px, py, pz));
+}
+
+
+/**
+ * Filters a marker alone and as part of a large batch with other markers, which have to give the same results.
+ */
+static void testBatch()
+{
+	const int MARKERS = 1003;
+	MarkerGapFiller single(5), batch(5);
+	single.setMarkerCount(1);
+	batch.setMarkerCount(MARKERS);
+
+	float x, y, z;
+	for (int frame = 0; frame < 100; frame++)
+	{
+		getThrownPosition(frame, x, y, z);
+		bool missing = (frame % 10) >= 7;
+		if (missing) single.setMarkerMissing(0); else single.setMarker(0, x, y, z);
+		for (int mIdx = 0; mIdx < MARKERS; mIdx++)
+		{
+			// the other markers have their own trajectories and gaps
+			if (mIdx == MARKERS / 2) { if (missing) batch.setMarkerMissing(mIdx); else batch.setMarker(mIdx, x, y, z); }
+			else if ((frame + mIdx) % 7 == 0) batch.setMarkerMissing(mIdx);
+			else batch.setMarker(mIdx, 0.01f * mIdx, 0.001f * frame * mIdx, -x);
+		}
+		single.update();
+		batch.update();
+
+		float sx = 0, sy = 0, sz = 0, bx = 0, by = 0, bz = 0;
+		bool  singlePredicted = single.getPrediction(0, sx, sy, sz);
+		bool  batchPredicted  = batch.getPrediction(MARKERS / 2, bx, by, bz);
+		CHECK(singlePredicted == missing);
+		CHECK(batchPredicted == singlePredicted);
+		CHECK((sx == bx) && (sy == by) && (sz == bz));
+	}
+}
+
+
+int main()
+{
+	testShortGap();
+	testLongGap();
+	testNoPrediction();
+	testBatch();
+	return TEST_RESULT();
+}
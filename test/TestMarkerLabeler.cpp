@@ -0,0 +1,164 @@
+/**
+ * Tests the labeling of unidentified markers:
+ * stable IDs for moving and shuffled markers, short and long dropouts,
+ * and a large cloud of markers across the grid cell boundaries.
+ */
+
+#include "Test.h"
+
+#include "MarkerLabeler.h"
+
+#include <algorithm>
+#include <random>
+#include <set>
+#include <vector>
+
+
+/**
+ * Labels a frame and returns the IDs of the markers.
+ */
+static std::vector<int> label(MarkerLabeler& refLabeler, const std::vector<float>& arrPositions)
+{
+	int nMarkers = (int)arrPositions.size() / 3;
+	refLabeler.update(arrPositions.data(), nMarkers);
+	std::vector<int> arrIDs(nMarkers);
+	for (int mIdx = 0; mIdx < nMarkers; mIdx++)
+	{
+		arrIDs[mIdx] = refLabeler.getMarkerID(mIdx);
+	}
+	return arrIDs;
+}
+
+
+/**
+ * Moves markers faster than the matching distance once their velocity is known,
+ * and passes them in a different order each frame.
+ */
+static void testMovingMarkers()
+{
+	MarkerLabeler labeler(0.05f, 5);
+	std::mt19937  rng(1);
+
+	// 4 markers, 0.5 apart, moving along X with accelerating speed
+	std::vector<int> arrOrder = { 0, 1, 2, 3 };
+	std::vector<int> arrFirstIDs;
+	float x = 0, speed = 0.03f;
+	for (int frame = 0; frame < 50; frame++)
+	{
+		std::shuffle(arrOrder.begin(), arrOrder.end(), rng);
+		std::vector<float> arrPositions;
+		for (int marker : arrOrder)
+		{
+			arrPositions.insert(arrPositions.end(), { x, 0.5f * marker, -0.2f });
+		}
+		std::vector<int> arrIDs = label(labeler, arrPositions);
+
+		// IDs per marker instead of per position in the frame
+		std::vector<int> arrMarkerIDs(4);
+		for (int mIdx = 0; mIdx < 4; mIdx++)
+		{
+			arrMarkerIDs[arrOrder[mIdx]] = arrIDs[mIdx];
+		}
+		if (frame == 0)
+		{
+			arrFirstIDs = arrMarkerIDs;
+			CHECK(std::set<int>(arrIDs.begin(), arrIDs.end()).size() == 4);
+		}
+		CHECK(arrMarkerIDs == arrFirstIDs);
+
+		x     += speed;
+		speed  = std::min(speed + 0.01f, 0.2f);
+	}
+	CHECK(speed > 0.05f * 3);
+}
+
+
+/**
+ * Lets a marker disappear for a shorter and a longer time than the maximum amount of missing frames.
+ */
+static void testDropouts()
+{
+	MarkerLabeler labeler(0.05f, 5);
+	const float speed = 0.02f;
+
+	std::vector<int> arrFirstIDs;
+	for (int frame = 0; frame < 40; frame++)
+	{
+		float x = speed * frame;
+		std::vector<float> arrPositions = { x, 0, 0 };
+		// the second marker is missing in frames 10-13 (4 frames) and 20-29 (10 frames)
+		bool visible = !((frame >= 10) && (frame < 14)) && !((frame >= 20) && (frame < 30));
+		if (visible)
+		{
+			arrPositions.insert(arrPositions.end(), { x, 1, 0 });
+		}
+		std::vector<int> arrIDs = label(labeler, arrPositions);
+
+		if (frame == 0) arrFirstIDs = arrIDs;
+		CHECK(arrIDs[0] == arrFirstIDs[0]);
+		if (visible && (frame < 20))
+		{
+			// the prediction kept the track alive
+			CHECK(arrIDs[1] == arrFirstIDs[1]);
+		}
+		else if (visible)
+		{
+			// the track has been discarded
+			CHECK(arrIDs[1] != arrFirstIDs[1]);
+			CHECK(arrIDs[1] != arrIDs[0]);
+		}
+	}
+
+	// after a reset, the IDs start again
+	labeler.reset();
+	std::vector<int> arrIDs = label(labeler, { 0, 0, 0, 0, 1, 0 });
+	CHECK(arrIDs == arrFirstIDs);
+}
+
+
+/**
+ * Labels a cloud of 2000 markers around the origin that jitter slightly around their positions,
+ * so that many of them cross grid cell boundaries and negative coordinates.
+ */
+static void testMarkerCloud()
+{
+	const int MARKERS = 2000;
+	MarkerLabeler labeler(0.05f, 5);
+	std::mt19937  rng(2);
+	std::uniform_real_distribution<float> random(-0.005f, 0.005f);
+
+	// markers 0.12 apart on a grid around the origin
+	std::vector<float> arrPositions;
+	for (int mIdx = 0; mIdx < MARKERS; mIdx++)
+	{
+		arrPositions.insert(arrPositions.end(), {
+			0.12f * (mIdx % 20 - 10),
+			0.12f * ((mIdx / 20) % 10 - 5),
+			0.12f * (mIdx / 200 - 5) });
+	}
+
+	std::vector<int> arrFirstIDs = label(labeler, arrPositions);
+	CHECK(std::set<int>(arrFirstIDs.begin(), arrFirstIDs.end()).size() == MARKERS);
+
+	const std::vector<float> arrBasePositions = arrPositions;
+	int nChanged = 0;
+	for (int frame = 0; frame < 100; frame++)
+	{
+		for (size_t idx = 0; idx < arrPositions.size(); idx++)
+		{
+			arrPositions[idx] = arrBasePositions[idx] + random(rng);
+		}
+		std::vector<int> arrIDs = label(labeler, arrPositions);
+		nChanged += (int)(arrIDs != arrFirstIDs);
+	}
+	CHECK(nChanged == 0);
+}
+
+
+int main()
+{
+	testMovingMarkers();
+	testDropouts();
+	testMarkerCloud();
+	return TEST_RESULT();
+}
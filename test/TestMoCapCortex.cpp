@@ -0,0 +1,231 @@
+/**
+ * Tests the Cortex module against the Cortex SDK emulator:
+ * streaming through the data callback while actors are added and removed
+ * and while the scene description is read like the server does for clients,
+ * and the conversion of actors with a single segment to rigid bodies.
+ */
+
+#include "Test.h"
+
+#include "MoCapCortex.h"
+
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+
+// the system under test and the data that the callback frames are converted into
+static MoCapCortex* g_pCortex       = nullptr;
+static MoCapData*   g_pData         = nullptr;
+static int          g_nSegments     = 0;
+static std::mutex   g_mtxData;
+static std::mutex   g_mtxScene;
+static int          g_nFrames       = 0;
+static int          g_nFailed       = 0;
+static int          g_nInconsistent = 0;
+
+
+/**
+ * Checks that the frame data matches the description and the synthetic scene of the emulator.
+ * Returns <code>false</code> if not.
+ */
+static bool isConsistent(const MoCapData& refData, int nSegments)
+{
+	const sFrameOfMocapData& refFrame = refData.frame;
+	int nBodies = (nSegments == 1) ? refFrame.nRigidBodies : refFrame.nSkeletons;
+	if ((nBodies != refFrame.nMarkerSets) || (refData.description.nDataDescriptions != 2 * refFrame.nMarkerSets + 1))
+	{
+		return false;
+	}
+
+	for (int aIdx = 0; aIdx < refFrame.nMarkerSets; aIdx++)
+	{
+		const sMarkerSetDescription* pDescr = refData.findMarkerSetDescription(refFrame.MocapData[aIdx]);
+		if ((pDescr == nullptr) || (pDescr->nMarkers != refFrame.MocapData[aIdx].nMarkers))
+		{
+			return false;
+		}
+
+		// segments are stacked 100 mm above each other, starting 1 m above the floor
+		const sRigidBodyData* pSegments = (nSegments == 1) ? &refFrame.RigidBodies[aIdx] : refFrame.Skeletons[aIdx].RigidBodyData;
+		for (int sIdx = 0; sIdx < nSegments; sIdx++)
+		{
+			const sRigidBodyData& refSegment = pSegments[sIdx];
+			if ((refSegment.params == STATUS_TRACKED) && (std::fabs(refSegment.y - (1.0f + 0.1f * sIdx)) > 1e-4f))
+			{
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+
+// the server lock for the scene description
+std::mutex& getSceneDescriptionMutex()
+{
+	return g_mtxScene;
+}
+
+
+/**
+ * Reads all names of the scene description like the server does when packetizing it.
+ *
+ * @return the total length of the names
+ */
+static size_t readDescription(const sDataDescriptions& refDescr)
+{
+	size_t length = 0;
+	for (int dIdx = 0; dIdx < refDescr.nDataDescriptions; dIdx++)
+	{
+		const sDataDescription& refBlock = refDescr.arrDataDescriptions[dIdx];
+		switch (refBlock.type)
+		{
+			case Descriptor_MarkerSet:
+				length += strlen(refBlock.Data.MarkerSetDescription->szName);
+				for (int mIdx = 0; mIdx < refBlock.Data.MarkerSetDescription->nMarkers; mIdx++)
+				{
+					length += strlen(refBlock.Data.MarkerSetDescription->szMarkerNames[mIdx]);
+				}
+				break;
+			case Descriptor_RigidBody:
+				length += strlen(refBlock.Data.RigidBodyDescription->szName);
+				break;
+			case Descriptor_Skeleton:
+				for (int bIdx = 0; bIdx < refBlock.Data.SkeletonDescription->nRigidBodies; bIdx++)
+				{
+					length += strlen(refBlock.Data.SkeletonDescription->RigidBodies[bIdx].szName);
+				}
+				break;
+			case Descriptor_ForcePlate:
+				length += strlen(refBlock.Data.ForcePlateDescription->strSerialNo);
+				break;
+		}
+	}
+	return length;
+}
+
+
+// converts each callback frame like the server does
+void signalNewFrame()
+{
+	std::lock_guard<std::mutex> lock(g_mtxData);
+	if ((g_pCortex != nullptr) && (g_pData != nullptr))
+	{
+		if (g_pCortex->getFrameData(*g_pData))
+		{
+			g_nFrames++;
+			if (!isConsistent(*g_pData, g_nSegments)) g_nInconsistent++;
+		}
+		else
+		{
+			g_nFailed++;
+		}
+	}
+}
+
+
+/**
+ * Runs the Cortex module with the given emulator settings for a while.
+ *
+ * @return the data of the last frame
+ */
+static std::unique_ptr<MoCapData> runCortex(const std::string& strSettings, double duration)
+{
+	MoCapCortexConfiguration config;
+	CHECK(CortexEmulator_ParseSettings(strSettings, config.emulatorSettings));
+	config.useCortex = true;
+
+	std::unique_ptr<MoCapData> pData(new MoCapData());
+	MoCapCortex cortex(config);
+	{
+		std::lock_guard<std::mutex> lock(g_mtxData);
+		g_pCortex   = &cortex;
+		g_pData     = pData.get();
+		g_nSegments = config.emulatorSettings.nSegments;
+		g_nFrames = g_nFailed = g_nInconsistent = 0;
+		CHECK(cortex.initialise());
+		CHECK(cortex.getSceneDescription(*pData));
+		cortex.setHandleUnknownMarkers(true);
+
+		// a description that is not part of the Cortex scene (e.g., from the interaction system)
+		sForcePlateDescription* pPlate = new sForcePlateDescription();
+		pPlate->ID = 1;
+		strcpy(pPlate->strSerialNo, "Plate");
+		sDataDescription& refBlock = pData->description.arrDataDescriptions[pData->description.nDataDescriptions++];
+		refBlock.type = Descriptor_ForcePlate;
+		refBlock.Data.ForcePlateDescription = pPlate;
+	}
+
+	// request the description while the scene changes
+	std::atomic<bool> running(true);
+	size_t            nRequests = 0;
+	std::thread       requester([&]
+	{
+		while (running)
+		{
+			std::lock_guard<std::mutex> lock(g_mtxScene);
+			CHECK(readDescription(pData->description) > 0);
+			nRequests++;
+		}
+	});
+
+	std::this_thread::sleep_for(std::chrono::duration<double>(duration));
+
+	running = false;
+	requester.join();
+	CHECK(nRequests > 0);
+
+	CHECK(cortex.deinitialise());
+	g_pCortex = nullptr;
+	g_pData   = nullptr;
+	return pData;
+}
+
+
+/**
+ * Streams skeletons while the emulator removes and adds the last actor every 50 frames.
+ * Every frame has to be converted with a matching description.
+ */
+static void testSceneChanges()
+{
+	std::unique_ptr<MoCapData> pData = runCortex("3,5,8,4,500,50", 0.5);
+
+	CHECK(g_nFrames > 100);
+	CHECK(g_nFailed == 0);
+	CHECK(g_nInconsistent == 0);
+	CHECK(pData->sceneVersion >= 2);
+	CHECK(pData->frame.nOtherMarkers == 4);
+
+	// the force plate stays behind the Cortex descriptions
+	const sDataDescriptions& refDescr = pData->description;
+	CHECK(refDescr.arrDataDescriptions[refDescr.nDataDescriptions - 1].type == Descriptor_ForcePlate);
+	std::cout << "Scene changes: " << g_nFrames << " frames, scene version " << pData->sceneVersion << std::endl;
+}
+
+
+/**
+ * Streams actors with one segment, which are converted to rigid bodies.
+ */
+static void testRigidBodies()
+{
+	std::unique_ptr<MoCapData> pData = runCortex("4,1,3,0,500", 0.2);
+
+	CHECK(g_nFrames > 50);
+	CHECK(g_nFailed == 0);
+	CHECK(g_nInconsistent == 0);
+	CHECK(pData->frame.nRigidBodies == 4);
+	CHECK(pData->frame.nSkeletons == 0);
+	CHECK(pData->description.arrDataDescriptions[3].type == Descriptor_RigidBody);
+	CHECK(pData->description.arrDataDescriptions[3].Data.RigidBodyDescription->ID == 1);
+}
+
+
+int main()
+{
+	testSceneChanges();
+	testRigidBodies();
+	return TEST_RESULT();
+}
@@ -0,0 +1,94 @@
+/**
+ * Tests reading force plate sub-frames from MoCap data files,
+ * including a channel with more sub-frames than NatNet can hold.
+ */
+
+#include "Test.h"
+
+#include "MoCapFile.h"
+
+#include <cstdio>
+#include <fstream>
+#include <memory>
+
+
+// the file reader signals new frames to the server
+void signalNewFrame() { }
+
+
+/**
+ * Writes a file with two plates of two channels each.
+ * The first channel of the first plate has the given number of sub-frames with the values 1, 2, 3, ...
+ * All other channels have two sub-frames with the values 10 * plate ID + channel index and the same + 0.5.
+ */
+static void writeFile(const char* czFilename, int nSubframes)
+{
+	std::ofstream file(czFilename);
+	file << "MotionServer Data File\t3\t60\n"
+	     << "Descriptions\t2\n"
+	     << "0\tF\t1\t\"A\"\t2\t\"c0\"\t\"c1\"\n"
+	     << "1\tF\t2\t\"B\"\t2\t\"c0\"\t\"c1\"\n"
+	     << "Frames\n"
+	     << "#frame\ttimestamp\tlatency\tmarkersetTag\tmarkersetCount\trigidbodyTag\trigidbodyCount\tskeletonTag\tskeletonCount\tforceplateTag\tforceplateCount"
+	     << "\tF.A.id\tF.A.channelCount\tF.A.c0.subframeCount\tF.A.c0.values\tF.A.c1.subframeCount\tF.A.c1.values"
+	     << "\tF.B.id\tF.B.channelCount\tF.B.c0.subframeCount\tF.B.c0.values\tF.B.c1.subframeCount\tF.B.c1.values\n";
+	for (int fIdx = 0; fIdx < 2; fIdx++)
+	{
+		file << fIdx << "\t0\t0\tM\t0\tR\t0\tS\t0\tF\t2";
+		file << "\t1\t2\t" << nSubframes;
+		for (int sIdx = 0; sIdx < nSubframes; sIdx++) file << "\t" << (sIdx + 1);
+		file << "\t2\t11\t11.5";
+		file << "\t2\t2\t2\t20\t20.5\t2\t21\t21.5\n";
+	}
+}
+
+
+/**
+ * Reads a file and checks the values of all channels.
+ */
+static void testSubframes(int nSubframes)
+{
+	const char* czFilename = "TestMoCapFile.mot";
+	writeFile(czFilename, nSubframes);
+
+	MoCapFileReaderConfiguration config;
+	config.filename = czFilename;
+	MoCapFileReader reader(config);
+	CHECK(reader.initialise());
+	std::unique_ptr<MoCapData> pData(new MoCapData());
+	CHECK(reader.getSceneDescription(*pData));
+	CHECK(reader.getFrameData(*pData));
+	reader.deinitialise();
+	remove(czFilename);
+
+	const sFrameOfMocapData& refFrame = pData->frame;
+	CHECK(refFrame.nForcePlates == 2);
+
+	// the first channel keeps as many sub-frames as fit
+	const sAnalogChannelData& refFirst = refFrame.ForcePlates[0].ChannelData[0];
+	CHECK(refFirst.nFrames == std::min(nSubframes, MAX_ANALOG_SUBFRAMES));
+	CHECK(refFirst.Values[refFirst.nFrames - 1] == refFirst.nFrames);
+
+	// the following columns must not be shifted by the skipped sub-frames
+	CHECK(refFrame.ForcePlates[0].ChannelData[1].nFrames == 2);
+	CHECK(refFrame.ForcePlates[0].ChannelData[1].Values[0] == 11);
+	CHECK(refFrame.ForcePlates[0].ChannelData[1].Values[1] == 11.5f);
+	CHECK(refFrame.ForcePlates[1].ID == 2);
+	CHECK(refFrame.ForcePlates[1].nChannels == 2);
+	for (int cIdx = 0; cIdx < 2; cIdx++)
+	{
+		const sAnalogChannelData& refChannel = refFrame.ForcePlates[1].ChannelData[cIdx];
+		CHECK(refChannel.nFrames == 2);
+		CHECK(refChannel.Values[0] == 20 + cIdx);
+		CHECK(refChannel.Values[1] == 20.5f + cIdx);
+	}
+}
+
+
+int main()
+{
+	testSubframes(3);
+	testSubframes(MAX_ANALOG_SUBFRAMES);
+	testSubframes(MAX_ANALOG_SUBFRAMES + 5);
+	return TEST_RESULT();
+}
@@ -0,0 +1,529 @@
+/**
+ * Tests the PieceMeta module against a local stand-in for the PieceMeta API:
+ * the data of several streams is downloaded in chunks over concurrent connections,
+ * one chunk fails on its first attempt (with an error or with too few frames) and has to be retried,
+ * and every frame that is played back while the rest is loading has to be complete,
+ * with the stream data in memory and in a column file.
+ * When a chunk cannot be loaded at all, playback has to stay before it,
+ * and without the first chunk of a stream, initialisation has to fail.
+ * Downloaded streams have to be taken from the cache the next time,
+ * and a local copy of the API has to be read through file:// URLs.
+ * Also checks the scanner for the frames of stream data responses.
+ */
+
+#include "Test.h"
+
+#include "HttpServer.h"
+#include "MoCapPieceMeta.h"
+
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+
+static const int   FRAMES       = 20000; // several chunks per stream
+static const int   STREAM_COUNT = 7;
+static const char* STREAMS[STREAM_COUNT][2] =
+{
+	{ "",  "timestamp" },
+	{ "A", "x" }, { "A", "y" }, { "A", "z" },
+	{ "B", "x" }, { "B", "y" }, { "B", "z" },
+};
+static const int   CONNECTIONS  = 4;
+
+static std::mutex g_mtxScene;
+
+
+// the server lock for the scene description
+std::mutex& getSceneDescriptionMutex()
+{
+	return g_mtxScene;
+}
+
+
+// playback is driven by the test
+void signalNewFrame()
+{
+}
+
+
+/**
+ * Gets the value of a frame of a stream, unique for every stream and frame.
+ */
+static float getValue(int streamIdx, int frame)
+{
+	return streamIdx * 100000.0f + frame;
+}
+
+
+/**
+ * Chunk that fails on its first requests (by default of stream B.x),
+ * either with an error or with fewer frames than requested.
+ */
+struct sFailure
+{
+	int              idxFrom;
+	int              count;
+	bool             truncated;
+	int              streamIdx;
+	int              delayMs;   // additional time for answering the other stream data requests
+	std::atomic<int> attempts;
+
+	sFailure(int idxFrom = -1, int count = 0, bool truncated = false) :
+		idxFrom(idxFrom), count(count), truncated(truncated), streamIdx(4), delayMs(0), attempts(0) {}
+};
+
+
+/**
+ * Answers the requests of the PieceMeta module like the PieceMeta API
+ * with one package, one channel, and the streams above.
+ */
+static int answerRequest(const std::string& path, std::string& content, sFailure& refFailure)
+{
+	int streamIdx, idxFrom, idxTo;
+	if (path == "/packages.json")
+	{
+		content = "[{\"uuid\":\"p1\",\"title\":\"Test package\",\"description\":\"\"}]";
+	}
+	else if (path == "/packages/p1/channels.json")
+	{
+		content = "[{\"uuid\":\"c1\",\"title\":\"Test channel\",\"parent_channel_uuid\":\"\"}]";
+	}
+	else if (path == "/channels/c1/streams.json")
+	{
+		content = "[";
+		for (int sIdx = 0; sIdx < STREAM_COUNT; sIdx++)
+		{
+			content += std::string((sIdx > 0) ? "," : "") +
+				"{\"uuid\":\"s" + std::to_string(sIdx) + "\",\"group\":\"" + STREAMS[sIdx][0] + "\",\"title\":\"" + STREAMS[sIdx][1] + "\"," +
+				"\"fps\":100,\"frameCount\":" + std::to_string(FRAMES) + "}";
+		}
+		content += "]";
+	}
+	else if ((sscanf(path.c_str(), "/streams/s%d.json?from=%d&to=%d", &streamIdx, &idxFrom, &idxTo) == 3) &&
+	         (streamIdx >= 0) && (streamIdx < STREAM_COUNT) && (idxFrom >= 0) && (idxFrom < idxTo) && (idxTo <= FRAMES))
+	{
+		if ((streamIdx == refFailure.streamIdx) && (idxFrom == refFailure.idxFrom) && (refFailure.attempts++ < refFailure.count))
+		{
+			if (!refFailure.truncated) return 500;
+			idxTo = (idxFrom + idxTo) / 2;
+		}
+		else
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(refFailure.delayMs));
+		}
+		content = "{\"uuid\":\"s" + std::to_string(streamIdx) + "\",\"frames\":[";
+		for (int frame = idxFrom; frame < idxTo; frame++)
+		{
+			content += ((frame > idxFrom) ? "," : "") + std::to_string((int) getValue(streamIdx, frame));
+		}
+		content += "]}";
+	}
+	else
+	{
+		return 404;
+	}
+	return 200;
+}
+
+
+/**
+ * Starts the stand-in with a failing chunk.
+ */
+static std::unique_ptr<HttpServer> startServer(sFailure& refFailure)
+{
+	std::unique_ptr<HttpServer> server(new HttpServer([&refFailure](const std::string& path, std::string& content)
+		{
+			return answerRequest(path, content, refFailure);
+		}, 20));
+	CHECK(server->start());
+	return server;
+}
+
+
+/**
+ * Creates the configuration of the PieceMeta module for the stand-in.
+ */
+static MoCapPieceMetaConfiguration createConfiguration(const HttpServer& refServer)
+{
+	MoCapPieceMetaConfiguration config;
+	config.usePieceMeta    = true;
+	config.baseURL         = refServer.getBaseURL();
+	config.connectionCount = CONNECTIONS;
+	return config;
+}
+
+
+/**
+ * Plays a frame and checks that all values belong to that frame.
+ *
+ * @return the frame number or -1 if the values are not correct
+ */
+static int playFrame(MoCapPieceMeta& refPieceMeta, MoCapData& refData)
+{
+	CHECK(refPieceMeta.getFrameData(refData));
+	int frame = refData.frame.iFrame;
+	const sMarkerSetData& refMarkers = refData.frame.MocapData[0];
+	bool correct = (refData.frame.fTimestamp == getValue(0, frame));
+	for (int mIdx = 0; mIdx < 2; mIdx++)
+	{
+		for (int aIdx = 0; aIdx < 3; aIdx++)
+		{
+			correct = correct && (refMarkers.Markers[mIdx][aIdx] == getValue(1 + mIdx * 3 + aIdx, frame));
+		}
+	}
+	return correct ? frame : -1;
+}
+
+
+/**
+ * Reads frames arrays with different formatting, null values, and errors.
+ */
+static void testParseFrames()
+{
+	float arrData[4] = { -1, -1, -1, -1 };
+	CHECK(MoCapPieceMeta::parseFrames("{\"frames\":[1,-2.5,3e2]}", arrData, 4) == 3);
+	CHECK((arrData[0] == 1) && (arrData[1] == -2.5f) && (arrData[2] == 300) && (arrData[3] == -1));
+
+	// whitespace, null (like json11: 0), "frames" as a value before the key
+	CHECK(MoCapPieceMeta::parseFrames("{ \"title\" : \"frames\",\n \"frames\" : [ null ,\t7 ] }", arrData, 4) == 2);
+	CHECK((arrData[0] == 0) && (arrData[1] == 7));
+
+	// values beyond the maximum are skipped
+	CHECK(MoCapPieceMeta::parseFrames("{\"frames\":[1,2,3,4,5,6]}", arrData, 2) == 2);
+	CHECK(MoCapPieceMeta::parseFrames("{\"frames\":[]}", arrData, 4) == 0);
+
+	// invalid responses
+	CHECK(MoCapPieceMeta::parseFrames("", arrData, 4) == -1);
+	CHECK(MoCapPieceMeta::parseFrames("{\"error\":\"not found\"}", arrData, 4) == -1);
+	CHECK(MoCapPieceMeta::parseFrames("{\"frames\":null}", arrData, 4) == -1);
+	CHECK(MoCapPieceMeta::parseFrames("{\"frames\":[1,2", arrData, 4) == -1);
+	CHECK(MoCapPieceMeta::parseFrames("{\"frames\":[1,\"x\"]}", arrData, 4) == -1);
+}
+
+
+/**
+ * Loads the streams from the stand-in and plays them back while the rest is loading.
+ *
+ * One chunk fails on its first request.
+ *
+ * @param columnFile  the file to keep the stream data in, or empty to keep it in memory
+ * @param truncated   <code>true</code> if the failed request returns too few frames instead of an error
+ */
+static void testDownload(const std::string& columnFile, bool truncated)
+{
+	sFailure                    failure(6000, 1, truncated);
+	std::unique_ptr<HttpServer> server = startServer(failure);
+	MoCapPieceMetaConfiguration config = createConfiguration(*server);
+	config.columnFile = columnFile;
+
+	MoCapPieceMeta pieceMeta(config);
+	CHECK(pieceMeta.initialise());
+	CHECK(pieceMeta.getUpdateRate() == 100);
+
+	MoCapData data;
+	CHECK(pieceMeta.getSceneDescription(data));
+	CHECK(data.frame.nMarkerSets == 1);
+	CHECK(data.frame.MocapData[0].nMarkers == 2);
+
+	// play until the last frame, which is only reached when all chunks have been loaded
+	int  nFrames    = 0;
+	int  nWrong     = 0;
+	bool reachedEnd = false;
+	std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+	while (!reachedEnd && (secondsSince(t0) < 30))
+	{
+		int frame = playFrame(pieceMeta, data);
+		if (frame < 0) nWrong++;
+		nFrames++;
+
+		reachedEnd = (frame == FRAMES - 1);
+		if (frame == 0)
+		{
+			// looping within the loaded range
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		}
+	}
+	std::cout << "Played " << nFrames << " frames in " << secondsSince(t0) << "s, "
+	          << server->getRequestCount() << " requests, up to " << server->getMaxConnections() << " at the same time" << std::endl;
+
+	CHECK(reachedEnd);
+	CHECK(nWrong == 0);
+	CHECK(failure.attempts == 2);
+	// packages, channels, streams, 4 chunks per stream, and the repeated chunk
+	CHECK(server->getRequestCount() == 3 + STREAM_COUNT * 4 + 1);
+	CHECK(server->getMaxConnections() > 1);
+	CHECK(server->getMaxConnections() <= CONNECTIONS);
+
+	CHECK(pieceMeta.deinitialise());
+}
+
+
+/**
+ * Loads the streams while one chunk fails on every attempt.
+ * Playback has to loop before that chunk, also after everything else has been loaded.
+ */
+static void testFailedChunk()
+{
+	sFailure                    failure(12000, INT_MAX);
+	std::unique_ptr<HttpServer> server = startServer(failure);
+	MoCapPieceMetaConfiguration config = createConfiguration(*server);
+
+	MoCapPieceMeta pieceMeta(config);
+	CHECK(pieceMeta.initialise());
+	MoCapData data;
+	CHECK(pieceMeta.getSceneDescription(data));
+
+	// play until all requests have been answered, then for a while longer
+	const int nRequests = 3 + STREAM_COUNT * 4 + 2;
+	int  maxFrame = 0;
+	int  nWrong   = 0;
+	bool answered = false;
+	std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+	std::chrono::steady_clock::time_point tAnswered;
+	while ((!answered || (secondsSince(tAnswered) < 0.5)) && (secondsSince(t0) < 30))
+	{
+		int frame = playFrame(pieceMeta, data);
+		if (frame < 0) nWrong++;
+		maxFrame = std::max(maxFrame, frame);
+
+		if (!answered && (server->getRequestCount() == nRequests))
+		{
+			answered  = true;
+			tAnswered = std::chrono::steady_clock::now();
+		}
+		if (frame == 0)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		}
+	}
+
+	CHECK(answered);
+	CHECK(nWrong == 0);
+	CHECK(maxFrame == 12000 - 1);
+	CHECK(failure.attempts == 3);
+	CHECK(server->getRequestCount() == nRequests);
+
+	CHECK(pieceMeta.deinitialise());
+}
+
+
+/**
+ * Loads the streams while the first chunk of one stream fails on every attempt.
+ * There is no frame that can be played, so initialisation has to fail
+ * as soon as that is clear, without loading the rest of the package.
+ */
+static void testFailedFirstChunk()
+{
+	sFailure failure(0, INT_MAX);
+	failure.streamIdx = 0;    // the first request of the loaders
+	failure.delayMs   = 2000; // the other requests take longer than the attempts of the failing one
+	std::unique_ptr<HttpServer> server = startServer(failure);
+	MoCapPieceMetaConfiguration config = createConfiguration(*server);
+
+	MoCapPieceMeta pieceMeta(config);
+	CHECK(!pieceMeta.initialise());
+	CHECK(!pieceMeta.isActive());
+	CHECK(failure.attempts == 3);
+	// packages, channels, streams, the failing attempts, and about two requests per other loader
+	std::cout << server->getRequestCount() << " requests until the failure" << std::endl;
+	CHECK(server->getRequestCount() < 3 + STREAM_COUNT * 4 / 2);
+
+	MoCapData data;
+	CHECK(!pieceMeta.getFrameData(data));
+
+	pieceMeta.deinitialise();
+}
+
+
+/**
+ * Plays all frames from the first one and checks their values.
+ *
+ * @return the amount of frames with wrong values, or -1 if the last frame was not reached in time
+ */
+static int playToEnd(MoCapPieceMeta& refPieceMeta, MoCapData& refData)
+{
+	int  nWrong = 0;
+	bool reachedEnd = false;
+	std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+	while (!reachedEnd && (secondsSince(t0) < 30))
+	{
+		int frame = playFrame(refPieceMeta, refData);
+		if (frame < 0) nWrong++;
+		reachedEnd = (frame == FRAMES - 1);
+	}
+	return reachedEnd ? nWrong : -1;
+}
+
+
+/**
+ * Counts the files in a directory that end with an extension.
+ */
+static int countFiles(const std::string& directory, const std::string& extension)
+{
+	int count = 0;
+	for (const auto& entry : std::filesystem::directory_iterator(directory))
+	{
+		if (entry.path().extension() == extension) count++;
+	}
+	return count;
+}
+
+
+/**
+ * Counts the cache files with a valid header: magic number, version, first frame, frame count.
+ */
+static int countValidCacheFiles(const std::string& directory)
+{
+	int count = 0;
+	for (int sIdx = 0; sIdx < STREAM_COUNT; sIdx++)
+	{
+		std::ifstream file(directory + "/s" + std::to_string(sIdx) + "_0_" + std::to_string(FRAMES) + ".bin", std::ios::in | std::ios::binary);
+		int32_t header[4] = { 0 };
+		file.read((char*) header, sizeof(header));
+		if (file && (header[0] == 0x434D5050) && (header[1] == 1) && (header[2] == 0) && (header[3] == FRAMES)) count++;
+	}
+	return count;
+}
+
+
+/**
+ * Waits until the last loader has written the cache files of all streams.
+ *
+ * @return <code>true</code> if all cache files are valid
+ */
+static bool waitForCacheFiles(const std::string& directory)
+{
+	std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+	while ((countValidCacheFiles(directory) < STREAM_COUNT) && (secondsSince(t0) < 10))
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+	return countValidCacheFiles(directory) == STREAM_COUNT;
+}
+
+
+/**
+ * Runs the PieceMeta module once with the cache and plays all frames.
+ *
+ * @return the amount of stream data requests
+ */
+static int runWithCache(const std::string& directory)
+{
+	sFailure                    failure;
+	std::unique_ptr<HttpServer> server = startServer(failure);
+	MoCapPieceMetaConfiguration config = createConfiguration(*server);
+	config.cacheDirectory = directory + "/";
+
+	MoCapPieceMeta pieceMeta(config);
+	CHECK(pieceMeta.initialise());
+	MoCapData data;
+	CHECK(pieceMeta.getSceneDescription(data));
+	CHECK(playToEnd(pieceMeta, data) == 0);
+
+	CHECK(waitForCacheFiles(directory));
+	CHECK(pieceMeta.deinitialise());
+	return server->getRequestCount() - 3; // packages, channels, streams
+}
+
+
+/**
+ * Downloads the streams into the cache, reads them from there the next time,
+ * and downloads streams again whose cache file does not match.
+ */
+static void testCache()
+{
+	const std::string directory = "TestMoCapPieceMeta.cache";
+	std::filesystem::remove_all(directory);
+
+	// first run: downloads everything and writes one cache file per stream
+	CHECK(runWithCache(directory) == STREAM_COUNT * 4);
+	CHECK(countFiles(directory, ".bin") == STREAM_COUNT);
+	CHECK(std::filesystem::exists(directory + "/s0_0_" + std::to_string(FRAMES) + ".bin"));
+
+	// second run: no stream data requests
+	CHECK(runWithCache(directory) == 0);
+
+	// a broken header and a wrong frame count: these two streams are downloaded again
+	{
+		std::fstream file(directory + "/s1_0_" + std::to_string(FRAMES) + ".bin", std::ios::in | std::ios::out | std::ios::binary);
+		int32_t magic = 0x12345678;
+		file.write((const char*) &magic, sizeof(magic));
+	}
+	{
+		std::fstream file(directory + "/s5_0_" + std::to_string(FRAMES) + ".bin", std::ios::in | std::ios::out | std::ios::binary);
+		int32_t frameCount = FRAMES / 2;
+		file.seekp(3 * sizeof(int32_t));
+		file.write((const char*) &frameCount, sizeof(frameCount));
+	}
+	CHECK(runWithCache(directory) == 2 * 4);
+
+	// ...and the repaired cache files are used the next time
+	CHECK(runWithCache(directory) == 0);
+	CHECK(countFiles(directory, ".bin") == STREAM_COUNT);
+	CHECK(countFiles(directory, ".tmp") == 0);
+
+	std::filesystem::remove_all(directory);
+}
+
+
+/**
+ * Reads a local copy of the API through file:// URLs, where each stream is read in one piece.
+ */
+static void testLocalFiles()
+{
+	const std::string directory = std::filesystem::absolute("TestMoCapPieceMeta.local").string();
+	std::filesystem::remove_all(directory);
+	std::filesystem::create_directories(directory + "/packages/p1");
+	std::filesystem::create_directories(directory + "/channels/c1");
+	std::filesystem::create_directories(directory + "/streams");
+
+	// same content as the stand-in
+	sFailure                 failure;
+	std::vector<std::string> arrPaths = { "/packages.json", "/packages/p1/channels.json", "/channels/c1/streams.json" };
+	for (int sIdx = 0; sIdx < STREAM_COUNT; sIdx++)
+	{
+		arrPaths.push_back("/streams/s" + std::to_string(sIdx) + ".json?from=0&to=" + std::to_string(FRAMES));
+	}
+	for (const std::string& path : arrPaths)
+	{
+		std::string content;
+		CHECK(answerRequest(path, content, failure) == 200);
+		std::ofstream file(directory + path.substr(0, path.find('?')), std::ios::out | std::ios::binary);
+		file << content;
+	}
+
+	MoCapPieceMetaConfiguration config;
+	config.usePieceMeta = true;
+	config.baseURL      = "file://" + directory + "/";
+
+	MoCapPieceMeta pieceMeta(config);
+	CHECK(pieceMeta.initialise());
+	MoCapData data;
+	CHECK(pieceMeta.getSceneDescription(data));
+	CHECK(playToEnd(pieceMeta, data) == 0);
+	CHECK(pieceMeta.deinitialise());
+
+	std::filesystem::remove_all(directory);
+}
+
+
+int main()
+{
+	testParseFrames();
+	testDownload("", false);
+	testDownload("TestMoCapPieceMeta.columns", false);
+	testDownload("", true);
+	testFailedChunk();
+	testFailedFirstChunk();
+	testCache();
+	testLocalFiles();
+	return TEST_RESULT();
+}
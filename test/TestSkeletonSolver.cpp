@@ -0,0 +1,157 @@
+/**
+ * Tests the skeleton solver with the Kinect bones:
+ * offsets, lengths, and bone directions of a rest pose,
+ * the orientation of the hip for turned and leaning users,
+ * and the fallbacks without or with degenerate root joints.
+ */
+
+#include "Test.h"
+
+#include "KinectSkeleton.h"
+
+#include <vector>
+
+
+/**
+ * Checks that two rotations are the same (q and -q describe the same rotation).
+ */
+static bool isSameRotation(const Quaternion& q1, const Quaternion& q2)
+{
+	float dot = q1.x * q2.x + q1.y * q2.y + q1.z * q2.z + q1.w * q2.w;
+	return std::fabs(std::fabs(dot) - 1) < 1e-5f;
+}
+
+
+static float distance(const Vector3D& v1, const Vector3D& v2)
+{
+	return (v1 - v2).length();
+}
+
+
+/**
+ * Solves the rest pose of a user facing the sensor.
+ */
+static void testRestPose()
+{
+	Vector3D joints[JOINT_COUNT];
+	getRestPose(joints);
+	SkeletonSolver solver = createKinectSolver();
+	solver.solve(joints);
+
+	CHECK(solver.getBoneCount() == KINECT_BONE_COUNT);
+	CHECK(isSameRotation(solver.getAbsoluteRotation(0), Quaternion()));
+	CHECK(solver.getLength(0) == 0);
+
+	for (int bIdx = 0; bIdx < KINECT_BONE_COUNT; bIdx++)
+	{
+		const sSkeletonBone& bone = solver.getBone(bIdx);
+		CHECK_CLOSE(solver.getOffset(bIdx), distance(joints[bone.jointPoint], joints[bone.jointParent]), 1e-6);
+		CHECK_CLOSE(solver.getLength(bIdx), distance(joints[bone.jointEnd],   joints[bone.jointPoint]),  1e-6);
+
+		// the Y axis of each bone points along the bone
+		if (solver.getLength(bIdx) > 0)
+		{
+			Vector3D direction = joints[bone.jointEnd] - joints[bone.jointPoint];
+			direction.normalize();
+			Vector3D axisY = solver.getAbsoluteRotation(bIdx).rotate(Vector3D(0, 1, 0));
+			CHECK(distance(axisY, direction) < 1e-5f);
+		}
+
+		// absolute rotation = parent rotation * relative rotation
+		if (bone.parentIndex >= 0)
+		{
+			Quaternion absRotation = solver.getAbsoluteRotation(bone.parentIndex);
+			absRotation.mult(solver.getRotation(bIdx));
+			CHECK(isSameRotation(absRotation, solver.getAbsoluteRotation(bIdx)));
+		}
+	}
+}
+
+
+/**
+ * Turns and tilts the rest pose.
+ * The hip has to follow the rotation, and all other bones keep their orientation relative to their parent.
+ */
+static void testTurnedPose()
+{
+	Vector3D joints[JOINT_COUNT];
+	getRestPose(joints);
+	SkeletonSolver restSolver = createKinectSolver();
+	restSolver.solve(joints);
+
+	const float PI = 3.14159265f;
+	std::vector<Quaternion> arrRotations =
+	{
+		Quaternion(0, 1, 0,  PI / 2),      // turned to the side
+		Quaternion(0, 1, 0,  PI),          // back to the sensor
+		Quaternion(0, 1, 0, -PI * 3 / 4),
+		Quaternion(1, 0, 0,  PI / 6),      // leaning forward
+	};
+	// leaning sideways while turned
+	Quaternion combined(0, 1, 0, PI * 0.8f);
+	combined.mult(Quaternion(0, 0, 1, -PI / 8));
+	arrRotations.push_back(combined);
+
+	for (const Quaternion& refRotation : arrRotations)
+	{
+		getRestPose(joints);
+		rotatePose(joints, refRotation);
+		SkeletonSolver solver = createKinectSolver();
+		solver.solve(joints);
+
+		CHECK(isSameRotation(solver.getAbsoluteRotation(0), refRotation));
+		CHECK(isSameRotation(solver.getRotation(0), refRotation));
+		for (int bIdx = 1; bIdx < KINECT_BONE_COUNT; bIdx++)
+		{
+			CHECK(isSameRotation(solver.getRotation(bIdx), restSolver.getRotation(bIdx)));
+			CHECK_CLOSE(solver.getOffset(bIdx), restSolver.getOffset(bIdx), 1e-5);
+			CHECK_CLOSE(solver.getLength(bIdx), restSolver.getLength(bIdx), 1e-5);
+		}
+	}
+}
+
+
+/**
+ * Solves without root joints, with degenerate root joints, and without calculating the offsets.
+ */
+static void testFallbacks()
+{
+	Vector3D joints[JOINT_COUNT];
+	getRestPose(joints);
+	rotatePose(joints, Quaternion(0, 1, 0, 1.0f));
+
+	// without root joints, the hip has no length and therefore no orientation
+	SkeletonSolver solver(KINECT_BONES, KINECT_BONE_COUNT);
+	solver.solve(joints);
+	CHECK(isSameRotation(solver.getAbsoluteRotation(0), Quaternion()));
+
+	// hips on the spine axis do not define a direction
+	solver.setRootJoints(SPINE, HIP_LEFT, HIP_RIGHT);
+	Vector3D collapsed[JOINT_COUNT];
+	getRestPose(collapsed);
+	collapsed[HIP_LEFT]  = collapsed[HIP_CENTER];
+	collapsed[HIP_RIGHT] = collapsed[SPINE];
+	solver.solve(collapsed);
+	CHECK(isSameRotation(solver.getAbsoluteRotation(0), Quaternion()));
+	for (int bIdx = 0; bIdx < KINECT_BONE_COUNT; bIdx++)
+	{
+		const Quaternion& rotation = solver.getRotation(bIdx);
+		CHECK(std::isfinite(rotation.x) && std::isfinite(rotation.y) && std::isfinite(rotation.z) && std::isfinite(rotation.w));
+	}
+
+	// the offsets of the previous solution are kept
+	std::vector<float> arrOffsets;
+	for (int bIdx = 0; bIdx < KINECT_BONE_COUNT; bIdx++) arrOffsets.push_back(solver.getOffset(bIdx));
+	solver.solve(joints, false);
+	for (int bIdx = 0; bIdx < KINECT_BONE_COUNT; bIdx++) CHECK(solver.getOffset(bIdx) == arrOffsets[bIdx]);
+	CHECK(isSameRotation(solver.getAbsoluteRotation(0), Quaternion(0, 1, 0, 1.0f)));
+}
+
+
+int main()
+{
+	testRestPose();
+	testTurnedPose();
+	testFallbacks();
+	return TEST_RESULT();
+}
@@ -0,0 +1,171 @@
+/**
+ * Tests the XBee coordinator against the emulated XBee network:
+ * discovery, pipelined remote AT commands, the limit of pending commands, and command timeouts.
+ */
+
+#include "Test.h"
+
+#include "XBeeEmulator.h"
+#include "XBeeDevice.h"
+
+#include <atomic>
+#include <thread>
+
+
+typedef std::chrono::steady_clock Clock;
+
+
+/**
+ * Compares sequential remote AT commands with pipelined ones.
+ */
+static void testPipelining()
+{
+	XBeeEmulatorSettings settings;
+	settings.nDevices   = 8;
+	settings.sampleRate = 50;
+	XBeeEmulator emulator(settings);
+	CHECK(emulator.start());
+
+	SerialPort      port(emulator.getDeviceName());
+	XBeeCoordinator coordinator(port);
+	coordinator.setNumberOfRetries(100);
+	int nDevices = coordinator.scanDevices();
+	CHECK(nDevices == settings.nDevices);
+
+	// sequential: one command, one response
+	Clock::time_point t0 = Clock::now();
+	int answered = 0;
+	for (const auto& node : coordinator.getConnectedDevices())
+	{
+		for (const char* czCommand : { "%V", "DB" })
+		{
+			XBeePacket_RemoteAT_Command command(czCommand);
+			command.setSerialNumber(node->getSerialNumber());
+			command.setNetworkAddress(node->getNetworkAddress());
+			XBeePacket_RemoteAT_CommandResponse response;
+			if (coordinator.process(command, response) && response.isOK()) answered++;
+		}
+	}
+	double timeSequential = secondsSince(t0);
+	CHECK(answered == 2 * nDevices);
+
+	// pipelined: all commands in flight at once while IO samples keep arriving
+	t0 = Clock::now();
+	for (const auto& node : coordinator.getConnectedDevices())
+	{
+		CHECK(node->requestTelemetry());
+	}
+	int pending = coordinator.getPendingCommandCount();
+	int samples = 0;
+	while ((coordinator.getPendingCommandCount() > 0) && (secondsSince(t0) < 5))
+	{
+		const XBeePacket_Receive* pPacket = coordinator.receive();
+		if ((pPacket != nullptr) && (pPacket->getFrameTypeID() == XBeePacket_IO_DataSample::FRAME_TYPE_ID)) samples++;
+	}
+	double timePipelined = secondsSince(t0);
+	CHECK(pending == 2 * nDevices);
+	CHECK(coordinator.getPendingCommandCount() == 0);
+
+	int updated = 0;
+	for (const auto& node : coordinator.getConnectedDevices())
+	{
+		if ((node->getBatteryVoltage() > 0) && (node->getSignalStrength() < 0)) updated++;
+	}
+	CHECK(updated == nDevices);
+	// all round trips overlap, so the whole batch takes little more than one
+	CHECK(timePipelined < timeSequential / 4);
+
+	std::cout << "Pipelining: " << nDevices << " devices, "
+		<< answered << " sequential commands in " << timeSequential << "s, "
+		<< pending << " pipelined commands in " << timePipelined << "s, "
+		<< samples << " IO samples received meanwhile" << std::endl;
+}
+
+
+/**
+ * Sends more commands than frame IDs from a second thread while the first thread receives.
+ */
+static void testPendingLimit()
+{
+	XBeeEmulatorSettings settings;
+	settings.nDevices = 2;
+	XBeeEmulator emulator(settings);
+	CHECK(emulator.start());
+
+	SerialPort      port(emulator.getDeviceName());
+	XBeeCoordinator coordinator(port);
+	CHECK(coordinator.scanDevices() == settings.nDevices);
+
+	std::atomic<bool> running(true);
+	std::atomic<int>  answered(0), timedOut(0), sent(0);
+	std::thread receiver([&] { while (running) coordinator.receive(); });
+	std::thread sender([&]
+	{
+		for (int i = 0; i < 300; i++)
+		{
+			XBeePacket_RemoteAT_Command command("%V");
+			command.setSerialNumber(coordinator.getConnectedDevices()[i % 2]->getSerialNumber());
+			auto handler = [&](const XBeePacket_AT_CommandResponse* pResponse) { if (pResponse) answered++; else timedOut++; };
+			if (coordinator.sendAsync(command, handler, 2000)) sent++;
+		}
+	});
+	sender.join();
+	Clock::time_point t0 = Clock::now();
+	while ((coordinator.getPendingCommandCount() > 0) && (secondsSince(t0) < 3))
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+	running = false;
+	receiver.join();
+
+	CHECK(sent == 255);
+	CHECK(answered == sent);
+	CHECK(timedOut == 0);
+	std::cout << "Pending limit: " << sent << " of 300 commands accepted, " << answered << " answered" << std::endl;
+}
+
+
+/**
+ * Checks that the handler of a command without response is called after the timeout,
+ * and that a response arriving after the timeout is ignored.
+ */
+static void testTimeout()
+{
+	XBeeEmulatorSettings settings;
+	settings.nDevices    = 1;
+	settings.remoteDelay = 1000;
+	XBeeEmulator emulator(settings);
+	CHECK(emulator.start());
+
+	SerialPort      port(emulator.getDeviceName());
+	XBeeCoordinator coordinator(port);
+	CHECK(coordinator.scanDevices() == 1);
+	while (coordinator.getPendingCommandCount() > 0) coordinator.receive(); // battery query of the discovery
+
+	XBeePacket_RemoteAT_Command command("%V");
+	command.setSerialNumber(coordinator.getConnectedDevices()[0]->getSerialNumber());
+	int timedOut = 0, answered = 0;
+	CHECK(coordinator.sendAsync(command, [&](const XBeePacket_AT_CommandResponse* pResponse) { if (pResponse) answered++; else timedOut++; }, 200));
+
+	Clock::time_point t0 = Clock::now();
+	while (coordinator.getPendingCommandCount() > 0) coordinator.receive();
+	double timeout = secondsSince(t0);
+	CHECK(timedOut == 1);
+	CHECK((timeout >= 0.2) && (timeout < 0.5));
+
+	// the late response must not reach the handler again
+	t0 = Clock::now();
+	while (secondsSince(t0) < 1.2) coordinator.receive();
+	CHECK(answered == 0);
+	CHECK(timedOut == 1);
+	std::cout << "Timeout: handler called after " << timeout << "s" << std::endl;
+}
+
+
+int main()
+{
+	testPipelining();
+	testPendingLimit();
+	testTimeout();
+	return TEST_RESULT();
+}
@@ -0,0 +1,79 @@
+/**
+ * Tests reading numbers, strings, and parts from XBee data views, including reads past the end.
+ */
+
+#include "Test.h"
+
+#include "XBeeData.h"
+
+
+/**
+ * Reads values that lie completely within the view.
+ */
+static void testReading()
+{
+	const uint8_t arrData[] = { 0x12, 0x34, 0x56, 0x78, 0x9A, 0xBC, 0xDE, 0xF0, 'A', 'B', 0, 'C', 'D' };
+	XBeeReadView view(arrData, sizeof(arrData));
+
+	CHECK(view.getByteAt(0) == 0x12);
+	CHECK(view.getNextByte() == 0x34);
+	CHECK(view.getUInt16At(0) == 0x1234);
+	CHECK(view.getNextUInt16() == 0x5678);
+	CHECK(view.getUInt32At(0) == 0x12345678);
+	CHECK(view.getNextUInt32() == 0x9ABCDEF0);
+	CHECK(view.getUInt64At(0) == 0x123456789ABCDEF0ull);
+	CHECK(view.getNextStringView() == "AB");
+	CHECK(view.getNextStringView() == "CD");
+	CHECK(view.getStringAt(8, 1) == "A");
+	CHECK(view.getNextString() == "B");
+
+	XBeeReadView part = view.getViewAt(2, 6);
+	CHECK(part.size() == 4);
+	CHECK(part.getUInt32At(0) == 0x56789ABC);
+}
+
+
+/**
+ * Reads past the end of a view, which must neither fail nor touch the bytes after the view.
+ */
+static void testReadingPastEnd()
+{
+	// the view only covers the first 4 bytes, the rest must never be read
+	const uint8_t arrData[] = { 0x12, 0x34, 0x56, 0x78, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF };
+	XBeeReadView view(arrData, 4);
+
+	CHECK(view.getUInt64At(0) == 0);
+	CHECK(view.getUInt32At(2) == 0);
+	CHECK(view.getUInt16At(3) == 0);
+	CHECK(view.getByteAt(4) == 0);
+	CHECK(view.getByteAt(1000) == 0);
+	CHECK(view.getStringViewAt(1000).empty());
+
+	// after a failed read, the view counts as completely read
+	CHECK(view.getUInt16At(1) == 0x3456);
+	CHECK(view.getNextUInt16() == 0);
+	CHECK(view.getNextByte() == 0);
+	CHECK(view.getNextStringView().empty());
+
+	// parts are limited to the view
+	XBeeReadView part = view.getViewAt(2, 100);
+	CHECK(part.size() == 2);
+	CHECK(part.getUInt16At(0) == 0x5678);
+	CHECK(view.getViewAt(8, 3).size() == 0);
+	CHECK(view.getViewAt(8, 100).size() == 0);
+	CHECK(view.getViewAt(8, 100).getNextUInt32() == 0);
+
+	// the empty view
+	XBeeReadView empty;
+	CHECK(empty.getNextUInt64() == 0);
+	CHECK(empty.getNextStringView().empty());
+	CHECK(empty.getViewAt(0, 10).size() == 0);
+}
+
+
+int main()
+{
+	testReading();
+	testReadingPastEnd();
+	return TEST_RESULT();
+}
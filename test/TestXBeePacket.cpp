@@ -0,0 +1,127 @@
+/**
+ * Tests unmarshalling received XBee packets, including reused packets and frames that are too short for their type.
+ */
+
+#include "Test.h"
+
+#include "XBeeFrames.h"
+#include "XBeePacket.h"
+
+
+/**
+ * Unmarshals complete frames of each type.
+ */
+static void testCompleteFrames()
+{
+	XBeeReadBuffer buffer;
+
+	XBeePacket_IO_DataSample sample;
+	CHECK(receiveFrame(buffer, PAYLOAD_IO_SAMPLE));
+	CHECK(sample.unmarshal(buffer));
+	CHECK(sample.getSerialNumber() == 0x0102030405060708ull);
+	CHECK(sample.getNetworkAddress() == 0x1234);
+	CHECK(sample.getDigitalInputMask() == 0x001F);
+	CHECK(sample.getDigitalInputState() == 0x0015);
+
+	XBeePacket_AT_CommandResponse response;
+	CHECK(receiveFrame(buffer, PAYLOAD_DISCOVERY_RESPONSE));
+	CHECK(response.unmarshal(buffer));
+	CHECK(response.getFrameID() == 7);
+	CHECK(response.getCommand() == "ND");
+	CHECK(response.isOK());
+	CHECK(response.getRawData().size() == PAYLOAD_DISCOVERY_RESPONSE.size() - 5);
+	CHECK(response.getRawData().getStringViewAt(10) == "Joystick 1");
+
+	XBeePacket_RemoteAT_CommandResponse remote;
+	CHECK(receiveFrame(buffer, PAYLOAD_REMOTE_RESPONSE));
+	CHECK(remote.unmarshal(buffer));
+	CHECK(remote.getSerialNumber() == 0x0102030405060708ull);
+	CHECK(remote.getNetworkAddress() == 0x1234);
+	CHECK(remote.getCommand() == "DB");
+	CHECK(remote.getRawData().size() == 1);
+	CHECK(remote.getRawData().getByteAt(0) == 0x2D);
+
+	// a packet of another type is refused
+	CHECK(!sample.unmarshal(buffer));
+}
+
+
+/**
+ * Reuses packet instances like the coordinator does.
+ * No field may keep its value from the previous frame.
+ */
+static void testReuse()
+{
+	XBeeReadBuffer buffer;
+
+	// a sample with digital inputs followed by one with only an analog input
+	XBeePacket_IO_DataSample sample;
+	CHECK(receiveFrame(buffer, PAYLOAD_IO_SAMPLE));
+	CHECK(sample.unmarshal(buffer));
+	CHECK(receiveFrame(buffer, { 0x92, 8,7,6,5,4,3,2,1, 0x56,0x78, 0x01, 0x01, 0x00,0x00, 0x01, 0x02,0x00 }));
+	CHECK(sample.unmarshal(buffer));
+	CHECK(sample.getSerialNumber() == 0x0807060504030201ull);
+	CHECK(sample.getDigitalInputMask() == 0);
+	CHECK(sample.getDigitalInputState() == 0);
+
+	// a failed unmarshal leaves nothing of the previous frame either
+	CHECK(receiveFrame(buffer, PAYLOAD_IO_SAMPLE));
+	CHECK(sample.unmarshal(buffer));
+	CHECK(receiveFrame(buffer, { 0x92, 1,2,3,4 }));
+	CHECK(!sample.unmarshal(buffer));
+	CHECK(sample.getSerialNumber() == 0);
+	CHECK(sample.getDigitalInputState() == 0);
+
+	// a response with data followed by one without
+	XBeePacket_AT_CommandResponse response;
+	CHECK(receiveFrame(buffer, PAYLOAD_DISCOVERY_RESPONSE));
+	CHECK(response.unmarshal(buffer));
+	CHECK(receiveFrame(buffer, { 0x88, 8, 'N','D', 0 }));
+	CHECK(response.unmarshal(buffer));
+	CHECK(response.getFrameID() == 8);
+	CHECK(response.getRawData().size() == 0);
+	CHECK(receiveFrame(buffer, { 0x88, 9 }));
+	CHECK(!response.unmarshal(buffer));
+	CHECK(response.getCommand().empty());
+	CHECK(response.getRawData().size() == 0);
+
+	XBeePacket_RemoteAT_CommandResponse remote;
+	CHECK(receiveFrame(buffer, PAYLOAD_REMOTE_RESPONSE));
+	CHECK(remote.unmarshal(buffer));
+	CHECK(receiveFrame(buffer, { 0x97, 9, 1,2,3,4 }));
+	CHECK(!remote.unmarshal(buffer));
+	CHECK(remote.getSerialNumber() == 0);
+	CHECK(remote.getNetworkAddress() == 0);
+	CHECK(remote.getRawData().size() == 0);
+}
+
+
+/**
+ * Unmarshals every shortened version of a frame, each with a valid checksum.
+ * Frames below the minimum size of the type must be refused without reading past their end.
+ */
+template<class Packet>
+static void testShortFrames(const std::vector<uint8_t>& arrPayload, size_t minFrameSize)
+{
+	Packet packet;
+	for (size_t len = 1; len <= arrPayload.size(); len++)
+	{
+		std::vector<uint8_t> arrPartial(arrPayload.begin(), arrPayload.begin() + len);
+		XBeeReadBuffer buffer;
+		CHECK(receiveFrame(buffer, arrPartial));
+		bool valid = packet.unmarshal(buffer);
+		CHECK(valid == (buffer.size() >= minFrameSize));
+	}
+}
+
+
+int main()
+{
+	testCompleteFrames();
+	testReuse();
+	testShortFrames<XBeePacket_AT_CommandResponse>(PAYLOAD_DISCOVERY_RESPONSE, XBeePacket_AT_CommandResponse::MIN_FRAME_SIZE);
+	testShortFrames<XBeePacket_RemoteAT_CommandResponse>(PAYLOAD_REMOTE_RESPONSE, XBeePacket_RemoteAT_CommandResponse::MIN_FRAME_SIZE);
+	// with digital inputs in the mask, the sample also needs their state
+	testShortFrames<XBeePacket_IO_DataSample>(PAYLOAD_IO_SAMPLE, XBeePacket_IO_DataSample::MIN_FRAME_SIZE + 2);
+	return TEST_RESULT();
+}
@@ -0,0 +1,62 @@
+/**
+ * Runs the XBee emulator on its own, e.g., for connecting a program to it manually.
+ *
+ * Usage: XBeeEmulatorTool [-devices N] [-rate samplesPerSecond] [-delay ms]
+ *
+ * Prints the name of the pseudo terminal to open as the serial port, then reads commands from stdin:
+ *   <device> <state>  sets the input pins of a joystick (state in hex, e.g., "0 F8" presses button 1)
+ *   q                 quits (as does the end of the input)
+ */
+
+#include "XBeeEmulator.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+
+int main(int argc, char** argv)
+{
+	XBeeEmulatorSettings settings;
+	for (int aIdx = 1; aIdx + 1 < argc; aIdx += 2)
+	{
+		if      (strcmp(argv[aIdx], "-devices") == 0) settings.nDevices    = atoi(argv[aIdx + 1]);
+		else if (strcmp(argv[aIdx], "-rate")    == 0) settings.sampleRate  = (float) atof(argv[aIdx + 1]);
+		else if (strcmp(argv[aIdx], "-delay")   == 0) settings.remoteDelay = atoi(argv[aIdx + 1]);
+		else
+		{
+			std::cerr << "Unknown option " << argv[aIdx] << std::endl;
+			return 1;
+		}
+	}
+
+	XBeeEmulator emulator(settings);
+	if (!emulator.start())
+	{
+		std::cerr << "Could not start the emulator" << std::endl;
+		return 1;
+	}
+	std::cout << emulator.getDeviceName() << std::endl;
+
+	std::string strLine;
+	while (std::getline(std::cin, strLine) && (strLine != "q"))
+	{
+		std::istringstream strm(strLine);
+		int      deviceIdx;
+		unsigned state;
+		if ((strm >> deviceIdx >> std::hex >> state) && (deviceIdx >= 0) && (deviceIdx < settings.nDevices))
+		{
+			emulator.setInputState(deviceIdx, (uint16_t) state);
+		}
+		else
+		{
+			std::cerr << "Expected <device> <state>" << std::endl;
+		}
+	}
+
+	std::cout << emulator.getSentSamples() << " samples sent, " << emulator.getDroppedFrames() << " frames dropped" << std::endl;
+	emulator.stop();
+	return 0;
+}
@@ -0,0 +1,58 @@
+/**
+ * Helpers for creating received XBee frames in the tests and benchmarks.
+ */
+
+#pragma once
+
+#include "XBeeData.h"
+
+#include <cstring>
+#include <vector>
+
+
+/**
+ * Adds start delimiter, length, and checksum to a frame payload.
+ *
+ * @param arrPayload  the frame type and data of the frame
+ *
+ * @return the complete frame as sent over the serial port
+ */
+inline std::vector<uint8_t> createFrame(const std::vector<uint8_t>& arrPayload)
+{
+	std::vector<uint8_t> arrFrame = { 0x7E, (uint8_t) (arrPayload.size() >> 8), (uint8_t) arrPayload.size() };
+	uint8_t checksum = 0;
+	for (uint8_t b : arrPayload)
+	{
+		arrFrame.push_back(b);
+		checksum += b;
+	}
+	arrFrame.push_back(0xFF - checksum);
+	return arrFrame;
+}
+
+
+/**
+ * Puts a frame with the given payload through a frame reader into a read buffer.
+ *
+ * @param refBuffer   the buffer to receive the frame into
+ * @param arrPayload  the frame type and data of the frame
+ *
+ * @return <code>true</code> if the frame reader accepted the frame
+ */
+inline bool receiveFrame(XBeeReadBuffer& refBuffer, const std::vector<uint8_t>& arrPayload)
+{
+	std::vector<uint8_t> arrFrame = createFrame(arrPayload);
+
+	XBeeFrameReader reader;
+	size_t   space;
+	uint8_t* pWrite = reader.getWritePointer(space);
+	memcpy(pWrite, arrFrame.data(), arrFrame.size());
+	reader.commitWrite(arrFrame.size());
+	return reader.extractFrame(refBuffer);
+}
+
+
+// payloads of frames as sent by XBee modules
+static const std::vector<uint8_t> PAYLOAD_IO_SAMPLE          = { 0x92, 1,2,3,4,5,6,7,8, 0x12,0x34, 0x01, 0x01, 0x00,0x1F, 0x00, 0x00,0x15 };
+static const std::vector<uint8_t> PAYLOAD_DISCOVERY_RESPONSE = { 0x88, 7, 'N','D', 0, 0x12,0x34, 0,0x13,0xA2,0,0x40,0x11,0x22,0x33, 'J','o','y','s','t','i','c','k',' ','1',0, 0xFF,0xFE, 1, 0, 0xC1,0x05, 0x10,0x1E };
+static const std::vector<uint8_t> PAYLOAD_REMOTE_RESPONSE    = { 0x97, 9, 1,2,3,4,5,6,7,8, 0x12,0x34, 'D','B', 0, 0x2D };
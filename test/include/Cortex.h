@@ -0,0 +1,168 @@
+/**
+ * Stand-in for the Cortex SDK header for building the tests on systems without the SDK.
+ * Declares only the constants, data structures, and entry points that MoCapCortex and the Cortex emulator use,
+ * with the same names and member layout as the Cortex SDK 5.x.
+ * The functions are implemented by the emulator (USE_CORTEX_EMULATOR).
+ */
+
+#pragma once
+
+#define XEMPTY        9999999.0f
+#define MAX_N_BODIES  100
+
+
+typedef float  tMarkerData[3];
+typedef double tSegmentData[7];
+typedef double tDofData;
+
+
+enum maReturnCode
+{
+	RC_Okay = 0,
+	RC_GeneralError,
+	RC_ApiError,
+	RC_NetworkError,
+	RC_TimeOut,
+	RC_MemoryError,
+	RC_Unrecognized
+};
+
+
+enum maVerbosityLevel
+{
+	VL_None = 0,
+	VL_Error,
+	VL_Warning,
+	VL_Info,
+	VL_Debug
+};
+
+
+typedef struct sHostInfo
+{
+	int           bFoundHost;
+	int           LatestConfirmationTime;
+	char          szHostMachineName[128];
+	unsigned char HostMachineAddress[4];
+	char          szHostProgramName[128];
+	unsigned char HostProgramVersion[4];
+} sHostInfo;
+
+
+typedef struct sHierarchy
+{
+	int    nSegments;
+	char** szSegmentNames;
+	int*   iParents;
+} sHierarchy;
+
+
+typedef struct sBodyDef
+{
+	char*      szName;
+	int        nMarkers;
+	char**     szMarkerNames;
+	sHierarchy Hierarchy;
+	int        nDofs;
+	char**     szDofNames;
+} sBodyDef;
+
+
+typedef struct sAnalogDefs
+{
+	int    nAnalogChannels;
+	char** szAnalogChannelNames;
+	int    nForcePlates;
+	int    nAngleEncoders;
+	char** szAngleEncoderNames;
+} sAnalogDefs;
+
+
+typedef struct sBodyDefs
+{
+	int         nBodyDefs;
+	sBodyDef    BodyDefs[MAX_N_BODIES];
+	sAnalogDefs AnalogDefs;
+	void*       AllocatedSpace;
+} sBodyDefs;
+
+
+typedef struct sBodyData
+{
+	char          szName[128];
+	int           nMarkers;
+	tMarkerData*  Markers;
+	float         fAvgMarkerResidual;
+	int           nSegments;
+	tSegmentData* Segments;
+	int           nDofs;
+	tDofData*     Dofs;
+	float         fAvgDofResidual;
+	int           nIterations;
+	int           ZoomEncoderValue;
+	int           FocusEncoderValue;
+	int           IrisEncoderValue;
+	float         CamTrackParams[6];
+	int           nEvents;
+	char**        Events;
+} sBodyData;
+
+
+typedef struct sAnalogData
+{
+	int     nAnalogChannels;
+	int     nAnalogSamples;
+	short*  AnalogSamples;
+	int     nForcePlates;
+	int     nForceSamples;
+	void*   Forces;
+	int     nAngleEncoders;
+	int     nAngleEncoderSamples;
+	double* AngleEncoderSamples;
+} sAnalogData;
+
+
+typedef struct sRecordingStatus
+{
+	int  bRecording;
+	int  iFirstFrame;
+	int  iLastFrame;
+	char szFilename[256];
+} sRecordingStatus;
+
+
+typedef struct sTimeCode
+{
+	int iHours, iMinutes, iSeconds, iFrames, iStandard;
+} sTimeCode;
+
+
+typedef struct sFrameOfData
+{
+	int              iFrame;
+	float            fDelay;
+	int              nBodies;
+	sBodyData        BodyData[MAX_N_BODIES];
+	int              nUnidentifiedMarkers;
+	tMarkerData*     UnidentifiedMarkers;
+	sAnalogData      AnalogData;
+	sRecordingStatus RecordingStatus;
+	sTimeCode        TimeCode;
+} sFrameOfData;
+
+
+int           Cortex_GetSdkVersion(unsigned char Version[4]);
+int           Cortex_SetErrorMsgHandlerFunc(void (*MyFunction)(int iLogLevel, char* szLogMessage));
+int           Cortex_SetDataHandlerFunc(void (*MyFunction)(sFrameOfData* pFrameOfData));
+int           Cortex_Initialize(char* szTalkToHostNicCardAddress, char* szHostNicCardAddress,
+                                char* szHostMulticastAddress = 0, char* szTalkToClientsNicCardAddress = 0,
+                                char* szClientsMulticastAddress = 0);
+int           Cortex_GetPortNumbers(int* TalkToHostPort, int* HostPort, int* HostMulticastPort,
+                                    int* TalkToClientsRequestPort, int* TalkToClientsMulticastPort, int* ClientsMulticastPort);
+int           Cortex_GetHostInfo(sHostInfo* pHostInfo);
+int           Cortex_Exit();
+int           Cortex_Request(char* szCommand, void** ppResponse, int* pnBytes);
+sBodyDefs*    Cortex_GetBodyDefs();
+int           Cortex_FreeBodyDefs(sBodyDefs* pBodyDefs);
+sFrameOfData* Cortex_GetCurrentFrame();
+int           Cortex_FreeFrame(sFrameOfData* pFrame);
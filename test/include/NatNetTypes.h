@@ -0,0 +1,162 @@
+/**
+ * Stand-in for the NatNet SDK header for building the tests on systems without the SDK.
+ * Declares only the constants and data structures that the MotionServer modules use,
+ * with the same names and member layout as NatNet 2.x.
+ * The real header (see include/ReadMe.txt) takes precedence when it is on the include path first.
+ */
+
+#pragma once
+
+#define MAX_MODELS              200
+#define MAX_RIGIDBODIES         1000
+#define MAX_NAMELENGTH          256
+#define MAX_MARKERS             200
+#define MAX_RBMARKERS           20
+#define MAX_SKELETONS           100
+#define MAX_SKELRIGIDBODIES     200
+#define MAX_LABELED_MARKERS     1000
+#define MAX_UNLABELED_MARKERS   1000
+#define MAX_FORCEPLATES         8
+#define MAX_ANALOG_CHANNELS     32
+#define MAX_ANALOG_SUBFRAMES    30
+
+
+typedef float MarkerData[3];
+
+typedef struct
+{
+	int   ID;
+	float x, y, z;
+	float size;
+	short params;
+} sMarker;
+
+
+typedef struct
+{
+	char   szName[MAX_NAMELENGTH];
+	int    nMarkers;
+	char** szMarkerNames;
+} sMarkerSetDescription;
+
+typedef struct
+{
+	char  szName[MAX_NAMELENGTH];
+	int   ID;
+	int   parentID;
+	float offsetx, offsety, offsetz;
+} sRigidBodyDescription;
+
+typedef struct
+{
+	char                  szName[MAX_NAMELENGTH];
+	int                   skeletonID;
+	int                   nRigidBodies;
+	sRigidBodyDescription RigidBodies[MAX_SKELRIGIDBODIES];
+} sSkeletonDescription;
+
+typedef struct
+{
+	int   ID;
+	char  strSerialNo[128];
+	float fWidth;
+	float fLength;
+	float Position[3];
+	float ElectricalOffsetMatrix[12][12];
+	float Calibration[12][12];
+	float Corners[4][3];
+	int   iPlateType;
+	int   iChannelDataType;
+	int   nChannels;
+	char  szChannelNames[MAX_ANALOG_CHANNELS][MAX_NAMELENGTH];
+} sForcePlateDescription;
+
+typedef enum
+{
+	Descriptor_MarkerSet = 0,
+	Descriptor_RigidBody,
+	Descriptor_Skeleton,
+	Descriptor_ForcePlate
+} DataDescriptors;
+
+typedef struct
+{
+	int type;
+	union
+	{
+		sMarkerSetDescription*  MarkerSetDescription;
+		sRigidBodyDescription*  RigidBodyDescription;
+		sSkeletonDescription*   SkeletonDescription;
+		sForcePlateDescription* ForcePlateDescription;
+	} Data;
+} sDataDescription;
+
+typedef struct
+{
+	int              nDataDescriptions;
+	sDataDescription arrDataDescriptions[MAX_MODELS];
+} sDataDescriptions;
+
+
+typedef struct
+{
+	char        szName[MAX_NAMELENGTH];
+	int         nMarkers;
+	MarkerData* Markers;
+} sMarkerSetData;
+
+typedef struct
+{
+	int         ID;
+	float       x, y, z;
+	float       qx, qy, qz, qw;
+	int         nMarkers;
+	MarkerData* Markers;
+	int*        MarkerIDs;
+	float*      MarkerSizes;
+	float       MeanError;
+	short       params;
+} sRigidBodyData;
+
+typedef struct
+{
+	int             skeletonID;
+	int             nRigidBodies;
+	sRigidBodyData* RigidBodyData;
+} sSkeletonData;
+
+typedef struct
+{
+	int   nFrames;
+	float Values[MAX_ANALOG_SUBFRAMES];
+} sAnalogChannelData;
+
+typedef struct
+{
+	int                ID;
+	int                nChannels;
+	sAnalogChannelData ChannelData[MAX_ANALOG_CHANNELS];
+	short              params;
+} sForcePlateData;
+
+typedef struct
+{
+	int             iFrame;
+	int             nMarkerSets;
+	sMarkerSetData  MocapData[MAX_MODELS];
+	int             nOtherMarkers;
+	MarkerData*     OtherMarkers;
+	int             nRigidBodies;
+	sRigidBodyData  RigidBodies[MAX_RIGIDBODIES];
+	int             nSkeletons;
+	sSkeletonData   Skeletons[MAX_SKELETONS];
+	int             nLabeledMarkers;
+	sMarker         LabeledMarkers[MAX_LABELED_MARKERS];
+	int             nForcePlates;
+	sForcePlateData ForcePlates[MAX_FORCEPLATES];
+	float           fLatency;
+	unsigned int    Timecode;
+	unsigned int    TimecodeSubframe;
+	double          fTimestamp;
+	short           params;
+} sFrameOfMocapData;